@@ -9,6 +9,8 @@
 #include "Animation/AnimNode_SequencePlayer.h"
 #include "Enumerations/EMotionMatchingEnums.h"
 #include "MotionMatchingUtil/MotionMatchingUtils.h"
+#include "MotionMatchingUtil/MotionMatchingQueryLog.h"
+#include "MotionMatchingUtil/MotionMatchingSearchTelemetry.h"
 
 #if ENGINE_MAJOR_VERSION > 4
 #include "Animation/AnimSyncScope.h"
@@ -45,6 +47,39 @@ static TAutoConsoleVariable<int32> CVarMMAnimDebug(
 	TEXT("<=0: Off \n")
 	TEXT("  2: On - Show Current Anim Info"));
 
+static TAutoConsoleVariable<int32> CVarMMSearchRecord(
+	TEXT("a.AnimNode.MoSymph.MMSearch.Record"),
+	0,
+	TEXT("Records every motion matching search to a query log in the profiling directory for offline replay. \n")
+	TEXT("<=0: Off \n")
+	TEXT("  1: On"));
+
+/** The cost of a single feature group of a search candidate. The candidate's body momentum (angular in W) is passed 
+separately as the linear search reads it from the trait search momenta rather than the pose */
+static FORCEINLINE float ComputeFeatureGroupCost(const EMotionFeatureGroup Group, const FMotionMatchingSearchQuery& Query,
+	const FVector4& CandidateMomentum, const FPoseMotionData& Candidate)
+{
+	const FCalibrationData& Calibration = Query.Calibration;
+
+	switch (Group)
+	{
+		case EMotionFeatureGroup::Momentum:
+			return FVector::DistSquared(Query.CurrentPose.LocalVelocity, FVector(CandidateMomentum))
+				* Calibration.Weight_Momentum * Query.OverridePoseMultiplier;
+		case EMotionFeatureGroup::AngularMomentum:
+			return FMath::Abs(Query.CurrentPose.RotationalVelocity - CandidateMomentum.W)
+				* Calibration.Weight_AngularMomentum * Query.OverridePoseMultiplier;
+		case EMotionFeatureGroup::Trajectory:
+			return FMotionMatchingUtils::ComputeTrajectoryCost(Query.DesiredTrajectory, Candidate.Trajectory, Calibration)
+				* Query.OverrideTrajectoryMultiplier;
+		case EMotionFeatureGroup::Joints:
+			return FMotionMatchingUtils::ComputePoseCost(Query.CurrentPose.JointData, Candidate.JointData, Calibration)
+				* Query.OverridePoseMultiplier;
+		default:
+			return 0.0f;
+	}
+}
+
 FAnimNode_MotionMatching::FAnimNode_MotionMatching() :
 	UpdateInterval(0.1f),
 	PlaybackRate(1.0f),
@@ -55,6 +90,11 @@ FAnimNode_MotionMatching::FAnimNode_MotionMatching() :
 	bBlendOutEarly(true),
 	PoseMatchMethod(EPoseMatchMethod::Optimized),
 	TransitionMethod(ETransitionMethod::Inertialization),
+	bSeedPoseSearch(true),
+	SearchSeedRadius(2),
+	InertializationHalfLife(0.05f),
+	bAsyncPoseSearch(false),
+	AsyncSearchDeadline(0.05f),
 	PastTrajectoryMode(EPastTrajectoryMode::ActualHistory),
 	bBlendTrajectory(false),
 	TrajectoryBlendMagnitude(1.0f),
@@ -75,9 +115,15 @@ FAnimNode_MotionMatching::FAnimNode_MotionMatching() :
 	bForcePoseSearch(false),
 	CurrentChosenPoseId(0),
 	DominantBlendChannel(0),
+	ActiveDatabaseId(0),
+	ActiveMotionData(nullptr),
 	bValidToEvaluate(false),
 	bInitialized(false),
-	bTriggerTransition(false), MotionMatchingMode(), AnimInstanceProxy(nullptr)
+	bTriggerTransition(false), MotionMatchingMode(), 
+	PendingSearchDispatchTime(0.0),
+	TransitionCount(0),
+	bRequiredTraitPoseMaskValid(false),
+	AnimInstanceProxy(nullptr)
 {
 	DesiredTrajectory.Clear();
 	BlendChannels.Empty(12);
@@ -91,7 +137,100 @@ FAnimNode_MotionMatching::FAnimNode_MotionMatching() :
 
 FAnimNode_MotionMatching::~FAnimNode_MotionMatching()
 {
+	CancelAsyncPoseSearch();
+}
+
+FMotionMatchingSearchQuery::FMotionMatchingSearchQuery()
+	: PoseMatchMethod(EPoseMatchMethod::Optimized),
+	NextPoseId(0),
+	OverridePoseMultiplier(1.0f),
+	OverrideTrajectoryMultiplier(1.0f),
+	bFavourCurrentPose(false),
+	CurrentPoseFavour(1.0f),
+	SeedRadius(INDEX_NONE),
+	DatabaseId(0),
+	TransitionCount(0),
+	SearchDatabaseId(INDEX_NONE)
+{
+}
+
+bool FMotionMatchingSearchQuery::IsSearchingOtherDatabase() const
+{
+	return SearchDatabaseId != INDEX_NONE && SearchDatabaseId != DatabaseId;
+}
+
+const TArray<uint64>& FMotionMatchingSearchQuery::GetSearchPoseMask() const
+{
+	return IsSearchingOtherDatabase() && DatabasePoseMasks.IsValidIndex(SearchDatabaseId) ? DatabasePoseMasks[SearchDatabaseId] : PoseMask;
+}
+
+int32 FMotionMatchingSearchQuery::GetSearchNextPoseId() const
+{
+	return IsSearchingOtherDatabase() ? INDEX_NONE : NextPoseId;
+}
+
+int32 FMotionMatchingSearchQuery::GetSearchSeedRadius() const
+{
+	return IsSearchingOtherDatabase() ? INDEX_NONE : SeedRadius;
+}
+
+FMotionMatchingSearchStats::FMotionMatchingSearchStats()
+	: SeedCount(0),
+	CandidateCount(0),
+	CostedCount(0),
+	RejectedGroupCount(0),
+	SkippedDatabaseCount(0)
+{
+}
+
+void FMotionMatchingSearchStats::Reset()
+{
+	SeedCount = 0;
+	CandidateCount = 0;
+	CostedCount = 0;
+	RejectedGroupCount = 0;
+	SkippedDatabaseCount = 0;
+}
 
+void FMotionMatchingSearchStats::Accumulate(const FMotionMatchingSearchStats& Other)
+{
+	SeedCount += Other.SeedCount;
+	CandidateCount += Other.CandidateCount;
+	CostedCount += Other.CostedCount;
+	RejectedGroupCount += Other.RejectedGroupCount;
+	SkippedDatabaseCount += Other.SkippedDatabaseCount;
+}
+
+float FMotionMatchingSearchStats::GetPruneRate() const
+{
+	return CandidateCount > 0 ? 1.0f - (float)CostedCount / (float)CandidateCount : 0.0f;
+}
+
+float FMotionMatchingSearchStats::GetGroupsPerRejection() const
+{
+	const int32 RejectedCount = CandidateCount - CostedCount;
+	return RejectedCount > 0 ? (float)RejectedGroupCount / (float)RejectedCount : 0.0f;
+}
+
+FMotionMatchingSearchResult::FMotionMatchingSearchResult()
+	: DatabaseId(0),
+	PoseId(0),
+	Cost(10000000.0f)
+{
+}
+
+FMotionMatchingSearchResult::FMotionMatchingSearchResult(const int32 InDatabaseId, const int32 InPoseId, const float InCost)
+	: DatabaseId(InDatabaseId),
+	PoseId(InPoseId),
+	Cost(InCost)
+{
+}
+
+FMotionMatchingAsyncSearch::FMotionMatchingAsyncSearch()
+	: ResultDatabaseId(0),
+	ResultPoseId(-1),
+	ResultRunnerUpCost(-1.0f)
+{
 }
 
 void FAnimNode_MotionMatching::UpdateBlending(const float DeltaTime)
@@ -188,6 +327,7 @@ void FAnimNode_MotionMatching::InitializeMatchedTransition(const FAnimationUpdat
 	else
 	{
 		//We just jump to the default pose because there is no way to match to external nodes.
+		SetActiveDatabase(0);
 		JumpToPose(0);
 	}
 }
@@ -265,6 +405,8 @@ void FAnimNode_MotionMatching::InitializeDistanceMatching(const FAnimationUpdate
 
 		const FPoseMotionData& Pose = MotionData->Poses[LowestCostPoseId];
 
+		//Distance match sections are only searched in the primary database
+		SetActiveDatabase(0);
 		TransitionToPose(LowestCostPoseId, Context, LowestCostTime - Pose.Time);
 	}
 }
@@ -279,40 +421,51 @@ void FAnimNode_MotionMatching::InitializeMotionAction(const FAnimationUpdateCont
 		return;
 	}
 
-	const FCalibrationData& FinalCalibration = FinalCalibrationSets[RequiredTraits];
+	//Only the actions with the requested id (and traits where possible) are scored
+	int32 CandidateStart = 0;
+	int32 CandidateEnd = 0;
+	if (!MotionData->GetActionCandidates(MotionActionPayload.ActionId, RequiredTraits, CandidateStart, CandidateEnd))
+	{
+		return;
+	}
+
+	//Action poses are scored with the same cost function as the main search but without favouring the current pose
+	FMotionMatchingSearchQuery ActionQuery;
+	BuildSearchQuery(ActionQuery, ActiveMotionData->Poses[FMath::Clamp(CurrentChosenPoseId, 0, ActiveMotionData->Poses.Num() - 1)]);
+	ActionQuery.bFavourCurrentPose = false;
+
+	//The natural next pose only exists in the actions' database if it is the active one
+	if (ActiveDatabaseId != 0)
+	{
+		ActionQuery.NextPoseId = INDEX_NONE;
+	}
 
-	//Cost function on action poses
 	int32 BestPoseId = -1;
 	int32 BestActionId = -1;
 	float BestActionCost = 10000000.0f;
-	for (int32 i = 0; i < MotionData->Actions.Num(); ++i)
+	for (int32 i = CandidateStart; i < CandidateEnd; ++i)
 	{
-		const FMotionAction& MotionAction = MotionData->Actions[i];
+		const int32 ActionId = MotionData->ActionIndex[i];
+		const FMotionAction& MotionAction = MotionData->Actions[ActionId];
 
-		if (MotionAction.ActionId == MotionActionPayload.ActionId) //TODO: Support Traits?
-		{
-			const int32 PoseId = FMath::Clamp(MotionAction.PoseId - PoseOffsetToStart, 0, MotionData->Poses.Num());
-			FPoseMotionData& Pose = MotionData->Poses[PoseId];
-
-			float Cost = FMotionMatchingUtils::ComputePoseCost(Pose.JointData, CurrentInterpolatedPose.JointData, FinalCalibration);
-
-			//TODO: Add momentum
-			//TODO: Add rotational momentum
-			//TODO: Add trajectory
+		const int32 PoseId = FMath::Clamp(MotionAction.PoseId - PoseOffsetToStart, 0, MotionData->Poses.Num() - 1);
+		const float Cost = ComputePoseSearchCost(MotionData, ActionQuery, PoseId);
 
-			Cost *= Pose.Favour;
-
-			if (Cost < BestActionCost)
-			{
-				BestActionCost = Cost;
-				BestActionId = i;
-				BestPoseId = Pose.PoseId;
-			}
+		if (Cost < BestActionCost)
+		{
+			BestActionCost = Cost;
+			BestActionId = ActionId;
+			BestPoseId = PoseId;
 		}
 	}
 
 	if (BestActionId > -1)
 	{
+		//A pending search result would override the action when motion matching resumes
+		DetachAsyncPoseSearch();
+
+		//Actions are only searched in the primary database
+		SetActiveDatabase(0);
 		TransitionToPose(BestPoseId, Context);
 		MotionMatchingMode = EMotionMatchingMode::Action;
 		CurrentActionId = BestActionId;
@@ -440,6 +593,20 @@ void FAnimNode_MotionMatching::UpdateMotionMatching(const float DeltaTime, const
 		}
 	}
 
+	//A deferred search is consumed before any new search is scheduled. Forced searches can't wait for it.
+	if (PendingSearchTask.IsValid())
+	{
+		if (bForcePoseSearch)
+		{
+			DetachAsyncPoseSearch();
+		}
+		else
+		{
+			ResolveAsyncPoseSearch(Context);
+			return;
+		}
+	}
+
 	if (TimeSinceMotionUpdate >= UpdateInterval || bForcePoseSearch)
 	{
 		TimeSinceMotionUpdate = 0.0f;
@@ -464,560 +631,994 @@ bool FAnimNode_MotionMatching::UpdateDistanceMatching(const float DeltaTime, con
 	return true;
 }
 
-void FAnimNode_MotionMatching::ComputeCurrentPose()
+int32 FAnimNode_MotionMatching::GetChannelPoseId(const FAnimChannelState& Channel, const float TimePassed, float& OutInterpolation) const
 {
-	const float PoseInterval = FMath::Max(0.01f, MotionData->PoseInterval);
+	OutInterpolation = 0.0f;
+
+	const UMotionDataAsset* ChannelMotionData = GetChannelMotionData(Channel);
+	const FMotionPoseRange* PoseRange = ChannelMotionData->FindPoseRangeForPose(Channel.StartPoseId);
+	if (!PoseRange)
+	{
+		return FMath::Clamp(Channel.StartPoseId, 0, ChannelMotionData->Poses.Num() - 1);
+	}
+
+	float PoseTime = Channel.StartTime + TimePassed;
+	if (Channel.AnimLength > 0.0f)
+	{
+		PoseTime = Channel.bLoop ? FMotionMatchingUtils::WrapAnimationTime(PoseTime, Channel.AnimLength)
+			: FMath::Min(PoseTime, Channel.AnimLength);
+	}
+
+	return PoseRange->GetPoseIdAtTime(PoseTime, ChannelMotionData->PoseInterval, OutInterpolation);
+}
 
+void FAnimNode_MotionMatching::ComputeChannelPoses(FPoseMotionData*& OutBeforePose, FPoseMotionData*& OutAfterPose)
+{
 	//====== Determine the next chosen pose ========
-	const FAnimChannelState& ChosenChannel = BlendChannels.Last();
+	float ChosenInterpolation = 0.0f;
+	CurrentChosenPoseId = GetChannelPoseId(BlendChannels.Last(), TimeSinceMotionChosen, ChosenInterpolation);
+
+	//====== Determine the next dominant pose ========
+	const FAnimChannelState& DominantChannel = BlendChannels[DominantBlendChannel];
+	const float TimePassed = TransitionMethod == ETransitionMethod::Blend ? DominantChannel.Age : TimeSinceMotionChosen;
+
+	UMotionDataAsset* DominantMotionData = GetChannelMotionData(DominantChannel);
+	const int32 MaxPoseIndex = DominantMotionData->Poses.Num() - 1;
+	const int32 BeforePoseId = GetChannelPoseId(DominantChannel, TimePassed, PoseInterpolationValue);
 
-	float ChosenClipLength = 0.0f;
-	switch (ChosenChannel.AnimType)
+	OutBeforePose = &DominantMotionData->Poses[BeforePoseId];
+	OutAfterPose = &DominantMotionData->Poses[FMath::Clamp(OutBeforePose->NextPoseId, 0, MaxPoseIndex)];
+}
+
+void FAnimNode_MotionMatching::ComputeCurrentPose()
+{
+	FPoseMotionData* BeforePose = nullptr;
+	FPoseMotionData* AfterPose = nullptr;
+	ComputeChannelPoses(BeforePose, AfterPose);
+
+	FMotionMatchingUtils::LerpPose(CurrentInterpolatedPose, *BeforePose, *AfterPose, PoseInterpolationValue);
+}
+
+void FAnimNode_MotionMatching::ComputeCurrentPose(const FCachedMotionPose& CachedMotionPose)
+{
+	FPoseMotionData* BeforePose = nullptr;
+	FPoseMotionData* AfterPose = nullptr;
+	ComputeChannelPoses(BeforePose, AfterPose);
+	
+	FMotionMatchingUtils::LerpPoseTrajectory(CurrentInterpolatedPose, *BeforePose,
+		*AfterPose, PoseInterpolationValue);
+
+	for (int32 i = 0; i < PoseBoneRemap.Num(); ++i)
 	{
-		case EMotionAnimAssetType::Sequence: ChosenClipLength = MotionData->GetSourceAnimAtIndex(ChosenChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::BlendSpace: ChosenClipLength = MotionData->GetSourceBlendSpaceAtIndex(ChosenChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::Composite: ChosenClipLength = MotionData->GetSourceCompositeAtIndex(ChosenChannel.AnimId).GetPlayLength(); break;
-		default: ;
+		const FCachedMotionBone& CachedMotionBone = CachedMotionPose.CachedBoneData[PoseBoneRemap[i]];
+		CurrentInterpolatedPose.JointData[i] = FJointData(CachedMotionBone.Transform.GetLocation(), CachedMotionBone.Velocity);
+	}
+}
+
+void FAnimNode_MotionMatching::SchedulePoseSearch(const FAnimationUpdateContext& Context, const bool bForceSynchronous /*= false*/)
+{
+	if (bBlendTrajectory)
+	{
+		ApplyTrajectoryBlending();
 	}
 
-	float TimePassed = TimeSinceMotionChosen;
-	int32 PoseIndex = ChosenChannel.StartPoseId;
+	const int32 MaxPoseId = ActiveMotionData->Poses.Num() - 1;
+	CurrentChosenPoseId = FMath::Clamp(CurrentChosenPoseId, 0, MaxPoseId); //Just in case
+	int32 NextPoseId = ActiveMotionData->Poses[CurrentChosenPoseId].NextPoseId;
+	if(NextPoseId < 0)
+	{
+		NextPoseId = CurrentChosenPoseId;
+	}
+	
+	FPoseMotionData& NextPose = ActiveMotionData->Poses[FMath::Clamp(NextPoseId, 0, MaxPoseId)];
 
-	float NewChosenTime = ChosenChannel.AnimTime;
-	if (ChosenChannel.AnimTime >= ChosenClipLength)
+	if (!bForcePoseSearch && bEnableToleranceTest)
 	{
-		if (ChosenChannel.bLoop)
-		{
-			NewChosenTime = FMotionMatchingUtils::WrapAnimationTime(NewChosenTime, ChosenClipLength);
-		}
-		else
+		if (NextPoseToleranceTest(NextPose))
 		{
-			const float TimeToNextClip = ChosenClipLength - (TimePassed + ChosenChannel.StartTime);
-
-			if (TimeToNextClip < PoseInterval / 2.0f)
+			if (FMotionMatchingSearchTelemetry::IsEnabled())
 			{
-				--PoseIndex;
+				FMotionMatchingSearchTelemetry::Get().RecordToleranceSkip(ActiveMotionData);
 			}
 
-			NewChosenTime = ChosenClipLength;
+			TimeSinceMotionUpdate = 0.0f;
+			return;
 		}
-
-		TimePassed = NewChosenTime - ChosenChannel.StartTime;
 	}
 
-	int32 NumPosesPassed = 0;
-	if (TimePassed < 0.0f)
+	if (!FinalCalibrationSets.Contains(RequiredTraits))
 	{
-		NumPosesPassed = FMath::CeilToInt(TimePassed / PoseInterval);
+		return;
 	}
-	else
+
+	//Deferred search. The result is validated and applied on a following update
+	if (bAsyncPoseSearch && !bForceSynchronous && !bForcePoseSearch)
 	{
-		NumPosesPassed = FMath::FloorToInt(TimePassed / PoseInterval); 
+		PendingSearch = MakeShared<FMotionMatchingAsyncSearch, ESPMode::ThreadSafe>();
+		BuildSearchQuery(PendingSearch->Query, NextPose);
+
+		TSharedPtr<FMotionMatchingAsyncSearch, ESPMode::ThreadSafe> Search = PendingSearch;
+		TArray<UMotionDataAsset*> SearchDatabases = Databases;
+		const bool bTrackRunnerUp = FMotionMatchingSearchTelemetry::IsEnabled();
+		PendingSearchTask = FFunctionGraphTask::CreateAndDispatchWhenReady([Search, SearchDatabases, bTrackRunnerUp]()
+		{
+			const FMotionMatchingSearchResult Result = GetLowestCostPose(SearchDatabases, Search->Query, nullptr,
+				bTrackRunnerUp ? &Search->ResultRunnerUpCost : nullptr, bTrackRunnerUp ? &Search->ResultStats : nullptr);
+
+			Search->ResultDatabaseId = Result.DatabaseId;
+			Search->ResultPoseId = Result.PoseId;
+		}, TStatId(), nullptr, ENamedThreads::AnyHiPriThreadNormalTask);
+
+		PendingSearchDispatchTime = FPlatformTime::Seconds();
+		return;
 	}
 
-	CurrentChosenPoseId = PoseIndex + NumPosesPassed;
+	BuildSearchQuery(SearchQuery, NextPose);
 
-	//====== Determine the next dominant pose ========
-	const FAnimChannelState& DominantChannel = BlendChannels[DominantBlendChannel];
+	TArray<FPoseMotionData>* PoseCandidates = nullptr;
+	float RunnerUpCost = -1.0f;
+	FMotionMatchingSearchStats SearchStats;
+	const bool bTelemetry = FMotionMatchingSearchTelemetry::IsEnabled();
+	const FMotionMatchingSearchResult Result = GetLowestCostPose(Databases, SearchQuery, &PoseCandidates,
+		bTelemetry ? &RunnerUpCost : nullptr, bTelemetry ? &SearchStats : nullptr);
+
+	RecordPoseSearch(SearchQuery, Result, RunnerUpCost, SearchStats);
+
+#if ENABLE_ANIM_DEBUG && ENABLE_DRAW_DEBUG
+	const int32 DebugLevel = CVarMMSearchDebug.GetValueOnAnyThread();
 
-	float DominantClipLength = 0.0f;
-	switch (ChosenChannel.AnimType)
+	if (DebugLevel == 1 && PoseCandidates)
 	{
-		case EMotionAnimAssetType::Sequence: DominantClipLength = MotionData->GetSourceAnimAtIndex(DominantChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::BlendSpace: DominantClipLength = MotionData->GetSourceBlendSpaceAtIndex(DominantChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::Composite: DominantClipLength = MotionData->GetSourceCompositeAtIndex(DominantChannel.AnimId).GetPlayLength(); break;
-		default: ;
-	}
+		HistoricalPosesSearchCounts.Add(PoseCandidates->Num());
+		HistoricalPosesSearchCounts.RemoveAt(0);
 
-	if (TransitionMethod == ETransitionMethod::Blend)
+		DrawCandidateTrajectories(PoseCandidates);
+	}
+	else if(DebugLevel == 2 && Result.DatabaseId == ActiveDatabaseId)
 	{
-		TimePassed = DominantChannel.Age;
+		PerformLinearSearchComparison(Context.AnimInstanceProxy, Result.PoseId, NextPose);
+	}
+#endif
+
+	ApplyPoseSearchResult(Result, Context);
+}
+
+void FAnimNode_MotionMatching::BuildSearchQuery(FMotionMatchingSearchQuery& OutQuery, const FPoseMotionData& NextPose)
+{
+	OutQuery.CurrentPose = CurrentInterpolatedPose;
+	OutQuery.DesiredTrajectory = DesiredTrajectory.TrajectoryPoints;
+	OutQuery.Calibration = FinalCalibrationSets[RequiredTraits];
+	OutQuery.RequiredTraits = RequiredTraits;
+	OutQuery.PoseMask = GetRequiredTraitPoseMask();
+	OutQuery.PoseMatchMethod = PoseMatchMethod;
+	OutQuery.NextPoseId = NextPose.PoseId;
+	OutQuery.OverridePoseMultiplier = (1.0f - OverrideQualityVsResponsivenessRatio) * 2.0f;
+	OutQuery.OverrideTrajectoryMultiplier = OverrideQualityVsResponsivenessRatio * 2.0f;
+	OutQuery.bFavourCurrentPose = bFavourCurrentPose;
+	OutQuery.CurrentPoseFavour = CurrentPoseFavour;
+	OutQuery.SeedRadius = bSeedPoseSearch ? SearchSeedRadius : INDEX_NONE;
+	OutQuery.DatabaseId = ActiveDatabaseId;
+	OutQuery.TransitionCount = TransitionCount;
+
+	if (Databases.Num() > 1)
+	{
+		OutQuery.DatabasePoseMasks = RequiredTraitPoseMasks;
 	}
 	else
 	{
-		TimePassed = TimeSinceMotionChosen;
+		OutQuery.DatabasePoseMasks.Reset();
 	}
+}
 
-	PoseIndex = DominantChannel.StartPoseId;
+void FAnimNode_MotionMatching::ApplyPoseSearchResult(const FMotionMatchingSearchResult& Result, const FAnimationUpdateContext& Context)
+{
+	UMotionDataAsset* BestMotionData = Databases[Result.DatabaseId];
+	const FPoseMotionData& BestPose = BestMotionData->Poses[Result.PoseId];
+	const FPoseMotionData& ChosenPose = ActiveMotionData->Poses[CurrentChosenPoseId];
 
-	//Determine if the new time is out of bounds of the dominant pose clip
-	float NewDominantTime = DominantChannel.StartTime + TimePassed;
-	if (NewDominantTime >= DominantClipLength)
-	{
-		if (DominantChannel.bLoop)
-		{
-			NewDominantTime = FMotionMatchingUtils::WrapAnimationTime(NewDominantTime, DominantClipLength);
-		}
-		else
-		{
-			const float TimeToNextClip = DominantClipLength - (TimePassed + DominantChannel.StartTime);
+	//Poses can only be at the same location if they come from the same database. The interpolated pose is taken from the
+	//dominant channel which can be from a different database to the chosen pose while blending
+	const bool bSameDominantDatabase = BlendChannels.IsValidIndex(DominantBlendChannel)
+		&& GetChannelMotionData(BlendChannels[DominantBlendChannel]) == BestMotionData;
 
-			if (TimeToNextClip < PoseInterval)
-			{
-				--PoseIndex;
-			}
+	bool bWinnerAtSameLocation = bSameDominantDatabase &&
+								 BestPose.AnimId == CurrentInterpolatedPose.AnimId &&
+								 BestPose.bMirrored == CurrentInterpolatedPose.bMirrored &&
+								FMath::Abs(BestPose.Time - CurrentInterpolatedPose.Time) < 0.25f
+								&& FVector2D::DistSquared(BestPose.BlendSpacePosition, CurrentInterpolatedPose.BlendSpacePosition) < 1.0f;
 
-			NewDominantTime = DominantClipLength;
-		}
+	
 
-		TimePassed = NewDominantTime - DominantChannel.StartTime;
+	if (!bWinnerAtSameLocation && Result.DatabaseId == ActiveDatabaseId)
+	{
+		bWinnerAtSameLocation = BestPose.AnimId == ChosenPose.AnimId &&
+								BestPose.bMirrored == ChosenPose.bMirrored &&
+								FMath::Abs(BestPose.Time - ChosenPose.Time) < 0.25f
+								&& FVector2D::DistSquared(BestPose.BlendSpacePosition, ChosenPose.BlendSpacePosition) < 1.0f;
 	}
 
-	if (TimePassed < -0.00001f)
+	if (!bWinnerAtSameLocation)
 	{
-		NumPosesPassed = FMath::CeilToInt(TimePassed / PoseInterval);
+		SetActiveDatabase(Result.DatabaseId);
+		TransitionToPose(BestPose.PoseId, Context);
 	}
-	else
+
+	if (FMotionMatchingSearchTelemetry::IsEnabled())
 	{
-		NumPosesPassed = FMath::CeilToInt(TimePassed / PoseInterval);
+		FMotionMatchingSearchTelemetry::Get().RecordOutcome(BestMotionData, !bWinnerAtSameLocation);
 	}
+}
 
-	PoseIndex = FMath::Clamp(PoseIndex + NumPosesPassed, 0, MotionData->Poses.Num());
-
-	//Get the before and after poses and then interpolate
-	FPoseMotionData* BeforePose;
-	FPoseMotionData* AfterPose;
-
-	if (TimePassed < -0.00001f)
+bool FAnimNode_MotionMatching::ResolveAsyncPoseSearch(const FAnimationUpdateContext& Context)
+{
+	if (!PendingSearchTask->IsComplete())
 	{
-		AfterPose = &MotionData->Poses[PoseIndex];
-		BeforePose = &MotionData->Poses[FMath::Clamp(AfterPose->LastPoseId, 0, MotionData->Poses.Num() - 1)];
+		if (FPlatformTime::Seconds() - PendingSearchDispatchTime < AsyncSearchDeadline)
+		{
+			return false;
+		}
 
-		PoseInterpolationValue = 1.0f - FMath::Abs((TimePassed / PoseInterval) - (float)NumPosesPassed);
+		//The search missed its deadline. Leave it to finish on its own and search synchronously with the current state instead
+		DetachAsyncPoseSearch();
+		TimeSinceMotionUpdate = 0.0f;
+		SchedulePoseSearch(Context, true);
+		return true;
 	}
-	else
+
+	const FMotionMatchingAsyncSearch& Search = *PendingSearch;
+	const FMotionMatchingSearchResult Result(Search.ResultDatabaseId, Search.ResultPoseId, 0.0f);
+
+	//The result is only valid if the node hasn't changed pose or traits since the query was made
+	const bool bValidResult = Search.Query.TransitionCount == TransitionCount
+		&& Search.Query.RequiredTraits == RequiredTraits
+		&& Databases.IsValidIndex(Result.DatabaseId)
+		&& Databases[Result.DatabaseId]->Poses.IsValidIndex(Result.PoseId)
+		&& !Databases[Result.DatabaseId]->Poses[Result.PoseId].bDoNotUse;
+
+	if (bValidResult)
 	{
-		BeforePose = &MotionData->Poses[FMath::Min(PoseIndex, MotionData->Poses.Num() - 2)];
-		AfterPose = &MotionData->Poses[BeforePose->NextPoseId];
+		RecordPoseSearch(Search.Query, Result, Search.ResultRunnerUpCost, Search.ResultStats);
+	}
+
+	PendingSearch.Reset();
+	PendingSearchTask = nullptr;
 
-		PoseInterpolationValue = (TimePassed / PoseInterval) - (float)NumPosesPassed;
+	if (bValidResult)
+	{
+		ApplyPoseSearchResult(Result, Context);
 	}
 
-	FMotionMatchingUtils::LerpPose(CurrentInterpolatedPose, *BeforePose, *AfterPose, PoseInterpolationValue);
+	return true;
 }
 
-void FAnimNode_MotionMatching::ComputeCurrentPose(const FCachedMotionPose& CachedMotionPose)
+void FAnimNode_MotionMatching::RecordPoseSearch(const FMotionMatchingSearchQuery& Query, const FMotionMatchingSearchResult& Result, const float RunnerUpCost,
+	const FMotionMatchingSearchStats& SearchStats)
 {
-	const float PoseInterval = FMath::Max(0.01f, MotionData->PoseInterval);
+	const bool bTelemetry = FMotionMatchingSearchTelemetry::IsEnabled();
 
-	//====== Determine the next chosen pose ========
-	const FAnimChannelState& ChosenChannel = BlendChannels.Last();
+	//Query logs are replayed against a single database
+	const bool bRecordQuery = CVarMMSearchRecord.GetValueOnAnyThread() > 0 && Databases.Num() == 1;
 
-	float ChosenClipLength = 0.0f;
-	switch (ChosenChannel.AnimType)
+	if (!bRecordQuery)
 	{
-		case EMotionAnimAssetType::Sequence: ChosenClipLength = MotionData->GetSourceAnimAtIndex(ChosenChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::BlendSpace: ChosenClipLength = MotionData->GetSourceBlendSpaceAtIndex(ChosenChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::Composite: ChosenClipLength = MotionData->GetSourceCompositeAtIndex(ChosenChannel.AnimId).GetPlayLength(); break;
-		default: ;
+		QueryRecorder.Reset();
 	}
 
-	float TimePassed = TimeSinceMotionChosen;
-	int32 PoseIndex = ChosenChannel.StartPoseId;
+	if (!bTelemetry && !bRecordQuery)
+	{
+		return;
+	}
 
-	float NewChosenTime = ChosenChannel.AnimTime;
-	if (ChosenChannel.AnimTime >= ChosenClipLength)
+	UMotionDataAsset* ResultMotionData = Databases[Result.DatabaseId];
+	const int32 ChosenPoseId = Result.PoseId;
+
+	//The natural next pose of the query is only favoured within its own database
+	FMotionMatchingCostBreakdown CostBreakdown;
+	if (Result.DatabaseId == Query.DatabaseId)
 	{
-		if (ChosenChannel.bLoop)
-		{
-			NewChosenTime = FMotionMatchingUtils::WrapAnimationTime(NewChosenTime, ChosenClipLength);
-		}
-		else
-		{
-			const float TimeToNextClip = ChosenClipLength - (TimePassed + ChosenChannel.StartTime);
+		ComputePoseSearchCostBreakdown(ResultMotionData, Query, ChosenPoseId, CostBreakdown);
+	}
+	else
+	{
+		FMotionMatchingSearchQuery DatabaseQuery = Query;
+		DatabaseQuery.NextPoseId = INDEX_NONE;
+		ComputePoseSearchCostBreakdown(ResultMotionData, DatabaseQuery, ChosenPoseId, CostBreakdown);
+	}
 
-			if (TimeToNextClip < PoseInterval / 2.0f)
-			{
-				--PoseIndex;
-			}
+	if (bTelemetry)
+	{
+		FMotionMatchingSearchTelemetry::Get().RecordSearch(ResultMotionData, CostBreakdown, RunnerUpCost);
+		FMotionMatchingSearchTelemetry::Get().RecordSearchStats(MotionData, SearchStats);
+	}
 
-			NewChosenTime = ChosenClipLength;
+	if (bRecordQuery)
+	{
+		if (!QueryRecorder.IsValid())
+		{
+			QueryRecorder = MakeShared<FMotionMatchingQueryRecorder>(FMotionMatchingQueryLog::MakeLogFileName(MotionData), MotionData, UserCalibration);
 		}
 
-		TimePassed = NewChosenTime - ChosenChannel.StartTime;
+		QueryRecorder->Record(Query, CurrentChosenPoseId, ChosenPoseId, CostBreakdown.Total);
 	}
+}
 
-	int32 NumPosesPassed = 0;
-	if (TimePassed < 0.0f)
+void FAnimNode_MotionMatching::CancelAsyncPoseSearch()
+{
+	if (PendingSearchTask.IsValid())
 	{
-		NumPosesPassed = FMath::CeilToInt(TimePassed / PoseInterval);
+		//The task references the motion data so it must finish before the node is torn down or re-initialised
+		FTaskGraphInterface::Get().WaitUntilTaskCompletes(PendingSearchTask);
 	}
-	else
+
+	if (DetachedSearchTasks.Num() > 0)
 	{
-		NumPosesPassed = FMath::FloorToInt(TimePassed / PoseInterval);
+		FTaskGraphInterface::Get().WaitUntilTasksComplete(DetachedSearchTasks);
+		DetachedSearchTasks.Reset();
 	}
-	
-	CurrentChosenPoseId = PoseIndex + NumPosesPassed;
 
-	//====== Determine the next dominant pose ========
-	const FAnimChannelState& DominantChannel = BlendChannels[DominantBlendChannel];
+	PendingSearch.Reset();
+	PendingSearchTask = nullptr;
+}
 
-	float DominantClipLength = 0.0f;
-	switch (ChosenChannel.AnimType)
+void FAnimNode_MotionMatching::DetachAsyncPoseSearch()
+{
+	//The task only holds its own copy of the query, result and database list through the shared search state,
+	//so it can be left to finish in the background without blocking the anim thread. Its result is discarded.
+	DetachedSearchTasks.RemoveAllSwap([](const FGraphEventRef& Task) { return Task->IsComplete(); });
+
+	if (PendingSearchTask.IsValid() && !PendingSearchTask->IsComplete())
 	{
-		case EMotionAnimAssetType::Sequence: DominantClipLength = MotionData->GetSourceAnimAtIndex(DominantChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::BlendSpace: DominantClipLength = MotionData->GetSourceBlendSpaceAtIndex(DominantChannel.AnimId).GetPlayLength(); break;
-		case EMotionAnimAssetType::Composite: DominantClipLength = MotionData->GetSourceCompositeAtIndex(DominantChannel.AnimId).GetPlayLength(); break;
-		default: ;
+		DetachedSearchTasks.Add(PendingSearchTask);
 	}
 
-	if (TransitionMethod == ETransitionMethod::Blend)
+	PendingSearch.Reset();
+	PendingSearchTask = nullptr;
+}
+
+void FAnimNode_MotionMatching::ScheduleTransitionPoseSearch(const FAnimationUpdateContext & Context)
+{
+	FMotionMatchingSearchResult Result(0, 0, 0.0f);
+	if (FinalCalibrationSets.Contains(RequiredTraits))
 	{
-		TimePassed = DominantChannel.Age;
+		//The current pose comes from outside the node so there is no natural next pose to favour or seed around
+		BuildSearchQuery(SearchQuery, CurrentInterpolatedPose);
+		SearchQuery.NextPoseId = INDEX_NONE;
+		SearchQuery.bFavourCurrentPose = false;
+
+		Result = GetLowestCostPose(Databases, SearchQuery);
 	}
-	else
+
+	if (!Databases.IsValidIndex(Result.DatabaseId) || !Databases[Result.DatabaseId]->Poses.IsValidIndex(Result.PoseId))
 	{
-		TimePassed = TimeSinceMotionChosen;
+		Result = FMotionMatchingSearchResult(0, 0, 0.0f);
 	}
 
-	PoseIndex = DominantChannel.StartPoseId;
+	SetActiveDatabase(Result.DatabaseId);
+	JumpToPose(Result.PoseId);
+}
+
+FMotionMatchingSearchResult FAnimNode_MotionMatching::GetLowestCostPose(const TArray<UMotionDataAsset*>& InDatabases, 
+	FMotionMatchingSearchQuery& Query, TArray<FPoseMotionData>** OutPoseCandidates /*= nullptr*/, 
+	float* OutRunnerUpCost /*= nullptr*/, FMotionMatchingSearchStats* OutStats /*= nullptr*/)
+{
+	//The database of the current pose is searched first. Its natural next pose and seeds give the tightest early out cost
+	const int32 QueryDatabaseId = InDatabases.IsValidIndex(Query.DatabaseId) ? Query.DatabaseId : 0;
+	UMotionDataAsset* QueryMotionData = InDatabases[QueryDatabaseId];
+
+	Query.SearchDatabaseId = INDEX_NONE;
 
-	//Determine if the new time is out of bounds of the dominant pose clip
-	float NewDominantTime = DominantChannel.StartTime + TimePassed;
-	if (NewDominantTime >= DominantClipLength)
+	FMotionMatchingSearchResult Result;
+	Result.DatabaseId = QueryDatabaseId;
+	Result.PoseId = GetLowestCostPoseId(QueryMotionData, Query, OutPoseCandidates, OutRunnerUpCost, OutStats);
+
+	if (InDatabases.Num() < 2)
 	{
-		if (DominantChannel.bLoop)
+		return Result;
+	}
+
+	Result.Cost = ComputePoseSearchCost(QueryMotionData, Query, Result.PoseId);
+
+	//Every other database with searchable poses is ordered by the lower bound of its search cost
+	TArray<TPair<float, int32>, TInlineAllocator<8>> DatabaseBounds;
+	for (int32 DatabaseId = 0; DatabaseId < InDatabases.Num(); ++DatabaseId)
+	{
+		if (DatabaseId == QueryDatabaseId 
+			|| !Query.DatabasePoseMasks.IsValidIndex(DatabaseId))
 		{
-			NewDominantTime = FMotionMatchingUtils::WrapAnimationTime(NewDominantTime, DominantClipLength);
+			continue;
 		}
-		else
-		{
-			const float TimeToNextClip = DominantClipLength - (TimePassed + DominantChannel.StartTime);
 
-			if (TimeToNextClip < PoseInterval)
+		const TArray<uint64>& PoseMask = Query.DatabasePoseMasks[DatabaseId];
+		bool bHasPoses = false;
+		for (const uint64 PoseWord : PoseMask)
+		{
+			if (PoseWord != 0)
 			{
-				--PoseIndex;
+				bHasPoses = true;
+				break;
 			}
+		}
 
-			NewDominantTime = DominantClipLength;
+		if (!bHasPoses)
+		{
+			continue;
 		}
 
-		TimePassed = NewDominantTime - DominantChannel.StartTime;
-	}
+		const FMotionFeatureBounds* Bounds = InDatabases[DatabaseId]->FindFeatureBounds(Query.RequiredTraits);
+		const float LowerBound = Bounds ? Bounds->ComputeLowerBound(Query.CurrentPose, Query.DesiredTrajectory, Query.Calibration,
+			Query.OverridePoseMultiplier, Query.OverrideTrajectoryMultiplier) : 0.0f;
 
-	if (TimePassed < -0.00001f)
-	{
-		NumPosesPassed = FMath::CeilToInt(TimePassed / PoseInterval);
+		DatabaseBounds.Emplace(LowerBound, DatabaseId);
 	}
-	else
+
+	DatabaseBounds.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	for (int32 i = 0; i < DatabaseBounds.Num(); ++i)
 	{
-		NumPosesPassed = FMath::CeilToInt(TimePassed / PoseInterval);
-	}
+		//With telemetry on the runner up must be correct too so databases are only skipped if they can't beat it
+		const float EarlyOutCost = OutRunnerUpCost ? *OutRunnerUpCost : Result.Cost;
+		if (DatabaseBounds[i].Key >= EarlyOutCost)
+		{
+			if (OutStats)
+			{
+				OutStats->SkippedDatabaseCount += DatabaseBounds.Num() - i;
+			}
 
-	const int32 MaxPoseIndex = MotionData->Poses.Num() - 1;
-	PoseIndex = FMath::Clamp(PoseIndex + NumPosesPassed, 0, MaxPoseIndex);
+			break;
+		}
 
-	//Get the before and after poses and then interpolate
-	FPoseMotionData* BeforePose;
-	FPoseMotionData* AfterPose;
+		const int32 DatabaseId = DatabaseBounds[i].Value;
+		UMotionDataAsset* DatabaseMotionData = InDatabases[DatabaseId];
 
-	if (TimePassed < -0.00001f)
-	{
-		AfterPose = &MotionData->Poses[PoseIndex];
-		BeforePose = &MotionData->Poses[FMath::Clamp(AfterPose->LastPoseId, 0, MaxPoseIndex)];
+		//The natural next pose and its seeds only exist in the query's database
+		Query.SearchDatabaseId = DatabaseId;
 
-		PoseInterpolationValue = 1.0f - FMath::Abs((TimePassed / PoseInterval) - (float)NumPosesPassed);
-	}
-	else
-	{
-		BeforePose = &MotionData->Poses[FMath::Min(PoseIndex, MotionData->Poses.Num() - 2)];
-		AfterPose = &MotionData->Poses[FMath::Clamp(BeforePose->NextPoseId, 0, MaxPoseIndex)];
+		float DatabaseRunnerUpCost = 10000000.0f;
+		TArray<FPoseMotionData>* DatabasePoseCandidates = nullptr;
+		FMotionMatchingSearchStats DatabaseStats;
+		const int32 DatabasePoseId = GetLowestCostPoseId(DatabaseMotionData, Query, &DatabasePoseCandidates,
+			OutRunnerUpCost ? &DatabaseRunnerUpCost : nullptr, OutStats ? &DatabaseStats : nullptr);
 
-		PoseInterpolationValue = (TimePassed / PoseInterval) - (float)NumPosesPassed;
-	}
-	
-	FMotionMatchingUtils::LerpPoseTrajectory(CurrentInterpolatedPose, *BeforePose,
-		*AfterPose, FMath::Clamp(PoseInterpolationValue, 0.0f, 1.0f));
+		if (OutStats)
+		{
+			OutStats->Accumulate(DatabaseStats);
+		}
 
-	UMotionMatchConfig* MMConfig = MotionData->MotionMatchConfig;
+		const float DatabaseCost = ComputePoseSearchCost(DatabaseMotionData, Query, DatabasePoseId);
+		if (DatabaseCost < Result.Cost)
+		{
+			if (OutRunnerUpCost)
+			{
+				*OutRunnerUpCost = FMath::Min(Result.Cost, DatabaseRunnerUpCost);
+			}
 
-	for (int32 i = 0; i < PoseBoneRemap.Num(); ++i)
-	{
-		const FCachedMotionBone& CachedMotionBone = CachedMotionPose.CachedBoneData[PoseBoneRemap[i]];
-		CurrentInterpolatedPose.JointData[i] = FJointData(CachedMotionBone.Transform.GetLocation(), CachedMotionBone.Velocity);
+			if (OutPoseCandidates)
+			{
+				*OutPoseCandidates = DatabasePoseCandidates;
+			}
+
+			Result = FMotionMatchingSearchResult(DatabaseId, DatabasePoseId, DatabaseCost);
+		}
+		else if (OutRunnerUpCost)
+		{
+			*OutRunnerUpCost = FMath::Min(*OutRunnerUpCost, DatabaseCost);
+		}
 	}
+
+	Query.SearchDatabaseId = INDEX_NONE;
+
+	return Result;
 }
 
-void FAnimNode_MotionMatching::SchedulePoseSearch(const FAnimationUpdateContext& Context)
+int32 FAnimNode_MotionMatching::GetLowestCostPoseId(UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+	TArray<FPoseMotionData>** OutPoseCandidates /*= nullptr*/, float* OutRunnerUpCost /*= nullptr*/, 
+	FMotionMatchingSearchStats* OutStats /*= nullptr*/)
 {
-	if (bBlendTrajectory)
+	if (Query.PoseMatchMethod == EPoseMatchMethod::PCAPrefiltered)
 	{
-		ApplyTrajectoryBlending();
+		const int32 LowestPoseId = GetLowestCostPoseId_PCA(InMotionData, Query, OutRunnerUpCost, OutStats);
+		return LowestPoseId != INDEX_NONE ? LowestPoseId : GetLowestCostPoseId_Linear(InMotionData, Query, OutRunnerUpCost, OutStats);
 	}
 
-	const int32 MaxPoseId = MotionData->Poses.Num() - 1;
-	CurrentChosenPoseId = FMath::Clamp(CurrentChosenPoseId, 0, MaxPoseId); //Just in case
-	int32 NextPoseId = MotionData->Poses[CurrentChosenPoseId].NextPoseId;
-	if(NextPoseId < 0)
+	if (Query.PoseMatchMethod == EPoseMatchMethod::Linear || !InMotionData->OptimisationModule)
 	{
-		NextPoseId = CurrentChosenPoseId;
+		return GetLowestCostPoseId_Linear(InMotionData, Query, OutRunnerUpCost, OutStats);
 	}
-	
-	FPoseMotionData& NextPose = MotionData->Poses[FMath::Clamp(NextPoseId, 0, MaxPoseId)];
 
-	if (!bForcePoseSearch && bEnableToleranceTest)
+	const FCalibrationData& FinalCalibration = Query.Calibration;
+	const FPoseMotionData& CurrentPose = Query.CurrentPose;
+
+	//Modules which filter down to poses of the motion data return their ids rather than copies. The ids are consumed
+	//before returning so per thread scratch is safe across databases.
+	static thread_local TArray<int32> CandidatePoseIds;
+	TArray<FPoseMotionData>* PoseCandidates = nullptr;
+	if (!InMotionData->OptimisationModule->GetFilteredPoseIds(CurrentPose, Query.DesiredTrajectory, Query.RequiredTraits, 
+		FinalCalibration, CandidatePoseIds))
 	{
-		if (NextPoseToleranceTest(NextPose))
+		CandidatePoseIds.Reset();
+		PoseCandidates = InMotionData->OptimisationModule->GetFilteredPoseListWithTrajectory(CurrentPose,
+			Query.DesiredTrajectory, Query.RequiredTraits, FinalCalibration);
+
+		if (!PoseCandidates)
 		{
-			TimeSinceMotionUpdate = 0.0f;
-			return;
+			return GetLowestCostPoseId_Linear(InMotionData, Query, OutRunnerUpCost, OutStats);
+		}
+
+		if (OutPoseCandidates)
+		{
+			*OutPoseCandidates = PoseCandidates;
 		}
 	}
 
-	int32 LowestPoseId = NextPose.PoseId;
+	const int32 PoseCandidateCount = PoseCandidates ? PoseCandidates->Num() : CandidatePoseIds.Num();
+	const FPoseMotionData* const AllPoses = InMotionData->Poses.GetData();
 
-	switch (PoseMatchMethod)
-	{
-		case EPoseMatchMethod::Optimized: { LowestPoseId = GetLowestCostPoseId(NextPose); } break;
-		case EPoseMatchMethod::Linear: { LowestPoseId = GetLowestCostPoseId_Linear(NextPose); } break;
-	}
+	//Seeding with the poses around the natural next pose tightens the early outs from the first candidate
+	TArray<int32, TInlineAllocator<16>> SeedPoseIds;
+	float LowestCost = 10000000.0f;
+	float RunnerUpCost = 10000000.0f;
+	const int32 SeedPoseId = SeedPoseSearch(InMotionData, Query, SeedPoseIds, LowestCost, RunnerUpCost);
+	int32 LowestPoseId = SeedPoseId != INDEX_NONE ? SeedPoseId : 0;
+	int32 CandidateCount = 0;
+	int32 CostedCount = 0;
+	int32 RejectedGroupCount = 0;
+
+	EMotionFeatureGroup GroupOrder[(int32)EMotionFeatureGroup::Count];
+	FinalCalibration.GetFeatureGroupOrder(GroupOrder);
+	const int32 LastGroupIndex = (int32)EMotionFeatureGroup::Count - 1;
+
+	//Early outs must be against the runner up if it is being tracked for telemetry
+	const float& EarlyOutCost = OutRunnerUpCost ? RunnerUpCost : LowestCost;
+	for (int32 CandidateIndex = 0; CandidateIndex < PoseCandidateCount; ++CandidateIndex)
+	{
+		const FPoseMotionData& Pose = PoseCandidates ? (*PoseCandidates)[CandidateIndex] : AllPoses[CandidatePoseIds[CandidateIndex]];
+		++CandidateCount;
+
+		//Feature groups are costed most discriminative first with an early out after each one but the last
+		const FVector4 Momentum(Pose.LocalVelocity, Pose.RotationalVelocity);
+		float Cost = 0.0f;
+		int32 GroupIndex = 0;
+		for (; GroupIndex < LastGroupIndex; ++GroupIndex)
+		{
+			Cost += ComputeFeatureGroupCost(GroupOrder[GroupIndex], Query, Momentum, Pose);
 
-#if ENABLE_ANIM_DEBUG && ENABLE_DRAW_DEBUG
-	const int32 DebugLevel = CVarMMSearchDebug.GetValueOnAnyThread();
+			if (Cost > EarlyOutCost)
+			{
+				break;
+			}
+		}
 
-	if(DebugLevel == 2)
-	{
-		PerformLinearSearchComparison(Context.AnimInstanceProxy, LowestPoseId, NextPose);
-	}
-#endif
+		if (GroupIndex < LastGroupIndex)
+		{
+			RejectedGroupCount += GroupIndex + 1;
+			continue; //Early Out
+		}
 
-	const FPoseMotionData& BestPose = MotionData->Poses[LowestPoseId];
-	const FPoseMotionData& ChosenPose = MotionData->Poses[CurrentChosenPoseId];
+		++CostedCount;
 
-	bool bWinnerAtSameLocation = BestPose.AnimId == CurrentInterpolatedPose.AnimId &&
-								 BestPose.bMirrored == CurrentInterpolatedPose.bMirrored &&
-								FMath::Abs(BestPose.Time - CurrentInterpolatedPose.Time) < 0.25f
-								&& FVector2D::DistSquared(BestPose.BlendSpacePosition, CurrentInterpolatedPose.BlendSpacePosition) < 1.0f;
+		Cost += ComputeFeatureGroupCost(GroupOrder[LastGroupIndex], Query, Momentum, Pose);
 
-	
+		//Favour Current Pose
+		if (Query.bFavourCurrentPose && Pose.PoseId == Query.GetSearchNextPoseId())
+		{
+			Cost *= Query.CurrentPoseFavour;
+		}
 
-	if (!bWinnerAtSameLocation)
-	{
-		bWinnerAtSameLocation = BestPose.AnimId == ChosenPose.AnimId &&
-								BestPose.bMirrored == ChosenPose.bMirrored &&
-								FMath::Abs(BestPose.Time - ChosenPose.Time) < 0.25f
-								&& FVector2D::DistSquared(BestPose.BlendSpacePosition, ChosenPose.BlendSpacePosition) < 1.0f;
+		//Apply Pose Favour
+		Cost *= Pose.Favour;
+
+		//Seed poses have already been costed. Not counting them twice keeps the runner up a different pose
+		if (Cost < RunnerUpCost && !SeedPoseIds.Contains(Pose.PoseId))
+		{
+			if (Cost < LowestCost)
+			{
+				RunnerUpCost = LowestCost;
+				LowestCost = Cost;
+				LowestPoseId = Pose.PoseId;
+			}
+			else
+			{
+				RunnerUpCost = Cost;
+			}
+		}
 	}
 
-	if (!bWinnerAtSameLocation)
+	if (OutRunnerUpCost)
 	{
-		TransitionToPose(BestPose.PoseId, Context);
+		*OutRunnerUpCost = RunnerUpCost;
 	}
-}
 
-void FAnimNode_MotionMatching::ScheduleTransitionPoseSearch(const FAnimationUpdateContext & Context)
-{
-	int32 LowestPoseId = GetLowestCostPoseId();
+	if (OutStats)
+	{
+		OutStats->SeedCount = SeedPoseIds.Num();
+		OutStats->CandidateCount = CandidateCount;
+		OutStats->CostedCount = CostedCount;
+		OutStats->RejectedGroupCount = RejectedGroupCount;
+	}
 
-	LowestPoseId = FMath::Clamp(LowestPoseId, 0, MotionData->Poses.Num() - 1);
-	JumpToPose(LowestPoseId);
+	return LowestPoseId;
 }
 
-int32 FAnimNode_MotionMatching::GetLowestCostPoseId()
+int32 FAnimNode_MotionMatching::GetLowestCostPoseId_Linear(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+	float* OutRunnerUpCost /*= nullptr*/, FMotionMatchingSearchStats* OutStats /*= nullptr*/)
 {
-	if (!FinalCalibrationSets.Contains(RequiredTraits))
-	{
-		return CurrentChosenPoseId;
-	}
+	const FCalibrationData& FinalCalibration = Query.Calibration;
 
-	const FCalibrationData& FinalCalibration = FinalCalibrationSets[RequiredTraits];
+	//The candidates with the required traits are one contiguous range of the trait search index
+	int32 SearchStart = 0;
+	int32 SearchEnd = 0;
+	InMotionData->GetTraitSearchRange(Query.RequiredTraits, SearchStart, SearchEnd);
+	const int32* SearchPoseIds = InMotionData->TraitSearchPoseIds.GetData();
+	const FVector4* SearchMomenta = InMotionData->TraitSearchMomenta.GetData();
 
-	int32 LowestPoseId = 0;
+	//Seeding with the poses around the natural next pose tightens the early outs from the first candidate
+	TArray<int32, TInlineAllocator<16>> SeedPoseIds;
 	float LowestCost = 10000000.0f;
-	for (FPoseMotionData& Pose : MotionData->Poses)
-	{
-		if (Pose.bDoNotUse 
-		 && Pose.Traits != RequiredTraits)
+	float RunnerUpCost = 10000000.0f;
+	const int32 SeedPoseId = SeedPoseSearch(InMotionData, Query, SeedPoseIds, LowestCost, RunnerUpCost);
+	int32 LowestPoseId = SeedPoseId != INDEX_NONE ? SeedPoseId : 0;
+	int32 CandidateCount = 0;
+	int32 CostedCount = 0;
+	int32 RejectedGroupCount = 0;
+
+	EMotionFeatureGroup GroupOrder[(int32)EMotionFeatureGroup::Count];
+	FinalCalibration.GetFeatureGroupOrder(GroupOrder);
+	const int32 LastGroupIndex = (int32)EMotionFeatureGroup::Count - 1;
+
+	//Early outs must be against the runner up if it is being tracked for telemetry
+	const float& EarlyOutCost = OutRunnerUpCost ? RunnerUpCost : LowestCost;
+	for (int32 SearchIndex = SearchStart; SearchIndex < SearchEnd; ++SearchIndex)
+	{
+		++CandidateCount;
+
+		//The pose itself is only read by the trajectory and joint groups. Momentum comes from the dense trait search momenta
+		const FVector4& Momentum = SearchMomenta[SearchIndex];
+		const int32 PoseId = SearchPoseIds[SearchIndex];
+		const FPoseMotionData& Pose = InMotionData->Poses[PoseId];
+
+		//Feature groups are costed most discriminative first with an early out after each one but the last
+		float Cost = 0.0f;
+		int32 GroupIndex = 0;
+		for (; GroupIndex < LastGroupIndex; ++GroupIndex)
 		{
-			continue;
-		}
+			Cost += ComputeFeatureGroupCost(GroupOrder[GroupIndex], Query, Momentum, Pose);
 
-		float Cost = FMotionMatchingUtils::ComputeTrajectoryCost(DesiredTrajectory.TrajectoryPoints,
-		                                                         Pose.Trajectory, FinalCalibration);
+			if (Cost > EarlyOutCost)
+			{
+				break;
+			}
+		}
 
-		Cost += FMotionMatchingUtils::ComputePoseCost(CurrentInterpolatedPose.JointData,
-			Pose.JointData, FinalCalibration);
+		if (GroupIndex < LastGroupIndex)
+		{
+			RejectedGroupCount += GroupIndex + 1;
+			continue; //Early out
+		}
 
-		Cost += FVector::DistSquared(CurrentInterpolatedPose.LocalVelocity, Pose.LocalVelocity) * FinalCalibration.Weight_Momentum;
+		++CostedCount;
 
+		Cost += ComputeFeatureGroupCost(GroupOrder[LastGroupIndex], Query, Momentum, Pose);
+		
+		//Pose Favour
 		Cost *= Pose.Favour;
 
-		if (Cost < LowestCost)
+		//Favour Current Pose
+		if (Query.bFavourCurrentPose && Pose.PoseId == Query.GetSearchNextPoseId())
 		{
-			LowestCost = Cost;
-			LowestPoseId = Pose.PoseId;
+			Cost *= Query.CurrentPoseFavour;
+		}
+
+		//Seed poses have already been costed. Not counting them twice keeps the runner up a different pose
+		if (Cost < RunnerUpCost && !SeedPoseIds.Contains(PoseId))
+		{
+			if (Cost < LowestCost)
+			{
+				RunnerUpCost = LowestCost;
+				LowestCost = Cost;
+				LowestPoseId = Pose.PoseId;
+			}
+			else
+			{
+				RunnerUpCost = Cost;
+			}
 		}
 	}
 
+	if (OutRunnerUpCost)
+	{
+		*OutRunnerUpCost = RunnerUpCost;
+	}
+
+	if (OutStats)
+	{
+		OutStats->SeedCount = SeedPoseIds.Num();
+		OutStats->CandidateCount = CandidateCount;
+		OutStats->CostedCount = CostedCount;
+		OutStats->RejectedGroupCount = RejectedGroupCount;
+	}
+
 	return LowestPoseId;
 }
 
-int32 FAnimNode_MotionMatching::GetLowestCostPoseId(const FPoseMotionData& NextPose)
+int32 FAnimNode_MotionMatching::GetLowestCostPoseId_PCA(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+	float* OutRunnerUpCost /*= nullptr*/, FMotionMatchingSearchStats* OutStats /*= nullptr*/)
 {
-	if (!FinalCalibrationSets.Contains(RequiredTraits))
+	const FPoseFeaturePCA* PCA = InMotionData->FindPCAPrefilter(Query.RequiredTraits);
+	if (!PCA)
 	{
-		return CurrentChosenPoseId;
+		return INDEX_NONE;
 	}
 
-	const FCalibrationData& FinalCalibration = FinalCalibrationSets[RequiredTraits];
-
-	TArray<FPoseMotionData>* PoseCandidates = MotionData->OptimisationModule->GetFilteredPoseList(CurrentInterpolatedPose, RequiredTraits, FinalCalibration);
-
-	if (!PoseCandidates)
+	TArray<float, TInlineAllocator<64>> QueryCoordinates;
+	QueryCoordinates.SetNumUninitialized(PCA->Dimensions);
+	if (!PCA->Project(Query.CurrentPose.LocalVelocity, Query.CurrentPose.JointData, Query.DesiredTrajectory, QueryCoordinates.GetData()))
 	{
-		return GetLowestCostPoseId_Linear(NextPose);
+		return INDEX_NONE;
 	}
 
-	const float OverridePoseMultiplier = (1.0f - OverrideQualityVsResponsivenessRatio) * 2.0f;
-	const float OverrideTrajectoryMultiplier = OverrideQualityVsResponsivenessRatio * 2.0f;
+	//The squared distance in the reduced space scaled by this is never more than the squared distance part of the exact cost
+	const float LowerBoundScale = PCA->GetLowerBoundScale(Query.Calibration, Query.OverridePoseMultiplier, Query.OverrideTrajectoryMultiplier);
+	const int32 Dimensions = PCA->Dimensions;
+	const int32 PoseCount = PCA->PoseIds.Num();
 
-	int32 LowestPoseId = 0;
-	float LowestCost = 10000000.0f;
-	for (FPoseMotionData& Pose : *PoseCandidates)
-	{
-		//Body Momentum
-		float Cost = FVector::DistSquared(CurrentInterpolatedPose.LocalVelocity, Pose.LocalVelocity)
-			* FinalCalibration.Weight_Momentum * OverridePoseMultiplier;
+	//First pass: lower bounds for every pose in the reduced space. Searches can run on worker threads so the scratch is 
+	//per thread. It is consumed before returning
+	static thread_local TArray<float> LowerBounds;
+	LowerBounds.SetNumUninitialized(PoseCount, false);
 
-		//Body Rotational Momentum
-		Cost += FMath::Abs(CurrentInterpolatedPose.RotationalVelocity - Pose.RotationalVelocity)
-			* FinalCalibration.Weight_AngularMomentum * OverridePoseMultiplier;
+	int32 MinBoundIndex = 0;
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		const float* PoseCoordinates = &PCA->Coordinates[i * Dimensions];
 
-		if(Cost > LowestCost) 
+		float Distance = 0.0f;
+		for (int32 d = 0; d < Dimensions; ++d)
 		{
-			continue; //Early Out
+			Distance += FMath::Square(PoseCoordinates[d] - QueryCoordinates[d]);
 		}
 
-		//Trajectory Cost 
-		const int32 TrajectoryIterations = FMath::Min(DesiredTrajectory.TrajectoryPoints.Num(), FinalCalibration.TrajectoryWeights.Num());
-		for (int32 i = 0; i < TrajectoryIterations; ++i)
-		{
-			const FTrajectoryWeightSet WeightSet = FinalCalibration.TrajectoryWeights[i];
-			const FTrajectoryPoint CurrentPoint = DesiredTrajectory.TrajectoryPoints[i];
-			const FTrajectoryPoint CandidatePoint = Pose.Trajectory[i];
+		LowerBounds[i] = Distance * LowerBoundScale * InMotionData->Poses[PCA->PoseIds[i]].Favour;
 
-			Cost += FVector::DistSquared(CandidatePoint.Position, CurrentPoint.Position) * WeightSet.Weight_Pos * OverrideTrajectoryMultiplier;
-			Cost += FMath::Abs(FMath::FindDeltaAngleDegrees(CandidatePoint.RotationZ, CurrentPoint.RotationZ))
-				* WeightSet.Weight_Facing * OverrideTrajectoryMultiplier;
+		if (LowerBounds[i] < LowerBounds[MinBoundIndex])
+		{
+			MinBoundIndex = i;
 		}
+	}
+
+	//The search starts from the seed poses and the pose with the lowest bound, whichever is better
+	TArray<int32, TInlineAllocator<16>> SeedPoseIds;
+	float LowestCost = 10000000.0f;
+	float RunnerUpCost = 10000000.0f;
+	int32 LowestPoseId = SeedPoseSearch(InMotionData, Query, SeedPoseIds, LowestCost, RunnerUpCost);
+
+	int32 CostedCount = 0;
+	const int32 MinBoundPoseId = PCA->PoseIds[MinBoundIndex];
+	if (!SeedPoseIds.Contains(MinBoundPoseId))
+	{
+		const float MinBoundCost = ComputePoseSearchCost(InMotionData, Query, MinBoundPoseId);
+		++CostedCount;
 
-		if (Cost > LowestCost) 
+		if (LowestPoseId == INDEX_NONE || MinBoundCost < LowestCost)
 		{
-			continue; //Early Out
+			RunnerUpCost = LowestCost;
+			LowestCost = MinBoundCost;
+			LowestPoseId = MinBoundPoseId;
 		}
-
-		for (int32 i = 0; i < CurrentInterpolatedPose.JointData.Num(); ++i)
+		else if (MinBoundCost < RunnerUpCost)
 		{
-			const FJointWeightSet WeightSet = FinalCalibration.PoseJointWeights[i];
-			const FJointData CurrentJoint = CurrentInterpolatedPose.JointData[i];
-			const FJointData CandidateJoint = Pose.JointData[i];
-
-			Cost += FVector::DistSquared(CurrentJoint.Velocity, CandidateJoint.Velocity) * WeightSet.Weight_Vel * OverridePoseMultiplier;
-			Cost += FVector::DistSquared(CurrentJoint.Position, CandidateJoint.Position) * WeightSet.Weight_Pos * OverridePoseMultiplier;
+			RunnerUpCost = MinBoundCost;
 		}
+	}
 
-		//Favour Current Pose
-		if (bFavourCurrentPose && Pose.PoseId == NextPose.PoseId)
+	//Second pass: exact costs for the poses whose lower bound could beat the best (or runner up) cost so far
+	const float& EarlyOutCost = OutRunnerUpCost ? RunnerUpCost : LowestCost;
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		const int32 PoseId = PCA->PoseIds[i];
+
+		//The current pose favour can lower the cost below the bound so it is always costed
+		if (i == MinBoundIndex 
+			|| (LowerBounds[i] >= EarlyOutCost && !(Query.bFavourCurrentPose && PoseId == Query.GetSearchNextPoseId()))
+			|| SeedPoseIds.Contains(PoseId))
 		{
-			Cost *= CurrentPoseFavour;
+			continue;
 		}
 
-		//Apply Pose Favour
-		Cost *= Pose.Favour;
+		const float Cost = ComputePoseSearchCost(InMotionData, Query, PoseId);
+		++CostedCount;
 
 		if (Cost < LowestCost)
 		{
+			RunnerUpCost = LowestCost;
 			LowestCost = Cost;
-			LowestPoseId = Pose.PoseId;
+			LowestPoseId = PoseId;
+		}
+		else if (Cost < RunnerUpCost)
+		{
+			RunnerUpCost = Cost;
 		}
 	}
 
-#if ENABLE_ANIM_DEBUG && ENABLE_DRAW_DEBUG
-	const int32 DebugLevel = CVarMMSearchDebug.GetValueOnAnyThread();
-	if (DebugLevel == 1)
+	if (OutRunnerUpCost)
 	{
-		HistoricalPosesSearchCounts.Add(PoseCandidates->Num());
-		HistoricalPosesSearchCounts.RemoveAt(0);
+		*OutRunnerUpCost = RunnerUpCost;
+	}
 
-		DrawCandidateTrajectories(PoseCandidates);
+	if (OutStats)
+	{
+		OutStats->SeedCount = SeedPoseIds.Num();
+		OutStats->CandidateCount = PoseCount;
+		OutStats->CostedCount = CostedCount;
 	}
-#endif
 
 	return LowestPoseId;
 }
 
-int32 FAnimNode_MotionMatching::GetLowestCostPoseId_Linear(const FPoseMotionData& NextPose)
+int32 FAnimNode_MotionMatching::SeedPoseSearch(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+	TArray<int32, TInlineAllocator<16>>& OutSeedPoseIds, float& OutLowestCost, float& OutRunnerUpCost)
 {
-	if (!FinalCalibrationSets.Contains(RequiredTraits))
+	OutSeedPoseIds.Reset();
+	OutLowestCost = 10000000.0f;
+	OutRunnerUpCost = 10000000.0f;
+
+	const int32 NextPoseId = Query.GetSearchNextPoseId();
+	const int32 SeedRadius = Query.GetSearchSeedRadius();
+	if (SeedRadius < 0 || !InMotionData->Poses.IsValidIndex(NextPoseId))
 	{
-		return CurrentChosenPoseId;
+		return INDEX_NONE;
 	}
 
-	const FCalibrationData& FinalCalibration = FinalCalibrationSets[RequiredTraits];
-
-	const float OverridePoseMultiplier = (1.0f - OverrideQualityVsResponsivenessRatio) * 2.0f;
-	const float OverrideTrajectoryMultiplier = OverrideQualityVsResponsivenessRatio * 2.0f;
-
-	int32 LowestPoseId = 0;
-	float LowestCost = 10000000.0f;
-	for (FPoseMotionData& Pose : MotionData->Poses)
+	int32 LowestPoseId = INDEX_NONE;
+	const TArray<uint64>& PoseMask = Query.GetSearchPoseMask();
+	auto AddSeed = [&](const int32 PoseId)
 	{
-		if (Pose.bDoNotUse || Pose.Traits != RequiredTraits)
+		//Only poses the search itself could choose are valid seeds
+		const int32 WordIndex = PoseId >> 6;
+		if (!PoseMask.IsValidIndex(WordIndex) || (PoseMask[WordIndex] & (1ULL << (PoseId & 63))) == 0
+			|| OutSeedPoseIds.Contains(PoseId))
 		{
-			continue;
+			return;
 		}
 
-		//Body Velocity Cost
-		float Cost = FVector::DistSquared(CurrentInterpolatedPose.LocalVelocity, Pose.LocalVelocity)
-			* FinalCalibration.Weight_Momentum * OverridePoseMultiplier;
-
-		//Body Rotational Velocity Cost
-		Cost += FMath::Abs(CurrentInterpolatedPose.RotationalVelocity - Pose.RotationalVelocity)
-			* FinalCalibration.Weight_AngularMomentum * OverridePoseMultiplier;
+		OutSeedPoseIds.Add(PoseId);
 
-		if(Cost > LowestCost) 
+		const float Cost = ComputePoseSearchCost(InMotionData, Query, PoseId);
+		if (Cost < OutLowestCost)
 		{
-			continue; //Early out
+			OutRunnerUpCost = OutLowestCost;
+			OutLowestCost = Cost;
+			LowestPoseId = PoseId;
 		}
-
-		//Pose Trajectory Cost
-		Cost += FMotionMatchingUtils::ComputeTrajectoryCost(DesiredTrajectory.TrajectoryPoints,
-		                                                    Pose.Trajectory, FinalCalibration) * OverrideTrajectoryMultiplier;
-
-		if(Cost > LowestCost) 
+		else if (Cost < OutRunnerUpCost)
 		{
-			continue; //Early out
+			OutRunnerUpCost = Cost;
 		}
+	};
 
-		// Pose Joint Cost
-		Cost += FMotionMatchingUtils::ComputePoseCost(CurrentInterpolatedPose.JointData,
-			Pose.JointData, FinalCalibration) * OverridePoseMultiplier;
-		
-		//Pose Favour
-		Cost *= Pose.Favour;
+	AddSeed(NextPoseId);
 
-		//Favour Current Pose
-		if (bFavourCurrentPose && Pose.PoseId == NextPose.PoseId)
+	//Walk the sequence forwards and backwards from the natural next pose. The walk stops at the ends of a clip
+	int32 ForwardPoseId = NextPoseId;
+	int32 BackwardPoseId = NextPoseId;
+	for (int32 Step = 0; Step < SeedRadius; ++Step)
+	{
+		ForwardPoseId = ForwardPoseId != INDEX_NONE ? InMotionData->Poses[ForwardPoseId].NextPoseId : INDEX_NONE;
+		BackwardPoseId = BackwardPoseId != INDEX_NONE ? InMotionData->Poses[BackwardPoseId].LastPoseId : INDEX_NONE;
+
+		ForwardPoseId = InMotionData->Poses.IsValidIndex(ForwardPoseId) ? ForwardPoseId : INDEX_NONE;
+		BackwardPoseId = InMotionData->Poses.IsValidIndex(BackwardPoseId) ? BackwardPoseId : INDEX_NONE;
+
+		if (ForwardPoseId != INDEX_NONE)
 		{
-			Cost *= CurrentPoseFavour;
+			AddSeed(ForwardPoseId);
 		}
 
-		if (Cost < LowestCost)
+		if (BackwardPoseId != INDEX_NONE)
 		{
-			LowestCost = Cost;
-			LowestPoseId = Pose.PoseId;
+			AddSeed(BackwardPoseId);
 		}
 	}
 
 	return LowestPoseId;
 }
 
+float FAnimNode_MotionMatching::ComputePoseSearchCost(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query, const int32 PoseId)
+{
+	FMotionMatchingCostBreakdown CostBreakdown;
+	ComputePoseSearchCostBreakdown(InMotionData, Query, PoseId, CostBreakdown);
+	return CostBreakdown.Total;
+}
+
+void FAnimNode_MotionMatching::ComputePoseSearchCostBreakdown(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+	const int32 PoseId, FMotionMatchingCostBreakdown& OutCostBreakdown)
+{
+	OutCostBreakdown = FMotionMatchingCostBreakdown();
+
+	if (!InMotionData->Poses.IsValidIndex(PoseId))
+	{
+		OutCostBreakdown.Total = 10000000.0f;
+		return;
+	}
+
+	const FCalibrationData& FinalCalibration = Query.Calibration;
+	const FPoseMotionData& CurrentPose = Query.CurrentPose;
+	const FPoseMotionData& Pose = InMotionData->Poses[PoseId];
+
+	//Body Velocity Cost
+	OutCostBreakdown.Momentum = FVector::DistSquared(CurrentPose.LocalVelocity, Pose.LocalVelocity)
+		* FinalCalibration.Weight_Momentum * Query.OverridePoseMultiplier;
+
+	//Body Rotational Velocity Cost
+	OutCostBreakdown.AngularMomentum = FMath::Abs(CurrentPose.RotationalVelocity - Pose.RotationalVelocity)
+		* FinalCalibration.Weight_AngularMomentum * Query.OverridePoseMultiplier;
+
+	//Pose Trajectory Cost
+	OutCostBreakdown.Trajectory = FMotionMatchingUtils::ComputeTrajectoryCost(Query.DesiredTrajectory,
+		Pose.Trajectory, FinalCalibration) * Query.OverrideTrajectoryMultiplier;
+
+	// Pose Joint Cost
+	OutCostBreakdown.Joints = FMotionMatchingUtils::ComputePoseCost(CurrentPose.JointData,
+		Pose.JointData, FinalCalibration) * Query.OverridePoseMultiplier;
+
+	//Pose Favour and Favour Current Pose
+	OutCostBreakdown.FavourMultiplier = Pose.Favour;
+	if (Query.bFavourCurrentPose && Pose.PoseId == Query.GetSearchNextPoseId())
+	{
+		OutCostBreakdown.FavourMultiplier *= Query.CurrentPoseFavour;
+	}
+
+	OutCostBreakdown.Total = OutCostBreakdown.GetUnfavouredCost() * OutCostBreakdown.FavourMultiplier;
+}
+
+const TArray<uint64>& FAnimNode_MotionMatching::GetRequiredTraitPoseMask()
+{
+	//Rebuild if the traits changed or any motion data was re-processed since the masks were built
+	bool bRebuild = !bRequiredTraitPoseMaskValid
+		|| RequiredTraitPoseMaskTraits != RequiredTraits
+		|| RequiredTraitPoseMasks.Num() != Databases.Num();
+
+	for (int32 DatabaseId = 0; !bRebuild && DatabaseId < Databases.Num(); ++DatabaseId)
+	{
+		bRebuild = RequiredTraitPoseMasks[DatabaseId].Num() != Databases[DatabaseId]->UsablePoseBitmap.Num();
+	}
+
+	if (bRebuild)
+	{
+		RequiredTraitPoseMasks.SetNum(Databases.Num());
+		for (int32 DatabaseId = 0; DatabaseId < Databases.Num(); ++DatabaseId)
+		{
+			Databases[DatabaseId]->GetTraitPoseMask(RequiredTraits, RequiredTraitPoseMasks[DatabaseId]);
+		}
+
+		RequiredTraitPoseMaskTraits = RequiredTraits;
+		bRequiredTraitPoseMaskValid = true;
+	}
+
+	return RequiredTraitPoseMasks[ActiveDatabaseId];
+}
+
+void FAnimNode_MotionMatching::SetActiveDatabase(const int32 DatabaseId)
+{
+	ActiveDatabaseId = Databases.IsValidIndex(DatabaseId) ? DatabaseId : 0;
+	ActiveMotionData = Databases.IsValidIndex(ActiveDatabaseId) ? Databases[ActiveDatabaseId] : MotionData;
+}
+
+UMotionDataAsset* FAnimNode_MotionMatching::GetChannelMotionData(const FAnimChannelState& Channel) const
+{
+	return Channel.MotionData ? Channel.MotionData : MotionData;
+}
+
 void FAnimNode_MotionMatching::TransitionToPose(const int32 PoseId, const FAnimationUpdateContext& Context, const float TimeOffset /*= 0.0f*/)
 {
 	switch (TransitionMethod)
 	{
 		case ETransitionMethod::None: { JumpToPose(PoseId, TimeOffset); } break;
 		case ETransitionMethod::Blend: { BlendToPose(PoseId, TimeOffset); } break;
+		case ETransitionMethod::OffsetInertialization:
+		{
+			JumpToPose(PoseId, TimeOffset);
+			OffsetInertializer.RequestTransition();
+		} break;
 		case ETransitionMethod::Inertialization:
 		{
 			JumpToPose(PoseId, TimeOffset);
@@ -1055,16 +1656,17 @@ void FAnimNode_MotionMatching::JumpToPose(const int32 PoseId, const float TimeOf
 {
 	TimeSinceMotionChosen = TimeSinceMotionUpdate;
 	CurrentChosenPoseId = PoseId;
+	++TransitionCount;
 
 	BlendChannels.Empty(TransitionMethod == ETransitionMethod::Blend ? 12 : 1);
-	const FPoseMotionData& Pose = MotionData->Poses[PoseId];
+	const FPoseMotionData& Pose = ActiveMotionData->Poses[PoseId];
 
 	switch (Pose.AnimType)
 	{
 		//Sequence Pose
 		case EMotionAnimAssetType::Sequence: 
 		{
-			const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(Pose.AnimId);
+			const FMotionAnimSequence& MotionAnim = ActiveMotionData->GetSourceAnimAtIndex(Pose.AnimId);
 
 			if (!MotionAnim.Sequence)
 			{
@@ -1074,11 +1676,13 @@ void FAnimNode_MotionMatching::JumpToPose(const int32 PoseId, const float TimeOf
 			BlendChannels.Emplace(FAnimChannelState(Pose, EBlendStatus::Dominant, 1.0f,
 				MotionAnim.Sequence->GetPlayLength(), MotionAnim.bLoop, MotionAnim.PlayRate, Pose.bMirrored, TimeSinceMotionChosen, TimeOffset));
 
+			BlendChannels.Last().MotionData = ActiveMotionData;
+
 		} break;
 		//Blend Space Pose
 		case EMotionAnimAssetType::BlendSpace:
 		{
-			const FMotionBlendSpace& MotionBlendSpace = MotionData->GetSourceBlendSpaceAtIndex(Pose.AnimId);
+			const FMotionBlendSpace& MotionBlendSpace = ActiveMotionData->GetSourceBlendSpaceAtIndex(Pose.AnimId);
 
 			if (!MotionBlendSpace.BlendSpace)
 			{
@@ -1088,15 +1692,21 @@ void FAnimNode_MotionMatching::JumpToPose(const int32 PoseId, const float TimeOf
 			BlendChannels.Emplace(FAnimChannelState(Pose, EBlendStatus::Dominant, 1.0f,
 				MotionBlendSpace.GetPlayLength(), MotionBlendSpace.bLoop, MotionBlendSpace.PlayRate, Pose.bMirrored, TimeSinceMotionChosen, TimeOffset));
 
-			MotionBlendSpace.BlendSpace->GetSamplesFromBlendInput(FVector(
-				Pose.BlendSpacePosition.X, Pose.BlendSpacePosition.Y, 0.0f), 
-				BlendChannels.Last().BlendSampleDataCache);
+			BlendChannels.Last().MotionData = ActiveMotionData;
+
+			//Sample weights are pre-processed. Only assets processed before they were stored evaluate the blend space
+			TArray<FBlendSampleData>& BlendSampleDataCache = BlendChannels.Last().BlendSampleDataCache;
+			if (!ActiveMotionData->GetBlendSampleData(PoseId, BlendSampleDataCache))
+			{
+				MotionBlendSpace.BlendSpace->GetSamplesFromBlendInput(FVector(
+					Pose.BlendSpacePosition.X, Pose.BlendSpacePosition.Y, 0.0f), BlendSampleDataCache);
+			}
 
 		} break;
 		//Composites
 		case EMotionAnimAssetType::Composite:
 		{
-			const FMotionComposite& MotionComposite = MotionData->GetSourceCompositeAtIndex(Pose.AnimId);
+			const FMotionComposite& MotionComposite = ActiveMotionData->GetSourceCompositeAtIndex(Pose.AnimId);
 
 			if (!MotionComposite.AnimComposite)
 			{
@@ -1105,6 +1715,8 @@ void FAnimNode_MotionMatching::JumpToPose(const int32 PoseId, const float TimeOf
 
 			BlendChannels.Emplace(FAnimChannelState(Pose, EBlendStatus::Dominant, 1.0f,
 				MotionComposite.AnimComposite->GetPlayLength(), MotionComposite.bLoop, MotionComposite.PlayRate, Pose.bMirrored, TimeSinceMotionChosen, TimeOffset));
+
+			BlendChannels.Last().MotionData = ActiveMotionData;
 		}
 		default: 
 		{ 
@@ -1119,46 +1731,57 @@ void FAnimNode_MotionMatching::BlendToPose(int32 PoseId, float TimeOffset /*= 0.
 {
 	TimeSinceMotionChosen = TimeSinceMotionUpdate;
 	CurrentChosenPoseId = PoseId;
+	++TransitionCount;
 
 	//BlendChannels.Last().BlendStatus = EBlendStatus::Decay;
 
-	const FPoseMotionData& Pose = MotionData->Poses[PoseId];
+	const FPoseMotionData& Pose = ActiveMotionData->Poses[PoseId];
 
 	switch (Pose.AnimType)
 	{
 		//Sequence Pose
 		case EMotionAnimAssetType::Sequence:
 		{
-			const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(Pose.AnimId);
+			const FMotionAnimSequence& MotionAnim = ActiveMotionData->GetSourceAnimAtIndex(Pose.AnimId);
 
 			BlendChannels.Emplace(FAnimChannelState(Pose, EBlendStatus::Chosen, 1.0f,
 				MotionAnim.Sequence->GetPlayLength(), MotionAnim.bLoop, MotionAnim.PlayRate,
 				Pose.bMirrored, TimeSinceMotionChosen, TimeOffset));
 
+			BlendChannels.Last().MotionData = ActiveMotionData;
+
 		} break;
 		//Blend Space Pose
 		case EMotionAnimAssetType::BlendSpace:
 		{
-			const FMotionBlendSpace& MotionBlendSpace = MotionData->GetSourceBlendSpaceAtIndex(Pose.AnimId);
+			const FMotionBlendSpace& MotionBlendSpace = ActiveMotionData->GetSourceBlendSpaceAtIndex(Pose.AnimId);
 
 			BlendChannels.Emplace(FAnimChannelState(Pose, EBlendStatus::Chosen, 1.0f,
 				MotionBlendSpace.GetPlayLength(), MotionBlendSpace.bLoop, MotionBlendSpace.PlayRate,
 				Pose.bMirrored, TimeSinceMotionChosen, TimeOffset));
 
-			MotionBlendSpace.BlendSpace->GetSamplesFromBlendInput(FVector(
-				Pose.BlendSpacePosition.X, Pose.BlendSpacePosition.Y, 0.0f),
-				BlendChannels.Last().BlendSampleDataCache);
+			BlendChannels.Last().MotionData = ActiveMotionData;
+
+			//Sample weights are pre-processed. Only assets processed before they were stored evaluate the blend space
+			TArray<FBlendSampleData>& BlendSampleDataCache = BlendChannels.Last().BlendSampleDataCache;
+			if (!ActiveMotionData->GetBlendSampleData(PoseId, BlendSampleDataCache))
+			{
+				MotionBlendSpace.BlendSpace->GetSamplesFromBlendInput(FVector(
+					Pose.BlendSpacePosition.X, Pose.BlendSpacePosition.Y, 0.0f), BlendSampleDataCache);
+			}
 
 		} break;
 		//Composites
 		case EMotionAnimAssetType::Composite:
 		{
-			const FMotionComposite& MotionComposite = MotionData->GetSourceCompositeAtIndex(Pose.AnimId);
+			const FMotionComposite& MotionComposite = ActiveMotionData->GetSourceCompositeAtIndex(Pose.AnimId);
 
 			BlendChannels.Emplace(FAnimChannelState(Pose, EBlendStatus::Chosen, 1.0f,
 				MotionComposite.AnimComposite->GetPlayLength(), MotionComposite.bLoop, MotionComposite.PlayRate,
 				Pose.bMirrored, TimeSinceMotionChosen, TimeOffset));
 
+			BlendChannels.Last().MotionData = ActiveMotionData;
+
 		} break;
 		//Default
 		default: 
@@ -1275,17 +1898,60 @@ bool FAnimNode_MotionMatching::IsValidToEvaluate(const FAnimInstanceProxy* InAni
 	}
 
 	//Validate Motion Matching optimization is setup correctly otherwise revert to Linear search
-	if (PoseMatchMethod == EPoseMatchMethod::Optimized 
-		&& MotionData->IsOptimisationValid())
+	if (PoseMatchMethod == EPoseMatchMethod::Optimized)
 	{
-		MotionData->OptimisationModule->InitializeRuntime();
+		if (MotionData->IsOptimisationValid())
+		{
+			MotionData->OptimisationModule->InitializeRuntime();
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Motion matching node was set to run in optimized mode. However, the optimisation setup is invalid and optimization will be disabled. Did you forget to pre-process your motion data with optimisation on?"));
+			PoseMatchMethod = EPoseMatchMethod::Linear;
+		}
 	}
-	else
+	else if (PoseMatchMethod == EPoseMatchMethod::PCAPrefiltered
+		&& MotionData->PCAPrefilters.Num() == 0)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Motion matching node was set to run in optimized mode. However, the optimisation setup is invalid and optimization will be disabled. Did you forget to pre-process your motion data with optimisation on?"));
+		UE_LOG(LogTemp, Warning, TEXT("Motion matching node was set to use the PCA pre-filter. However, the motion data has no PCA pre-filter and a linear search will be used instead. Did you forget to pre-process your motion data with 'Build PCA Prefilter' on?"));
 		PoseMatchMethod = EPoseMatchMethod::Linear;
 	}
 
+	//Gather the databases to search. The primary motion data is always first and provides the calibration for all of them
+	Databases.Empty(AdditionalMotionData.Num() + 1);
+	Databases.Add(MotionData);
+	for (UMotionDataAsset* AdditionalData : AdditionalMotionData)
+	{
+		if (!AdditionalData || Databases.Contains(AdditionalData))
+		{
+			continue;
+		}
+
+		if (!AdditionalData->bIsProcessed || AdditionalData->MotionMatchConfig != MMConfig)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Motion matching node: Additional motion data '%s' will not be searched. It must be pre-processed and use the same motion match config as the primary motion data."),
+				*AdditionalData->GetName());
+			continue;
+		}
+
+		if (PoseMatchMethod == EPoseMatchMethod::Optimized)
+		{
+			if (!AdditionalData->IsOptimisationValid())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Motion matching node: Additional motion data '%s' will not be searched. The node is optimized but the motion data has no valid optimisation."),
+					*AdditionalData->GetName());
+				continue;
+			}
+
+			AdditionalData->OptimisationModule->InitializeRuntime();
+		}
+
+		Databases.Add(AdditionalData);
+	}
+
+	SetActiveDatabase(0);
+	bRequiredTraitPoseMaskValid = false;
+
 	//If the user calibration is not set on the motion data asset, get it from the Motion Data instead
 	if (!UserCalibration)
 	{
@@ -1301,6 +1967,13 @@ bool FAnimNode_MotionMatching::IsValidToEvaluate(const FAnimInstanceProxy* InAni
 			FCalibrationData& NewFinalCalibration = FinalCalibrationSets.Add(FeatureStdDevPairs.Key, FCalibrationData());
 			NewFinalCalibration.GenerateFinalWeights(UserCalibration, FeatureStdDevPairs.Value);
 		}
+
+		bRequiredTraitPoseMaskValid = false;
+
+		if (QueryRecorder.IsValid())
+		{
+			QueryRecorder->InvalidateCalibrations();
+		}
 	}
 	else
 	{
@@ -1374,6 +2047,9 @@ void FAnimNode_MotionMatching::Initialize_AnyThread(const FAnimationInitializeCo
 {
 	FAnimNode_AssetPlayerBase::Initialize_AnyThread(Context);
 	
+	CancelAsyncPoseSearch();
+	OffsetInertializer.Reset();
+
 	GetEvaluateGraphExposedInputs().Execute(Context);
 
 	if(!bValidToEvaluate)
@@ -1405,6 +2081,10 @@ void FAnimNode_MotionMatching::UpdateAssetPlayer(const FAnimationUpdateContext&
 	DECLARE_SCOPE_HIERARCHICAL_COUNTER_ANIMNODE(UpdateAssetPlayer)
 	
 	GetEvaluateGraphExposedInputs().Execute(Context);
+
+	//The desired trajectory may be set from blueprint with only its rotations. Facing directions are converted once here
+	//for every search this update
+	DesiredTrajectory.UpdateFacings();
 	
 	if (!MotionData 
 	|| !MotionData->bIsProcessed
@@ -1415,6 +2095,7 @@ void FAnimNode_MotionMatching::UpdateAssetPlayer(const FAnimationUpdateContext&
 	}
 	
 	const float DeltaTime = Context.GetDeltaTime();
+	OffsetInertializer.Update(DeltaTime);
 
 	if (!bInitialized)
 	{
@@ -1516,6 +2197,11 @@ void FAnimNode_MotionMatching::Evaluate_AnyThread(FPoseContext& Output)
 	else
 	{
 		EvaluateSinglePose(Output);
+
+		if (TransitionMethod == ETransitionMethod::OffsetInertialization)
+		{
+			OffsetInertializer.Apply(Output.Pose, InertializationHalfLife);
+		}
 	}
 }
 
@@ -1532,13 +2218,14 @@ void FAnimNode_MotionMatching::GatherDebugData(FNodeDebugData& DebugData)
 void FAnimNode_MotionMatching::EvaluateSinglePose(FPoseContext& Output)
 {
 	FAnimChannelState& PrimaryChannel = BlendChannels.Last();
+	const UMotionDataAsset* ChannelMotionData = GetChannelMotionData(PrimaryChannel);
 	float AnimTime = PrimaryChannel.AnimTime;
 
 	switch (PrimaryChannel.AnimType)
 	{
 		case EMotionAnimAssetType::Sequence:
 		{
-			const FMotionAnimSequence& MotionSequence = MotionData->GetSourceAnimAtIndex(PrimaryChannel.AnimId);
+			const FMotionAnimSequence& MotionSequence = ChannelMotionData->GetSourceAnimAtIndex(PrimaryChannel.AnimId);
 			UAnimSequence* AnimSequence = MotionSequence.Sequence;
 
 
@@ -1557,7 +2244,7 @@ void FAnimNode_MotionMatching::EvaluateSinglePose(FPoseContext& Output)
 
 		case EMotionAnimAssetType::BlendSpace:
 		{
-			const FMotionBlendSpace& MotionBlendSpace = MotionData->GetSourceBlendSpaceAtIndex(PrimaryChannel.AnimId);
+			const FMotionBlendSpace& MotionBlendSpace = ChannelMotionData->GetSourceBlendSpaceAtIndex(PrimaryChannel.AnimId);
 			UBlendSpaceBase* BlendSpace = MotionBlendSpace.BlendSpace;
 
 			if (!BlendSpace)
@@ -1585,7 +2272,7 @@ void FAnimNode_MotionMatching::EvaluateSinglePose(FPoseContext& Output)
 
 		case EMotionAnimAssetType::Composite:
 		{
-			const FMotionComposite& MotionComposite = MotionData->GetSourceCompositeAtIndex(PrimaryChannel.AnimId);
+			const FMotionComposite& MotionComposite = ChannelMotionData->GetSourceCompositeAtIndex(PrimaryChannel.AnimId);
 			UAnimComposite* Composite = MotionComposite.AnimComposite;
 
 			if(!Composite)
@@ -1656,6 +2343,7 @@ void FAnimNode_MotionMatching::EvaluateBlendPose(FPoseContext& Output)
 		{
 			FCompactPose& Pose = ChannelPoses[i];
 			FAnimChannelState& AnimChannel = BlendChannels[i];
+			const UMotionDataAsset* ChannelMotionData = GetChannelMotionData(AnimChannel);
 
 			const float Weight = AnimChannel.Weight * ((((float)(i + 1)) / ((float)PoseCount)));
 			ChannelWeights[i] = Weight;
@@ -1667,7 +2355,7 @@ void FAnimNode_MotionMatching::EvaluateBlendPose(FPoseContext& Output)
 			{
 				case EMotionAnimAssetType::Sequence:
 				{
-					const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(AnimChannel.AnimId);
+					const FMotionAnimSequence& MotionAnim = ChannelMotionData->GetSourceAnimAtIndex(AnimChannel.AnimId);
 					UAnimSequence* AnimSequence = MotionAnim.Sequence;
 
 					if(!AnimSequence)
@@ -1689,7 +2377,7 @@ void FAnimNode_MotionMatching::EvaluateBlendPose(FPoseContext& Output)
 				} break;
 				case EMotionAnimAssetType::BlendSpace:
 				{
-					const FMotionBlendSpace& MotionBlendSpace = MotionData->GetSourceBlendSpaceAtIndex(AnimChannel.AnimId);
+					const FMotionBlendSpace& MotionBlendSpace = ChannelMotionData->GetSourceBlendSpaceAtIndex(AnimChannel.AnimId);
 					UBlendSpaceBase* BlendSpace = MotionBlendSpace.BlendSpace;
 
 					if(!BlendSpace)
@@ -1834,22 +2522,27 @@ void FAnimNode_MotionMatching::CreateTickRecordForNode(const FAnimationUpdateCon
 
 void FAnimNode_MotionMatching::PerformLinearSearchComparison(const FAnimationUpdateContext& Context, int32 ComparePoseId, FPoseMotionData& NextPose)
 {
-	int32 LowestPoseId = LowestPoseId = GetLowestCostPoseId_Linear(NextPose);
+	//The search query and the compared pose both belong to the active database
+	const int32 LowestPoseId = GetLowestCostPoseId_Linear(ActiveMotionData, SearchQuery);
 
-	const bool SamePoseChosen = LowestPoseId == ComparePoseId;
+	if (!ActiveMotionData->Poses.IsValidIndex(LowestPoseId) 
+		|| !ActiveMotionData->Poses.IsValidIndex(ComparePoseId))
+	{
+		return;
+	}
 
-	LowestPoseId = FMath::Clamp(LowestPoseId, 0, MotionData->Poses.Num() - 1);
+	const bool SamePoseChosen = LowestPoseId == ComparePoseId;
 
 	float LinearChosenPoseCost = 0.0f;
-	const float ActualChosenPoseCost = 0.0f;
+	float ActualChosenPoseCost = 0.0f;
 
 	float LinearChosenTrajectoryCost = 0.0f;
 	float ActualChosenTrajectoryCost = 0.0f;
 	
 	if (!SamePoseChosen)
 	{
-		const FPoseMotionData& LinearPose = MotionData->Poses[LowestPoseId];
-		const FPoseMotionData& ActualPose = MotionData->Poses[ComparePoseId];
+		const FPoseMotionData& LinearPose = ActiveMotionData->Poses[LowestPoseId];
+		const FPoseMotionData& ActualPose = ActiveMotionData->Poses[ComparePoseId];
 
 		LinearChosenTrajectoryCost = FMotionMatchingUtils::ComputeTrajectoryCost(CurrentInterpolatedPose.Trajectory, LinearPose.Trajectory,
 			1.0f, 0.0f);
@@ -1860,11 +2553,11 @@ void FAnimNode_MotionMatching::PerformLinearSearchComparison(const FAnimationUpd
 		LinearChosenPoseCost = FMotionMatchingUtils::ComputePoseCost(CurrentInterpolatedPose.JointData, LinearPose.JointData,
 			1.0f, 0.0f);
 
-		LinearChosenPoseCost = FMotionMatchingUtils::ComputePoseCost(CurrentInterpolatedPose.JointData, ActualPose.JointData,
+		ActualChosenPoseCost = FMotionMatchingUtils::ComputePoseCost(CurrentInterpolatedPose.JointData, ActualPose.JointData,
 			1.0f, 0.0f);
 	}
 
-	const UMotionMatchConfig* MMConfig = MotionData->MotionMatchConfig;
+	const UMotionMatchConfig* MMConfig = ActiveMotionData->MotionMatchConfig;
 
 	const float TrajectorySearchError = FMath::Abs(ActualChosenTrajectoryCost - LinearChosenTrajectoryCost) / MMConfig->TrajectoryTimes.Num();
 	const float PoseSearchError = FMath::Abs(ActualChosenPoseCost - LinearChosenPoseCost) / MMConfig->PoseBones.Num();
@@ -1887,7 +2580,7 @@ UAnimSequence* FAnimNode_MotionMatching::GetAnimAtIndex(const int32 AnimId)
 
 	const FAnimChannelState& AnimChannel = BlendChannels[AnimId];
 
-	return MotionData->GetSourceAnimAtIndex(AnimChannel.AnimId).Sequence;
+	return GetChannelMotionData(AnimChannel)->GetSourceAnimAtIndex(AnimChannel.AnimId).Sequence;
 }
 
 UAnimSequenceBase* FAnimNode_MotionMatching::GetPrimaryAnim()
@@ -1901,8 +2594,8 @@ UAnimSequenceBase* FAnimNode_MotionMatching::GetPrimaryAnim()
 
 	switch (CurrentChannel.AnimType)
 	{
-		case EMotionAnimAssetType::Sequence: return MotionData->GetSourceAnimAtIndex(CurrentChannel.AnimId).Sequence;
-		case EMotionAnimAssetType::Composite: return MotionData->GetSourceCompositeAtIndex(CurrentChannel.AnimId).AnimComposite;
+		case EMotionAnimAssetType::Sequence: return GetChannelMotionData(CurrentChannel)->GetSourceAnimAtIndex(CurrentChannel.AnimId).Sequence;
+		case EMotionAnimAssetType::Composite: return GetChannelMotionData(CurrentChannel)->GetSourceCompositeAtIndex(CurrentChannel.AnimId).AnimComposite;
 		default: return nullptr;
 	}
 }
@@ -1962,12 +2655,12 @@ void FAnimNode_MotionMatching::DrawTrajectoryDebug(FAnimInstanceProxy* InAnimIns
 void FAnimNode_MotionMatching::DrawChosenTrajectoryDebug(FAnimInstanceProxy* InAnimInstanceProxy)
 {
 	if (InAnimInstanceProxy == nullptr 
-	|| CurrentChosenPoseId > MotionData->Poses.Num() - 1)
+	|| CurrentChosenPoseId > ActiveMotionData->Poses.Num() - 1)
 	{
 		return;
 	}
 
-	TArray<FTrajectoryPoint>& CurrentTrajectory = MotionData->Poses[CurrentChosenPoseId].Trajectory;
+	TArray<FTrajectoryPoint>& CurrentTrajectory = ActiveMotionData->Poses[CurrentChosenPoseId].Trajectory;
 
 	if (CurrentTrajectory.Num() == 0)
 	{
@@ -2123,7 +2816,7 @@ void FAnimNode_MotionMatching::DrawSearchCounts(FAnimInstanceProxy* InAnimInstan
 
 	AveCount /= HistoricalPosesSearchCounts.Num();
 
-	const int32 PoseCount = MotionData->Poses.Num();
+	const int32 PoseCount = ActiveMotionData->Poses.Num();
 
 	const FString TotalMessage = FString::Printf(TEXT("Total Poses: %02d"), PoseCount);
 	const FString LastMessage = FString::Printf(TEXT("Poses Searched: %02d (%f % Reduction)"), LatestCount, ((float)PoseCount - (float)LatestCount) / (float)PoseCount * 100.0f);
@@ -2144,8 +2837,12 @@ void FAnimNode_MotionMatching::DrawAnimDebug(FAnimInstanceProxy* InAnimInstanceP
 		return;
 	}
 
-	FPoseMotionData& CurrentPose = MotionData->Poses[FMath::Clamp(CurrentInterpolatedPose.PoseId,
-			0, MotionData->Poses.Num())];
+	//The interpolated pose comes from the dominant channel which may be from any of the searched databases
+	UMotionDataAsset* DominantMotionData = BlendChannels.IsValidIndex(DominantBlendChannel)
+		? GetChannelMotionData(BlendChannels[DominantBlendChannel]) : MotionData;
+
+	FPoseMotionData& CurrentPose = DominantMotionData->Poses[FMath::Clamp(CurrentInterpolatedPose.PoseId,
+			0, DominantMotionData->Poses.Num())];
 
 	//Print Pose Information
 	FString Message = FString::Printf(TEXT("Pose Id: %02d \nPoseFavour: %f \nMirrored: "),
@@ -2175,7 +2872,7 @@ void FAnimNode_MotionMatching::DrawAnimDebug(FAnimInstanceProxy* InAnimInstanceP
 	const FAnimChannelState& AnimChannel = BlendChannels.Last();
 	AnimMessage += FString::Printf(TEXT("Anim Time: %0f \nAnimName: "), AnimChannel.AnimTime);
 	
-	FMotionAnimAsset* MotionAnimAsset = MotionData->GetSourceAnim(CurrentPose.AnimId, CurrentPose.AnimType);
+	FMotionAnimAsset* MotionAnimAsset = DominantMotionData->GetSourceAnim(CurrentPose.AnimId, CurrentPose.AnimType);
 	if(MotionAnimAsset && MotionAnimAsset->AnimAsset)
 	{
 		AnimMessage += MotionAnimAsset->AnimAsset->GetName();
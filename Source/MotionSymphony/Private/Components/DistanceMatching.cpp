@@ -2,6 +2,7 @@
 
 #include "Components/DistanceMatching.h"
 #include "DrawDebugHelpers.h"
+#include "Misc/AutomationTest.h"
 
 #define LOCTEXT_NAMESPACE "MotionSymphony"
 
@@ -15,6 +16,7 @@ static TAutoConsoleVariable<int32> CVarDistanceMatchingDebug(
 UDistanceMatching::UDistanceMatching()
 	: bAutomaticTriggers(false),
 	DistanceTolerance(5.0f),
+	bUseAnalyticalPrediction(true),
 	MinPlantDetectionAngle(130.0f),
 	MinPlantSpeed(100.0f),
 	MinPlantAccel(100.0f),
@@ -392,8 +394,7 @@ void UDistanceMatching::TickComponent(float DeltaTime, ELevelTick TickType, FAct
 
 FDistanceMatchingModule::FDistanceMatchingModule()
 	: AnimSequence(nullptr),
-	LastKeyChecked(0),
-	MaxDistance(0.0f)
+	LastKeyChecked(0)
 {
 
 }
@@ -401,103 +402,263 @@ FDistanceMatchingModule::FDistanceMatchingModule()
 void FDistanceMatchingModule::Setup(UAnimSequenceBase* InAnimSequence, const FName& DistanceCurveName)
 {
 	AnimSequence = InAnimSequence;
+	BakedCurve = FBakedDistanceCurveCache::Get().FindOrBake(InAnimSequence, DistanceCurveName);
+}
+
+void FDistanceMatchingModule::Initialize()
+{
+	LastKeyChecked = 0;
+}
 
-	if(!AnimSequence)
+float FDistanceMatchingModule::FindMatchingTime(float DesiredDistance, bool bNegateCurve)
+{
+	if(!BakedCurve.IsValid()
+	|| BakedCurve->GetKeyCount() < 2
+	|| FMath::Abs(DesiredDistance) > BakedCurve->GetMaxDistance())
 	{
-		return;
+		return -1.0f;
 	}
 
-	FSmartName CurveName;
-#if ENGINE_MAJOR_VERSION > 4
-	const FRawCurveTracks& RawCurves = InAnimSequence->GetCurveData();
-#else
-	const FRawCurveTracks& RawCurves = InAnimSequence->RawCurveData;
-#endif
-	InAnimSequence->GetSkeleton()->GetSmartNameByName(USkeleton::AnimCurveMappingName, DistanceCurveName, CurveName);
+	//Find the time in the animation with the matching distance
+	LastKeyChecked = FMath::Clamp(LastKeyChecked, 0, BakedCurve->GetKeyCount() - 1);
+	int32 StartKey = LastKeyChecked; //The cursor is not advanced so that matching can move back along the curve
 
-	if (CurveName.IsValid())
+	return BakedCurve->FindMatchingTime(DesiredDistance, bNegateCurve, StartKey);
+}
+
+bool UDistanceMatching::CalculateStartLocation(FVector& OutStartLocation, const float DeltaTime, const int32 MaxIterations) const
+{
+	if (!bUseAnalyticalPrediction)
 	{
-		const FFloatCurve* DistanceCurve = static_cast<const FFloatCurve*>(RawCurves.GetCurveData(CurveName.UID));
+		return CalculateStartLocation_Iterative(OutStartLocation, DeltaTime, MaxIterations);
+	}
 
-		if(DistanceCurve)
-		{
-			CurveKeys = DistanceCurve->FloatCurve.GetCopyOfKeys();
+	const FVector TargetVelocity = MovementComponent->Velocity;
+	FVector Acceleration = TargetVelocity.GetSafeNormal() * MovementComponent->GetMaxAcceleration();
+	Acceleration.Z = 0.0f;
 
-			for (FRichCurveKey& Key : CurveKeys)
-			{
-				if (FMath::Abs(Key.Value) > MaxDistance)
-				{
-					MaxDistance = FMath::Abs(Key.Value);
-				}
-			}
-		}
-		else
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Distance matching curve could not be found. Distance matching node will not operate as expected."));
-		}
+	float StartDistance = 0.0f;
+	int32 Iterations = 0;
+	if (!PredictStartDistance(TargetVelocity.Size(), Acceleration.Size(), DeltaTime, MaxIterations, StartDistance, Iterations))
+	{
+		return false;
 	}
+
+	OutStartLocation = ParentActor->GetActorLocation() - Acceleration.GetSafeNormal() * StartDistance;
+	return true;
 }
 
-void FDistanceMatchingModule::Initialize()
+bool UDistanceMatching::CalculateStopLocation(FVector& OutStopLocation, const float DeltaTime, const int32 MaxIterations)
 {
-	LastKeyChecked = 0;
+	//The closed form solution only covers braking without any input acceleration
+	if (!bUseAnalyticalPrediction 
+		|| !MovementComponent->GetCurrentAcceleration().IsZero())
+	{
+		return CalculateStopLocation_Iterative(OutStopLocation, DeltaTime, MaxIterations);
+	}
+
+	FVector Velocity = MovementComponent->Velocity;
+	Velocity.Z = 0.0f;
+
+	const float Friction = FMath::Max(MovementComponent->GroundFriction * MovementComponent->BrakingFrictionFactor, 0.0f);
+	const float BrakingDeceleration = FMath::Max(MovementComponent->BrakingDecelerationWalking, 0.0f);
+
+	float StopDistance = 0.0f;
+	float StopTime = 0.0f;
+	if (!PredictBrakingStop(Velocity.Size(), Friction, BrakingDeceleration, DeltaTime, MaxIterations, StopDistance, StopTime))
+	{
+		return false;
+	}
+
+	TimeToMarker = StopTime;
+	OutStopLocation = ParentActor->GetActorLocation() + Velocity.GetSafeNormal() * StopDistance;
+	return true;
 }
 
-float FDistanceMatchingModule::FindMatchingTime(float DesiredDistance, bool bNegateCurve)
+bool UDistanceMatching::PredictBrakingStop(const float Speed, const float Friction, const float BrakingDeceleration,
+	const float DeltaTime, const int32 MaxIterations, float& OutStopDistance, float& OutStopTime)
 {
-	if(CurveKeys.Num() < 2
-	|| FMath::Abs(DesiredDistance) > FMath::Abs(MaxDistance))
+	const float MIN_TICK_TIME = 1e-6;
+	if (DeltaTime < MIN_TICK_TIME || MaxIterations < 1)
 	{
-		return -1.0f;
+		return false;
 	}
 
-	//Find the time in the animation with the matching distance
-	LastKeyChecked = FMath::Clamp(LastKeyChecked, 0, CurveKeys.Num() - 1);
-	FRichCurveKey* PKey = &CurveKeys[LastKeyChecked];
-	FRichCurveKey* SKey = nullptr;
+	const bool bZeroFriction = (Friction < 0.00001f);
+	const bool bZeroBraking = (BrakingDeceleration < 0.00001f);
 
-	const float Negator = bNegateCurve ? -1.0f : 1.0f;
+	//Won't stop if there is no Braking acceleration or friction
+	if (bZeroFriction && bZeroBraking)
+	{
+		return false;
+	}
 
-	for (int32 i = LastKeyChecked; i < CurveKeys.Num(); ++i)
+	//Every frame is sub-stepped identically so the speed after a frame is an affine function of the speed before it,
+	//i.e. S(n+1) = FrameScale * S(n) - FrameLoss. This holds until the speed reaches zero.
+	const double Braking = bZeroBraking ? 0.0 : BrakingDeceleration;
+	const float MaxDeltaTime = (1.0f / 33.0f);
+	double FrameScale = 1.0;
+	double FrameLoss = 0.0;
+	bool bReversesInFrame = false;
+	float RemainingTime = DeltaTime;
+	while (RemainingTime >= MIN_TICK_TIME)
 	{
-		FRichCurveKey& Key = CurveKeys[i];
+		const float DT = ((RemainingTime > MaxDeltaTime && !bZeroFriction) ? FMath::Min(MaxDeltaTime, RemainingTime * 0.5f) : RemainingTime);
+		RemainingTime -= DT;
 
-		if (Key.Value * Negator > DesiredDistance)
+		const double StepScale = 1.0 - Friction * DT;
+		bReversesInFrame |= (StepScale <= 0.0);
+		FrameScale *= StepScale;
+		FrameLoss = FrameLoss * StepScale + Braking * DT;
+	}
+
+	//The movement component clamps speed to zero below this threshold
+	const double StopSpeed = bZeroBraking ? 1.0 : 10.0;
+	const double StartSpeed = Speed;
+	const bool bLinear = FrameScale >= 1.0;
+	const double Offset = bLinear ? 0.0 : FrameLoss / (1.0 - FrameScale);
+
+	//Integer power by squaring to keep double precision
+	auto FrameScalePow = [FrameScale](int32 Frame) -> double
+	{
+		double Result = 1.0;
+		double Base = FrameScale;
+		for (; Frame > 0; Frame >>= 1)
 		{
-			PKey = &Key;
-			//LastKeyChecked = i;
+			if (Frame & 1)
+			{
+				Result *= Base;
+			}
+
+			Base *= Base;
 		}
-		else
+
+		return Result;
+	};
+
+	auto SpeedAtFrame = [&](const int32 Frame) -> double
+	{
+		return bLinear ? StartSpeed - Frame * FrameLoss
+			: FrameScalePow(Frame) * (StartSpeed + Offset) - Offset;
+	};
+
+	//Estimate the first frame at which the character is stopped then correct for any rounding error
+	int32 StopFrame = 1;
+	if (!bReversesInFrame && SpeedAtFrame(1) > StopSpeed)
+	{
+		const float Estimate = bLinear ? (float)((StartSpeed - StopSpeed) / FrameLoss)
+			: FMath::Loge((float)((StopSpeed + Offset) / (StartSpeed + Offset))) / FMath::Loge((float)FrameScale);
+
+		StopFrame = FMath::IsFinite(Estimate) ? FMath::Clamp(FMath::CeilToInt(FMath::Min(Estimate, (float)MaxIterations + 1.0f)), 1, MaxIterations + 1)
+			: MaxIterations + 1;
+
+		while (StopFrame > 1 && SpeedAtFrame(StopFrame - 1) <= StopSpeed)
 		{
-			SKey = &Key;
-			break;
+			--StopFrame;
 		}
+
+		while (StopFrame <= MaxIterations && SpeedAtFrame(StopFrame) > StopSpeed)
+		{
+			++StopFrame;
+		}
+	}
+
+	if (StopFrame > MaxIterations)
+	{
+		return false;
 	}
 
-	if (!SKey)
+	//The character moves at the speed of each frame before the one on which it stops
+	const int32 MovingFrames = StopFrame - 1;
+	const double SpeedSum = bLinear ? MovingFrames * StartSpeed - FrameLoss * MovingFrames * (MovingFrames + 1) * 0.5
+		: (StartSpeed + Offset) * FrameScale * (1.0 - FrameScalePow(MovingFrames)) / (1.0 - FrameScale) - Offset * MovingFrames;
+
+	OutStopDistance = (float)(SpeedSum * DeltaTime);
+	OutStopTime = StopFrame * DeltaTime;
+	return true;
+}
+
+bool UDistanceMatching::PredictStartDistance(const float TargetSpeed, const float Acceleration, const float DeltaTime,
+	const int32 MaxIterations, float& OutStartDistance, int32& OutIterations)
+{
+	const float MIN_TICK_TIME = 1e-6;
+	if (DeltaTime < MIN_TICK_TIME || MaxIterations < 1)
 	{
-		return PKey->Time;
+		return false;
 	}
 
-	const float DV = (SKey->Value * Negator) - (PKey->Value * Negator);
+	//Starting from rest the velocity is always aligned with the acceleration so friction has no effect and the 
+	//speed grows linearly, i.e. S(n) = n * Acceleration * DeltaTime.
+	const double SpeedPerFrame = (double)Acceleration * DeltaTime;
+	const double ReachedSpeedSqr = (double)TargetSpeed * TargetSpeed - 0.1;
 
-	if(DV < 0.000001f)
+	int32 Iterations = 1;
+	if (ReachedSpeedSqr >= 0.0)
 	{
-		return PKey->Time;
+		if (SpeedPerFrame <= 0.0)
+		{
+			return false;
+		}
+
+		const double ReachedSpeed = FMath::Sqrt(ReachedSpeedSqr);
+		Iterations = FMath::Clamp(FMath::FloorToInt((float)(ReachedSpeed / SpeedPerFrame)) + 1, 1, MaxIterations + 1);
+
+		while (Iterations > 1 && FMath::Square((Iterations - 1) * SpeedPerFrame) > ReachedSpeedSqr)
+		{
+			--Iterations;
+		}
+
+		while (Iterations <= MaxIterations && FMath::Square(Iterations * SpeedPerFrame) <= ReachedSpeedSqr)
+		{
+			++Iterations;
+		}
 	}
 
-	const float DT = SKey->Time - PKey->Time;
+	if (Iterations > MaxIterations)
+	{
+		return false;
+	}
 
-	return ((DT / DV) * (DesiredDistance - (PKey->Value * Negator))) + PKey->Time;
+	OutIterations = Iterations;
+	OutStartDistance = (float)(SpeedPerFrame * DeltaTime * Iterations * (Iterations + 1) * 0.5);
+	return true;
 }
 
-bool UDistanceMatching::CalculateStartLocation(FVector& OutStartLocation, const float DeltaTime, const int32 MaxIterations) const
+bool UDistanceMatching::CalculateStartLocation_Iterative(FVector& OutStartLocation, const float DeltaTime, const int32 MaxIterations) const
 {
-	
 	const FVector TargetVelocity = MovementComponent->Velocity;
 	const FVector Acceleration = TargetVelocity.GetSafeNormal() * MovementComponent->GetMaxAcceleration();
 	const float Friction = FMath::Max(MovementComponent->GroundFriction, 0.0f);
 
+	FVector StartOffset = FVector::ZeroVector;
+	if (!SimulateStart(TargetVelocity, Acceleration, Friction, DeltaTime, MaxIterations, StartOffset))
+	{
+		return false;
+	}
+
+	OutStartLocation = ParentActor->GetActorLocation() + StartOffset;
+	return true;
+}
+
+bool UDistanceMatching::CalculateStopLocation_Iterative(FVector& OutStopLocation, const float DeltaTime, const int32 MaxIterations)
+{
+	FVector StopOffset = FVector::ZeroVector;
+	float StopTime = 0.0f;
+	if (!SimulateStop(MovementComponent->Velocity, MovementComponent->GetCurrentAcceleration(), 
+		MovementComponent->GroundFriction * MovementComponent->BrakingFrictionFactor, MovementComponent->BrakingDecelerationWalking,
+		DeltaTime, MaxIterations, StopOffset, StopTime))
+	{
+		return false;
+	}
+
+	TimeToMarker = StopTime;
+	OutStopLocation = ParentActor->GetActorLocation() + StopOffset;
+	return true;
+}
+
+bool UDistanceMatching::SimulateStart(const FVector& TargetVelocity, const FVector& Acceleration, const float Friction, const float DeltaTime,
+	const int32 MaxIterations, FVector& OutStartOffset)
+{
 	const float MIN_TICK_TIME = 1e-6;
 	if (DeltaTime < MIN_TICK_TIME)
 	{
@@ -506,8 +667,7 @@ bool UDistanceMatching::CalculateStartLocation(FVector& OutStartLocation, const
 	
 	FVector LastVelocity = FVector::ZeroVector;
 
-	
-	FVector CurrentLocation = ParentActor->GetActorLocation();
+	FVector CurrentLocation = FVector::ZeroVector;
 	int32 Iterations = 0;
 	while (Iterations < MaxIterations)
 	{
@@ -528,23 +688,17 @@ bool UDistanceMatching::CalculateStartLocation(FVector& OutStartLocation, const
 		if(TargetVelocity.SizeSquared() - LastVelocity.SizeSquared() < 0.1)
 		{
 			//Target Velocity reached
-			OutStartLocation = CurrentLocation;
-			break;
+			OutStartOffset = CurrentLocation;
+			return true;
 		}
-
 	}
 
-	return true;
+	return false;
 }
 
-bool UDistanceMatching::CalculateStopLocation(FVector& OutStopLocation, const float DeltaTime, const int32 MaxIterations)
+bool UDistanceMatching::SimulateStop(const FVector& Velocity, const FVector& Acceleration, float Friction, float BrakingDeceleration,
+	const float DeltaTime, const int32 MaxIterations, FVector& OutStopOffset, float& OutStopTime)
 {
-	const FVector CurrentLocation = ParentActor->GetActorLocation();
-	const FVector Velocity = MovementComponent->Velocity;
-	const FVector Acceleration = MovementComponent->GetCurrentAcceleration();
-	float Friction = MovementComponent->GroundFriction * MovementComponent->BrakingFrictionFactor;
-	float BrakingDeceleration = MovementComponent->BrakingDecelerationWalking;
-
 	const float MIN_TICK_TIME = 1e-6;
 	if (DeltaTime < MIN_TICK_TIME)
 	{
@@ -561,7 +715,7 @@ bool UDistanceMatching::CalculateStopLocation(FVector& OutStopLocation, const fl
 	BrakingDeceleration = FMath::Max(BrakingDeceleration, 0.0f);
 	Friction = FMath::Max(Friction, 0.0f);
 	const bool bZeroFriction = (Friction < 0.00001f);
-	const bool bZeroBraking = (BrakingDeceleration == 0.00001f);
+	const bool bZeroBraking = (BrakingDeceleration < 0.00001f);
 
 	//Won't stop if there is no Braking acceleration or friction
 	if (bZeroAcceleration && bZeroFriction && bZeroBraking)
@@ -572,7 +726,7 @@ bool UDistanceMatching::CalculateStopLocation(FVector& OutStopLocation, const fl
 	FVector LastVelocity = bZeroAcceleration ? Velocity : Velocity.ProjectOnToNormal(Acceleration.GetSafeNormal());
 	LastVelocity.Z = 0;
 
-	FVector LastLocation = CurrentLocation;
+	FVector LastLocation = FVector::ZeroVector;
 
 	int Iterations = 0;
 	float PredictionTime = 0.0f;
@@ -638,8 +792,8 @@ bool UDistanceMatching::CalculateStopLocation(FVector& OutStopLocation, const fl
 		if (VSizeSq <= 1.f
 			|| (LastVelocity | OldVel) <= 0.f)
 		{
-			TimeToMarker = PredictionTime;
-			OutStopLocation = LastLocation;
+			OutStopTime = PredictionTime;
+			OutStopOffset = LastLocation;
 			return true;
 		}
 	}
@@ -647,4 +801,115 @@ bool UDistanceMatching::CalculateStopLocation(FVector& OutStopLocation, const fl
 	return false;
 }
 
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDistanceMatchingPredictionTest, "MotionSymphony.DistanceMatching.ClosedFormPrediction",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDistanceMatchingPredictionTest::RunTest(const FString& Parameters)
+{
+	const int32 MaxIterations = 5000;
+	const float Speeds[] = { 15.0f, 100.0f, 237.0f, 450.0f, 600.0f, 1000.0f };
+	const float Frictions[] = { 0.0f, 0.5f, 2.0f, 8.0f, 40.0f };
+	const float Decelerations[] = { 0.0f, 256.0f, 2048.0f };
+	const float DeltaTimes[] = { 1.0f / 144.0f, 1.0f / 60.0f, 1.0f / 30.0f, 1.0f / 20.0f };
+
+	int32 CaseCount = 0;
+	int32 MismatchCount = 0;
+	float MaxDistanceError = 0.0f;
+
+	//Braking to a stop with no input acceleration
+	for (const float Speed : Speeds)
+	{
+		for (const float Friction : Frictions)
+		{
+			for (const float Deceleration : Decelerations)
+			{
+				for (const float DeltaTime : DeltaTimes)
+				{
+					float PredictedDistance = 0.0f;
+					float PredictedTime = 0.0f;
+					const bool bPredicted = UDistanceMatching::PredictBrakingStop(Speed, Friction, Deceleration,
+						DeltaTime, MaxIterations, PredictedDistance, PredictedTime);
+
+					FVector SimulatedOffset = FVector::ZeroVector;
+					float SimulatedTime = 0.0f;
+					const bool bSimulated = UDistanceMatching::SimulateStop(FVector(Speed, 0.0f, 0.0f), FVector::ZeroVector, Friction, Deceleration,
+						DeltaTime, MaxIterations, SimulatedOffset, SimulatedTime);
+
+					++CaseCount;
+					if (bPredicted != bSimulated)
+					{
+						++MismatchCount;
+						AddError(FString::Printf(TEXT("Stop from %f with friction %f, braking %f and delta time %f: predicted %d, simulated %d."),
+							Speed, Friction, Deceleration, DeltaTime, bPredicted, bSimulated));
+					}
+					else if (bPredicted)
+					{
+						const float DistanceError = FMath::Abs(PredictedDistance - SimulatedOffset.Size());
+						MaxDistanceError = FMath::Max(MaxDistanceError, DistanceError);
+
+						//A speed right on the stop threshold may be rounded to either side so the stop can be a frame apart
+						if (DistanceError > 1.0f || !FMath::IsNearlyEqual(PredictedTime, SimulatedTime, DeltaTime * 1.5f))
+						{
+							++MismatchCount;
+							AddError(FString::Printf(TEXT("Stop from %f with friction %f, braking %f and delta time %f: predicted %f cm in %f s, simulated %f cm in %f s."),
+								Speed, Friction, Deceleration, DeltaTime, PredictedDistance, PredictedTime, SimulatedOffset.Size(), SimulatedTime));
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//Accelerating from rest to the speed
+	const float Accelerations[] = { 500.0f, 2048.0f, 8000.0f };
+	for (const float Speed : Speeds)
+	{
+		for (const float Friction : Frictions)
+		{
+			for (const float Acceleration : Accelerations)
+			{
+				for (const float DeltaTime : DeltaTimes)
+				{
+					float PredictedDistance = 0.0f;
+					int32 PredictedIterations = 0;
+					const bool bPredicted = UDistanceMatching::PredictStartDistance(Speed, Acceleration, DeltaTime, 
+						MaxIterations, PredictedDistance, PredictedIterations);
+
+					FVector SimulatedOffset = FVector::ZeroVector;
+					const bool bSimulated = UDistanceMatching::SimulateStart(FVector(Speed, 0.0f, 0.0f), FVector(Acceleration, 0.0f, 0.0f), 
+						Friction, DeltaTime, MaxIterations, SimulatedOffset);
+
+					++CaseCount;
+					if (bPredicted != bSimulated)
+					{
+						++MismatchCount;
+						AddError(FString::Printf(TEXT("Start to %f with friction %f, acceleration %f and delta time %f: predicted %d, simulated %d."),
+							Speed, Friction, Acceleration, DeltaTime, bPredicted, bSimulated));
+					}
+					else if (bPredicted)
+					{
+						const float DistanceError = FMath::Abs(PredictedDistance - SimulatedOffset.Size());
+						MaxDistanceError = FMath::Max(MaxDistanceError, DistanceError);
+
+						if (DistanceError > 1.0f)
+						{
+							++MismatchCount;
+							AddError(FString::Printf(TEXT("Start to %f with friction %f, acceleration %f and delta time %f: predicted %f cm, simulated %f cm."),
+								Speed, Friction, Acceleration, DeltaTime, PredictedDistance, SimulatedOffset.Size()));
+						}
+					}
+				}
+			}
+		}
+	}
+
+	AddInfo(FString::Printf(TEXT("%d cases, %d mismatches, largest distance error %f cm."), CaseCount, MismatchCount, MaxDistanceError));
+
+	return MismatchCount == 0;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
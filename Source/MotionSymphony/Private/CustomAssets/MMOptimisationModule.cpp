@@ -30,6 +30,18 @@ TArray<FPoseMotionData>* UMMOptimisationModule::GetFilteredPoseList(const FPoseM
 	return nullptr;
 }
 
+TArray<FPoseMotionData>* UMMOptimisationModule::GetFilteredPoseListWithTrajectory(const FPoseMotionData& CurrentPose, 
+	const TArray<FTrajectoryPoint>& DesiredTrajectory, const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration)
+{
+	return GetFilteredPoseList(CurrentPose, RequiredTraits, FinalCalibration);
+}
+
+bool UMMOptimisationModule::GetFilteredPoseIds(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+	const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration, TArray<int32>& OutPoseIds)
+{
+	return false;
+}
+
 void UMMOptimisationModule::InitializeRuntime()
 {
 	bIsRuntimeInitialized = true;
@@ -44,4 +56,9 @@ bool UMMOptimisationModule::IsProcessedAndValid(const UMotionDataAsset* CheckMot
 
 void UMMOptimisationModule::DrawDebug(FPrimitiveDrawInterface* DrawInterface, const UWorld* World, const UMotionDataAsset* MotionData) const
 {
+}
+
+bool UMMOptimisationModule::BuildDebugDrawBatch(FMotionDebugDrawBatch& OutBatch, const UMotionDataAsset* MotionData) const
+{
+	return false;
 }
\ No newline at end of file
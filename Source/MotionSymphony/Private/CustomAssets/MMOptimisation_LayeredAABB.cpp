@@ -18,6 +18,12 @@ void UMMOptimisation_LayeredAABB::BuildOptimisationStructures(UMotionDataAsset*
 
 	for (FPoseMotionData& Pose : InMotionDataAsset->Poses)
 	{
+		//Pruned poses are culled here as the copies in each bin can't be checked against the motion data
+		if (InMotionDataAsset->IsPosePruned(Pose.PoseId))
+		{
+			continue;
+		}
+
 		TArray<FPoseMotionData>& PoseBin = PoseBins.FindOrAdd(Pose.Traits);
 		PoseBin.Add(Pose);
 	}
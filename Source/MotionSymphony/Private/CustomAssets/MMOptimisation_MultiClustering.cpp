@@ -3,6 +3,7 @@
 #include "CustomAssets/MMOptimisation_MultiClustering.h"
 #include "CustomAssets/MotionDataAsset.h"
 #include "MotionMatchingUtil/MotionMatchingUtils.h"
+#include "MotionMatchingUtil/MotionDebugDrawBatch.h"
 
 UMMOptimisation_MultiClustering::UMMOptimisation_MultiClustering(const FObjectInitializer& ObjectInitializer)
 	: UMMOptimisationModule(ObjectInitializer),
@@ -21,6 +22,11 @@ void UMMOptimisation_MultiClustering::BuildOptimisationStructures(UMotionDataAss
 
 	for (FPoseMotionData& Pose : InMotionDataAsset->Poses)
 	{
+		if (InMotionDataAsset->IsPosePruned(Pose.PoseId))
+		{
+			continue;
+		}
+
 		TArray<FPoseMotionData>& PoseBin = PoseBins.FindOrAdd(Pose.Traits);
 		PoseBin.Add(FPoseMotionData(Pose));
 	}
@@ -187,3 +193,34 @@ void UMMOptimisation_MultiClustering::DrawDebug(FPrimitiveDrawInterface* DrawInt
 
 	//Todo: Draw pose lookup table data
 }
+
+bool UMMOptimisation_MultiClustering::BuildDebugDrawBatch(FMotionDebugDrawBatch& OutBatch, const UMotionDataAsset* MotionData) const
+{
+	if (!MotionData
+		|| !MotionData->bIsProcessed
+		|| !MotionData->bOptimize
+		|| MotionData->OptimisationModule != this)
+	{
+		return true;
+	}
+
+	//Trajectory clusters. Each sample trajectory is anchored at its last point for screen space LOD
+#if WITH_EDITORONLY_DATA
+	TArray<FVector> Points;
+	for (const FKMCluster& Cluster : KMeansClusteringSet.Clusters)
+	{
+		for (const FPoseMotionData& Pose : Cluster.Samples)
+		{
+			Points.Reset(Pose.Trajectory.Num());
+			for (const FTrajectoryPoint& Point : Pose.Trajectory)
+			{
+				Points.Add(Point.Position);
+			}
+
+			OutBatch.AddPolyline(Points, Cluster.DebugDrawColor);
+		}
+	}
+#endif
+
+	return true;
+}
@@ -0,0 +1,213 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "CustomAssets/MMOptimisation_ProductQuantisation.h"
+#include "CustomAssets/MotionDataAsset.h"
+
+bool FPoseQuantizedSet::IsValid() const
+{
+	return Quantizer.IsValid()
+		&& Quantizer.ItemCount == PoseIds.Num()
+		&& Quantizer.FeatureCount == FeatureScales.Num();
+}
+
+UMMOptimisation_ProductQuantisation::UMMOptimisation_ProductQuantisation(const FObjectInitializer& ObjectInitializer)
+	: UMMOptimisationModule(ObjectInitializer),
+	SubspaceCount(8),
+	CodebookSize(256),
+	TrainingIterations(16),
+	TrainingSampleLimit(16384),
+	RerankCount(64)
+{
+}
+
+void UMMOptimisation_ProductQuantisation::BuildOptimisationStructures(UMotionDataAsset* InMotionDataAsset)
+{
+	Super::BuildOptimisationStructures(InMotionDataAsset);
+
+	QuantizedSets.Empty();
+
+	TMap<FMotionTraitField, TArray<int32>> TraitPoseIds;
+	for (const FPoseMotionData& Pose : InMotionDataAsset->Poses)
+	{
+		if (InMotionDataAsset->IsPoseSearchable(Pose.PoseId))
+		{
+			TraitPoseIds.FindOrAdd(Pose.Traits).Add(Pose.PoseId);
+		}
+	}
+
+	for (TPair<FMotionTraitField, TArray<int32>>& TraitPair : TraitPoseIds)
+	{
+		const FCalibrationData* StdDeviations = InMotionDataAsset->FeatureStandardDeviations.Find(TraitPair.Key);
+		if (!StdDeviations)
+		{
+			continue;
+		}
+
+		const int32 JointCount = StdDeviations->PoseJointWeights.Num();
+		const int32 TrajectoryCount = StdDeviations->TrajectoryWeights.Num();
+		const int32 FeatureCount = GetFeatureCount(JointCount, TrajectoryCount);
+
+		FPoseQuantizedSet QuantizedSet;
+		for (const int32 PoseId : TraitPair.Value)
+		{
+			const FPoseMotionData& Pose = InMotionDataAsset->Poses[PoseId];
+			if (Pose.JointData.Num() == JointCount && Pose.Trajectory.Num() == TrajectoryCount)
+			{
+				QuantizedSet.PoseIds.Add(PoseId);
+			}
+		}
+
+		const int32 PoseCount = QuantizedSet.PoseIds.Num();
+		if (PoseCount == 0)
+		{
+			continue;
+		}
+
+		//Feature scales normalise each feature group by its standard deviation
+		QuantizedSet.FeatureScales.Reset(FeatureCount);
+		auto AddScale = [&QuantizedSet](const float Scale, const int32 Width)
+		{
+			for (int32 i = 0; i < Width; ++i)
+			{
+				QuantizedSet.FeatureScales.Add(FMath::IsFinite(Scale) ? FMath::Max(Scale, 0.0f) : 0.0f);
+			}
+		};
+
+		AddScale(StdDeviations->Weight_Momentum, 3);
+		for (const FJointWeightSet& WeightSet : StdDeviations->PoseJointWeights)
+		{
+			AddScale(WeightSet.Weight_Pos, 3);
+			AddScale(WeightSet.Weight_Vel, 3);
+		}
+
+		for (const FTrajectoryWeightSet& WeightSet : StdDeviations->TrajectoryWeights)
+		{
+			AddScale(WeightSet.Weight_Pos, 3);
+		}
+
+		TArray<float> Features;
+		Features.SetNumUninitialized(PoseCount * FeatureCount);
+		for (int32 i = 0; i < PoseCount; ++i)
+		{
+			const FPoseMotionData& Pose = InMotionDataAsset->Poses[QuantizedSet.PoseIds[i]];
+			GatherFeatures(Pose.LocalVelocity, Pose.JointData, Pose.Trajectory, QuantizedSet.FeatureScales, &Features[i * FeatureCount]);
+		}
+
+		QuantizedSet.Quantizer.Train(Features, PoseCount, FeatureCount, SubspaceCount, CodebookSize, TrainingIterations, TrainingSampleLimit);
+
+		if (QuantizedSet.IsValid())
+		{
+			UE_LOG(LogTemp, Log, TEXT("Motion data '%s' product quantisation: %d poses, %d features in %d sub-spaces, %d KB."),
+				*InMotionDataAsset->GetName(), PoseCount, FeatureCount, QuantizedSet.Quantizer.GetSubspaceCount(),
+				(int32)(QuantizedSet.Quantizer.GetAllocatedSize() / 1024));
+
+			QuantizedSets.Add(TraitPair.Key, MoveTemp(QuantizedSet));
+		}
+	}
+}
+
+TArray<FPoseMotionData>* UMMOptimisation_ProductQuantisation::GetFilteredPoseList(const FPoseMotionData& CurrentPose,
+	const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration)
+{
+	//The candidates are returned as pose ids by GetFilteredPoseIds
+	return nullptr;
+}
+
+bool UMMOptimisation_ProductQuantisation::GetFilteredPoseIds(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+	const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration, TArray<int32>& OutPoseIds)
+{
+	const FPoseQuantizedSet* QuantizedSet = QuantizedSets.Find(RequiredTraits);
+	if (!QuantizedSet || !ParentMotionDataAsset)
+	{
+		return false;
+	}
+
+	const FPoseProductQuantizer& Quantizer = QuantizedSet->Quantizer;
+	const int32 FeatureCount = Quantizer.FeatureCount;
+	if (GetFeatureCount(CurrentPose.JointData.Num(), DesiredTrajectory.Num()) != FeatureCount
+		|| GetFeatureCount(FinalCalibration.PoseJointWeights.Num(), FinalCalibration.TrajectoryWeights.Num()) != FeatureCount)
+	{
+		return false;
+	}
+
+	//Searches can run on worker threads so the scratch data is per thread. None of it outlives this call.
+	static thread_local TArray<float> QueryFeatures;
+	static thread_local TArray<float> ColumnWeights;
+	static thread_local TArray<float> DistanceTable;
+	static thread_local TArray<int32> NearestItems;
+
+	QueryFeatures.SetNumUninitialized(FeatureCount, false);
+	GatherFeatures(CurrentPose.LocalVelocity, CurrentPose.JointData, DesiredTrajectory, QuantizedSet->FeatureScales, QueryFeatures.GetData());
+
+	//Column weights convert normalised squared distances back into the runtime calibration's cost. The pose and
+	//trajectory multipliers of the query are left to the exact re-rank.
+	ColumnWeights.SetNumUninitialized(FeatureCount, false);
+	int32 Column = 0;
+	auto AddWeight = [&QuantizedSet, &Column](const float RuntimeWeight, const int32 Width)
+	{
+		for (int32 i = 0; i < Width; ++i, ++Column)
+		{
+			const float FeatureScale = QuantizedSet->FeatureScales[Column];
+			ColumnWeights[Column] = FeatureScale > 0.0f ? RuntimeWeight / (FeatureScale * FeatureScale) : 0.0f;
+		}
+	};
+
+	AddWeight(FinalCalibration.Weight_Momentum, 3);
+	for (const FJointWeightSet& WeightSet : FinalCalibration.PoseJointWeights)
+	{
+		AddWeight(WeightSet.Weight_Pos, 3);
+		AddWeight(WeightSet.Weight_Vel, 3);
+	}
+
+	for (const FTrajectoryWeightSet& WeightSet : FinalCalibration.TrajectoryWeights)
+	{
+		AddWeight(WeightSet.Weight_Pos, 3);
+	}
+
+	Quantizer.ComputeDistanceTable(QueryFeatures.GetData(), ColumnWeights.GetData(), DistanceTable);
+	Quantizer.FindNearest(DistanceTable, RerankCount, NearestItems);
+
+	OutPoseIds.SetNumUninitialized(NearestItems.Num(), false);
+	for (int32 i = 0; i < NearestItems.Num(); ++i)
+	{
+		OutPoseIds[i] = QuantizedSet->PoseIds[NearestItems[i]];
+	}
+
+	return OutPoseIds.Num() > 0;
+}
+
+bool UMMOptimisation_ProductQuantisation::IsProcessedAndValid(const UMotionDataAsset* CheckMotionData) const
+{
+	return Super::IsProcessedAndValid(CheckMotionData)
+		&& QuantizedSets.Num() > 0;
+}
+
+int32 UMMOptimisation_ProductQuantisation::GetFeatureCount(const int32 JointCount, const int32 TrajectoryCount)
+{
+	return 3 + JointCount * 6 + TrajectoryCount * 3;
+}
+
+void UMMOptimisation_ProductQuantisation::GatherFeatures(const FVector& LocalVelocity, const TArray<FJointData>& JointData,
+	const TArray<FTrajectoryPoint>& Trajectory, const TArray<float>& FeatureScales, float* OutFeatures)
+{
+	int32 Column = 0;
+	auto AddVector = [&FeatureScales, &Column, OutFeatures](const FVector& Value)
+	{
+		OutFeatures[Column] = Value.X * FeatureScales[Column]; ++Column;
+		OutFeatures[Column] = Value.Y * FeatureScales[Column]; ++Column;
+		OutFeatures[Column] = Value.Z * FeatureScales[Column]; ++Column;
+	};
+
+	AddVector(LocalVelocity);
+
+	for (const FJointData& Joint : JointData)
+	{
+		AddVector(Joint.Position);
+		AddVector(Joint.Velocity);
+	}
+
+	for (const FTrajectoryPoint& Point : Trajectory)
+	{
+		AddVector(Point.Position);
+	}
+}
@@ -15,7 +15,7 @@ void UMMOptimisation_TraitBins::BuildOptimisationStructures(UMotionDataAsset* In
 
 	for (FPoseMotionData& Pose : InMotionDataAsset->Poses)
 	{
-		if(Pose.bDoNotUse)
+		if(!InMotionDataAsset->IsPoseSearchable(Pose.PoseId))
 			continue;
 
 		FPoseBin& PoseBin = PoseBins.FindOrAdd(Pose.Traits);
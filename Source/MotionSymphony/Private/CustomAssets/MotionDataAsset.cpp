@@ -13,10 +13,15 @@
 #include "Tags/TagSection.h"
 #include "Tags/TagPoint.h"
 #include "MotionMatchingUtil/MMBlueprintFunctionLibrary.h"
+#include "Data/CookedPoseDatabase.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Misc/AutomationTest.h"
 
 #if WITH_EDITOR
 #include "AnimationEditorUtils.h"
 #include "Misc/MessageDialog.h"
+#include "Interfaces/ITargetPlatform.h"
 #endif
 
 
@@ -57,7 +62,16 @@ UMotionDataAsset::UMotionDataAsset(const FObjectInitializer& ObjectInitializer)
 	MotionMatchConfig(nullptr),
 	JointVelocityCalculationMethod(EJointVelocityCalculationMethod::BodyDependent),
 	NotifyTriggerMode(ENotifyTriggerMode::HighestWeightedAnimation),
+	NotifyRelevancyWeight(0.0f),
 	bOptimize(true),
+	bBuildPCAPrefilter(false),
+	PCATargetVariance(0.95f),
+	PCAMaxDimensions(12),
+	bPruneRedundantPoses(false),
+	PruneCostEpsilon(0.1f),
+	PrunedPoseCount(0),
+	PruneSearchTimeSaving(0.0f),
+	PruneMaxCostIncrease(0.0f),
 	OptimisationModule(nullptr),
 	PreprocessCalibration(nullptr),
 	MirroringProfile(nullptr),
@@ -471,26 +485,42 @@ void UMotionDataAsset::PreProcess()
 	
 
 	GeneratePoseSequencing();
+	UpdateTrajectoryFacings();
 
 	MMPreProcessTask.EnterProgressFrame();
 
-	//Standard deviations
-	//First Find a list of traits
-	TArray<FMotionTraitField> UsedMotionTraits;
-	for (int32 i = 0; i < Poses.Num(); ++i)
+	//Standard deviations for each used trait
+	FCalibrationData::GenerateStandardDeviationWeights(this, FeatureStandardDeviations);
+
+	PreprocessCalibration->Initialize();
+
+	if (bPruneRedundantPoses)
+	{
+		PruneRedundantPoses();
+	}
+	else
 	{
-		UsedMotionTraits.AddUnique(Poses[i].Traits);
+		PrunedPoseBitmap.Empty();
+		PrunedPoseCount = 0;
+		PruneSearchTimeSaving = 0.0f;
+		PruneMaxCostIncrease = 0.0f;
 	}
 
-	FeatureStandardDeviations.Empty(UsedMotionTraits.Num());
+	BuildFeatureGroupOrders();
 
-	for (const FMotionTraitField& MotionTrait : UsedMotionTraits)
+	if (bBuildPCAPrefilter)
+	{
+		BuildPCAPrefilters();
+	}
+	else
 	{
-		FCalibrationData& NewCalibrationData = FeatureStandardDeviations.Add(MotionTrait, FCalibrationData(this));
-		NewCalibrationData.GenerateStandardDeviationWeights(this, MotionTrait);
+		PCAPrefilters.Empty();
 	}
 
-	PreprocessCalibration->Initialize();
+	BuildTraitPoseBitmaps();
+	BuildTraitSearchIndex();
+	BuildFeatureBounds();
+	BuildActionIndex();
 
 	if(bOptimize && OptimisationModule)
 	{
@@ -513,6 +543,21 @@ void UMotionDataAsset::PreProcess()
 void UMotionDataAsset::ClearPoses()
 {
 	Poses.Empty();
+	TraitPoseBitmaps.Empty();
+	UsablePoseBitmap.Empty();
+	PrunedPoseBitmap.Empty();
+	UsedTraitPositions.Empty();
+	TraitSearchPoseIds.Empty();
+	TraitSearchMomenta.Empty();
+	TraitSearchRanges.Empty();
+	PoseRanges.Empty();
+	BlendSampleWeights.Empty();
+	AnimPoseRangeLookup.Empty();
+	Actions.Empty();
+	ActionIndex.Empty();
+	ActionIndexRanges.Empty();
+	PCAPrefilters.Empty();
+	FeatureBounds.Empty();
 	DistanceMatchSections.Empty();
 	bIsProcessed = false;
 }
@@ -655,6 +700,97 @@ void UMotionDataAsset::AddAction(const FPoseMotionData& ClosestPose, const FMoti
 	}
 }
 
+/** Strict weak ordering of trait fields so that actions and poses with the same traits are contiguous in their indices */
+static bool IsTraitFieldLess(const FMotionTraitField& A, const FMotionTraitField& B)
+{
+	for (int32 WordIndex = 0; WordIndex < MOTION_TRAIT_FIELD_WORDS; ++WordIndex)
+	{
+		const uint32 WordA = (uint32)A.GetWord(WordIndex);
+		const uint32 WordB = (uint32)B.GetWord(WordIndex);
+
+		if (WordA != WordB)
+		{
+			return WordA < WordB;
+		}
+	}
+
+	return false;
+}
+
+void UMotionDataAsset::BuildActionIndex()
+{
+	ActionIndex.Empty(Actions.Num());
+	ActionIndexRanges.Empty();
+
+	for (int32 i = 0; i < Actions.Num(); ++i)
+	{
+		ActionIndex.Add(i);
+	}
+
+	ActionIndex.StableSort([this](const int32 A, const int32 B)
+	{
+		const FMotionAction& ActionA = Actions[A];
+		const FMotionAction& ActionB = Actions[B];
+
+		if (ActionA.ActionId != ActionB.ActionId)
+		{
+			return ActionA.ActionId < ActionB.ActionId;
+		}
+
+		return IsTraitFieldLess(ActionA.Trait, ActionB.Trait);
+	});
+
+	for (int32 i = 0; i < ActionIndex.Num(); ++i)
+	{
+		FIntPoint& Range = ActionIndexRanges.FindOrAdd(Actions[ActionIndex[i]].ActionId, FIntPoint(i, 0));
+		++Range.Y;
+	}
+}
+
+bool UMotionDataAsset::GetActionCandidates(const int32 ActionId, const FMotionTraitField& Traits, int32& OutStart, int32& OutEnd) const
+{
+	const FIntPoint* Range = ActionIndexRanges.Find(ActionId);
+
+	if (!Range || Range->Y < 1)
+	{
+		return false;
+	}
+
+	OutStart = Range->X;
+	OutEnd = Range->X + Range->Y;
+
+	//Binary search for the first action with the traits, then walk to the end of that trait's run
+	int32 First = OutStart;
+	int32 Count = Range->Y;
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+		if (IsTraitFieldLess(Actions[ActionIndex[First + Step]].Trait, Traits))
+		{
+			First += Step + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+
+	int32 Last = First;
+	while (Last < OutEnd && Actions[ActionIndex[Last]].Trait == Traits)
+	{
+		++Last;
+	}
+
+	if (Last > First)
+	{
+		OutStart = First;
+		OutEnd = Last;
+	}
+
+	return true;
+}
+
 float UMotionDataAsset::GetPoseInterval() const
 {
 	return PoseInterval;
@@ -683,13 +819,337 @@ void UMotionDataAsset::PostLoad()
 	{
 		MotionBlendSpace.ParentMotionDataAsset = this;
 	}
+
+	for (TPair<FDistanceMatchIdentifier, FDistanceMatchGroup>& DistanceMatchGroupPair : DistanceMatchSections)
+	{
+		for (FDistanceMatchSection& DistanceMatchSection : DistanceMatchGroupPair.Value.DistanceMatchSections)
+		{
+			DistanceMatchSection.BakeDistanceCurve();
+		}
+	}
+
+	//Cooked assets load their search index with the pose database
+	const bool bHasCookedSearchIndex = LoadCookedPoseDatabase();
+
+	//Assets processed before trajectory facings were stored as directions. The facing standard deviations of these were
+	//measured in degrees so the facing weights are wrong until the asset is pre-processed again. Optimisation modules
+	//hold their own pose copies and cluster centers built with the old facings, so they are invalid until then as well
+	if (UpdateTrajectoryFacings() > 0 && bIsProcessed)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("MotionDataAsset '%s' was pre-processed before trajectory facing directions were stored. Re-preprocess it to update the facing calibration and optimisation."),
+			*GetName());
+
+		if (OptimisationModule)
+		{
+			OptimisationModule->bIsProcessed = false;
+		}
+
+		bIsOptimised = false;
+	}
+
+	//Assets processed before pose ranges were serialized
+	if (PoseRanges.Num() == 0 && Poses.Num() > 0)
+	{
+		BuildPoseRanges();
+	}
+
+	BuildPoseRangeLookup();
+	BuildTraitPoseBitmaps();
+
+	if (bHasCookedSearchIndex)
+	{
+		BuildTraitSearchRanges();
+	}
+	else
+	{
+		BuildTraitSearchIndex();
+	}
+
+	BuildActionIndex();
+}
+
+bool UMotionDataAsset::LoadCookedPoseDatabase()
+{
+	if (CookedPoseData.GetBulkDataSize() == 0)
+	{
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int64 BlobSize = CookedPoseData.GetBulkDataSize();
+
+	//The whole blob is a single allocation (or a mapped file region) which is unpacked and then released. The unpacked
+	//poses are allocated the same way as those of an uncooked asset
+	const uint8* BlobData = static_cast<const uint8*>(CookedPoseData.LockReadOnly());
+	const bool bSuccess = FCookedPoseDatabase::Unpack(BlobData, BlobSize, Poses, TraitSearchPoseIds, PrunedPoseBitmap);
+	CookedPoseData.Unlock();
+	CookedPoseData.RemoveBulkData();
+
+	if (!bSuccess)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionDataAsset '%s': The cooked pose database is invalid or out of date. Please re-cook the asset."), *GetName());
+		Poses.Empty();
+		bIsProcessed = false;
+		return false;
+	}
+
+	UE_LOG(LogTemp, Verbose, TEXT("MotionDataAsset '%s': Loaded %d poses from a %lld byte cooked pose database in %.3fms"),
+		*GetName(), Poses.Num(), BlobSize, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	return true;
+}
+
+void UMotionDataAsset::GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize)
+{
+	Super::GetResourceSizeEx(CumulativeResourceSize);
+
+	SIZE_T PoseSize = Poses.GetAllocatedSize();
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		PoseSize += Pose.Trajectory.GetAllocatedSize() + Pose.JointData.GetAllocatedSize();
+	}
+
+	SIZE_T TraitBitmapSize = TraitPoseBitmaps.GetAllocatedSize() + UsablePoseBitmap.GetAllocatedSize() + PrunedPoseBitmap.GetAllocatedSize();
+	for (const TArray<uint64>& TraitPoseBitmap : TraitPoseBitmaps)
+	{
+		TraitBitmapSize += TraitPoseBitmap.GetAllocatedSize();
+	}
+
+	const SIZE_T TraitSearchIndexSize = TraitSearchPoseIds.GetAllocatedSize() + TraitSearchMomenta.GetAllocatedSize()
+		+ TraitSearchRanges.GetAllocatedSize();
+
+	CumulativeResourceSize.AddDedicatedSystemMemoryBytes(PoseSize + TraitBitmapSize + TraitSearchIndexSize);
+}
+
+void UMotionDataAsset::BuildTraitPoseBitmaps()
+{
+	const int32 WordCount = FMath::DivideAndRoundUp(Poses.Num(), 64);
+
+	TraitPoseBitmaps.Empty(MOTION_TRAIT_FIELD_BITS);
+	TraitPoseBitmaps.SetNum(MOTION_TRAIT_FIELD_BITS);
+	UsablePoseBitmap.Init(0, WordCount);
+	UsedTraitPositions.Empty();
+
+	TArray<int32> PoseTraitPositions;
+	for (int32 PoseId = 0; PoseId < Poses.Num(); ++PoseId)
+	{
+		const FPoseMotionData& Pose = Poses[PoseId];
+		const uint64 PoseBit = 1ull << (PoseId % 64);
+		const int32 WordIndex = PoseId / 64;
+
+		if (!Pose.bDoNotUse && !IsPosePruned(PoseId))
+		{
+			UsablePoseBitmap[WordIndex] |= PoseBit;
+		}
+
+		PoseTraitPositions.Reset();
+		Pose.Traits.GetTraitPositions(PoseTraitPositions);
+		for (const int32 TraitPosition : PoseTraitPositions)
+		{
+			TArray<uint64>& TraitBitmap = TraitPoseBitmaps[TraitPosition];
+
+			if (TraitBitmap.Num() == 0)
+			{
+				TraitBitmap.Init(0, WordCount);
+				UsedTraitPositions.Add(TraitPosition);
+			}
+
+			TraitBitmap[WordIndex] |= PoseBit;
+		}
+	}
+
+	UsedTraitPositions.Sort();
+}
+
+void UMotionDataAsset::GetTraitPoseMask(const FMotionTraitField& Traits, TArray<uint64>& OutPoseMask) const
+{
+	OutPoseMask = UsablePoseBitmap;
+
+	//A required trait that no pose has can never be matched
+	TArray<int32> RequiredTraitPositions;
+	Traits.GetTraitPositions(RequiredTraitPositions);
+	for (const int32 TraitPosition : RequiredTraitPositions)
+	{
+		if (!TraitPoseBitmaps.IsValidIndex(TraitPosition) 
+			|| TraitPoseBitmaps[TraitPosition].Num() == 0)
+		{
+			FMemory::Memzero(OutPoseMask.GetData(), OutPoseMask.Num() * sizeof(uint64));
+			return;
+		}
+	}
+
+	//Poses must have every required trait and none of the other traits used in the database
+	const int32 WordCount = OutPoseMask.Num();
+	for (const int32 TraitPosition : UsedTraitPositions)
+	{
+		const uint64* TraitWords = TraitPoseBitmaps[TraitPosition].GetData();
+		uint64* MaskWords = OutPoseMask.GetData();
+
+		if (Traits.HasTrait(TraitPosition))
+		{
+			for (int32 i = 0; i < WordCount; ++i)
+			{
+				MaskWords[i] &= TraitWords[i];
+			}
+		}
+		else
+		{
+			for (int32 i = 0; i < WordCount; ++i)
+			{
+				MaskWords[i] &= ~TraitWords[i];
+			}
+		}
+	}
+}
+
+int32 UMotionDataAsset::UpdateTrajectoryFacings()
+{
+	int32 ChangedCount = 0;
+	for (FPoseMotionData& Pose : Poses)
+	{
+		for (FTrajectoryPoint& Point : Pose.Trajectory)
+		{
+			const FVector2D Facing = FTrajectoryPoint::GetFacingDirection(Point.RotationZ);
+			if (!Point.Facing.Equals(Facing, KINDA_SMALL_NUMBER))
+			{
+				Point.Facing = Facing;
+				++ChangedCount;
+			}
+		}
+	}
+
+	return ChangedCount;
+}
+
+void UMotionDataAsset::BuildTraitSearchIndex()
+{
+	TraitSearchPoseIds.Empty(Poses.Num());
+
+	for (int32 PoseId = 0; PoseId < Poses.Num(); ++PoseId)
+	{
+		if (!Poses[PoseId].bDoNotUse && !IsPosePruned(PoseId))
+		{
+			TraitSearchPoseIds.Add(PoseId);
+		}
+	}
+
+	//Stable so that poses stay in pose id order within each trait set
+	TraitSearchPoseIds.StableSort([this](const int32 A, const int32 B)
+	{
+		return IsTraitFieldLess(Poses[A].Traits, Poses[B].Traits);
+	});
+
+	BuildTraitSearchRanges();
+}
+
+void UMotionDataAsset::BuildTraitSearchRanges()
+{
+	TraitSearchMomenta.Empty(TraitSearchPoseIds.Num());
+	TraitSearchRanges.Empty();
+
+	for (int32 i = 0; i < TraitSearchPoseIds.Num(); ++i)
+	{
+		const FPoseMotionData& Pose = Poses[TraitSearchPoseIds[i]];
+		TraitSearchMomenta.Add(FVector4(Pose.LocalVelocity, Pose.RotationalVelocity));
+
+		FIntPoint& Range = TraitSearchRanges.FindOrAdd(Pose.Traits, FIntPoint(i, 0));
+		++Range.Y;
+	}
+}
+
+bool UMotionDataAsset::GetTraitSearchRange(const FMotionTraitField& Traits, int32& OutStart, int32& OutEnd) const
+{
+	const FIntPoint* Range = TraitSearchRanges.Find(Traits);
+
+	if (!Range || Range->Y < 1)
+	{
+		OutStart = 0;
+		OutEnd = 0;
+		return false;
+	}
+
+	OutStart = Range->X;
+	OutEnd = Range->X + Range->Y;
+	return true;
 }
 
 void UMotionDataAsset::Serialize(FArchive& Ar)
 {
+	//When cooking, the pose database and its search indices are written as a compact bulk data blob and stripped from the 
+	//tagged properties
+	bool bHasCookedPoseData = false;
+	TArray<FPoseMotionData> StrippedPoses;
+	TArray<uint64> StrippedPrunedPoseBitmap;
+
+#if WITH_EDITOR
+	if (Ar.IsSaving() && Ar.IsCooking() && bIsProcessed && FCookedPoseDatabase::CanPack(Poses))
+	{
+		BuildTraitSearchIndex();
+
+		TArray<uint8> Blob;
+		FCookedPoseDatabase::Pack(Poses, TraitSearchPoseIds, PrunedPoseBitmap, Blob);
+
+		CookedPoseData.Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(CookedPoseData.Realloc(Blob.Num()), Blob.GetData(), Blob.Num());
+		CookedPoseData.Unlock();
+
+		uint32 BulkDataFlags = BULKDATA_Force_NOT_InlinePayload;
+		if (Ar.CookingTarget()->SupportsFeature(ETargetPlatformFeatures::MemoryMappedFiles))
+		{
+			BulkDataFlags |= BULKDATA_MemoryMappedPayload;
+		}
+		CookedPoseData.SetBulkDataFlags(BulkDataFlags);
+
+		bHasCookedPoseData = true;
+		Swap(StrippedPoses, Poses);
+		Swap(StrippedPrunedPoseBitmap, PrunedPoseBitmap);
+	}
+#endif
+
 	Super::Super::Serialize(Ar);
+
+	if (Ar.IsFilterEditorOnly())
+	{
+		Ar << bHasCookedPoseData;
+
+		if (bHasCookedPoseData)
+		{
+			//The payload is stored after the export data so it can be mapped instead of read where the platform allows
+			const bool bAttemptFileMapping = Ar.IsLoading() && FPlatformProperties::SupportsMemoryMappedFiles();
+			CookedPoseData.Serialize(Ar, this, INDEX_NONE, bAttemptFileMapping);
+		}
+	}
+
+#if WITH_EDITOR
+	//The tagged properties have been written so the poses can be restored. The bulk data payload is only written by the 
+	//linker once the package has been saved, so it is kept until PostSaveRoot
+	if (Ar.IsSaving() && bHasCookedPoseData)
+	{
+		Swap(StrippedPoses, Poses);
+		Swap(StrippedPrunedPoseBitmap, PrunedPoseBitmap);
+	}
+#endif
 }
 
+#if WITH_EDITOR
+#if ENGINE_MAJOR_VERSION > 4
+void UMotionDataAsset::PostSaveRoot(FObjectPostSaveRootContext ObjectSaveContext)
+{
+	Super::PostSaveRoot(ObjectSaveContext);
+#else
+void UMotionDataAsset::PostSaveRoot(bool bCleanupIsRequired)
+{
+	Super::PostSaveRoot(bCleanupIsRequired);
+#endif
+
+	//The cooked pose database payload has been written by now
+	if (CookedPoseData.GetBulkDataSize() > 0)
+	{
+		CookedPoseData.RemoveBulkData();
+	}
+}
+#endif
+
 #if WITH_EDITOR
 void UMotionDataAsset::RemapTracksToNewSkeleton(USkeleton* NewSkeleton, bool bConvertSpaces)
 {
@@ -702,7 +1162,17 @@ void UMotionDataAsset::TickAssetPlayer(FAnimTickRecord& Instance, FAnimNotifyQue
 	const float DeltaTime = Context.GetDeltaTime();
 	const bool bGenerateNotifies = NotifyTriggerMode != ENotifyTriggerMode::None;
 
-	TArray<FAnimNotifyEventReference> Notifies;
+	//Nothing to do per channel if there are no notifies or root motion to gather
+	if (!bGenerateNotifies && Context.RootMotionMode != ERootMotionMode::RootMotionFromEverything)
+	{
+		return;
+	}
+
+	//The engine's notify gathering functions require the default allocator so a scratch array is reused per thread instead. 
+	//Reset keeps the allocation so that ticking doesn't allocate once the array has grown to fit.
+	static thread_local TArray<FAnimNotifyEventReference> NotifyScratch;
+	TArray<FAnimNotifyEventReference>& Notifies = NotifyScratch;
+	Notifies.Reset();
 	
 	const TArray<FAnimChannelState>* BlendChannels = reinterpret_cast<TArray<FAnimChannelState>*>(Instance.BlendSpace.BlendSampleDataCache);
 	
@@ -716,12 +1186,19 @@ void UMotionDataAsset::TickAssetPlayer(FAnimTickRecord& Instance, FAnimNotifyQue
 			&& ChannelState.Weight > ZERO_ANIMWEIGHT_THRESH)
 		{
 			float ChannelWeight;
+
+			//Irrelevant channels still need to be ticked for root motion but don't gather notifies
+			const bool bChannelNotifies = bGenerateNotifies && (NotifyTriggerMode != ENotifyTriggerMode::AllAnimations 
+				|| ChannelState.Weight >= NotifyRelevancyWeight);
+
+			//Channels from other databases searched by the node are ticked against their own source animations
+			const UMotionDataAsset* ChannelMotionData = ChannelState.MotionData ? ChannelState.MotionData : this;
 			
 			switch (ChannelState.AnimType)
 			{
-				case EMotionAnimAssetType::Sequence: { ChannelWeight = TickAnimChannelForSequence(ChannelState, Context, Notifies, HighestWeight, DeltaTime, bGenerateNotifies); } break;
-				case EMotionAnimAssetType::BlendSpace: { ChannelWeight = TickAnimChannelForBlendSpace(ChannelState, Context, Notifies, HighestWeight, DeltaTime, bGenerateNotifies); } break;
-				case EMotionAnimAssetType::Composite: { ChannelWeight = TickAnimChannelForComposite(ChannelState, Context, Notifies, HighestWeight, DeltaTime, bGenerateNotifies); } break;
+				case EMotionAnimAssetType::Sequence: { ChannelWeight = ChannelMotionData->TickAnimChannelForSequence(ChannelState, Context, Notifies, HighestWeight, DeltaTime, bChannelNotifies); } break;
+				case EMotionAnimAssetType::BlendSpace: { ChannelWeight = ChannelMotionData->TickAnimChannelForBlendSpace(ChannelState, Context, Notifies, HighestWeight, DeltaTime, bChannelNotifies); } break;
+				case EMotionAnimAssetType::Composite: { ChannelWeight = ChannelMotionData->TickAnimChannelForComposite(ChannelState, Context, Notifies, HighestWeight, DeltaTime, bChannelNotifies); } break;
 				default: { continue; } break;
 			}
 
@@ -735,16 +1212,18 @@ void UMotionDataAsset::TickAssetPlayer(FAnimTickRecord& Instance, FAnimNotifyQue
 
 	if (bGenerateNotifies)
 	{
-		if (NotifyTriggerMode == ENotifyTriggerMode::HighestWeightedAnimation)
+		if (NotifyTriggerMode == ENotifyTriggerMode::HighestWeightedAnimation
+			&& BlendChannels->IsValidIndex(HighestWeightChannelId))
 		{
 			const FAnimChannelState& ChannelState = (*BlendChannels)[HighestWeightChannelId];
+			const UMotionDataAsset* ChannelMotionData = ChannelState.MotionData ? ChannelState.MotionData : this;
 			float PreviousTime = ChannelState.AnimTime - DeltaTime;
 
 			switch (ChannelState.AnimType)
 			{
 				case EMotionAnimAssetType::Sequence: 
 				{
-					const FMotionAnimSequence& MotionAnim = GetSourceAnimAtIndex(ChannelState.AnimId);
+					const FMotionAnimSequence& MotionAnim = ChannelMotionData->GetSourceAnimAtIndex(ChannelState.AnimId);
 
 					if (!MotionAnim.bLoop)
 					{
@@ -760,11 +1239,11 @@ void UMotionDataAsset::TickAssetPlayer(FAnimTickRecord& Instance, FAnimNotifyQue
 				} break;
 				case EMotionAnimAssetType::BlendSpace:
 				{
-					const FMotionBlendSpace& MotionBlendSpace = GetSourceBlendSpaceAtIndex(ChannelState.AnimId);
+					const FMotionBlendSpace& MotionBlendSpace = ChannelMotionData->GetSourceBlendSpaceAtIndex(ChannelState.AnimId);
 					const bool bLooping = MotionBlendSpace.bLoop;
 
 					float HighestSampleWeight = -1.0f;
-					float HighestSampleId = 0;
+					int32 HighestSampleId = 0;
 					for (int32 k = 0; k < ChannelState.BlendSampleDataCache.Num(); ++k)
 					{
 						const FBlendSampleData& BlendSampleData = ChannelState.BlendSampleDataCache[k];
@@ -796,7 +1275,7 @@ void UMotionDataAsset::TickAssetPlayer(FAnimTickRecord& Instance, FAnimNotifyQue
 
 				case EMotionAnimAssetType::Composite:
 				{
-					const FMotionComposite& MotionComposite = GetSourceCompositeAtIndex(ChannelState.AnimId);
+					const FMotionComposite& MotionComposite = ChannelMotionData->GetSourceCompositeAtIndex(ChannelState.AnimId);
 
 					if (!MotionComposite.bLoop)
 					{
@@ -902,7 +1381,8 @@ float UMotionDataAsset::TickAnimChannelForBlendSpace(const FAnimChannelState& Ch
 			//Notifies
 			if (bGenerateNotifies)
 			{
-				if (NotifyTriggerMode == ENotifyTriggerMode::AllAnimations)
+				if (NotifyTriggerMode == ENotifyTriggerMode::AllAnimations
+					&& ChannelState.Weight * SampleWeight >= NotifyRelevancyWeight)
 				{
 					SampleSequence->GetAnimNotifies(PreviousTime, DeltaTime, MotionBlendSpace.bLoop, Notifies);
 				}
@@ -1247,8 +1727,12 @@ bool UMotionDataAsset::SetAnimMetaPreviewIndex(EMotionAnimAssetType AssetType, i
 	return true;
 }
 
-void UMotionDataAsset::AddAnimNotifiesToNotifyQueue(FAnimNotifyQueue& NotifyQueue, TArray<FAnimNotifyEventReference>& Notifies, float InstanceWeight) const
+void UMotionDataAsset::AddAnimNotifiesToNotifyQueue(FAnimNotifyQueue& NotifyQueue, const TArray<FAnimNotifyEventReference>& Notifies, float InstanceWeight) const
 {
+	//Notify states must only be queued once. They are deduplicated with a small set rather than searching the queue for each one
+	TSet<const FAnimNotifyEvent*, DefaultKeyFuncs<const FAnimNotifyEvent*>, TInlineSetAllocator<16>> QueuedNotifyStates;
+	bool bQueuedNotifyStatesGathered = false;
+
 	for (const FAnimNotifyEventReference& NotifyRef : Notifies)
 	{
 		const FAnimNotifyEvent* Notify = NotifyRef.GetNotify();
@@ -1270,7 +1754,34 @@ void UMotionDataAsset::AddAnimNotifiesToNotifyQueue(FAnimNotifyQueue& NotifyQueu
 			const bool bPassesDedicatedServerCheck = Notify->bTriggerOnDedicatedServer || !IsRunningDedicatedServer();
 			if (bPassesDedicatedServerCheck && Notify->TriggerWeightThreshold < InstanceWeight && bPassesFiltering && bPassesChanceOfTriggering )
 			{
-				Notify->NotifyStateClass ? NotifyQueue.AnimNotifies.AddUnique(NotifyRef) : NotifyQueue.AnimNotifies.Add(NotifyRef);
+				if (!Notify->NotifyStateClass)
+				{
+					NotifyQueue.AnimNotifies.Add(NotifyRef);
+					continue;
+				}
+
+				//Notify states already in the queue (e.g. from other asset players) are only gathered if there is a state to add
+				if (!bQueuedNotifyStatesGathered)
+				{
+					for (const FAnimNotifyEventReference& QueuedNotifyRef : NotifyQueue.AnimNotifies)
+					{
+						const FAnimNotifyEvent* QueuedNotify = QueuedNotifyRef.GetNotify();
+						if (QueuedNotify && QueuedNotify->NotifyStateClass)
+						{
+							QueuedNotifyStates.Add(QueuedNotify);
+						}
+					}
+
+					bQueuedNotifyStatesGathered = true;
+				}
+
+				bool bAlreadyQueued = false;
+				QueuedNotifyStates.Add(Notify, &bAlreadyQueued);
+
+				if (!bAlreadyQueued)
+				{
+					NotifyQueue.AnimNotifies.Add(NotifyRef);
+				}
 			}
 		}
 	}
@@ -1788,101 +2299,765 @@ void UMotionDataAsset::PreProcessComposite(const int32 SourceCompositeIndex, con
 
 void UMotionDataAsset::GeneratePoseSequencing()
 {
-	for (int32 i = 0; i < Poses.Num(); ++i)
+	BuildPoseRanges();
+	BuildPoseRangeLookup();
+	BuildBlendSampleWeights();
+
+	for (const FMotionPoseRange& PoseRange : PoseRanges)
 	{
-		FPoseMotionData& Pose = Poses[i];
-		FPoseMotionData& BeforePose = Poses[FMath::Max(0, i - 1)];
-		FPoseMotionData& AfterPose = Poses[FMath::Min(i + 1, Poses.Num() - 1)];
-		
-		if (BeforePose.AnimType == Pose.AnimType 
-			&& BeforePose.AnimId == Pose.AnimId
-			&& BeforePose.bMirrored == Pose.bMirrored
-			&& FVector2D::Distance(BeforePose.BlendSpacePosition, Pose.BlendSpacePosition) < 0.001f)
-		{
-			Pose.LastPoseId = BeforePose.PoseId;
-		}
-		else
+		for (int32 PoseId = PoseRange.StartPoseId; PoseId <= PoseRange.EndPoseId; ++PoseId)
 		{
-			const FMotionAnimAsset* MotionAnim = GetSourceAnim(Pose.AnimId, Pose.AnimType);
+			FPoseMotionData& Pose = Poses[PoseId];
 
-			//If the animation is looping, the last Pose needs to wrap to the end
-			if (MotionAnim->bLoop)
+			//Looping animations wrap to the other end of their range, otherwise the ends of the range reference themselves
+			if (PoseId > PoseRange.StartPoseId)
 			{
-				
-				for(int32 n = Pose.PoseId + 1; n < Poses.Num(); ++n)
-				{
-					const FPoseMotionData& CandidatePose = Poses[n];
+				Pose.LastPoseId = PoseId - 1;
+			}
+			else
+			{
+				Pose.LastPoseId = PoseRange.bLoop ? PoseRange.EndPoseId : PoseId;
+			}
 
-					if(CandidatePose.AnimType != Pose.AnimType
-						|| CandidatePose.AnimId != Pose.AnimId
-						|| CandidatePose.bMirrored != Pose.bMirrored)
-					{
-						Pose.LastPoseId = Poses[n-1].PoseId;
-						break;
-					}
-							
-				}
+			if (PoseId < PoseRange.EndPoseId)
+			{
+				Pose.NextPoseId = PoseId + 1;
 			}
 			else
 			{
-				Pose.LastPoseId = Pose.PoseId;
+				Pose.NextPoseId = PoseRange.bLoop ? PoseRange.StartPoseId : PoseId;
 			}
 		}
+	}
+}
 
-		if (AfterPose.AnimType == Pose.AnimType
-			&& AfterPose.AnimId == Pose.AnimId 
-			&& AfterPose.bMirrored == Pose.bMirrored
-			&& FVector2D::Distance(AfterPose.BlendSpacePosition, Pose.BlendSpacePosition) < 0.001f)
+void UMotionDataAsset::BuildPCAPrefilters()
+{
+	PCAPrefilters.Empty(FeatureStandardDeviations.Num());
+
+	TMap<FMotionTraitField, TArray<int32>> TraitPoseIds;
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		TraitPoseIds.FindOrAdd(Pose.Traits).Add(Pose.PoseId);
+	}
+
+	for (const TPair<FMotionTraitField, TArray<int32>>& TraitPair : TraitPoseIds)
+	{
+		const FCalibrationData* StdDeviations = FeatureStandardDeviations.Find(TraitPair.Key);
+		if (!StdDeviations)
 		{
-			Pose.NextPoseId = AfterPose.PoseId;
+			continue;
 		}
-		else
+
+		FPoseFeaturePCA PCA;
+		PCA.Build(this, TraitPair.Value, *StdDeviations, PCATargetVariance, PCAMaxDimensions);
+
+		if (PCA.IsValid())
 		{
-			const FMotionAnimAsset* MotionAnim = GetSourceAnim(Pose.AnimId, Pose.AnimType);
-			
-			if (MotionAnim->bLoop)
+			UE_LOG(LogTemp, Log, TEXT("Motion data '%s' PCA pre-filter: %d poses, %d of %d dimensions, %.1f%% variance retained, %.1f%% top 1 agreement."),
+				*GetName(), PCA.PoseIds.Num(), PCA.Dimensions, PCA.FeatureCount, PCA.RetainedVariance * 100.0f, PCA.TopOneAgreement * 100.0f);
+
+			PCAPrefilters.Add(TraitPair.Key, MoveTemp(PCA));
+		}
+	}
+}
+
+const FPoseFeaturePCA* UMotionDataAsset::FindPCAPrefilter(const FMotionTraitField& Traits) const
+{
+	const FPoseFeaturePCA* PCA = PCAPrefilters.Find(Traits);
+	return PCA && PCA->IsValid() ? PCA : nullptr;
+}
+
+void UMotionDataAsset::BuildFeatureGroupOrders()
+{
+	const int32 GroupCount = (int32)EMotionFeatureGroup::Count;
+	const int32 SampleCount = 128;
+
+	TMap<FMotionTraitField, TArray<int32>> TraitPoseIds;
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		if (IsPoseSearchable(Pose.PoseId))
+		{
+			TraitPoseIds.FindOrAdd(Pose.Traits).Add(Pose.PoseId);
+		}
+	}
+
+	for (TPair<FMotionTraitField, FCalibrationData>& TraitPair : FeatureStandardDeviations)
+	{
+		FCalibrationData& StdDeviations = TraitPair.Value;
+		StdDeviations.FeatureGroupOrder.Empty(GroupCount);
+
+		const TArray<int32>* PoseIds = TraitPoseIds.Find(TraitPair.Key);
+		if (!PoseIds || PoseIds->Num() < 2)
+		{
+			continue;
+		}
+
+		FCalibrationData Calibration;
+		Calibration.GenerateFinalWeights(PreprocessCalibration, StdDeviations);
+
+		//Queries and candidates are spread evenly over the poses so that the order is deterministic
+		const int32 QueryCount = FMath::Min(PoseIds->Num(), SampleCount);
+		const int32 CandidateStride = FMath::Max(1, PoseIds->Num() / (SampleCount * 2));
+
+		double Mean[GroupCount] = {};
+		double M2[GroupCount] = {};
+		int32 RejectCount[GroupCount] = {};
+		int32 PairCount = 0;
+
+		TArray<float> PairCosts;
+		for (int32 QueryIndex = 0; QueryIndex < QueryCount; ++QueryIndex)
+		{
+			const FPoseMotionData& QueryPose = Poses[(*PoseIds)[QueryIndex * PoseIds->Num() / QueryCount]];
+
+			//The cost of every feature group of each candidate against a query made from the pose itself
+			PairCosts.Reset();
+			float LowestCost = 10000000.0f;
+			for (int32 CandidateIndex = 0; CandidateIndex < PoseIds->Num(); CandidateIndex += CandidateStride)
 			{
-				for(int32 n = Pose.PoseId - 1; n > -1; --n)
+				const FPoseMotionData& Candidate = Poses[(*PoseIds)[CandidateIndex]];
+				if (Candidate.PoseId == QueryPose.PoseId)
 				{
-					const FPoseMotionData& CandidatePose = Poses[n];
+					continue;
+				}
 
-					if(CandidatePose.AnimType != Pose.AnimType
-						|| CandidatePose.AnimId != Pose.AnimId
-						|| CandidatePose.bMirrored != Pose.bMirrored)
+				const float Costs[GroupCount] =
+				{
+					FVector::DistSquared(QueryPose.LocalVelocity, Candidate.LocalVelocity) * Calibration.Weight_Momentum,
+					FMath::Abs(QueryPose.RotationalVelocity - Candidate.RotationalVelocity) * Calibration.Weight_AngularMomentum,
+					FMotionMatchingUtils::ComputeTrajectoryCost(QueryPose.Trajectory, Candidate.Trajectory, Calibration),
+					FMotionMatchingUtils::ComputePoseCost(QueryPose.JointData, Candidate.JointData, Calibration)
+				};
+
+				PairCosts.Append(Costs, GroupCount);
+				LowestCost = FMath::Min(LowestCost, (Costs[0] + Costs[1] + Costs[2] + Costs[3]) * Candidate.Favour);
+			}
+
+			//A group rejects a candidate on its own if its cost is more than the best cost the search would find
+			for (int32 PairIndex = 0; PairIndex < PairCosts.Num(); PairIndex += GroupCount)
+			{
+				++PairCount;
+
+				for (int32 Group = 0; Group < GroupCount; ++Group)
+				{
+					const double Cost = PairCosts[PairIndex + Group];
+					const double Delta = Cost - Mean[Group];
+					Mean[Group] += Delta / PairCount;
+					M2[Group] += Delta * (Cost - Mean[Group]);
+
+					RejectCount[Group] += Cost > LowestCost ? 1 : 0;
+				}
+			}
+		}
+
+		if (PairCount == 0)
+		{
+			continue;
+		}
+
+		//Sequential early outs are cheapest when ordered by rejection rate over evaluation cost. The feature count of 
+		//each group stands in for its evaluation cost
+		const int32 JointCount = Calibration.PoseJointWeights.Num();
+		const int32 TrajectoryCount = Calibration.TrajectoryWeights.Num();
+		const float FeatureCounts[GroupCount] = { 3.0f, 1.0f, FMath::Max(TrajectoryCount * 5.0f, 1.0f), FMath::Max(JointCount * 6.0f, 1.0f) };
+
+		float Scores[GroupCount];
+		for (int32 Group = 0; Group < GroupCount; ++Group)
+		{
+			Scores[Group] = (float)RejectCount[Group] / PairCount / FeatureCounts[Group];
+			StdDeviations.FeatureGroupOrder.Add((EMotionFeatureGroup)Group);
+		}
+
+		//Ties (e.g. groups that never reject) keep the default order
+		StdDeviations.FeatureGroupOrder.StableSort([&Scores](const EMotionFeatureGroup A, const EMotionFeatureGroup B)
+		{
+			return Scores[(int32)A] > Scores[(int32)B];
+		});
+
+		static const TCHAR* GroupNames[GroupCount] = { TEXT("Momentum"), TEXT("AngularMomentum"), TEXT("Trajectory"), TEXT("Joints") };
+
+		FString OrderString;
+		for (const EMotionFeatureGroup Group : StdDeviations.FeatureGroupOrder)
+		{
+			const int32 GroupId = (int32)Group;
+			OrderString += FString::Printf(TEXT(" %s (mean %.3f, variance %.3f, rejects %.1f%%)"), GroupNames[GroupId],
+				Mean[GroupId], M2[GroupId] / PairCount, 100.0f * RejectCount[GroupId] / PairCount);
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Motion data '%s' feature group order for %d poses:%s"), *GetName(), PoseIds->Num(), *OrderString);
+	}
+}
+
+void UMotionDataAsset::BuildFeatureBounds()
+{
+	FeatureBounds.Empty(FeatureStandardDeviations.Num());
+
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		if (IsPoseSearchable(Pose.PoseId))
+		{
+			FeatureBounds.FindOrAdd(Pose.Traits).Add(Pose);
+		}
+	}
+}
+
+const FMotionFeatureBounds* UMotionDataAsset::FindFeatureBounds(const FMotionTraitField& Traits) const
+{
+	const FMotionFeatureBounds* Bounds = FeatureBounds.Find(Traits);
+	return Bounds && Bounds->IsValid() ? Bounds : nullptr;
+}
+
+//Prunes the poses of one trait set against earlier kept poses and returns the number pruned. The best cost of every leave 
+//one out query is then kept within CostEpsilon of the unpruned best by restoring the unpruned winner where it is not
+static int32 PruneTraitSetPoses(const TArray<FPoseMotionData>& Poses, const TArray<int32>& TraitPoseIds, const FCalibrationData& Calibration,
+	const float CostEpsilon, TArray<uint64>& OutPrunedPoseBitmap, float& OutMaxCostIncrease, uint64& OutFullSearchCycles, uint64& OutPrunedSearchCycles)
+{
+	const int32 MaxPoseId = Poses.Num() - 1;
+	int32 PrunedCount = 0;
+
+	//A pose is only redundant if it matches the representative and both continue the same way, so that landing on 
+	//the representative plays out like landing on the pruned pose would
+	auto IsRedundant = [&](const FPoseMotionData& Pose, const FPoseMotionData& Representative)
+	{
+		if (!FMath::IsNearlyEqual(Pose.Favour, Representative.Favour)
+			|| Pose.JointData.Num() != Representative.JointData.Num()
+			|| Pose.Trajectory.Num() != Representative.Trajectory.Num()
+			|| FMotionMatchingUtils::ComputePoseDistance(Representative, Pose, Calibration) > CostEpsilon)
+		{
+			return false;
+		}
+
+		const FPoseMotionData& NextPose = Poses[FMath::Clamp(Pose.NextPoseId, 0, MaxPoseId)];
+		const FPoseMotionData& NextRepresentative = Poses[FMath::Clamp(Representative.NextPoseId, 0, MaxPoseId)];
+
+		return NextPose.JointData.Num() == NextRepresentative.JointData.Num()
+			&& NextPose.Trajectory.Num() == NextRepresentative.Trajectory.Num()
+			&& FMotionMatchingUtils::ComputePoseDistance(NextRepresentative, NextPose, Calibration) <= CostEpsilon;
+	};
+
+	//The momentum cost alone of two redundant poses is within epsilon so they are at most one velocity cell apart
+	const bool bUseCells = Calibration.Weight_Momentum > KINDA_SMALL_NUMBER;
+	const float CellSize = bUseCells ? FMath::Max(FMath::Sqrt(CostEpsilon / Calibration.Weight_Momentum), 0.01f) : 1.0f;
+	const int32 CellRange = bUseCells ? 1 : 0;
+
+	//Poses are visited in id order and only pruned against earlier kept poses so the result is deterministic
+	TMap<FIntVector, TArray<int32>> RepresentativeCells;
+	TArray<int32> KeptPoseIds;
+	KeptPoseIds.Reserve(TraitPoseIds.Num());
+
+	for (const int32 PoseId : TraitPoseIds)
+	{
+		const FPoseMotionData& Pose = Poses[PoseId];
+		const FIntVector Cell = bUseCells ? FIntVector(FMath::FloorToInt(Pose.LocalVelocity.X / CellSize),
+			FMath::FloorToInt(Pose.LocalVelocity.Y / CellSize), FMath::FloorToInt(Pose.LocalVelocity.Z / CellSize)) : FIntVector::ZeroValue;
+
+		bool bRedundant = false;
+		for (int32 X = -CellRange; X <= CellRange && !bRedundant; ++X)
+		{
+			for (int32 Y = -CellRange; Y <= CellRange && !bRedundant; ++Y)
+			{
+				for (int32 Z = -CellRange; Z <= CellRange && !bRedundant; ++Z)
+				{
+					const TArray<int32>* Representatives = RepresentativeCells.Find(Cell + FIntVector(X, Y, Z));
+					if (!Representatives)
 					{
-						Pose.NextPoseId = Poses[n+1].PoseId;
-						break;
+						continue;
+					}
+
+					for (const int32 RepresentativeId : *Representatives)
+					{
+						if (IsRedundant(Pose, Poses[RepresentativeId]))
+						{
+							bRedundant = true;
+							break;
+						}
 					}
 				}
-				
 			}
-			else
+		}
+
+		if (bRedundant)
+		{
+			OutPrunedPoseBitmap[PoseId / 64] |= 1ull << (PoseId % 64);
+			++PrunedCount;
+		}
+		else
+		{
+			RepresentativeCells.FindOrAdd(Cell).Add(PoseId);
+			KeptPoseIds.Add(PoseId);
+		}
+	}
+
+	//Leave one out queries are linearly searched with and without the pruned poses
+	auto FindLowestCost = [&](const FPoseMotionData& QueryPose, const TArray<int32>& SearchPoseIds, int32& OutPoseId)
+	{
+		float LowestCost = 10000000.0f;
+		OutPoseId = INDEX_NONE;
+
+		for (const int32 SearchPoseId : SearchPoseIds)
+		{
+			const FPoseMotionData& SearchPose = Poses[SearchPoseId];
+			if (SearchPoseId != QueryPose.PoseId
+				&& SearchPose.JointData.Num() == QueryPose.JointData.Num()
+				&& SearchPose.Trajectory.Num() == QueryPose.Trajectory.Num())
+			{
+				const float Cost = FMotionMatchingUtils::ComputePoseDistance(QueryPose, SearchPose, Calibration) * SearchPose.Favour;
+				if (Cost < LowestCost)
+				{
+					LowestCost = Cost;
+					OutPoseId = SearchPoseId;
+				}
+			}
+		}
+
+		return LowestCost;
+	};
+
+	if (PrunedCount == 0)
+	{
+		return 0;
+	}
+
+	//The cost is not a metric so redundancy alone does not bound the best cost increase. Every pose of the trait set is 
+	//checked as a query. Restoring the unpruned winner of a violating query makes its increase zero and, as poses are only
+	//ever restored, can not raise any other query. Queries only read the pruned set so they are checked in parallel
+	const int32 QueryCount = TraitPoseIds.Num();
+	TArray<float> FullCosts;
+	TArray<int32> RestorePoseIds;
+	FullCosts.SetNumUninitialized(QueryCount);
+	RestorePoseIds.SetNumUninitialized(QueryCount);
+
+	ParallelFor(QueryCount, [&](const int32 QueryIndex)
+	{
+		const FPoseMotionData& QueryPose = Poses[TraitPoseIds[QueryIndex]];
+
+		int32 FullPoseId = INDEX_NONE;
+		int32 PrunedPoseId = INDEX_NONE;
+		FullCosts[QueryIndex] = FindLowestCost(QueryPose, TraitPoseIds, FullPoseId);
+		const float PrunedCost = FindLowestCost(QueryPose, KeptPoseIds, PrunedPoseId);
+
+		RestorePoseIds[QueryIndex] = PrunedCost - FullCosts[QueryIndex] > CostEpsilon ? FullPoseId : INDEX_NONE;
+	});
+
+	//Restored in query order so the result is deterministic. Several queries can share a winner
+	for (const int32 RestorePoseId : RestorePoseIds)
+	{
+		const uint64 PoseBit = RestorePoseId != INDEX_NONE ? 1ull << (RestorePoseId % 64) : 0;
+		if (PoseBit != 0 && (OutPrunedPoseBitmap[RestorePoseId / 64] & PoseBit) != 0)
+		{
+			OutPrunedPoseBitmap[RestorePoseId / 64] &= ~PoseBit;
+			KeptPoseIds.Add(RestorePoseId);
+			--PrunedCount;
+		}
+	}
+
+	//The exact largest increase over every query on the final pose set
+	TArray<float> CostIncreases;
+	CostIncreases.SetNumUninitialized(QueryCount);
+
+	ParallelFor(QueryCount, [&](const int32 QueryIndex)
+	{
+		int32 PrunedPoseId = INDEX_NONE;
+		CostIncreases[QueryIndex] = FindLowestCost(Poses[TraitPoseIds[QueryIndex]], KeptPoseIds, PrunedPoseId) - FullCosts[QueryIndex];
+	});
+
+	for (const float CostIncrease : CostIncreases)
+	{
+		OutMaxCostIncrease = FMath::Max(OutMaxCostIncrease, CostIncrease);
+	}
+
+	//The search time saving is an estimate timed on a single threaded sample of the queries
+	const int32 QueryStep = FMath::Max(1, QueryCount / 32);
+	int32 BestPoseId = INDEX_NONE;
+	for (int32 i = 0; i < QueryCount; i += QueryStep)
+	{
+		const FPoseMotionData& QueryPose = Poses[TraitPoseIds[i]];
+
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		FindLowestCost(QueryPose, TraitPoseIds, BestPoseId);
+		OutFullSearchCycles += FPlatformTime::Cycles64() - StartCycles;
+
+		StartCycles = FPlatformTime::Cycles64();
+		FindLowestCost(QueryPose, KeptPoseIds, BestPoseId);
+		OutPrunedSearchCycles += FPlatformTime::Cycles64() - StartCycles;
+	}
+
+	return PrunedCount;
+}
+
+void UMotionDataAsset::PruneRedundantPoses()
+{
+	PrunedPoseBitmap.Init(0, FMath::DivideAndRoundUp(Poses.Num(), 64));
+	PrunedPoseCount = 0;
+	PruneSearchTimeSaving = 0.0f;
+	PruneMaxCostIncrease = 0.0f;
+
+	TMap<FMotionTraitField, TArray<int32>> TraitPoseIds;
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		if (!Pose.bDoNotUse)
+		{
+			TraitPoseIds.FindOrAdd(Pose.Traits).Add(Pose.PoseId);
+		}
+	}
+
+	int32 CandidateCount = 0;
+	uint64 FullSearchCycles = 0;
+	uint64 PrunedSearchCycles = 0;
+
+	for (const TPair<FMotionTraitField, TArray<int32>>& TraitPair : TraitPoseIds)
+	{
+		const FCalibrationData* StdDeviations = FeatureStandardDeviations.Find(TraitPair.Key);
+		if (!StdDeviations)
+		{
+			continue;
+		}
+
+		FCalibrationData Calibration;
+		Calibration.GenerateFinalWeights(PreprocessCalibration, *StdDeviations);
+
+		PrunedPoseCount += PruneTraitSetPoses(Poses, TraitPair.Value, Calibration, PruneCostEpsilon, 
+			PrunedPoseBitmap, PruneMaxCostIncrease, FullSearchCycles, PrunedSearchCycles);
+
+		CandidateCount += TraitPair.Value.Num();
+	}
+
+	PruneSearchTimeSaving = FullSearchCycles > 0 ? 1.0f - (float)((double)PrunedSearchCycles / (double)FullSearchCycles) : 0.0f;
+}
+
+bool UMotionDataAsset::IsPosePruned(const int32 PoseId) const
+{
+	const int32 WordIndex = PoseId / 64;
+	return PrunedPoseBitmap.IsValidIndex(WordIndex) && (PrunedPoseBitmap[WordIndex] & (1ull << (PoseId % 64))) != 0;
+}
+
+bool UMotionDataAsset::IsPoseSearchable(const int32 PoseId) const
+{
+	return Poses.IsValidIndex(PoseId) 
+		&& !Poses[PoseId].bDoNotUse 
+		&& !IsPosePruned(PoseId);
+}
+
+void UMotionDataAsset::BuildPoseRanges()
+{
+	PoseRanges.Empty();
+
+	for (int32 PoseId = 0; PoseId < Poses.Num(); ++PoseId)
+	{
+		const FPoseMotionData& Pose = Poses[PoseId];
+
+		if (PoseRanges.Num() > 0)
+		{
+			FMotionPoseRange& LastRange = PoseRanges.Last();
+
+			if (LastRange.AnimType == Pose.AnimType
+				&& LastRange.AnimId == Pose.AnimId
+				&& LastRange.bMirrored == Pose.bMirrored
+				&& FVector2D::Distance(LastRange.BlendSpacePosition, Pose.BlendSpacePosition) < 0.001f)
 			{
-				Pose.NextPoseId = Pose.PoseId;
+				LastRange.EndPoseId = PoseId;
+				continue;
 			}
 		}
 
-		//If the Pose at the beginning of the database is looping, we need to fix its before Pose reference
-		FPoseMotionData& StartPose = Poses[0];
-		const FMotionAnimAsset* StartMotionAnim = GetSourceAnim(StartPose.AnimId, StartPose.AnimType);
+		const FMotionAnimAsset* MotionAnim = GetSourceAnim(Pose.AnimId, Pose.AnimType);
+
+		FMotionPoseRange& NewRange = PoseRanges.AddDefaulted_GetRef();
+		NewRange.AnimType = Pose.AnimType;
+		NewRange.AnimId = Pose.AnimId;
+		NewRange.bMirrored = Pose.bMirrored;
+		NewRange.bLoop = MotionAnim ? MotionAnim->bLoop : false;
+		NewRange.BlendSpacePosition = Pose.BlendSpacePosition;
+		NewRange.StartPoseId = PoseId;
+		NewRange.EndPoseId = PoseId;
+		NewRange.StartTime = Pose.Time;
+	}
+}
+
+void UMotionDataAsset::BuildPoseRangeLookup()
+{
+	AnimPoseRangeLookup.Init(FIntPoint(INDEX_NONE, 0), GetAnimCount() * 2);
 
-		if (StartMotionAnim->bLoop)
+	for (int32 RangeIndex = 0; RangeIndex < PoseRanges.Num(); ++RangeIndex)
+	{
+		const FMotionPoseRange& PoseRange = PoseRanges[RangeIndex];
+		const int32 AnimSlot = GetAnimSlot(PoseRange.AnimType, PoseRange.AnimId, PoseRange.bMirrored);
+
+		if (!AnimPoseRangeLookup.IsValidIndex(AnimSlot))
 		{
-			const int32 PosesToEnd = FMath::FloorToInt((StartMotionAnim->GetPlayLength() - StartPose.Time) / PoseInterval);
-			StartPose.LastPoseId = StartPose.PoseId + PosesToEnd;
+			continue;
 		}
 
-		//If the Pose at the end of the database is looping, we need to fix its after Pose reference
-		FPoseMotionData& EndPose = Poses.Last();
-		const FMotionAnimAsset* EndMotionAnim = GetSourceAnim(EndPose.AnimId, EndPose.AnimType);
+		//The ranges of an animation are always generated consecutively
+		FIntPoint& SlotRanges = AnimPoseRangeLookup[AnimSlot];
+		if (SlotRanges.X == INDEX_NONE)
+		{
+			SlotRanges.X = RangeIndex;
+		}
 
-		if (EndMotionAnim->bLoop)
+		++SlotRanges.Y;
+	}
+}
+
+int32 UMotionDataAsset::GetAnimSlot(const EMotionAnimAssetType AnimType, const int32 AnimId, const bool bMirrored) const
+{
+	int32 AnimIndex = INDEX_NONE;
+	switch (AnimType)
+	{
+		case EMotionAnimAssetType::Sequence: AnimIndex = AnimId; break;
+		case EMotionAnimAssetType::BlendSpace: AnimIndex = SourceMotionAnims.Num() + AnimId; break;
+		case EMotionAnimAssetType::Composite: AnimIndex = SourceMotionAnims.Num() + SourceBlendSpaces.Num() + AnimId; break;
+		default: return INDEX_NONE;
+	}
+
+	return AnimIndex * 2 + (bMirrored ? 1 : 0);
+}
+
+const FMotionPoseRange* UMotionDataAsset::FindPoseRange(const EMotionAnimAssetType AnimType, const int32 AnimId,
+	const bool bMirrored, const FVector2D& BlendSpacePosition /*= FVector2D::ZeroVector*/) const
+{
+	const int32 AnimSlot = GetAnimSlot(AnimType, AnimId, bMirrored);
+
+	if (!AnimPoseRangeLookup.IsValidIndex(AnimSlot) 
+		|| AnimPoseRangeLookup[AnimSlot].X == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	const FIntPoint& SlotRanges = AnimPoseRangeLookup[AnimSlot];
+
+	//Only blend spaces have more than one range per animation (one for each sampled position)
+	const FMotionPoseRange* ClosestRange = &PoseRanges[SlotRanges.X];
+	float ClosestDistanceSqr = FVector2D::DistSquared(ClosestRange->BlendSpacePosition, BlendSpacePosition);
+	for (int32 RangeIndex = SlotRanges.X + 1; RangeIndex < SlotRanges.X + SlotRanges.Y; ++RangeIndex)
+	{
+		const float DistanceSqr = FVector2D::DistSquared(PoseRanges[RangeIndex].BlendSpacePosition, BlendSpacePosition);
+
+		if (DistanceSqr < ClosestDistanceSqr)
 		{
-			const int32 PosesToBeginning = FMath::FloorToInt(EndPose.Time / PoseInterval);
-			EndPose.NextPoseId = EndPose.PoseId - PosesToBeginning;
+			ClosestDistanceSqr = DistanceSqr;
+			ClosestRange = &PoseRanges[RangeIndex];
 		}
 	}
+
+	return ClosestRange;
+}
+
+const FMotionPoseRange* UMotionDataAsset::FindPoseRangeForPose(const int32 PoseId) const
+{
+	if (!Poses.IsValidIndex(PoseId))
+	{
+		return nullptr;
+	}
+
+	const FPoseMotionData& Pose = Poses[PoseId];
+	const FMotionPoseRange* PoseRange = FindPoseRange(Pose.AnimType, Pose.AnimId, Pose.bMirrored, Pose.BlendSpacePosition);
+
+	return PoseRange && PoseRange->Contains(PoseId) ? PoseRange : nullptr;
+}
+
+void UMotionDataAsset::BuildBlendSampleWeights()
+{
+	BlendSampleWeights.Empty();
+
+	TArray<FBlendSampleData> SampleData;
+	for (FMotionPoseRange& PoseRange : PoseRanges)
+	{
+		PoseRange.BlendSampleStart = INDEX_NONE;
+		PoseRange.BlendSampleCount = 0;
+
+		if (PoseRange.AnimType != EMotionAnimAssetType::BlendSpace
+			|| !SourceBlendSpaces.IsValidIndex(PoseRange.AnimId)
+			|| !SourceBlendSpaces[PoseRange.AnimId].BlendSpace)
+		{
+			continue;
+		}
+
+		//Every pose in the range shares the same blend space position so the blend space only needs to be evaluated once
+		UBlendSpaceBase* BlendSpace = SourceBlendSpaces[PoseRange.AnimId].BlendSpace;
+		BlendSpace->GetSamplesFromBlendInput(FVector(PoseRange.BlendSpacePosition.X, PoseRange.BlendSpacePosition.Y, 0.0f), SampleData);
+
+		PoseRange.BlendSampleStart = BlendSampleWeights.Num();
+		PoseRange.BlendSampleCount = SampleData.Num();
+
+		for (const FBlendSampleData& Sample : SampleData)
+		{
+			BlendSampleWeights.Emplace(Sample.SampleDataIndex, Sample.TotalWeight);
+		}
+	}
+}
+
+bool UMotionDataAsset::GetBlendSampleData(const int32 PoseId, TArray<FBlendSampleData>& OutSampleData) const
+{
+	//Pose ranges are in pose id order
+	const int32 RangeIndex = Algo::UpperBoundBy(PoseRanges, PoseId, &FMotionPoseRange::StartPoseId) - 1;
+
+	if (!PoseRanges.IsValidIndex(RangeIndex))
+	{
+		return false;
+	}
+
+	const FMotionPoseRange& PoseRange = PoseRanges[RangeIndex];
+
+	if (!PoseRange.Contains(PoseId)
+		|| PoseRange.AnimType != EMotionAnimAssetType::BlendSpace
+		|| PoseRange.BlendSampleCount <= 0
+		|| !BlendSampleWeights.IsValidIndex(PoseRange.BlendSampleStart + PoseRange.BlendSampleCount - 1)
+		|| !SourceBlendSpaces.IsValidIndex(PoseRange.AnimId))
+	{
+		return false;
+	}
+
+	const UBlendSpaceBase* BlendSpace = SourceBlendSpaces[PoseRange.AnimId].BlendSpace;
+	if (!BlendSpace)
+	{
+		return false;
+	}
+
+	OutSampleData.Reset(PoseRange.BlendSampleCount);
+	for (int32 i = PoseRange.BlendSampleStart; i < PoseRange.BlendSampleStart + PoseRange.BlendSampleCount; ++i)
+	{
+		const FMotionBlendSampleWeight& SampleWeight = BlendSampleWeights[i];
+
+		//The blend space was changed since pre-processing
+		if (!BlendSpace->IsValidBlendSampleIndex(SampleWeight.SampleIndex))
+		{
+			OutSampleData.Reset();
+			return false;
+		}
+
+		const FBlendSample& Sample = BlendSpace->GetBlendSample(SampleWeight.SampleIndex);
+
+		FBlendSampleData& SampleData = OutSampleData.Emplace_GetRef(SampleWeight.SampleIndex);
+		SampleData.TotalWeight = SampleWeight.Weight;
+		SampleData.Animation = Sample.Animation;
+		SampleData.SamplePlayRate = Sample.RateScale;
+	}
+
+	return true;
+}
+
+int32 UMotionDataAsset::GetPoseIdAtTime(const EMotionAnimAssetType AnimType, const int32 AnimId, const bool bMirrored,
+	const float Time, const FVector2D& BlendSpacePosition /*= FVector2D::ZeroVector*/) const
+{
+	const FMotionPoseRange* PoseRange = FindPoseRange(AnimType, AnimId, bMirrored, BlendSpacePosition);
+
+	if (!PoseRange)
+	{
+		return INDEX_NONE;
+	}
+
+	float Interpolation = 0.0f;
+	return PoseRange->GetPoseIdAtTime(Time, PoseInterval, Interpolation);
+}
+
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMotionDataPruneToleranceTest, "MotionSymphony.MotionData.PruneRedundantPoses.Tolerance",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FMotionDataPruneToleranceTest::RunTest(const FString& Parameters)
+{
+	const float CostEpsilon = 0.1f;
+
+	//128 poses. A search time sample of every fourth query would skip the pair's first pose at 126
+	const int32 ClusterCount = 42;
+
+	//Clusters of three poses 0.05 apart that continue into the next cluster, so only the middle pose of each is redundant
+	TArray<FPoseMotionData> Poses;
+	for (int32 Cluster = 0; Cluster < ClusterCount; ++Cluster)
+	{
+		for (int32 i = 0; i < 3; ++i)
+		{
+			FPoseMotionData& Pose = Poses.AddDefaulted_GetRef();
+			Pose.PoseId = Poses.Num() - 1;
+			Pose.LocalVelocity = FVector(Cluster * 10.0f + i * 0.05f, 0.0f, 0.0f);
+		}
+	}
+
+	//A distant near exact pair. Pruning the second would raise the best cost of the first's query far beyond epsilon
+	for (int32 i = 0; i < 2; ++i)
+	{
+		FPoseMotionData& Pose = Poses.AddDefaulted_GetRef();
+		Pose.PoseId = Poses.Num() - 1;
+		Pose.LocalVelocity = FVector(1000.0f + i * 0.01f, 0.0f, 0.0f);
+	}
+
+	TArray<int32> TraitPoseIds;
+	for (FPoseMotionData& Pose : Poses)
+	{
+		Pose.NextPoseId = FMath::Min(Pose.PoseId + 1, Poses.Num() - 1);
+		Pose.LastPoseId = FMath::Max(Pose.PoseId - 1, 0);
+		TraitPoseIds.Add(Pose.PoseId);
+	}
+
+	//With no joints or trajectory the cost is the momentum and angular momentum cost only
+	const FCalibrationData Calibration(0, 0);
+
+	auto Prune = [&](TArray<uint64>& OutPrunedPoseBitmap, float& OutMaxCostIncrease)
+	{
+		OutPrunedPoseBitmap.Init(0, FMath::DivideAndRoundUp(Poses.Num(), 64));
+		OutMaxCostIncrease = 0.0f;
+
+		uint64 FullSearchCycles = 0;
+		uint64 PrunedSearchCycles = 0;
+		return PruneTraitSetPoses(Poses, TraitPoseIds, Calibration, CostEpsilon, 
+			OutPrunedPoseBitmap, OutMaxCostIncrease, FullSearchCycles, PrunedSearchCycles);
+	};
+
+	TArray<uint64> PrunedPoseBitmap;
+	TArray<uint64> RepeatPrunedPoseBitmap;
+	float MaxCostIncrease = 0.0f;
+	float RepeatMaxCostIncrease = 0.0f;
+	const int32 PrunedCount = Prune(PrunedPoseBitmap, MaxCostIncrease);
+	const int32 RepeatPrunedCount = Prune(RepeatPrunedPoseBitmap, RepeatMaxCostIncrease);
+
+	TestEqual(TEXT("Pruning is deterministic"), RepeatPrunedCount, PrunedCount);
+	TestTrue(TEXT("Pruning is deterministic"), RepeatPrunedPoseBitmap == PrunedPoseBitmap);
+
+	auto IsPruned = [&](const int32 PoseId)
+	{
+		return (PrunedPoseBitmap[PoseId / 64] & (1ull << (PoseId % 64))) != 0;
+	};
+
+	//The pair's second pose is redundant but must be restored to keep the bound
+	bool bExpectedPosesPruned = true;
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		const bool bExpectPruned = Pose.PoseId < ClusterCount * 3 && Pose.PoseId % 3 == 1;
+		bExpectedPosesPruned &= IsPruned(Pose.PoseId) == bExpectPruned;
+	}
+
+	TestEqual(TEXT("Pruned pose count"), PrunedCount, ClusterCount);
+	TestTrue(TEXT("Only the redundant poses that keep the bound are pruned"), bExpectedPosesPruned);
+
+	//The bound holds for every query, not just a sample of them
+	float LargestCostIncrease = 0.0f;
+	for (const FPoseMotionData& QueryPose : Poses)
+	{
+		float FullCost = 10000000.0f;
+		float PrunedCost = 10000000.0f;
+		for (const FPoseMotionData& Pose : Poses)
+		{
+			if (Pose.PoseId != QueryPose.PoseId)
+			{
+				const float Cost = FMotionMatchingUtils::ComputePoseDistance(QueryPose, Pose, Calibration);
+				FullCost = FMath::Min(FullCost, Cost);
+				PrunedCost = IsPruned(Pose.PoseId) ? PrunedCost : FMath::Min(PrunedCost, Cost);
+			}
+		}
+
+		LargestCostIncrease = FMath::Max(LargestCostIncrease, PrunedCost - FullCost);
+	}
+
+	TestTrue(TEXT("The best cost increase of every query is within epsilon"), LargestCostIncrease <= CostEpsilon);
+	TestTrue(TEXT("The reported best cost increase is within epsilon"), MaxCostIncrease <= CostEpsilon);
+	TestTrue(TEXT("The reported best cost increase matches the queries"), FMath::IsNearlyEqual(MaxCostIncrease, LargestCostIncrease, 0.0001f));
+
+	return true;
 }
 
+#endif //WITH_DEV_AUTOMATION_TESTS
 
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -6,6 +6,7 @@
 FAnimChannelState::FAnimChannelState()
 	: Weight(0.0f), 
 	  HighestWeight(0.0f), 
+	  MotionData(nullptr),
 	  AnimId(0), 
 	  AnimType(EMotionAnimAssetType::None),
 	  StartPoseId(0), 
@@ -27,6 +28,7 @@ FAnimChannelState::FAnimChannelState(const FPoseMotionData & InPose,
 	float InPlayRate, bool bInMirrored, float InTimeOffset /*= 0.0f*/, float InPoseOffset /*= 0.0f*/)
 	: Weight(InWeight), 
 	HighestWeight(InWeight),
+	MotionData(nullptr),
 	AnimId(InPose.AnimId), 
 	AnimType(InPose.AnimType),
 	StartPoseId(InPose.PoseId),
@@ -0,0 +1,298 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "Data/BakedDistanceCurve.h"
+#include "Algo/BinarySearch.h"
+#include "Misc/AutomationTest.h"
+
+FBakedDistanceCurve::FBakedDistanceCurve()
+	: MaxDistance(0.0f)
+{
+}
+
+void FBakedDistanceCurve::Bake(const TArray<FRichCurveKey>& InKeys)
+{
+	Reset();
+
+	KeyTimes.Reserve(InKeys.Num());
+	KeyDistances.Reserve(InKeys.Num());
+
+	for (const FRichCurveKey& Key : InKeys)
+	{
+		KeyTimes.Add(Key.Time);
+		KeyDistances.Add(Key.Value);
+		MaxDistance = FMath::Max(MaxDistance, FMath::Abs(Key.Value));
+	}
+
+	BuildSegments(KeyTimes, KeyDistances, 1.0f, Segments);
+	BuildSegments(KeyTimes, KeyDistances, -1.0f, NegatedSegments);
+}
+
+void FBakedDistanceCurve::Reset()
+{
+	KeyTimes.Empty();
+	KeyDistances.Empty();
+	Segments.Empty();
+	NegatedSegments.Empty();
+	MaxDistance = 0.0f;
+}
+
+int32 FBakedDistanceCurve::GetKeyCount() const
+{
+	return KeyTimes.Num();
+}
+
+float FBakedDistanceCurve::GetMaxDistance() const
+{
+	return MaxDistance;
+}
+
+const TArray<FBakedDistanceCurve::FSegment>& FBakedDistanceCurve::GetSegments(const bool bNegated) const
+{
+	return bNegated ? NegatedSegments : Segments;
+}
+
+SIZE_T FBakedDistanceCurve::GetAllocatedSize() const
+{
+	return KeyTimes.GetAllocatedSize() + KeyDistances.GetAllocatedSize()
+		+ Segments.GetAllocatedSize() + NegatedSegments.GetAllocatedSize();
+}
+
+void FBakedDistanceCurve::BuildSegments(const TArray<float>& InKeyTimes, const TArray<float>& InKeyDistances,
+	const float Negator, TArray<FSegment>& OutSegments)
+{
+	OutSegments.Empty();
+
+	const int32 KeyCount = InKeyDistances.Num();
+	int32 StartKey = 0;
+	while (StartKey < KeyCount)
+	{
+		//Extend the segment for as long as the distance does not increase
+		int32 EndKey = StartKey;
+		while (EndKey + 1 < KeyCount
+			&& InKeyDistances[EndKey + 1] * Negator <= InKeyDistances[EndKey] * Negator)
+		{
+			++EndKey;
+		}
+
+		FSegment& Segment = OutSegments.AddDefaulted_GetRef();
+		Segment.StartKey = StartKey;
+		Segment.EndKey = EndKey;
+		Segment.MaxDistance = InKeyDistances[StartKey] * Negator;
+		Segment.MinDistance = InKeyDistances[EndKey] * Negator;
+		Segment.StartTime = InKeyTimes[StartKey];
+		Segment.EndTime = InKeyTimes[EndKey];
+
+		StartKey = EndKey + 1;
+	}
+}
+
+float FBakedDistanceCurve::FindMatchingTime(const float DesiredDistance, const bool bNegated, int32& InOutStartKey) const
+{
+	const int32 KeyCount = KeyTimes.Num();
+	const int32 StartKey = InOutStartKey;
+
+	if (StartKey < 0 || StartKey >= KeyCount)
+	{
+		return -1.0f;
+	}
+
+	const TArray<FSegment>& CurveSegments = bNegated ? NegatedSegments : Segments;
+	const float Negator = bNegated ? -1.0f : 1.0f;
+
+	//Find the segment containing the start key
+	int32 SegmentIndex = Algo::UpperBoundBy(CurveSegments, StartKey, 
+		[](const FSegment& Segment) { return Segment.StartKey; }) - 1;
+	SegmentIndex = FMath::Max(SegmentIndex, 0);
+
+	//Find the first key at or after the start key whose distance is at or below the desired distance
+	int32 MatchKey = INDEX_NONE;
+	for (; SegmentIndex < CurveSegments.Num(); ++SegmentIndex)
+	{
+		const FSegment& Segment = CurveSegments[SegmentIndex];
+
+		if (Segment.MinDistance > DesiredDistance)
+		{
+			continue;
+		}
+
+		//Distances are non-increasing within a segment so the first match can be found with a binary search
+		int32 Low = FMath::Max(Segment.StartKey, StartKey);
+		int32 High = Segment.EndKey;
+		while (Low < High)
+		{
+			const int32 Mid = (Low + High) / 2;
+
+			if (KeyDistances[Mid] * Negator <= DesiredDistance)
+			{
+				High = Mid;
+			}
+			else
+			{
+				Low = Mid + 1;
+			}
+		}
+
+		MatchKey = Low;
+		break;
+	}
+
+	if (MatchKey == INDEX_NONE)
+	{
+		return KeyTimes[KeyCount - 1];
+	}
+
+	InOutStartKey = MatchKey;
+
+	if (MatchKey == StartKey)
+	{
+		return KeyTimes[MatchKey];
+	}
+
+	//Interpolate the exact time between the key before the desired distance and the key after it
+	const int32 PrevKey = MatchKey - 1;
+	const float PrevDistance = KeyDistances[PrevKey] * Negator;
+	const float DV = PrevDistance - (KeyDistances[MatchKey] * Negator);
+
+	if (DV < 0.000001f)
+	{
+		return KeyTimes[PrevKey];
+	}
+
+	const float DT = KeyTimes[MatchKey] - KeyTimes[PrevKey];
+
+	return KeyTimes[PrevKey] + ((PrevDistance - DesiredDistance) / DV) * DT;
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBakedDistanceCurveLookupTest, "MotionSymphony.DistanceMatching.BakedCurveLookup",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FBakedDistanceCurveLookupTest::RunTest(const FString& Parameters)
+{
+	const int32 KeyCount = 5000;
+	const int32 QueryCount = 20000;
+
+	//A stop curve with bumps and plateaus so that it has many monotonic segments
+	TArray<FRichCurveKey> Keys;
+	Keys.Reserve(KeyCount);
+	for (int32 i = 0; i < KeyCount; ++i)
+	{
+		float Distance = 500.0f * (1.0f - (float)i / (float)(KeyCount - 1)) + 2.0f * FMath::Sin(i * 0.37f);
+		if (i % 100 == 1)
+		{
+			Distance = Keys[i - 1].Value;
+		}
+
+		Keys.Add(FRichCurveKey(i * 0.01f, Distance));
+	}
+
+	FBakedDistanceCurve BakedCurve;
+	BakedCurve.Bake(Keys);
+
+	TestEqual(TEXT("Baked key count"), BakedCurve.GetKeyCount(), KeyCount);
+	TestTrue(TEXT("The curve has many segments"), BakedCurve.GetSegments(false).Num() > 100 && BakedCurve.GetSegments(true).Num() > 100);
+
+	//The linear key walk the baked lookup replaces
+	auto LinearFindMatchingTime = [&Keys](const float DesiredDistance, const bool bNegated, int32& InOutStartKey)
+	{
+		const int32 StartKey = InOutStartKey;
+		if (StartKey < 0 || StartKey >= Keys.Num())
+		{
+			return -1.0f;
+		}
+
+		const float Negator = bNegated ? -1.0f : 1.0f;
+		for (int32 i = StartKey; i < Keys.Num(); ++i)
+		{
+			if (Keys[i].Value * Negator > DesiredDistance)
+			{
+				continue;
+			}
+
+			InOutStartKey = i;
+			if (i == StartKey)
+			{
+				return Keys[i].Time;
+			}
+
+			const float PrevDistance = Keys[i - 1].Value * Negator;
+			const float DV = PrevDistance - Keys[i].Value * Negator;
+			if (DV < 0.000001f)
+			{
+				return Keys[i - 1].Time;
+			}
+
+			return Keys[i - 1].Time + ((PrevDistance - DesiredDistance) / DV) * (Keys[i].Time - Keys[i - 1].Time);
+		}
+
+		return Keys.Last().Time;
+	};
+
+	//Random queries from random start keys as well as frame by frame queries that carry the last key checked
+	FRandomStream Random(2021);
+	TArray<float> DesiredDistances;
+	TArray<int32> StartKeys;
+	TArray<bool> Negations;
+	for (int32 i = 0; i < QueryCount; ++i)
+	{
+		const bool bNegated = Random.FRand() < 0.5f;
+		DesiredDistances.Add(Random.FRandRange(-20.0f, 520.0f) * (bNegated ? -1.0f : 1.0f));
+		StartKeys.Add(Random.RandRange(-1, KeyCount));
+		Negations.Add(bNegated);
+	}
+
+	int32 MismatchCount = 0;
+	for (int32 i = 0; i < QueryCount; ++i)
+	{
+		int32 BakedStartKey = StartKeys[i];
+		int32 LinearStartKey = StartKeys[i];
+		const float BakedTime = BakedCurve.FindMatchingTime(DesiredDistances[i], Negations[i], BakedStartKey);
+		const float LinearTime = LinearFindMatchingTime(DesiredDistances[i], Negations[i], LinearStartKey);
+
+		if (BakedStartKey != LinearStartKey || !FMath::IsNearlyEqual(BakedTime, LinearTime, 0.0001f))
+		{
+			++MismatchCount;
+		}
+	}
+
+	int32 BakedLastKey = 0;
+	int32 LinearLastKey = 0;
+	for (float DesiredDistance = 520.0f; DesiredDistance > -20.0f; DesiredDistance -= 0.37f)
+	{
+		const float BakedTime = BakedCurve.FindMatchingTime(DesiredDistance, false, BakedLastKey);
+		const float LinearTime = LinearFindMatchingTime(DesiredDistance, false, LinearLastKey);
+
+		if (BakedLastKey != LinearLastKey || !FMath::IsNearlyEqual(BakedTime, LinearTime, 0.0001f))
+		{
+			++MismatchCount;
+		}
+	}
+
+	TestEqual(TEXT("Baked lookups that differ from the linear key walk"), MismatchCount, 0);
+
+	//Microbenchmark of the random queries, which is the worst case for the linear walk
+	float TimeSum = 0.0f;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < QueryCount; ++i)
+	{
+		int32 StartKey = StartKeys[i];
+		TimeSum += LinearFindMatchingTime(DesiredDistances[i], Negations[i], StartKey);
+	}
+	const double LinearSeconds = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < QueryCount; ++i)
+	{
+		int32 StartKey = StartKeys[i];
+		TimeSum -= BakedCurve.FindMatchingTime(DesiredDistances[i], Negations[i], StartKey);
+	}
+	const double BakedSeconds = FPlatformTime::Seconds() - StartTime;
+
+	AddInfo(FString::Printf(TEXT("%d queries on %d keys: linear walk %.3f ms, baked lookup %.3f ms (checksum %f)."),
+		QueryCount, KeyCount, LinearSeconds * 1000.0, BakedSeconds * 1000.0, TimeSum));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
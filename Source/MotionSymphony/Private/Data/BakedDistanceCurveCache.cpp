@@ -0,0 +1,174 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "Data/BakedDistanceCurveCache.h"
+#include "Animation/AnimSequence.h"
+#if WITH_EDITORONLY_DATA && ENGINE_MAJOR_VERSION > 4
+#include "Animation/AnimData/AnimDataModel.h"
+#endif
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+
+static FAutoConsoleCommand CmdDistanceCurveCacheStats(
+	TEXT("a.AnimNode.MoSymph.DistanceCurveCache.Stats"),
+	TEXT("Logs the number of shared baked distance curves and the memory they use compared to per node copies."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const FBakedDistanceCurveCache::FStats Stats = FBakedDistanceCurveCache::Get().GetStats();
+
+		UE_LOG(LogTemp, Log, TEXT("Baked distance curve cache: %d curves shared by %d nodes, %llu bytes (%llu bytes as per node copies). %d bakes for %d requests."),
+			Stats.CurveCount, Stats.HandleCount, (uint64)Stats.AllocatedSize, (uint64)Stats.UnsharedSize, Stats.BakeCount, Stats.RequestCount);
+	}));
+
+FBakedDistanceCurveCache::FStats::FStats()
+	: CurveCount(0),
+	HandleCount(0),
+	RequestCount(0),
+	BakeCount(0),
+	AllocatedSize(0),
+	UnsharedSize(0)
+{
+}
+
+FBakedDistanceCurveCache::FBakedDistanceCurveCache()
+	: RequestCount(0),
+	BakeCount(0)
+{
+}
+
+FBakedDistanceCurveCache& FBakedDistanceCurveCache::Get()
+{
+	static FBakedDistanceCurveCache Instance;
+	return Instance;
+}
+
+FBakedDistanceCurveHandle FBakedDistanceCurveCache::FindOrBake(UAnimSequenceBase* InAnimSequence, const FName& DistanceCurveName)
+{
+	if (!InAnimSequence)
+	{
+		return FBakedDistanceCurveHandle();
+	}
+
+	FCurveKey Key;
+	Key.Sequence = FObjectKey(InAnimSequence);
+	Key.CurveName = DistanceCurveName;
+	Key.DataGuid = GetSequenceDataGuid(InAnimSequence);
+
+	{
+		FScopeLock Lock(&CurvesCriticalSection);
+		++RequestCount;
+
+		if (const TWeakPtr<const FBakedDistanceCurve, ESPMode::ThreadSafe>* CachedCurve = Curves.Find(Key))
+		{
+			FBakedDistanceCurveHandle Handle = CachedCurve->Pin();
+			if (Handle.IsValid())
+			{
+				return Handle;
+			}
+		}
+	}
+
+	//Bake outside of the lock so that other curves can still be fetched while this one is extracted
+	TSharedPtr<FBakedDistanceCurve, ESPMode::ThreadSafe> BakedCurve = MakeShared<FBakedDistanceCurve, ESPMode::ThreadSafe>();
+	if (!ExtractCurve(InAnimSequence, DistanceCurveName, *BakedCurve))
+	{
+		return FBakedDistanceCurveHandle();
+	}
+
+	FScopeLock Lock(&CurvesCriticalSection);
+
+	//Another thread may have baked the same curve in the meantime. If so, share theirs
+	TWeakPtr<const FBakedDistanceCurve, ESPMode::ThreadSafe>& CachedCurve = Curves.FindOrAdd(Key);
+	FBakedDistanceCurveHandle Handle = CachedCurve.Pin();
+	if (!Handle.IsValid())
+	{
+		Handle = BakedCurve;
+		CachedCurve = Handle;
+		++BakeCount;
+	}
+
+	//Drop entries for curves which are no longer referenced
+	for (auto It = Curves.CreateIterator(); It; ++It)
+	{
+		if (!It->Value.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	return Handle;
+}
+
+FBakedDistanceCurveCache::FStats FBakedDistanceCurveCache::GetStats() const
+{
+	FScopeLock Lock(&CurvesCriticalSection);
+
+	FStats Stats;
+	Stats.RequestCount = RequestCount;
+	Stats.BakeCount = BakeCount;
+	Stats.AllocatedSize = Curves.GetAllocatedSize();
+	for (const TPair<FCurveKey, TWeakPtr<const FBakedDistanceCurve, ESPMode::ThreadSafe>>& CurvePair : Curves)
+	{
+		FBakedDistanceCurveHandle Handle = CurvePair.Value.Pin();
+		if (Handle.IsValid())
+		{
+			//The pinned handle above is not held by a node
+			const int32 NodeHandleCount = Handle.GetSharedReferenceCount() - 1;
+			const SIZE_T CurveSize = sizeof(FBakedDistanceCurve) + Handle->GetAllocatedSize();
+
+			++Stats.CurveCount;
+			Stats.HandleCount += NodeHandleCount;
+			Stats.AllocatedSize += CurveSize;
+			Stats.UnsharedSize += CurveSize * NodeHandleCount;
+		}
+	}
+
+	return Stats;
+}
+
+FGuid FBakedDistanceCurveCache::GetSequenceDataGuid(UAnimSequenceBase* InAnimSequence)
+{
+	//Sequences can only be modified in the editor so cooked builds only need to key by the sequence
+#if WITH_EDITORONLY_DATA
+#if ENGINE_MAJOR_VERSION > 4
+	//The data model holds the curves of all sequence types and its guid changes with any edit to them
+	if (const UAnimDataModel* DataModel = InAnimSequence->GetDataModel())
+	{
+		return DataModel->GenerateGuid();
+	}
+#else
+	if (const UAnimSequence* Sequence = Cast<UAnimSequence>(InAnimSequence))
+	{
+		return Sequence->RawDataGuid;
+	}
+#endif
+#endif
+
+	return FGuid();
+}
+
+bool FBakedDistanceCurveCache::ExtractCurve(UAnimSequenceBase* InAnimSequence, const FName& DistanceCurveName, FBakedDistanceCurve& OutCurve)
+{
+	FSmartName CurveName;
+#if ENGINE_MAJOR_VERSION > 4
+	const FRawCurveTracks& RawCurves = InAnimSequence->GetCurveData();
+#else
+	const FRawCurveTracks& RawCurves = InAnimSequence->RawCurveData;
+#endif
+	InAnimSequence->GetSkeleton()->GetSmartNameByName(USkeleton::AnimCurveMappingName, DistanceCurveName, CurveName);
+
+	if (!CurveName.IsValid())
+	{
+		return false;
+	}
+
+	const FFloatCurve* DistanceCurve = static_cast<const FFloatCurve*>(RawCurves.GetCurveData(CurveName.UID));
+
+	if (!DistanceCurve)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Distance matching curve could not be found. Distance matching node will not operate as expected."));
+		return false;
+	}
+
+	OutCurve.Bake(DistanceCurve->FloatCurve.GetConstRefOfKeys());
+	return true;
+}
@@ -4,6 +4,89 @@
 #include "Data/MotionTraitField.h"
 #include "CustomAssets/MotionDataAsset.h"
 #include "CustomAssets/MotionMatchConfig.h"
+#include "Async/ParallelFor.h"
+#include "Misc/AutomationTest.h"
+
+/** Running mean and variance (Welford) of every feature column of a set of poses. Columns are laid out as momentum (3), 
+angular momentum (1), then position (3) and velocity (3) for each pose joint, then position (3) and facing direction (2) 
+for each trajectory point. */
+struct FPoseFeatureMoments
+{
+	int32 Count;
+	TArray<double> Mean;
+	TArray<double> M2;
+
+	FPoseFeatureMoments(const int32 ColumnCount)
+		: Count(0)
+	{
+		Mean.SetNumZeroed(ColumnCount);
+		M2.SetNumZeroed(ColumnCount);
+	}
+
+	FORCEINLINE void Add(const int32 Column, const double Value)
+	{
+		const double Delta = Value - Mean[Column];
+		Mean[Column] += Delta / Count;
+		M2[Column] += Delta * (Value - Mean[Column]);
+	}
+
+	FORCEINLINE void Add(const int32 Column, const FVector& Value)
+	{
+		Add(Column, Value.X);
+		Add(Column + 1, Value.Y);
+		Add(Column + 2, Value.Z);
+	}
+
+	FORCEINLINE void Add(const int32 Column, const FVector2D& Value)
+	{
+		Add(Column, Value.X);
+		Add(Column + 1, Value.Y);
+	}
+
+	void AddPose(const FPoseMotionData& Pose)
+	{
+		++Count;
+
+		int32 Column = 0;
+		Add(Column, Pose.LocalVelocity); Column += 3;
+		Add(Column, Pose.RotationalVelocity); Column += 1;
+
+		for (const FJointData& JointData : Pose.JointData)
+		{
+			Add(Column, JointData.Position); Column += 3;
+			Add(Column, JointData.Velocity); Column += 3;
+		}
+
+		for (const FTrajectoryPoint& TrajPoint : Pose.Trajectory)
+		{
+			Add(Column, TrajPoint.Position); Column += 3;
+			Add(Column, TrajPoint.Facing); Column += 2;
+		}
+	}
+
+	/** The standard deviation of a feature spanning one or more columns, i.e. the root mean squared distance to the mean */
+	float GetStandardDeviation(const int32 Column, const int32 Width) const
+	{
+		if (Count < 1)
+		{
+			return 0.0f;
+		}
+
+		double Variance = 0.0;
+		for (int32 i = Column; i < Column + Width; ++i)
+		{
+			Variance += M2[i];
+		}
+
+		return (float)FMath::Sqrt(Variance / Count);
+	}
+};
+
+static float GetStandardDeviationWeight(const float StdDev)
+{
+	//If the StdDev is 0 the weight must be set to 0
+	return FMath::IsNearlyEqual(StdDev, 0.0f) ? 0.0f : 1.0f / StdDev;
+}
 
 FCalibrationData::FCalibrationData()
 	: Weight_Momentum(1.0f),
@@ -129,157 +212,103 @@ void FCalibrationData::GenerateStandardDeviationWeights(const UMotionDataAsset*
 		return;
 	}
 
-	UMotionMatchConfig* MMConfig = SourceMotionData->MotionMatchConfig;
-
-	Initialize(MMConfig);
-
-	int32 PoseCount = 0;
-
-	//For momentum and angular momentum
-	FVector TotalMomentum = FVector::ZeroVector;
-	float TotalAngularMomentum = 0.0f;
-
-	for (const FPoseMotionData& Pose : SourceMotionData->Poses)
+	TArray<int32> PoseIds;
+	for (int32 PoseId = 0; PoseId < SourceMotionData->Poses.Num(); ++PoseId)
 	{
-		if (Pose.bDoNotUse || Pose.Traits != MotionTrait)
+		if (SourceMotionData->Poses[PoseId].Traits == MotionTrait)
 		{
-			continue;
+			PoseIds.Add(PoseId);
 		}
-
-		++PoseCount;
-
-		TotalMomentum += Pose.LocalVelocity;
-		TotalAngularMomentum += Pose.RotationalVelocity;
 	}
 
-	PoseCount = FMath::Max(PoseCount, 1);
-
-	const FVector MeanMomentum = TotalMomentum / PoseCount;
-	const float MeanAngularMomentum = TotalAngularMomentum / PoseCount;
+	SetStandardDeviationWeights(SourceMotionData, PoseIds);
+}
 
-	//Sum the total of all atom distances squared to the mean
-	float TotalDistanceToMeanSquared_Momentum = 0.0f;
-	float TotalDistanceToMeanSquared_AngularMomentum = 0.0f;
+void FCalibrationData::GenerateStandardDeviationWeights(const UMotionDataAsset* SourceMotionData, TMap<FMotionTraitField, FCalibrationData>& OutStdDeviations)
+{
+	OutStdDeviations.Empty();
 
-	for (const FPoseMotionData& Pose : SourceMotionData->Poses)
+	if (!SourceMotionData || !SourceMotionData->MotionMatchConfig)
 	{
-		if (Pose.bDoNotUse || Pose.Traits != MotionTrait)
-		{
-			continue;
-		}
-
-		const float DistanceToMean_Momentum = FVector::DistSquared(Pose.LocalVelocity, MeanMomentum);
-		const float DistanceToMean_AngularMomentum = FMath::Abs(Pose.RotationalVelocity - MeanAngularMomentum);
-
-		TotalDistanceToMeanSquared_Momentum += DistanceToMean_Momentum * DistanceToMean_Momentum;
-		TotalDistanceToMeanSquared_AngularMomentum += DistanceToMean_AngularMomentum * DistanceToMean_AngularMomentum;
+		return;
 	}
 
-	Weight_Momentum = 1.0f / FMath::Sqrt(TotalDistanceToMeanSquared_Momentum / PoseCount);
-	Weight_AngularMomentum = 1.0f / FMath::Sqrt(TotalDistanceToMeanSquared_AngularMomentum / PoseCount);
+	//Partition the poses by trait in order of first appearance so that the output is deterministic
+	TArray<FMotionTraitField> Traits;
+	TArray<TArray<int32>> TraitPoseIds;
+	TMap<FMotionTraitField, int32> TraitIndices;
 
-	//For Each Bone
-	for (int32 i = 0; i < MMConfig->PoseBones.Num(); ++i)
+	for (int32 PoseId = 0; PoseId < SourceMotionData->Poses.Num(); ++PoseId)
 	{
-		//Sum up magnitude of all pose atoms
-		FVector TotalPosition =  FVector::ZeroVector;
-		FVector TotalVelocity = FVector::ZeroVector;
+		const FMotionTraitField& PoseTraits = SourceMotionData->Poses[PoseId].Traits;
 
-		for (const FPoseMotionData& Pose : SourceMotionData->Poses)
-		{
-			if(Pose.bDoNotUse || Pose.Traits != MotionTrait)
-			{
-				continue;
-			}
+		int32* ExistingTraitIndex = TraitIndices.Find(PoseTraits);
+		const int32 TraitIndex = ExistingTraitIndex ? *ExistingTraitIndex : TraitIndices.Add(PoseTraits, Traits.Add(PoseTraits));
 
-			const FJointData& PoseJointData = Pose.JointData[i];
-
-			TotalPosition += PoseJointData.Position;
-			TotalVelocity += PoseJointData.Velocity;
+		if (TraitIndex >= TraitPoseIds.Num())
+		{
+			TraitPoseIds.AddDefaulted();
 		}
 
-		//Find Mean
-		FVector MeanPosition = TotalPosition / PoseCount;
-		FVector MeanVelocity = TotalPosition / PoseCount;
+		TraitPoseIds[TraitIndex].Add(PoseId);
+	}
 
-		//Sum the total of all atom distances squared to the mean
-		float TotalDistanceToMeanSquared_Position = 0.0f;
-		float TotalDistanceToMeanSquared_Velocity = 0.0f;
+	//Each partition is accumulated in pose order by a single task so the results don't depend on scheduling
+	TArray<FCalibrationData> TraitStdDeviations;
+	TraitStdDeviations.Init(FCalibrationData(), Traits.Num());
 
-		for (const FPoseMotionData& Pose : SourceMotionData->Poses)
-		{
-			if (Pose.bDoNotUse || Pose.Traits != MotionTrait)
-			{
-				continue;
-			}
+	ParallelFor(Traits.Num(), [&](int32 TraitIndex)
+	{
+		TraitStdDeviations[TraitIndex].SetStandardDeviationWeights(SourceMotionData, TraitPoseIds[TraitIndex]);
+	});
 
-			const FJointData& PoseJointData = Pose.JointData[i];
+	OutStdDeviations.Reserve(Traits.Num());
+	for (int32 TraitIndex = 0; TraitIndex < Traits.Num(); ++TraitIndex)
+	{
+		OutStdDeviations.Add(Traits[TraitIndex], MoveTemp(TraitStdDeviations[TraitIndex]));
+	}
+}
 
-			const float DistanceToMean_Position = FVector::DistSquared(PoseJointData.Position, MeanPosition);
-			const float DistanceToMean_Velocity = FVector::DistSquared(PoseJointData.Velocity, MeanVelocity);
+void FCalibrationData::SetStandardDeviationWeights(const UMotionDataAsset* SourceMotionData, const TArray<int32>& PoseIds)
+{
+	UMotionMatchConfig* MMConfig = SourceMotionData->MotionMatchConfig;
 
-			TotalDistanceToMeanSquared_Position += DistanceToMean_Position * DistanceToMean_Position;
-			TotalDistanceToMeanSquared_Velocity += DistanceToMean_Velocity * DistanceToMean_Velocity;
-		}
+	Initialize(MMConfig);
 
-		FJointWeightSet& StdDevWeightSet = PoseJointWeights[i];
+	const int32 JointCount = MMConfig->PoseBones.Num();
+	const int32 TrajectoryCount = MMConfig->TrajectoryTimes.Num();
 
-		//Set the standard deviation of these features
-		StdDevWeightSet.Weight_Pos = 1.0f / FMath::Sqrt(TotalDistanceToMeanSquared_Position / PoseCount);
-		StdDevWeightSet.Weight_Vel = 1.0f / FMath::Sqrt(TotalDistanceToMeanSquared_Velocity / PoseCount);
-	}
+	//Single pass over the poses accumulating every feature column at once
+	FPoseFeatureMoments Moments(4 + JointCount * 6 + TrajectoryCount * 5);
 
-	//For Each Trajectory Point
-	for (int32 i = 0; i < MMConfig->TrajectoryTimes.Num(); ++i)
+	for (const int32 PoseId : PoseIds)
 	{
-		FVector TotalPosition = FVector::ZeroVector;
-		float TotalFacingAngle = 0.0f;
+		const FPoseMotionData& Pose = SourceMotionData->Poses[PoseId];
 
-		for (const FPoseMotionData& Pose : SourceMotionData->Poses)
+		if (Pose.bDoNotUse
+			|| Pose.JointData.Num() != JointCount
+			|| Pose.Trajectory.Num() != TrajectoryCount)
 		{
-			if (Pose.bDoNotUse || Pose.Traits != MotionTrait)
-			{
-				continue;
-			}
-
-			const FTrajectoryPoint& TrajPoint = Pose.Trajectory[i];
-
-			TotalPosition += TrajPoint.Position;
-			TotalFacingAngle += TrajPoint.RotationZ;
+			continue;
 		}
 
-		//Find Mean
-		FVector MeanPosition = TotalPosition / PoseCount;
-		const float MeanFacing = TotalFacingAngle / PoseCount;
-
-		//Sum the total of all atom distances squared to the mean
-		float TotalDistanceToMeanSquared_Position = 0.0f;
-		float TotalDistanceToMeanSquared_Facing = 0.0f;
-
-		for (const FPoseMotionData& Pose : SourceMotionData->Poses)
-		{
-			if (Pose.bDoNotUse || Pose.Traits != MotionTrait)
-			{
-				continue;
-			}
-
-			const FTrajectoryPoint& TrajPoint = Pose.Trajectory[i];
-
-			const float DistanceToMean_Position = FVector::DistSquared(TrajPoint.Position, MeanPosition);
-			const float DistanceToMean_Facing = FMath::Abs(TrajPoint.RotationZ - MeanFacing);
+		Moments.AddPose(Pose);
+	}
 
-			TotalDistanceToMeanSquared_Position += DistanceToMean_Position * DistanceToMean_Position;
-			TotalDistanceToMeanSquared_Facing += DistanceToMean_Facing * DistanceToMean_Facing;
-		}
+	int32 Column = 0;
+	Weight_Momentum = GetStandardDeviationWeight(Moments.GetStandardDeviation(Column, 3)); Column += 3;
+	Weight_AngularMomentum = GetStandardDeviationWeight(Moments.GetStandardDeviation(Column, 1)); Column += 1;
 
-		FTrajectoryWeightSet& StdDevWeightSet = TrajectoryWeights[i];
+	for (FJointWeightSet& StdDevWeightSet : PoseJointWeights)
+	{
+		StdDevWeightSet.Weight_Pos = GetStandardDeviationWeight(Moments.GetStandardDeviation(Column, 3)); Column += 3;
+		StdDevWeightSet.Weight_Vel = GetStandardDeviationWeight(Moments.GetStandardDeviation(Column, 3)); Column += 3;
+	}
 
-		//Set the standard deviation of these features (if the StdDev is 0 the weight must be set to 0
-		const float StdDev_Pos = FMath::Sqrt(TotalDistanceToMeanSquared_Position / PoseCount);
-		StdDevWeightSet.Weight_Pos = FMath::IsNearlyEqual(StdDev_Pos, 0.0f) ? 0.0f : 1.0f / StdDev_Pos;
-		
-		const float StdDev_Facing = FMath::Sqrt(TotalDistanceToMeanSquared_Facing / PoseCount);
-		StdDevWeightSet.Weight_Facing = FMath::IsNearlyEqual(StdDev_Facing, 0.0f) ? 0.0f : 1.0f / StdDev_Facing;
+	for (FTrajectoryWeightSet& StdDevWeightSet : TrajectoryWeights)
+	{
+		StdDevWeightSet.Weight_Pos = GetStandardDeviationWeight(Moments.GetStandardDeviation(Column, 3)); Column += 3;
+		StdDevWeightSet.Weight_Facing = GetStandardDeviationWeight(Moments.GetStandardDeviation(Column, 2)); Column += 2;
 	}
 }
 
@@ -292,6 +321,8 @@ void FCalibrationData::GenerateFinalWeights(const UMotionCalibration* SourceCali
 
 	Initialize(SourceCalibration->MotionMatchConfig);
 
+	FeatureGroupOrder = StdDeviationNormalizers.FeatureGroupOrder;
+
 	const float TrajMultiplier = SourceCalibration->QualityVsResponsivenessRatio * 2.0f;
 	const float PoseMultiplier = (1.0f - SourceCalibration->QualityVsResponsivenessRatio) * 2.0f;
 
@@ -320,4 +351,194 @@ void FCalibrationData::GenerateFinalWeights(const UMotionCalibration* SourceCali
 
 		TrajectoryWeights.Add(CalibWeightSet * StdDevWeightSet);
 	}
-}
\ No newline at end of file
+}
+
+void FCalibrationData::GetFeatureGroupOrder(EMotionFeatureGroup* OutOrder) const
+{
+	const int32 GroupCount = (int32)EMotionFeatureGroup::Count;
+
+	uint32 GroupMask = 0;
+	if (FeatureGroupOrder.Num() == GroupCount)
+	{
+		for (const EMotionFeatureGroup Group : FeatureGroupOrder)
+		{
+			GroupMask |= (int32)Group < GroupCount ? 1u << (int32)Group : 0u;
+		}
+	}
+
+	const bool bValidOrder = GroupMask == (1u << GroupCount) - 1;
+	for (int32 i = 0; i < GroupCount; ++i)
+	{
+		OutOrder[i] = bValidOrder ? FeatureGroupOrder[i] : (EMotionFeatureGroup)i;
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCalibrationStandardDeviationTest, "MotionSymphony.Calibration.StandardDeviations",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FCalibrationStandardDeviationTest::RunTest(const FString& Parameters)
+{
+	const int32 JointCount = 2;
+	const int32 TrajectoryCount = 3;
+	const int32 PoseCount = 900;
+
+	UMotionMatchConfig* MMConfig = NewObject<UMotionMatchConfig>(GetTransientPackage());
+	MMConfig->PoseBones.SetNum(JointCount);
+	MMConfig->TrajectoryTimes = { -0.5f, 0.5f, 1.0f };
+
+	UMotionDataAsset* MotionData = NewObject<UMotionDataAsset>(GetTransientPackage());
+	MotionData->MotionMatchConfig = MMConfig;
+
+	//Three traits with features far from the origin, which loses precision in a naive single pass. The third trait 
+	//doesn't move so its momentum deviation, and weight, is zero
+	FRandomStream Random(35);
+	for (int32 PoseId = 0; PoseId < PoseCount; ++PoseId)
+	{
+		const int32 TraitIndex = PoseId % 3;
+
+		FPoseMotionData& Pose = MotionData->Poses.AddDefaulted_GetRef();
+		Pose.PoseId = PoseId;
+		Pose.Traits = FMotionTraitField(TraitIndex);
+		Pose.LocalVelocity = TraitIndex == 2 ? FVector(5000.0f, 0.0f, 0.0f) : FVector(5000.0f) + Random.GetUnitVector() * Random.FRandRange(0.0f, 300.0f);
+		Pose.RotationalVelocity = Random.FRandRange(-90.0f, 90.0f) * (TraitIndex + 1);
+
+		for (int32 i = 0; i < JointCount; ++i)
+		{
+			Pose.JointData.Add(FJointData(FVector(10000.0f * (i + 1)) + Random.GetUnitVector() * Random.FRandRange(0.0f, 20.0f),
+				Random.GetUnitVector() * Random.FRandRange(0.0f, 400.0f)));
+		}
+
+		for (int32 i = 0; i < TrajectoryCount; ++i)
+		{
+			Pose.Trajectory.Add(FTrajectoryPoint(FVector(Random.FRandRange(-200.0f, 200.0f), Random.FRandRange(-200.0f, 200.0f), 0.0f) * (i + 1), 
+				Random.FRandRange(-180.0f, 180.0f)));
+		}
+
+		//Unused poses and poses that don't match the config are excluded
+		Pose.bDoNotUse = PoseId % 50 == 7;
+		if (PoseId % 70 == 11)
+		{
+			Pose.JointData.Pop();
+			Pose.LocalVelocity = FVector(1000000.0f);
+		}
+	}
+
+	TMap<FMotionTraitField, FCalibrationData> StdDeviations;
+	TMap<FMotionTraitField, FCalibrationData> RepeatStdDeviations;
+	FCalibrationData::GenerateStandardDeviationWeights(MotionData, StdDeviations);
+	FCalibrationData::GenerateStandardDeviationWeights(MotionData, RepeatStdDeviations);
+
+	auto GetWeights = [](const FCalibrationData& Calibration)
+	{
+		TArray<float> Weights = { Calibration.Weight_Momentum, Calibration.Weight_AngularMomentum };
+		for (const FJointWeightSet& WeightSet : Calibration.PoseJointWeights)
+		{
+			Weights.Add(WeightSet.Weight_Pos);
+			Weights.Add(WeightSet.Weight_Vel);
+		}
+
+		for (const FTrajectoryWeightSet& WeightSet : Calibration.TrajectoryWeights)
+		{
+			Weights.Add(WeightSet.Weight_Pos);
+			Weights.Add(WeightSet.Weight_Facing);
+		}
+
+		return Weights;
+	};
+
+	//Each feature's values in the same order as the weights
+	auto GetFeatures = [](const FPoseMotionData& Pose)
+	{
+		TArray<TArray<double>> Features = { { Pose.LocalVelocity.X, Pose.LocalVelocity.Y, Pose.LocalVelocity.Z }, { Pose.RotationalVelocity } };
+		for (const FJointData& JointData : Pose.JointData)
+		{
+			Features.Add({ JointData.Position.X, JointData.Position.Y, JointData.Position.Z });
+			Features.Add({ JointData.Velocity.X, JointData.Velocity.Y, JointData.Velocity.Z });
+		}
+
+		for (const FTrajectoryPoint& TrajPoint : Pose.Trajectory)
+		{
+			Features.Add({ TrajPoint.Position.X, TrajPoint.Position.Y, TrajPoint.Position.Z });
+			Features.Add({ TrajPoint.Facing.X, TrajPoint.Facing.Y });
+		}
+
+		return Features;
+	};
+
+	TestEqual(TEXT("Standard deviations for every trait"), StdDeviations.Num(), 3);
+
+	for (int32 TraitIndex = 0; TraitIndex < 3; ++TraitIndex)
+	{
+		const FMotionTraitField Traits(TraitIndex);
+		const FCalibrationData* Calibration = StdDeviations.Find(Traits);
+		const FCalibrationData* RepeatCalibration = RepeatStdDeviations.Find(Traits);
+		if (!TestNotNull(TEXT("Trait standard deviations"), Calibration) || !TestNotNull(TEXT("Trait standard deviations"), RepeatCalibration))
+		{
+			continue;
+		}
+
+		TestTrue(TEXT("Standard deviations are deterministic"), GetWeights(*Calibration) == GetWeights(*RepeatCalibration));
+
+		//Two pass reference. The mean of each feature first, then the mean squared distance to it
+		TArray<TArray<TArray<double>>> PoseFeatures;
+		for (const FPoseMotionData& Pose : MotionData->Poses)
+		{
+			if (Pose.Traits == Traits && !Pose.bDoNotUse && Pose.JointData.Num() == JointCount && Pose.Trajectory.Num() == TrajectoryCount)
+			{
+				PoseFeatures.Add(GetFeatures(Pose));
+			}
+		}
+
+		TArray<float> ReferenceWeights;
+		const int32 FeatureCount = PoseFeatures[0].Num();
+		for (int32 Feature = 0; Feature < FeatureCount; ++Feature)
+		{
+			const int32 Width = PoseFeatures[0][Feature].Num();
+
+			TArray<double> Mean;
+			Mean.SetNumZeroed(Width);
+			for (const TArray<TArray<double>>& Features : PoseFeatures)
+			{
+				for (int32 i = 0; i < Width; ++i)
+				{
+					Mean[i] += Features[Feature][i] / PoseFeatures.Num();
+				}
+			}
+
+			double SquaredDistanceSum = 0.0;
+			for (const TArray<TArray<double>>& Features : PoseFeatures)
+			{
+				for (int32 i = 0; i < Width; ++i)
+				{
+					SquaredDistanceSum += FMath::Square(Features[Feature][i] - Mean[i]);
+				}
+			}
+
+			const float StdDev = (float)FMath::Sqrt(SquaredDistanceSum / PoseFeatures.Num());
+			ReferenceWeights.Add(FMath::IsNearlyEqual(StdDev, 0.0f) ? 0.0f : 1.0f / StdDev);
+		}
+
+		const TArray<float> Weights = GetWeights(*Calibration);
+		if (!TestEqual(TEXT("Weight count"), Weights.Num(), ReferenceWeights.Num()))
+		{
+			continue;
+		}
+
+		for (int32 i = 0; i < Weights.Num(); ++i)
+		{
+			TestTrue(FString::Printf(TEXT("Trait %d weight %d (%f) matches the two pass reference (%f)"), TraitIndex, i, Weights[i], ReferenceWeights[i]),
+				FMath::IsNearlyEqual(Weights[i], ReferenceWeights[i], FMath::Max(FMath::Abs(ReferenceWeights[i]) * 0.0001f, 1e-8f)));
+		}
+
+		if (TraitIndex == 2)
+		{
+			TestEqual(TEXT("A constant feature has a zero weight"), Calibration->Weight_Momentum, 0.0f);
+		}
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
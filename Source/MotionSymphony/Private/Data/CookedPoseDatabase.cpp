@@ -0,0 +1,280 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "Data/CookedPoseDatabase.h"
+#include "Misc/Crc.h"
+
+const uint32 FCookedPoseDatabase::Magic = 0x4D534442; //'MSDB'
+const uint32 FCookedPoseDatabase::Version = 2;
+
+namespace CookedPoseDatabase
+{
+	constexpr int64 SectionAlignment = 16;
+
+	FORCEINLINE int64 GetPayloadOffset()
+	{
+		return Align((int64)sizeof(FCookedPoseDatabase::FHeader), SectionAlignment);
+	}
+
+	bool IsValidSection(const int64 Offset, const int64 Size, const int64 DataSize)
+	{
+		return Offset >= GetPayloadOffset()
+			&& Offset % SectionAlignment == 0
+			&& Size >= 0
+			&& Offset + Size <= DataSize;
+	}
+}
+
+int32 FCookedPoseDatabase::GetFeatureStride(const int32 TrajectoryPointCount, const int32 JointCount)
+{
+	//Local velocity (3), rotational velocity (1), trajectory points (position 3, facing 1), joints (position 3, velocity 3)
+	return 4 + TrajectoryPointCount * 4 + JointCount * 6;
+}
+
+bool FCookedPoseDatabase::CanPack(const TArray<FPoseMotionData>& Poses)
+{
+	if (Poses.Num() == 0)
+	{
+		return false;
+	}
+
+	const int32 TrajectoryPointCount = Poses[0].Trajectory.Num();
+	const int32 JointCount = Poses[0].JointData.Num();
+
+	for (int32 PoseIndex = 0; PoseIndex < Poses.Num(); ++PoseIndex)
+	{
+		const FPoseMotionData& Pose = Poses[PoseIndex];
+
+		if (Pose.PoseId != PoseIndex
+			|| Pose.Trajectory.Num() != TrajectoryPointCount
+			|| Pose.JointData.Num() != JointCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FCookedPoseDatabase::Pack(const TArray<FPoseMotionData>& Poses, const TArray<int32>& SearchPoseIds, 
+	const TArray<uint64>& PrunedPoseBitmap, TArray<uint8>& OutBlob)
+{
+	check(CanPack(Poses));
+
+	FHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = Magic;
+	Header.Version = Version;
+	Header.PoseCount = Poses.Num();
+	Header.TrajectoryPointCount = Poses[0].Trajectory.Num();
+	Header.JointCount = Poses[0].JointData.Num();
+	Header.TraitWordCount = MOTION_TRAIT_FIELD_WORDS;
+	Header.FeatureStride = GetFeatureStride(Header.TrajectoryPointCount, Header.JointCount);
+	Header.SearchIndexCount = SearchPoseIds.Num();
+	Header.PrunedWordCount = PrunedPoseBitmap.Num();
+
+	const int64 PoseCount = Header.PoseCount;
+	Header.FeatureOffset = CookedPoseDatabase::GetPayloadOffset();
+	Header.MetadataOffset = Align(Header.FeatureOffset + PoseCount * Header.FeatureStride * sizeof(float), CookedPoseDatabase::SectionAlignment);
+	Header.SequencingOffset = Align(Header.MetadataOffset + PoseCount * sizeof(FPoseMetadata), CookedPoseDatabase::SectionAlignment);
+	Header.TraitOffset = Align(Header.SequencingOffset + PoseCount * sizeof(FPoseSequencing), CookedPoseDatabase::SectionAlignment);
+	Header.SearchIndexOffset = Align(Header.TraitOffset + PoseCount * Header.TraitWordCount * sizeof(int32), CookedPoseDatabase::SectionAlignment);
+	Header.PrunedOffset = Align(Header.SearchIndexOffset + Header.SearchIndexCount * sizeof(int32), CookedPoseDatabase::SectionAlignment);
+	Header.TotalSize = Align(Header.PrunedOffset + Header.PrunedWordCount * sizeof(uint64), CookedPoseDatabase::SectionAlignment);
+
+	OutBlob.Reset();
+	OutBlob.SetNumZeroed(Header.TotalSize);
+	uint8* Data = OutBlob.GetData();
+
+	float* Features = reinterpret_cast<float*>(Data + Header.FeatureOffset);
+	FPoseMetadata* Metadata = reinterpret_cast<FPoseMetadata*>(Data + Header.MetadataOffset);
+	FPoseSequencing* Sequencing = reinterpret_cast<FPoseSequencing*>(Data + Header.SequencingOffset);
+	int32* TraitWords = reinterpret_cast<int32*>(Data + Header.TraitOffset);
+
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		*Features++ = Pose.LocalVelocity.X;
+		*Features++ = Pose.LocalVelocity.Y;
+		*Features++ = Pose.LocalVelocity.Z;
+		*Features++ = Pose.RotationalVelocity;
+
+		for (const FTrajectoryPoint& Point : Pose.Trajectory)
+		{
+			*Features++ = Point.Position.X;
+			*Features++ = Point.Position.Y;
+			*Features++ = Point.Position.Z;
+			*Features++ = Point.RotationZ;
+		}
+
+		for (const FJointData& Joint : Pose.JointData)
+		{
+			*Features++ = Joint.Position.X;
+			*Features++ = Joint.Position.Y;
+			*Features++ = Joint.Position.Z;
+			*Features++ = Joint.Velocity.X;
+			*Features++ = Joint.Velocity.Y;
+			*Features++ = Joint.Velocity.Z;
+		}
+
+		Metadata->AnimId = Pose.AnimId;
+		Metadata->CandidateSetId = Pose.CandidateSetId;
+		Metadata->Time = Pose.Time;
+		Metadata->Favour = Pose.Favour;
+		Metadata->BlendSpacePosition = Pose.BlendSpacePosition;
+		Metadata->AnimType = (uint8)Pose.AnimType;
+		Metadata->Flags = (Pose.bMirrored ? EPoseFlags::Mirrored : 0) | (Pose.bDoNotUse ? EPoseFlags::DoNotUse : 0);
+		++Metadata;
+
+		Sequencing->NextPoseId = Pose.NextPoseId;
+		Sequencing->LastPoseId = Pose.LastPoseId;
+		++Sequencing;
+
+		for (int32 WordIndex = 0; WordIndex < MOTION_TRAIT_FIELD_WORDS; ++WordIndex)
+		{
+			*TraitWords++ = Pose.Traits.GetWord(WordIndex);
+		}
+	}
+
+	FMemory::Memcpy(Data + Header.SearchIndexOffset, SearchPoseIds.GetData(), Header.SearchIndexCount * sizeof(int32));
+	FMemory::Memcpy(Data + Header.PrunedOffset, PrunedPoseBitmap.GetData(), Header.PrunedWordCount * sizeof(uint64));
+
+	const int64 PayloadOffset = CookedPoseDatabase::GetPayloadOffset();
+	Header.PayloadCrc = FCrc::MemCrc32(Data + PayloadOffset, Header.TotalSize - PayloadOffset);
+
+	FMemory::Memcpy(Data, &Header, sizeof(FHeader));
+}
+
+bool FCookedPoseDatabase::Validate(const uint8* Data, const int64 DataSize)
+{
+	if (!Data || DataSize < CookedPoseDatabase::GetPayloadOffset())
+	{
+		return false;
+	}
+
+	FHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(FHeader));
+
+	if (Header.Magic != Magic
+		|| Header.Version != Version
+		|| Header.TotalSize != DataSize
+		|| Header.PoseCount < 0
+		|| Header.TrajectoryPointCount < 0
+		|| Header.JointCount < 0
+		|| Header.SearchIndexCount < 0 || Header.SearchIndexCount > Header.PoseCount
+		|| Header.PrunedWordCount < 0 || Header.PrunedWordCount > FMath::DivideAndRoundUp(Header.PoseCount, 64)
+		|| Header.TraitWordCount != MOTION_TRAIT_FIELD_WORDS
+		|| Header.FeatureStride != GetFeatureStride(Header.TrajectoryPointCount, Header.JointCount))
+	{
+		return false;
+	}
+
+	const int64 PoseCount = Header.PoseCount;
+	if (!CookedPoseDatabase::IsValidSection(Header.FeatureOffset, PoseCount * Header.FeatureStride * sizeof(float), DataSize)
+		|| !CookedPoseDatabase::IsValidSection(Header.MetadataOffset, PoseCount * sizeof(FPoseMetadata), DataSize)
+		|| !CookedPoseDatabase::IsValidSection(Header.SequencingOffset, PoseCount * sizeof(FPoseSequencing), DataSize)
+		|| !CookedPoseDatabase::IsValidSection(Header.TraitOffset, PoseCount * Header.TraitWordCount * sizeof(int32), DataSize)
+		|| !CookedPoseDatabase::IsValidSection(Header.SearchIndexOffset, Header.SearchIndexCount * sizeof(int32), DataSize)
+		|| !CookedPoseDatabase::IsValidSection(Header.PrunedOffset, Header.PrunedWordCount * sizeof(uint64), DataSize))
+	{
+		return false;
+	}
+
+	const int64 PayloadOffset = CookedPoseDatabase::GetPayloadOffset();
+	if (FCrc::MemCrc32(Data + PayloadOffset, DataSize - PayloadOffset) != Header.PayloadCrc)
+	{
+		return false;
+	}
+
+	//Every pose reference must resolve within the database
+	const FPoseMetadata* Metadata = reinterpret_cast<const FPoseMetadata*>(Data + Header.MetadataOffset);
+	const FPoseSequencing* Sequencing = reinterpret_cast<const FPoseSequencing*>(Data + Header.SequencingOffset);
+	for (int32 PoseIndex = 0; PoseIndex < Header.PoseCount; ++PoseIndex)
+	{
+		if (Metadata[PoseIndex].AnimId < 0
+			|| Metadata[PoseIndex].AnimType > (uint8)EMotionAnimAssetType::Composite
+			|| Sequencing[PoseIndex].NextPoseId < -1 || Sequencing[PoseIndex].NextPoseId >= Header.PoseCount
+			|| Sequencing[PoseIndex].LastPoseId < -1 || Sequencing[PoseIndex].LastPoseId >= Header.PoseCount)
+		{
+			return false;
+		}
+	}
+
+	const int32* SearchPoseIds = reinterpret_cast<const int32*>(Data + Header.SearchIndexOffset);
+	for (int32 SearchIndex = 0; SearchIndex < Header.SearchIndexCount; ++SearchIndex)
+	{
+		if (SearchPoseIds[SearchIndex] < 0 || SearchPoseIds[SearchIndex] >= Header.PoseCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FCookedPoseDatabase::Unpack(const uint8* Data, const int64 DataSize, TArray<FPoseMotionData>& OutPoses, 
+	TArray<int32>& OutSearchPoseIds, TArray<uint64>& OutPrunedPoseBitmap)
+{
+	if (!Validate(Data, DataSize))
+	{
+		return false;
+	}
+
+	FHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(FHeader));
+
+	const float* Features = reinterpret_cast<const float*>(Data + Header.FeatureOffset);
+	const FPoseMetadata* Metadata = reinterpret_cast<const FPoseMetadata*>(Data + Header.MetadataOffset);
+	const FPoseSequencing* Sequencing = reinterpret_cast<const FPoseSequencing*>(Data + Header.SequencingOffset);
+	const int32* TraitWords = reinterpret_cast<const int32*>(Data + Header.TraitOffset);
+
+	OutPoses.Empty(Header.PoseCount);
+	for (int32 PoseIndex = 0; PoseIndex < Header.PoseCount; ++PoseIndex)
+	{
+		FPoseMotionData& Pose = OutPoses.Emplace_GetRef(Header.TrajectoryPointCount, Header.JointCount);
+		Pose.PoseId = PoseIndex;
+
+		Pose.LocalVelocity = FVector(Features[0], Features[1], Features[2]);
+		Pose.RotationalVelocity = Features[3];
+		Features += 4;
+
+		for (FTrajectoryPoint& Point : Pose.Trajectory)
+		{
+			Point.Position = FVector(Features[0], Features[1], Features[2]);
+			Point.RotationZ = Features[3];
+			Point.UpdateFacing();
+			Features += 4;
+		}
+
+		for (FJointData& Joint : Pose.JointData)
+		{
+			Joint.Position = FVector(Features[0], Features[1], Features[2]);
+			Joint.Velocity = FVector(Features[3], Features[4], Features[5]);
+			Features += 6;
+		}
+
+		const FPoseMetadata& PoseMetadata = Metadata[PoseIndex];
+		Pose.AnimId = PoseMetadata.AnimId;
+		Pose.CandidateSetId = PoseMetadata.CandidateSetId;
+		Pose.Time = PoseMetadata.Time;
+		Pose.Favour = PoseMetadata.Favour;
+		Pose.BlendSpacePosition = PoseMetadata.BlendSpacePosition;
+		Pose.AnimType = (EMotionAnimAssetType)PoseMetadata.AnimType;
+		Pose.bMirrored = (PoseMetadata.Flags & EPoseFlags::Mirrored) != 0;
+		Pose.bDoNotUse = (PoseMetadata.Flags & EPoseFlags::DoNotUse) != 0;
+
+		Pose.NextPoseId = Sequencing[PoseIndex].NextPoseId;
+		Pose.LastPoseId = Sequencing[PoseIndex].LastPoseId;
+
+		for (int32 WordIndex = 0; WordIndex < MOTION_TRAIT_FIELD_WORDS; ++WordIndex)
+		{
+			Pose.Traits.GetWord(WordIndex) = *TraitWords++;
+		}
+	}
+
+	OutSearchPoseIds.SetNumUninitialized(Header.SearchIndexCount);
+	FMemory::Memcpy(OutSearchPoseIds.GetData(), Data + Header.SearchIndexOffset, Header.SearchIndexCount * sizeof(int32));
+
+	OutPrunedPoseBitmap.SetNumUninitialized(Header.PrunedWordCount);
+	FMemory::Memcpy(OutPrunedPoseBitmap.GetData(), Data + Header.PrunedOffset, Header.PrunedWordCount * sizeof(uint64));
+
+	return true;
+}
@@ -81,6 +81,8 @@ void FDistanceMatchSection::GenerateDistanceCurve(const UAnimSequence* Sequence)
 			DistanceCurve.UpdateOrAddKey(CumulativeDistance, Time);
 		}
 	}
+
+	BakeDistanceCurve();
 }
 
 void FDistanceMatchSection::GenerateRotationCurve(const UAnimSequence* Sequence)
@@ -126,51 +128,18 @@ void FDistanceMatchSection::GenerateRotationCurve(const UAnimSequence* Sequence)
 			DistanceCurve.UpdateOrAddKey(CumulativeDistance, Time);
 		}
 	}
+
+	BakeDistanceCurve();
 }
 
+void FDistanceMatchSection::BakeDistanceCurve()
+{
+	BakedDistanceCurve.Bake(DistanceCurve.FloatCurve.GetConstRefOfKeys());
+}
 
 float FDistanceMatchSection::FindMatchingTime(const float DesiredDistance, int32& LastKeyChecked)
 {
-	int32 KeyCount = DistanceCurve.FloatCurve.Keys.Num();
-	int32 StartKey = LastKeyChecked;
-
-	if(StartKey < 0 || StartKey >= KeyCount)
-		return -1.0f;
-
-	FRichCurveKey* PKey = &DistanceCurve.FloatCurve.Keys[StartKey];
-	FRichCurveKey* SKey = nullptr;
-
-	for (int32 i = StartKey; i < KeyCount; ++i)
-	{
-		FRichCurveKey& Key = DistanceCurve.FloatCurve.Keys[i];
-
-		if (Key.Value > DesiredDistance)
-		{
-			PKey = &Key;
-		}
-		else
-		{
-			SKey = &Key;
-			LastKeyChecked = i;
-			break;
-		}
-	}
-
-	if (!SKey)
-	{
-		return PKey->Time;
-	}
-
-	float dV = SKey->Value - PKey->Value;
-
-	if (dV < 0.000001f)
-	{
-		return PKey->Time;
-	}
-
-	float dT = SKey->Time - PKey->Time;
-
-	return ((dT / dV) * (DesiredDistance - PKey->Value)) + PKey->Time; //Interpolate the exact time
+	return BakedDistanceCurve.FindMatchingTime(DesiredDistance, false, LastKeyChecked);
 }
 
 FDistanceMatchPayload::FDistanceMatchPayload()
@@ -0,0 +1,99 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "Data/MotionFeatureBounds.h"
+#include "Data/CalibrationData.h"
+#include "CustomAssets/MotionCalibration.h"
+#include "Data/PoseMotionData.h"
+
+FMotionFeatureBounds::FMotionFeatureBounds()
+	: LocalVelocity(ForceInit),
+	MinRotationalVelocity(0.0f),
+	MaxRotationalVelocity(0.0f),
+	MinFavour(1.0f),
+	PoseCount(0)
+{
+}
+
+bool FMotionFeatureBounds::IsValid() const
+{
+	return PoseCount > 0;
+}
+
+void FMotionFeatureBounds::Add(const FPoseMotionData& Pose)
+{
+	if (PoseCount == 0)
+	{
+		TrajectoryPositions.Init(FBox(ForceInit), Pose.Trajectory.Num());
+		TrajectoryFacings.Init(FBox2D(ForceInit), Pose.Trajectory.Num());
+		JointPositions.Init(FBox(ForceInit), Pose.JointData.Num());
+		JointVelocities.Init(FBox(ForceInit), Pose.JointData.Num());
+		MinRotationalVelocity = MaxRotationalVelocity = Pose.RotationalVelocity;
+		MinFavour = Pose.Favour;
+	}
+
+	LocalVelocity += Pose.LocalVelocity;
+	MinRotationalVelocity = FMath::Min(MinRotationalVelocity, Pose.RotationalVelocity);
+	MaxRotationalVelocity = FMath::Max(MaxRotationalVelocity, Pose.RotationalVelocity);
+	MinFavour = FMath::Min(MinFavour, Pose.Favour);
+
+	const int32 TrajectoryCount = FMath::Min(TrajectoryPositions.Num(), Pose.Trajectory.Num());
+	for (int32 i = 0; i < TrajectoryCount; ++i)
+	{
+		TrajectoryPositions[i] += Pose.Trajectory[i].Position;
+		TrajectoryFacings[i] += Pose.Trajectory[i].Facing;
+	}
+
+	const int32 JointCount = FMath::Min(JointPositions.Num(), Pose.JointData.Num());
+	for (int32 i = 0; i < JointCount; ++i)
+	{
+		JointPositions[i] += Pose.JointData[i].Position;
+		JointVelocities[i] += Pose.JointData[i].Velocity;
+	}
+
+	++PoseCount;
+}
+
+float FMotionFeatureBounds::ComputeLowerBound(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+	const FCalibrationData& Calibration, const float PoseMultiplier, const float TrajectoryMultiplier) const
+{
+	if (!IsValid())
+	{
+		return 0.0f;
+	}
+
+	//Body Momentum
+	float Bound = LocalVelocity.ComputeSquaredDistanceToPoint(CurrentPose.LocalVelocity) * Calibration.Weight_Momentum * PoseMultiplier;
+
+	//Body Rotational Momentum
+	const float RotationalVelocityDistance = FMath::Max3(0.0f, MinRotationalVelocity - CurrentPose.RotationalVelocity, 
+		CurrentPose.RotationalVelocity - MaxRotationalVelocity);
+	Bound += RotationalVelocityDistance * Calibration.Weight_AngularMomentum * PoseMultiplier;
+
+	//Trajectory. Every term of the cost is positive so any subset of them is still a lower bound
+	const int32 TrajectoryCount = FMath::Min3(DesiredTrajectory.Num(), Calibration.TrajectoryWeights.Num(), TrajectoryPositions.Num());
+	for (int32 i = 0; i < TrajectoryCount; ++i)
+	{
+		Bound += TrajectoryPositions[i].ComputeSquaredDistanceToPoint(DesiredTrajectory[i].Position)
+			* Calibration.TrajectoryWeights[i].Weight_Pos * TrajectoryMultiplier;
+	}
+
+	//Bounds built before facings were stored as directions have none
+	const int32 FacingCount = FMath::Min(TrajectoryCount, TrajectoryFacings.Num());
+	for (int32 i = 0; i < FacingCount; ++i)
+	{
+		Bound += TrajectoryFacings[i].ComputeSquaredDistanceToPoint(DesiredTrajectory[i].Facing)
+			* Calibration.TrajectoryWeights[i].Weight_Facing * TrajectoryMultiplier;
+	}
+
+	//Joints
+	const int32 JointCount = FMath::Min3(CurrentPose.JointData.Num(), Calibration.PoseJointWeights.Num(), JointPositions.Num());
+	for (int32 i = 0; i < JointCount; ++i)
+	{
+		const FJointWeightSet& WeightSet = Calibration.PoseJointWeights[i];
+
+		Bound += (JointVelocities[i].ComputeSquaredDistanceToPoint(CurrentPose.JointData[i].Velocity) * WeightSet.Weight_Vel
+			+ JointPositions[i].ComputeSquaredDistanceToPoint(CurrentPose.JointData[i].Position) * WeightSet.Weight_Pos) * PoseMultiplier;
+	}
+
+	return Bound * FMath::Max(MinFavour, 0.0f);
+}
@@ -0,0 +1,69 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "Data/MotionPoseRange.h"
+
+FMotionBlendSampleWeight::FMotionBlendSampleWeight()
+	: SampleIndex(0),
+	Weight(0.0f)
+{
+}
+
+FMotionBlendSampleWeight::FMotionBlendSampleWeight(const int32 InSampleIndex, const float InWeight)
+	: SampleIndex(InSampleIndex),
+	Weight(InWeight)
+{
+}
+
+FMotionPoseRange::FMotionPoseRange()
+	: AnimType(EMotionAnimAssetType::None),
+	AnimId(0),
+	bMirrored(false),
+	bLoop(false),
+	BlendSpacePosition(FVector2D::ZeroVector),
+	StartPoseId(0),
+	EndPoseId(-1),
+	StartTime(0.0f),
+	BlendSampleStart(INDEX_NONE),
+	BlendSampleCount(0)
+{
+}
+
+int32 FMotionPoseRange::Num() const
+{
+	return EndPoseId - StartPoseId + 1;
+}
+
+bool FMotionPoseRange::Contains(const int32 PoseId) const
+{
+	return PoseId >= StartPoseId && PoseId <= EndPoseId;
+}
+
+int32 FMotionPoseRange::GetPoseIdAtTime(const float Time, const float PoseInterval, float& OutInterpolation) const
+{
+	const int32 PoseCount = Num();
+	if (PoseCount < 1)
+	{
+		OutInterpolation = 0.0f;
+		return StartPoseId;
+	}
+
+	//A small tolerance so that times sitting exactly on a pose aren't floored to the pose before due to float error
+	const float PosesPassed = FMath::Max(0.0f, (Time - StartTime) / FMath::Max(PoseInterval, 0.01f) + KINDA_SMALL_NUMBER);
+	int32 PoseOffset = FMath::FloorToInt(PosesPassed);
+	OutInterpolation = FMath::Clamp(PosesPassed - PoseOffset, 0.0f, 1.0f);
+
+	if (PoseOffset >= PoseCount)
+	{
+		if (bLoop)
+		{
+			PoseOffset %= PoseCount;
+		}
+		else
+		{
+			PoseOffset = PoseCount - 1;
+			OutInterpolation = 0.0f;
+		}
+	}
+
+	return StartPoseId + PoseOffset;
+}
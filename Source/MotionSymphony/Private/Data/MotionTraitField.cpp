@@ -5,121 +5,163 @@
 FMotionTraitField::FMotionTraitField()
 	: A(0),
 	B(0)
-{ }
+{
+	FMemory::Memzero(Extended);
+}
 
 FMotionTraitField::FMotionTraitField(const int32 TraitPosition)
 	: A(0),
 	B(0)
 {
-	if (TraitPosition < 32)
-	{
-		A = (1 << TraitPosition);
-	}
-	else
-	{
-		B = (1 << (TraitPosition - 32));
-	}
+	FMemory::Memzero(Extended);
+	SetTraitPosition(TraitPosition);
 }
 
 FMotionTraitField::FMotionTraitField(const int32 InA, const int32 InB)
 	: A(InA),
 	B(InB)
-{ }
-
-
+{
+	FMemory::Memzero(Extended);
+}
 
 void FMotionTraitField::Clear()
 {
 	B = A = 0;
+	FMemory::Memzero(Extended);
 }
 
-bool FMotionTraitField::HasTrait(const int32 TraitPosition) const
+bool FMotionTraitField::IsEmpty() const
 {
-	if (TraitPosition < 32)
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
 	{
-		int32 Trait = (1 << TraitPosition);
-
-		return (A & Trait) == Trait;
+		if (GetWord(i) != 0)
+		{
+			return false;
+		}
 	}
-	else
-	{
-		int32 Trait = (1 << (TraitPosition - 32));
 
-		return (B & Trait) == Trait;
+	return true;
+}
+
+bool FMotionTraitField::HasTrait(const int32 TraitPosition) const
+{
+	if (!IsValidTraitPosition(TraitPosition))
+	{
+		return false;
 	}
 
-	return false;
+	const uint32 Trait = (1u << (TraitPosition % 32));
+
+	return ((uint32)GetWord(TraitPosition / 32) & Trait) == Trait;
 }
 
 bool FMotionTraitField::HasTraits(const FMotionTraitField Traits) const
 {
-	return ((A & Traits.A) == Traits.A) && ((B & Traits.B) == Traits.B);
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
+	{
+		if ((GetWord(i) & Traits.GetWord(i)) != Traits.GetWord(i))
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-void FMotionTraitField::SetTraitPosition(const int32 TraitPosition)
+void FMotionTraitField::GetTraitPositions(TArray<int32>& OutTraitPositions) const
 {
-	if (TraitPosition < 32)
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
 	{
-		A |= (1 << TraitPosition);
+		uint32 Word = (uint32)GetWord(i);
+		while (Word != 0)
+		{
+			const uint32 Bit = FMath::CountTrailingZeros(Word);
+			OutTraitPositions.Add(i * 32 + Bit);
+			Word &= Word - 1;
+		}
 	}
-	else
+}
+
+void FMotionTraitField::SetTraitPosition(const int32 TraitPosition)
+{
+	if (!IsValidTraitPosition(TraitPosition))
 	{
-		B |= (1 << (TraitPosition - 32));
+		return;
 	}
+
+	GetWord(TraitPosition / 32) |= (int32)(1u << (TraitPosition % 32));
 }
 
 void FMotionTraitField::UnSetTraitPosition(const int32 TraitPosition)
 {
-	if (TraitPosition < 32)
-	{
-		A &= ~(1 << TraitPosition);
-	}
-	else
+	if (!IsValidTraitPosition(TraitPosition))
 	{
-		B &= ~(1 << (TraitPosition - 32));
+		return;
 	}
+
+	GetWord(TraitPosition / 32) &= ~(int32)(1u << (TraitPosition % 32));
 }
 
 void FMotionTraitField::SetTraits(const FMotionTraitField Traits)
 {
-	A |= Traits.A;
-	B |= Traits.B;
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
+	{
+		GetWord(i) |= Traits.GetWord(i);
+	}
 }
 
 void FMotionTraitField::UnSetTraits(const FMotionTraitField Traits)
 {
-	A &= ~Traits.A;
-	B &= ~Traits.B;
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
+	{
+		GetWord(i) &= ~Traits.GetWord(i);
+	}
 }
 
 bool FMotionTraitField::operator==(const FMotionTraitField& rhs) const
 {
-	return (A == rhs.A && B == rhs.B);
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
+	{
+		if (GetWord(i) != rhs.GetWord(i))
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 bool FMotionTraitField::operator!=(const FMotionTraitField& rhs) const
 {
-	return (A != rhs.A || B != rhs.B);
+	return !(*this == rhs);
 }
 
 FMotionTraitField FMotionTraitField::operator&(const FMotionTraitField& rhs) const
 {
-	return FMotionTraitField(A & rhs.A, B | rhs.B);
+	FMotionTraitField Result = *this;
+	Result &= rhs;
+	return Result;
 }
 
 FMotionTraitField FMotionTraitField::operator|(const FMotionTraitField& rhs) const
 {
-	return FMotionTraitField(A | rhs.A, B | rhs.B);
+	FMotionTraitField Result = *this;
+	Result |= rhs;
+	return Result;
 }
 
 void FMotionTraitField::operator&=(const FMotionTraitField& rhs)
 {
-	A &= rhs.A;
-	B &= rhs.B;
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
+	{
+		GetWord(i) &= rhs.GetWord(i);
+	}
 }
 
 void FMotionTraitField::operator|=(const FMotionTraitField& rhs)
 {
-	A |= rhs.A;
-	B |= rhs.B;
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_WORDS; ++i)
+	{
+		GetWord(i) |= rhs.GetWord(i);
+	}
 }
@@ -0,0 +1,434 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "Data/PoseFeaturePCA.h"
+#include "Data/CalibrationData.h"
+#include "Data/PoseMotionData.h"
+#include "CustomAssets/MotionDataAsset.h"
+
+/** Eigen decomposition of a symmetric matrix (row major, N x N) with cyclic Jacobi rotations. The matrix is destroyed. 
+Eigen vectors are returned as the columns of OutEigenVectors. */
+static void ComputeSymmetricEigen(TArray<double>& Matrix, const int32 N, TArray<double>& OutEigenValues, TArray<double>& OutEigenVectors)
+{
+	OutEigenVectors.SetNumZeroed(N * N);
+	for (int32 i = 0; i < N; ++i)
+	{
+		OutEigenVectors[i * N + i] = 1.0;
+	}
+
+	for (int32 Sweep = 0; Sweep < 64; ++Sweep)
+	{
+		double OffDiagonal = 0.0;
+		double Diagonal = 0.0;
+		for (int32 p = 0; p < N; ++p)
+		{
+			Diagonal += Matrix[p * N + p] * Matrix[p * N + p];
+			for (int32 q = p + 1; q < N; ++q)
+			{
+				OffDiagonal += Matrix[p * N + q] * Matrix[p * N + q];
+			}
+		}
+
+		if (OffDiagonal <= Diagonal * 1e-24)
+		{
+			break;
+		}
+
+		for (int32 p = 0; p < N - 1; ++p)
+		{
+			for (int32 q = p + 1; q < N; ++q)
+			{
+				const double Apq = Matrix[p * N + q];
+				if (FMath::Abs(Apq) < 1e-300)
+				{
+					continue;
+				}
+
+				const double Theta = (Matrix[q * N + q] - Matrix[p * N + p]) / (2.0 * Apq);
+				const double T = (Theta >= 0.0 ? 1.0 : -1.0) / (FMath::Abs(Theta) + FMath::Sqrt(Theta * Theta + 1.0));
+				const double C = 1.0 / FMath::Sqrt(T * T + 1.0);
+				const double S = T * C;
+
+				for (int32 k = 0; k < N; ++k)
+				{
+					const double Akp = Matrix[k * N + p];
+					const double Akq = Matrix[k * N + q];
+					Matrix[k * N + p] = C * Akp - S * Akq;
+					Matrix[k * N + q] = S * Akp + C * Akq;
+				}
+
+				for (int32 k = 0; k < N; ++k)
+				{
+					const double Apk = Matrix[p * N + k];
+					const double Aqk = Matrix[q * N + k];
+					Matrix[p * N + k] = C * Apk - S * Aqk;
+					Matrix[q * N + k] = S * Apk + C * Aqk;
+				}
+
+				for (int32 k = 0; k < N; ++k)
+				{
+					const double Vkp = OutEigenVectors[k * N + p];
+					const double Vkq = OutEigenVectors[k * N + q];
+					OutEigenVectors[k * N + p] = C * Vkp - S * Vkq;
+					OutEigenVectors[k * N + q] = S * Vkp + C * Vkq;
+				}
+			}
+		}
+	}
+
+	OutEigenValues.SetNumUninitialized(N);
+	for (int32 i = 0; i < N; ++i)
+	{
+		OutEigenValues[i] = Matrix[i * N + i];
+	}
+}
+
+FPoseFeaturePCA::FPoseFeaturePCA()
+	: FeatureCount(0),
+	Dimensions(0),
+	RetainedVariance(0.0f),
+	TopOneAgreement(0.0f)
+{
+}
+
+bool FPoseFeaturePCA::IsValid() const
+{
+	return Dimensions > 0
+		&& FeatureScales.Num() == FeatureCount
+		&& Mean.Num() == FeatureCount
+		&& Basis.Num() == Dimensions * FeatureCount
+		&& Coordinates.Num() == PoseIds.Num() * Dimensions;
+}
+
+int32 FPoseFeaturePCA::GetFeatureCount(const int32 JointCount, const int32 TrajectoryCount)
+{
+	return 3 + JointCount * 6 + TrajectoryCount * 5;
+}
+
+void FPoseFeaturePCA::Build(const UMotionDataAsset* InMotionData, const TArray<int32>& InPoseIds, 
+	const FCalibrationData& StdDeviationNormalizers, const float TargetVariance, const int32 MaxDimensions)
+{
+	*this = FPoseFeaturePCA();
+
+	const int32 JointCount = StdDeviationNormalizers.PoseJointWeights.Num();
+	const int32 TrajectoryCount = StdDeviationNormalizers.TrajectoryWeights.Num();
+
+	for (const int32 PoseId : InPoseIds)
+	{
+		const FPoseMotionData& Pose = InMotionData->Poses[PoseId];
+		if (InMotionData->IsPoseSearchable(PoseId) 
+			&& Pose.JointData.Num() == JointCount 
+			&& Pose.Trajectory.Num() == TrajectoryCount)
+		{
+			PoseIds.Add(PoseId);
+		}
+	}
+
+	const int32 PoseCount = PoseIds.Num();
+	if (PoseCount < 2)
+	{
+		PoseIds.Empty();
+		return;
+	}
+
+	//Feature scales normalise each feature group by its standard deviation
+	FeatureCount = GetFeatureCount(JointCount, TrajectoryCount);
+	FeatureScales.Reset(FeatureCount);
+	FeatureScales.Add(StdDeviationNormalizers.Weight_Momentum);
+	FeatureScales.Add(StdDeviationNormalizers.Weight_Momentum);
+	FeatureScales.Add(StdDeviationNormalizers.Weight_Momentum);
+
+	for (const FJointWeightSet& WeightSet : StdDeviationNormalizers.PoseJointWeights)
+	{
+		FeatureScales.Add(WeightSet.Weight_Pos);
+		FeatureScales.Add(WeightSet.Weight_Pos);
+		FeatureScales.Add(WeightSet.Weight_Pos);
+		FeatureScales.Add(WeightSet.Weight_Vel);
+		FeatureScales.Add(WeightSet.Weight_Vel);
+		FeatureScales.Add(WeightSet.Weight_Vel);
+	}
+
+	for (const FTrajectoryWeightSet& WeightSet : StdDeviationNormalizers.TrajectoryWeights)
+	{
+		FeatureScales.Add(WeightSet.Weight_Pos);
+		FeatureScales.Add(WeightSet.Weight_Pos);
+		FeatureScales.Add(WeightSet.Weight_Pos);
+		FeatureScales.Add(WeightSet.Weight_Facing);
+		FeatureScales.Add(WeightSet.Weight_Facing);
+	}
+
+	for (float& FeatureScale : FeatureScales)
+	{
+		FeatureScale = FMath::IsFinite(FeatureScale) ? FMath::Max(FeatureScale, 0.0f) : 0.0f;
+	}
+
+	//Normalised features and their mean
+	Mean.SetNumZeroed(FeatureCount);
+
+	TArray<float> Features;
+	Features.SetNumUninitialized(PoseCount * FeatureCount);
+
+	TArray<double> MeanSum;
+	MeanSum.SetNumZeroed(FeatureCount);
+
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		const FPoseMotionData& Pose = InMotionData->Poses[PoseIds[i]];
+		float* PoseFeatures = &Features[i * FeatureCount];
+		GatherFeatures(Pose.LocalVelocity, Pose.JointData, Pose.Trajectory, PoseFeatures);
+
+		for (int32 f = 0; f < FeatureCount; ++f)
+		{
+			MeanSum[f] += PoseFeatures[f];
+		}
+	}
+
+	for (int32 f = 0; f < FeatureCount; ++f)
+	{
+		Mean[f] = (float)(MeanSum[f] / PoseCount);
+	}
+
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		for (int32 f = 0; f < FeatureCount; ++f)
+		{
+			Features[i * FeatureCount + f] -= Mean[f];
+		}
+	}
+
+	//Covariance
+	TArray<double> Covariance;
+	Covariance.SetNumZeroed(FeatureCount * FeatureCount);
+
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		const float* PoseFeatures = &Features[i * FeatureCount];
+		for (int32 a = 0; a < FeatureCount; ++a)
+		{
+			const double FeatureA = PoseFeatures[a];
+			for (int32 b = a; b < FeatureCount; ++b)
+			{
+				Covariance[a * FeatureCount + b] += FeatureA * PoseFeatures[b];
+			}
+		}
+	}
+
+	double TotalVariance = 0.0;
+	for (int32 a = 0; a < FeatureCount; ++a)
+	{
+		for (int32 b = a; b < FeatureCount; ++b)
+		{
+			const double Value = Covariance[a * FeatureCount + b] / PoseCount;
+			Covariance[a * FeatureCount + b] = Value;
+			Covariance[b * FeatureCount + a] = Value;
+		}
+
+		TotalVariance += Covariance[a * FeatureCount + a];
+	}
+
+	if (TotalVariance <= 0.0)
+	{
+		*this = FPoseFeaturePCA();
+		return;
+	}
+
+	TArray<double> EigenValues;
+	TArray<double> EigenVectors;
+	ComputeSymmetricEigen(Covariance, FeatureCount, EigenValues, EigenVectors);
+
+	TArray<int32> ComponentOrder;
+	ComponentOrder.SetNumUninitialized(FeatureCount);
+	for (int32 i = 0; i < FeatureCount; ++i)
+	{
+		ComponentOrder[i] = i;
+	}
+
+	ComponentOrder.Sort([&EigenValues](const int32 A, const int32 B) { return EigenValues[A] > EigenValues[B]; });
+
+	//Keep components until the target variance is explained
+	const int32 DimensionLimit = FMath::Clamp(MaxDimensions, 1, FeatureCount);
+	double KeptVariance = 0.0;
+	while (Dimensions < DimensionLimit && KeptVariance < TargetVariance * TotalVariance)
+	{
+		KeptVariance += FMath::Max(0.0, EigenValues[ComponentOrder[Dimensions]]);
+		++Dimensions;
+	}
+
+	RetainedVariance = (float)(KeptVariance / TotalVariance);
+
+	Basis.SetNumUninitialized(Dimensions * FeatureCount);
+	for (int32 d = 0; d < Dimensions; ++d)
+	{
+		const int32 Component = ComponentOrder[d];
+		for (int32 f = 0; f < FeatureCount; ++f)
+		{
+			Basis[d * FeatureCount + f] = (float)EigenVectors[f * FeatureCount + Component];
+		}
+	}
+
+	//Project every pose
+	Coordinates.SetNumUninitialized(PoseCount * Dimensions);
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		const float* PoseFeatures = &Features[i * FeatureCount];
+		for (int32 d = 0; d < Dimensions; ++d)
+		{
+			const float* Component = &Basis[d * FeatureCount];
+			float Coordinate = 0.0f;
+			for (int32 f = 0; f < FeatureCount; ++f)
+			{
+				Coordinate += PoseFeatures[f] * Component[f];
+			}
+
+			Coordinates[i * Dimensions + d] = Coordinate;
+		}
+	}
+
+	//Sample how often the nearest neighbour in the reduced space is the nearest neighbour in the full space
+	const int32 SampleCount = FMath::Min(PoseCount, 100);
+	int32 AgreementCount = 0;
+	for (int32 Sample = 0; Sample < SampleCount; ++Sample)
+	{
+		const int32 QueryIndex = (int32)((int64)Sample * PoseCount / SampleCount);
+		const float* QueryFeatures = &Features[QueryIndex * FeatureCount];
+		const float* QueryCoordinates = &Coordinates[QueryIndex * Dimensions];
+
+		int32 FullNearest = INDEX_NONE;
+		int32 ReducedNearest = INDEX_NONE;
+		float FullNearestDistance = BIG_NUMBER;
+		float ReducedNearestDistance = BIG_NUMBER;
+
+		for (int32 i = 0; i < PoseCount; ++i)
+		{
+			if (i == QueryIndex)
+			{
+				continue;
+			}
+
+			const float* PoseFeatures = &Features[i * FeatureCount];
+			float FullDistance = 0.0f;
+			for (int32 f = 0; f < FeatureCount; ++f)
+			{
+				FullDistance += FMath::Square(PoseFeatures[f] - QueryFeatures[f]);
+			}
+
+			const float* PoseCoordinates = &Coordinates[i * Dimensions];
+			float ReducedDistance = 0.0f;
+			for (int32 d = 0; d < Dimensions; ++d)
+			{
+				ReducedDistance += FMath::Square(PoseCoordinates[d] - QueryCoordinates[d]);
+			}
+
+			if (FullDistance < FullNearestDistance)
+			{
+				FullNearestDistance = FullDistance;
+				FullNearest = i;
+			}
+
+			if (ReducedDistance < ReducedNearestDistance)
+			{
+				ReducedNearestDistance = ReducedDistance;
+				ReducedNearest = i;
+			}
+		}
+
+		AgreementCount += FullNearest == ReducedNearest ? 1 : 0;
+	}
+
+	TopOneAgreement = (float)AgreementCount / SampleCount;
+}
+
+bool FPoseFeaturePCA::Project(const FVector& LocalVelocity, const TArray<FJointData>& JointData,
+	const TArray<FTrajectoryPoint>& Trajectory, float* OutCoordinates) const
+{
+	if (GetFeatureCount(JointData.Num(), Trajectory.Num()) != FeatureCount)
+	{
+		return false;
+	}
+
+	TArray<float, TInlineAllocator<128>> Features;
+	Features.SetNumUninitialized(FeatureCount);
+	GatherFeatures(LocalVelocity, JointData, Trajectory, Features.GetData());
+
+	for (int32 d = 0; d < Dimensions; ++d)
+	{
+		const float* Component = &Basis[d * FeatureCount];
+		float Coordinate = 0.0f;
+		for (int32 f = 0; f < FeatureCount; ++f)
+		{
+			Coordinate += (Features[f] - Mean[f]) * Component[f];
+		}
+
+		OutCoordinates[d] = Coordinate;
+	}
+
+	return true;
+}
+
+float FPoseFeaturePCA::GetLowerBoundScale(const FCalibrationData& Calibration, const float PoseMultiplier, const float TrajectoryMultiplier) const
+{
+	const int32 JointCount = Calibration.PoseJointWeights.Num();
+	const int32 TrajectoryCount = Calibration.TrajectoryWeights.Num();
+
+	if (GetFeatureCount(JointCount, TrajectoryCount) != FeatureCount)
+	{
+		return 0.0f;
+	}
+
+	float LowerBoundScale = BIG_NUMBER;
+	int32 Column = 0;
+
+	//Constant (unscaled) columns can't be told apart in the reduced space and are left out of the bound
+	auto AddGroup = [this, &LowerBoundScale, &Column](const float RuntimeWeight, const int32 Width)
+	{
+		const float FeatureScale = FeatureScales[Column];
+		if (FeatureScale > 0.0f)
+		{
+			LowerBoundScale = FMath::Min(LowerBoundScale, RuntimeWeight / (FeatureScale * FeatureScale));
+		}
+
+		Column += Width;
+	};
+
+	AddGroup(Calibration.Weight_Momentum * PoseMultiplier, 3);
+
+	for (const FJointWeightSet& WeightSet : Calibration.PoseJointWeights)
+	{
+		AddGroup(WeightSet.Weight_Pos * PoseMultiplier, 3);
+		AddGroup(WeightSet.Weight_Vel * PoseMultiplier, 3);
+	}
+
+	for (const FTrajectoryWeightSet& WeightSet : Calibration.TrajectoryWeights)
+	{
+		AddGroup(WeightSet.Weight_Pos * TrajectoryMultiplier, 3);
+		AddGroup(WeightSet.Weight_Facing * TrajectoryMultiplier, 2);
+	}
+
+	return LowerBoundScale >= BIG_NUMBER ? 0.0f : FMath::Max(LowerBoundScale, 0.0f);
+}
+
+void FPoseFeaturePCA::GatherFeatures(const FVector& LocalVelocity, const TArray<FJointData>& JointData,
+	const TArray<FTrajectoryPoint>& Trajectory, float* OutFeatures) const
+{
+	int32 Column = 0;
+	auto AddVector = [this, &Column, OutFeatures](const FVector& Value)
+	{
+		OutFeatures[Column] = Value.X * FeatureScales[Column]; ++Column;
+		OutFeatures[Column] = Value.Y * FeatureScales[Column]; ++Column;
+		OutFeatures[Column] = Value.Z * FeatureScales[Column]; ++Column;
+	};
+
+	AddVector(LocalVelocity);
+
+	for (const FJointData& Joint : JointData)
+	{
+		AddVector(Joint.Position);
+		AddVector(Joint.Velocity);
+	}
+
+	for (const FTrajectoryPoint& TrajPoint : Trajectory)
+	{
+		AddVector(TrajPoint.Position);
+		OutFeatures[Column] = TrajPoint.Facing.X * FeatureScales[Column]; ++Column;
+		OutFeatures[Column] = TrajPoint.Facing.Y * FeatureScales[Column]; ++Column;
+	}
+}
@@ -47,6 +47,14 @@ void FTrajectory::MakeRelativeTo(FTransform a_transform)
 	}
 }
 
+void FTrajectory::UpdateFacings()
+{
+	for (FTrajectoryPoint& Point : TrajectoryPoints)
+	{
+		Point.UpdateFacing();
+	}
+}
+
 void FTrajectory::SetTrajectoryPoint(const int32 Index, const FVector InPosition, const float InRotationZ)
 {
 	if(Index < 0 || Index > TrajectoryPoints.Num() -1)
@@ -9,24 +9,39 @@ void FTrajectoryPoint::Lerp(FTrajectoryPoint& o_result,
 	o_result.Position = FMath::Lerp(a_from.Position, a_to.Position, a_progress);
 	o_result.RotationZ = FMath::Lerp(FRotator(0.0f, a_from.RotationZ, 0.0f), 
 		FRotator(0.0f, a_to.RotationZ, 0.0f), a_progress).Yaw;
+	o_result.UpdateFacing();
 }
 
 FTrajectoryPoint::FTrajectoryPoint()
-	: Position(FVector(0.0f)), RotationZ(0.0f)
+	: Position(FVector(0.0f)), RotationZ(0.0f), Facing(1.0f, 0.0f)
 {
 
 }
 
 FTrajectoryPoint::FTrajectoryPoint(FVector a_position, float a_facingAngle)
-	: Position(a_position), RotationZ(a_facingAngle)
+	: Position(a_position), RotationZ(a_facingAngle), Facing(GetFacingDirection(a_facingAngle))
 {
 
 }
 
+void FTrajectoryPoint::UpdateFacing()
+{
+	Facing = GetFacingDirection(RotationZ);
+}
+
+FVector2D FTrajectoryPoint::GetFacingDirection(const float InRotationZ)
+{
+	float Sin, Cos;
+	FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(InRotationZ));
+
+	return FVector2D(Cos, Sin);
+}
+
 FTrajectoryPoint& FTrajectoryPoint::operator+=(const FTrajectoryPoint& rhs)
 {
 	Position += rhs.Position;
 	RotationZ += rhs.RotationZ;
+	Facing += rhs.Facing;
 
 	return *this;
 }
@@ -35,6 +50,7 @@ FTrajectoryPoint& FTrajectoryPoint::operator/=(const float rhs)
 {
 	Position /= rhs;
 	RotationZ /= rhs;
+	Facing /= rhs;
 
 	return *this;
 }
@@ -43,6 +59,7 @@ FTrajectoryPoint& FTrajectoryPoint::operator*=(const float rhs)
 {
 	Position *= rhs;
 	RotationZ *= rhs;
+	Facing *= rhs;
 
 	return *this;
 }
\ No newline at end of file
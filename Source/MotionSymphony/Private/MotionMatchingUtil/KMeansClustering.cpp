@@ -57,6 +57,7 @@ float FKMCluster::ReCalculateCenter()
 	for (int32 i = 0; i < Center.Num(); ++i)
 	{
 		CumulativeTrajectory.Emplace(FTrajectoryPoint(FVector::ZeroVector, 0.0f));
+		CumulativeTrajectory.Last().Facing = FVector2D::ZeroVector;
 	}
 
 	//Add up all the trajectory points
@@ -69,7 +70,7 @@ float FKMCluster::ReCalculateCenter()
 			FTrajectoryPoint& SamplePoint = Pose.Trajectory[i];
 
 			CumPoint.Position += SamplePoint.Position;
-			CumPoint.RotationZ += SamplePoint.RotationZ;
+			CumPoint.Facing += SamplePoint.Facing;
 		}	
 	}
 
@@ -79,7 +80,12 @@ float FKMCluster::ReCalculateCenter()
 		FTrajectoryPoint& CumPoint = CumulativeTrajectory[i];
 
 		CumPoint.Position /= Samples.Num();
-		CumPoint.RotationZ /= Samples.Num();
+
+		//Facings are averaged as directions so that the average doesn't break across the +-180 degree wrap. If they 
+		//cancel out, the old center facing is kept
+		const FVector2D AverageFacing = CumPoint.Facing.GetSafeNormal();
+		CumPoint.Facing = AverageFacing.IsNearlyZero() ? FTrajectoryPoint::GetFacingDirection(Center[i].RotationZ) : AverageFacing;
+		CumPoint.RotationZ = FMath::RadiansToDegrees(FMath::Atan2(CumPoint.Facing.Y, CumPoint.Facing.X));
 	}
 
 	const float CenterDelta = FMotionMatchingUtils::ComputeTrajectoryCost(Center, CumulativeTrajectory, 1.0f, 1.0f);
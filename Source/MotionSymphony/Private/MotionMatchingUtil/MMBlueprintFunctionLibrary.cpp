@@ -37,27 +37,19 @@ FVector UMMBlueprintFunctionLibrary::GetVectorRelativeToCamera(const float Input
 
 FMotionTraitField UMMBlueprintFunctionLibrary::CreateMotionTraitField(const FString TraitName)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
 		return FMotionTraitField();
 	}
 
-	int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-	if (TraitIndex > 63)
-	{
-		//Trait index out of range
-		return FMotionTraitField();
-	}
-
-	return FMotionTraitField(TraitIndex);
+	return Settings->GetTraitHandle(TraitName);
 }
 
 FMotionTraitField UMMBlueprintFunctionLibrary::CreateMotionTraitFieldFromArray(const TArray<FString>& TraitNames)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
@@ -67,7 +59,7 @@ FMotionTraitField UMMBlueprintFunctionLibrary::CreateMotionTraitFieldFromArray(c
 	FMotionTraitField MotionTraits = FMotionTraitField();
 	for (const FString& TraitName : TraitNames)
 	{
-		MotionTraits.SetTraitPosition(Settings->TraitNames.IndexOfByKey(TraitName));
+		MotionTraits.SetTraitPosition(Settings->GetTraitPosition(TraitName));
 	}
 
 	return MotionTraits;
@@ -75,27 +67,19 @@ FMotionTraitField UMMBlueprintFunctionLibrary::CreateMotionTraitFieldFromArray(c
 
 void UMMBlueprintFunctionLibrary::AddTrait(const FString TraitName, FMotionTraitField& OutTraitField)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
 		return;
 	}
 
-	int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-	if (TraitIndex > 63)
-	{
-		//Trait index out of range
-		return;
-	}
-
-	OutTraitField.SetTraitPosition(TraitIndex);
+	OutTraitField.SetTraitPosition(Settings->GetTraitPosition(TraitName));
 }
 
 void UMMBlueprintFunctionLibrary::AddTraits(const TArray<FString>& TraitNames,FMotionTraitField& OutTraitField)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
@@ -104,12 +88,7 @@ void UMMBlueprintFunctionLibrary::AddTraits(const TArray<FString>& TraitNames,FM
 
 	for (const FString& TraitName : TraitNames)
 	{
-		int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-		if (TraitIndex > -1 && TraitIndex < 64)
-		{
-			OutTraitField.SetTraitPosition(TraitIndex);
-		}
+		OutTraitField.SetTraitPosition(Settings->GetTraitPosition(TraitName));
 	}
 }
 
@@ -120,41 +99,28 @@ void UMMBlueprintFunctionLibrary::AddTraitField(const FMotionTraitField NewTrait
 
 void UMMBlueprintFunctionLibrary::RemoveTrait(const FString TraitName, FMotionTraitField& OutTraitField)
 {	
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
 		return;
 	}
 
-	int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-	if (TraitIndex > 63)
-	{
-		return;
-	}
-
-	OutTraitField.UnSetTraitPosition(TraitIndex);
+	OutTraitField.UnSetTraitPosition(Settings->GetTraitPosition(TraitName));
 }
 
 void UMMBlueprintFunctionLibrary::RemoveTraits(const TArray<FString>& TraitNames, FMotionTraitField& OutTraitField)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
 		return;
 	}
 
-	FMotionTraitField TraitsToRemove = FMotionTraitField();
 	for (const FString& TraitName : TraitNames)
 	{
-		int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-		if (TraitIndex > -1 && TraitIndex < 64)
-		{
-			OutTraitField.UnSetTraitPosition(TraitIndex);
-		}
+		OutTraitField.UnSetTraitPosition(Settings->GetTraitPosition(TraitName));
 	}
 }
 
@@ -165,51 +131,24 @@ void UMMBlueprintFunctionLibrary::RemoveTraitField(const FMotionTraitField Trait
 
 void UMMBlueprintFunctionLibrary::ClearTraitField(FMotionTraitField& OutTraitField)
 {
-	OutTraitField.A = OutTraitField.B = 0;
+	OutTraitField.Clear();
 }
 
 FMotionTraitField UMMBlueprintFunctionLibrary::GetTraitHandle(const FString TraitName)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if (!Settings)
 	{
 		return FMotionTraitField();
 	}
 
-	int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-	if (TraitIndex > 63)
-	{
-		return FMotionTraitField();
-	}
-
-	return FMotionTraitField(TraitIndex);
+	return Settings->GetTraitHandle(TraitName);
 }
 
-
-
 FMotionTraitField UMMBlueprintFunctionLibrary::GetTraitHandleFromArray(const TArray<FString>& TraitNames)
 {
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
-
-	if (!Settings)
-	{
-		return FMotionTraitField();
-	}
-
-	FMotionTraitField MotionTraits = FMotionTraitField();
-	for (const FString& TraitName : TraitNames)
-	{
-		int32 TraitIndex = Settings->TraitNames.IndexOfByKey(TraitName);
-
-		if (TraitIndex > -1 && TraitIndex < 64)
-		{
-			MotionTraits.SetTraitPosition(TraitIndex);
-		}
-	}
-
-	return MotionTraits;
+	return CreateMotionTraitFieldFromArray(TraitNames);
 }
 
 void UMMBlueprintFunctionLibrary::InitializeTrajectory(FTrajectory& OutTrajectory, const int32 TrajectoryCount)
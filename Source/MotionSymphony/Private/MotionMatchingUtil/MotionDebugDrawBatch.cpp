@@ -0,0 +1,194 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingUtil/MotionDebugDrawBatch.h"
+#include "SceneManagement.h"
+#include "SceneView.h"
+
+void FMotionDebugDrawBatch::Reset()
+{
+	LineVertices.Reset();
+	LineColors.Reset();
+	PolylineVertices.Reset();
+	Polylines.Reset();
+}
+
+bool FMotionDebugDrawBatch::IsEmpty() const
+{
+	return LineColors.Num() == 0 && Polylines.Num() == 0;
+}
+
+void FMotionDebugDrawBatch::AddLine(const FVector& Start, const FVector& End, const FLinearColor& Color)
+{
+	LineVertices.Add(Start);
+	LineVertices.Add(End);
+	LineColors.Add(Color);
+}
+
+void FMotionDebugDrawBatch::AddWireSphere(const FVector& Center, const float Radius, const int32 Segments, const FLinearColor& Color)
+{
+	const int32 SegmentCount = FMath::Max(Segments, 4);
+	const float AngleStep = 2.0f * PI / SegmentCount;
+
+	//One circle around each axis
+	const FVector Axes[3][2] = { { FVector::ForwardVector, FVector::RightVector },
+		{ FVector::ForwardVector, FVector::UpVector }, { FVector::RightVector, FVector::UpVector } };
+
+	for (const FVector (&Axis)[2] : Axes)
+	{
+		FVector LastPoint = Center + Axis[0] * Radius;
+		for (int32 i = 1; i <= SegmentCount; ++i)
+		{
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, AngleStep * i);
+
+			const FVector Point = Center + (Axis[0] * Cos + Axis[1] * Sin) * Radius;
+			AddLine(LastPoint, Point, Color);
+			LastPoint = Point;
+		}
+	}
+}
+
+void FMotionDebugDrawBatch::AddArrow(const FVector& Start, const FVector& End, const float ArrowSize, const FLinearColor& Color)
+{
+	AddLine(Start, End, Color);
+
+	FVector Direction = End - Start;
+	if (!Direction.Normalize())
+	{
+		return;
+	}
+
+	FVector Up(0.0f, 0.0f, 1.0f);
+	FVector Right = Direction ^ Up;
+	if (!Right.IsNormalized())
+	{
+		Direction.FindBestAxisVectors(Up, Right);
+	}
+
+	const FMatrix ArrowMatrix(Direction, Right, Up, FVector::ZeroVector);
+	AddLine(End, End + ArrowMatrix.TransformVector(FVector(-ArrowSize, ArrowSize, 0.0f)), Color);
+	AddLine(End, End + ArrowMatrix.TransformVector(FVector(-ArrowSize, -ArrowSize, 0.0f)), Color);
+}
+
+void FMotionDebugDrawBatch::AddPolyline(const TArray<FVector>& Points, const FLinearColor& Color)
+{
+	if (Points.Num() < 2)
+	{
+		return;
+	}
+
+	FPolyline& Polyline = Polylines.AddDefaulted_GetRef();
+	Polyline.Anchor = Points.Last();
+	Polyline.Color = Color;
+	Polyline.FirstVertex = PolylineVertices.Num();
+	Polyline.VertexCount = Points.Num();
+
+	PolylineVertices.Append(Points);
+}
+
+void FMotionDebugDrawBatch::Draw(FPrimitiveDrawInterface* DrawInterface, const FSceneView* View, const FTransform& Transform,
+	const float Thickness, const uint8 DepthPriority, const float LODCellSize /*= 0.0f*/) const
+{
+	if (!DrawInterface || IsEmpty())
+	{
+		return;
+	}
+
+	//Screen space LOD. Each cell keeps the first polyline that lands in it until a second one does, after which the
+	//cell is drawn as a single point at the average anchor position
+	struct FLODCell
+	{
+		FVector AnchorSum;
+		FLinearColor ColorSum;
+		int32 FirstPolyline;
+		int32 Count;
+	};
+
+	TMap<FIntPoint, FLODCell> Cells;
+	TArray<int32> UnculledPolylines;
+
+	if (View && LODCellSize > 0.0f)
+	{
+		Cells.Reserve(Polylines.Num() / 4);
+
+		for (int32 PolylineIndex = 0; PolylineIndex < Polylines.Num(); ++PolylineIndex)
+		{
+			const FPolyline& Polyline = Polylines[PolylineIndex];
+			const FVector Anchor = Transform.TransformPosition(Polyline.Anchor);
+
+			FVector2D PixelPosition;
+			if (!View->WorldToPixel(Anchor, PixelPosition))
+			{
+				continue;
+			}
+
+			const FIntPoint CellKey(FMath::FloorToInt(PixelPosition.X / LODCellSize), FMath::FloorToInt(PixelPosition.Y / LODCellSize));
+			FLODCell* Cell = Cells.Find(CellKey);
+			if (!Cell)
+			{
+				const FLODCell NewCell = { Anchor, Polyline.Color, PolylineIndex, 1 };
+				Cells.Add(CellKey, NewCell);
+			}
+			else
+			{
+				Cell->AnchorSum += Anchor;
+				Cell->ColorSum += Polyline.Color;
+				++Cell->Count;
+			}
+		}
+
+		for (const TPair<FIntPoint, FLODCell>& CellPair : Cells)
+		{
+			if (CellPair.Value.Count == 1)
+			{
+				UnculledPolylines.Add(CellPair.Value.FirstPolyline);
+			}
+		}
+	}
+	else
+	{
+		UnculledPolylines.SetNumUninitialized(Polylines.Num());
+		for (int32 PolylineIndex = 0; PolylineIndex < Polylines.Num(); ++PolylineIndex)
+		{
+			UnculledPolylines[PolylineIndex] = PolylineIndex;
+		}
+	}
+
+	int32 LineCount = LineColors.Num();
+	for (const int32 PolylineIndex : UnculledPolylines)
+	{
+		LineCount += Polylines[PolylineIndex].VertexCount - 1;
+	}
+
+	DrawInterface->AddReserveLines(DepthPriority, LineCount, false, Thickness > 0.0f);
+
+	for (int32 LineIndex = 0; LineIndex < LineColors.Num(); ++LineIndex)
+	{
+		DrawInterface->DrawLine(Transform.TransformPosition(LineVertices[LineIndex * 2]), Transform.TransformPosition(LineVertices[LineIndex * 2 + 1]),
+			LineColors[LineIndex], DepthPriority, Thickness);
+	}
+
+	for (const int32 PolylineIndex : UnculledPolylines)
+	{
+		const FPolyline& Polyline = Polylines[PolylineIndex];
+
+		FVector LastPoint = Transform.TransformPosition(PolylineVertices[Polyline.FirstVertex]);
+		for (int32 i = 1; i < Polyline.VertexCount; ++i)
+		{
+			const FVector Point = Transform.TransformPosition(PolylineVertices[Polyline.FirstVertex + i]);
+			DrawInterface->DrawLine(LastPoint, Point, Polyline.Color, DepthPriority, Thickness);
+			LastPoint = Point;
+		}
+	}
+
+	//Aggregated points grow with the number of polylines they represent
+	for (const TPair<FIntPoint, FLODCell>& CellPair : Cells)
+	{
+		const FLODCell& Cell = CellPair.Value;
+		if (Cell.Count > 1)
+		{
+			const float PointSize = FMath::Min(3.0f + FMath::Sqrt((float)Cell.Count), LODCellSize);
+			DrawInterface->DrawPoint(Cell.AnchorSum / Cell.Count, Cell.ColorSum / (float)Cell.Count, PointSize, DepthPriority);
+		}
+	}
+}
@@ -0,0 +1,115 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingUtil/MotionMatchingInertialization.h"
+#include "Animation/Skeleton.h"
+
+FMotionMatchingOffsetInertializer::FBoneOffset::FBoneOffset()
+	: Position(FVector::ZeroVector),
+	Velocity(FVector::ZeroVector),
+	Rotation(FVector::ZeroVector),
+	AngularVelocity(FVector::ZeroVector)
+{
+}
+
+FMotionMatchingOffsetInertializer::FMotionMatchingOffsetInertializer()
+	: PendingDeltaTime(0.0f),
+	bPendingTransition(false)
+{
+}
+
+void FMotionMatchingOffsetInertializer::Reset()
+{
+	Offsets.Reset();
+	LastOutputPose.Reset();
+	LastOutputValid.Reset();
+	PendingDeltaTime = 0.0f;
+	bPendingTransition = false;
+}
+
+void FMotionMatchingOffsetInertializer::RequestTransition()
+{
+	bPendingTransition = true;
+}
+
+void FMotionMatchingOffsetInertializer::Update(const float DeltaTime)
+{
+	PendingDeltaTime += DeltaTime;
+}
+
+void FMotionMatchingOffsetInertializer::Apply(FCompactPose& InOutPose, const float HalfLife)
+{
+	const FBoneContainer& BoneContainer = InOutPose.GetBoneContainer();
+	const USkeleton* Skeleton = BoneContainer.GetSkeletonAsset();
+
+	if (!Skeleton)
+	{
+		return;
+	}
+
+	const int32 SkeletonBoneCount = Skeleton->GetReferenceSkeleton().GetNum();
+	if (Offsets.Num() != SkeletonBoneCount)
+	{
+		Offsets.SetNum(SkeletonBoneCount);
+		LastOutputPose.SetNum(SkeletonBoneCount);
+		LastOutputValid.Init(false, SkeletonBoneCount);
+	}
+
+	const float DeltaTime = PendingDeltaTime;
+	PendingDeltaTime = 0.0f;
+
+	for (const FCompactPoseBoneIndex BoneIndex : InOutPose.ForEachBoneIndex())
+	{
+		const int32 SkeletonBoneIndex = BoneContainer.GetSkeletonIndex(BoneIndex);
+		if (!Offsets.IsValidIndex(SkeletonBoneIndex))
+		{
+			continue;
+		}
+
+		FTransform& BoneTransform = InOutPose[BoneIndex];
+		FBoneOffset& Offset = Offsets[SkeletonBoneIndex];
+
+		//The offset takes the bone from the new source pose to where it was last output. The offset velocities carry over 
+		//because the new pose was chosen to match the joint velocities of the previous one.
+		if (bPendingTransition && LastOutputValid[SkeletonBoneIndex])
+		{
+			const FTransform& LastTransform = LastOutputPose[SkeletonBoneIndex];
+
+			Offset.Position = LastTransform.GetTranslation() - BoneTransform.GetTranslation();
+
+			FQuat RotationOffset = LastTransform.GetRotation() * BoneTransform.GetRotation().Inverse();
+			RotationOffset.EnforceShortestArcWith(FQuat::Identity);
+
+			FVector Axis;
+			float Angle;
+			RotationOffset.ToAxisAndAngle(Axis, Angle);
+			Offset.Rotation = Axis * Angle;
+		}
+
+		DecaySpring(Offset.Position, Offset.Velocity, HalfLife, DeltaTime);
+		DecaySpring(Offset.Rotation, Offset.AngularVelocity, HalfLife, DeltaTime);
+
+		BoneTransform.AddToTranslation(Offset.Position);
+
+		const float Angle = Offset.Rotation.Size();
+		if (Angle > KINDA_SMALL_NUMBER)
+		{
+			BoneTransform.SetRotation((FQuat(Offset.Rotation / Angle, Angle) * BoneTransform.GetRotation()).GetNormalized());
+		}
+
+		LastOutputPose[SkeletonBoneIndex] = BoneTransform;
+		LastOutputValid[SkeletonBoneIndex] = true;
+	}
+
+	bPendingTransition = false;
+}
+
+void FMotionMatchingOffsetInertializer::DecaySpring(FVector& InOutOffset, FVector& InOutVelocity, const float HalfLife, const float DeltaTime)
+{
+	//Critically damped spring towards zero, solved exactly for the time step so it is stable for any delta time
+	const float Damping = (2.0f * 0.69314718f) / (HalfLife + KINDA_SMALL_NUMBER);
+	const FVector J1 = InOutVelocity + InOutOffset * Damping;
+	const float DecayFactor = FMath::Exp(-Damping * DeltaTime);
+
+	InOutOffset = DecayFactor * (InOutOffset + J1 * DeltaTime);
+	InOutVelocity = DecayFactor * (InOutVelocity - J1 * Damping * DeltaTime);
+}
@@ -0,0 +1,267 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingUtil/MotionMatchingQueryLog.h"
+#include "CustomAssets/MotionDataAsset.h"
+#include "CustomAssets/MotionCalibration.h"
+#include "HAL/FileManager.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Misc/Paths.h"
+
+const uint32 FMotionMatchingQueryLog::Magic = 0x4D4D514C; //'MMQL'
+const uint32 FMotionMatchingQueryLog::Version = 1;
+
+FMotionMatchingQueryRecord::FMotionMatchingQueryRecord()
+	: CalibrationId(-1),
+	CurrentPoseId(-1),
+	ChosenPoseId(-1),
+	ChosenCost(0.0f)
+{
+}
+
+bool FMotionMatchingQueryLog::Load(const FString& FileName)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FileName));
+
+	if (!Reader)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Motion matching query log '%s' could not be opened."), *FileName);
+		return false;
+	}
+
+	FArchive& Ar = *Reader;
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	Ar << FileMagic;
+	Ar << FileVersion;
+
+	if (FileMagic != Magic || FileVersion != Version)
+	{
+		UE_LOG(LogTemp, Error, TEXT("'%s' is not a motion matching query log or is from an incompatible version."), *FileName);
+		return false;
+	}
+
+	Ar << MotionDataPath;
+	Ar << CalibrationPath;
+
+	CalibrationTraits.Empty();
+	Calibrations.Empty();
+	Records.Empty();
+
+	while (!Ar.AtEnd() && !Ar.IsError())
+	{
+		uint8 ChunkType = 0;
+		Ar << ChunkType;
+
+		int32 CalibrationId = -1;
+		Ar << CalibrationId;
+
+		if (ChunkType == (uint8)EChunkType::Calibration)
+		{
+			if (CalibrationId != Calibrations.Num())
+			{
+				break;
+			}
+
+			SerializeTraits(Ar, CalibrationTraits.AddDefaulted_GetRef());
+			SerializeCalibration(Ar, Calibrations.AddDefaulted_GetRef());
+		}
+		else if (ChunkType == (uint8)EChunkType::Search)
+		{
+			if (!Calibrations.IsValidIndex(CalibrationId))
+			{
+				break;
+			}
+
+			FMotionMatchingQueryRecord& Record = Records.AddDefaulted_GetRef();
+			Record.CalibrationId = CalibrationId;
+			Ar << Record.CurrentPoseId;
+			Ar << Record.ChosenPoseId;
+			Ar << Record.ChosenCost;
+			SerializeQuery(Ar, Record.Query);
+
+			if (Ar.IsError())
+			{
+				Records.Pop();
+				break;
+			}
+
+			Record.Query.Calibration = Calibrations[CalibrationId];
+			Record.Query.RequiredTraits = CalibrationTraits[CalibrationId];
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	//A log cut short (e.g. by a crash) is still usable up until the last complete record
+	if (Ar.IsError() || !Ar.AtEnd())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Motion matching query log '%s' is truncated or corrupt. Only the first %d records were loaded."),
+			*FileName, Records.Num());
+	}
+
+	return true;
+}
+
+FString FMotionMatchingQueryLog::MakeLogFileName(const UMotionDataAsset* InMotionData)
+{
+	static FThreadSafeCounter LogCounter;
+
+	return FPaths::Combine(FPaths::ProfilingDir(), TEXT("MotionMatching"), FString::Printf(TEXT("%s_%s_%d.mmqlog"),
+		InMotionData ? *InMotionData->GetName() : TEXT("None"), *FDateTime::Now().ToString(), LogCounter.Increment()));
+}
+
+void FMotionMatchingQueryLog::SerializeCalibration(FArchive& Ar, FCalibrationData& Calibration)
+{
+	Ar << Calibration.Weight_Momentum;
+	Ar << Calibration.Weight_AngularMomentum;
+
+	int32 JointCount = Calibration.PoseJointWeights.Num();
+	Ar << JointCount;
+	Calibration.PoseJointWeights.SetNum(FMath::Max(0, JointCount));
+	for (FJointWeightSet& WeightSet : Calibration.PoseJointWeights)
+	{
+		Ar << WeightSet.Weight_Pos;
+		Ar << WeightSet.Weight_Vel;
+	}
+
+	int32 TrajectoryCount = Calibration.TrajectoryWeights.Num();
+	Ar << TrajectoryCount;
+	Calibration.TrajectoryWeights.SetNum(FMath::Max(0, TrajectoryCount));
+	for (FTrajectoryWeightSet& WeightSet : Calibration.TrajectoryWeights)
+	{
+		Ar << WeightSet.Weight_Pos;
+		Ar << WeightSet.Weight_Facing;
+	}
+}
+
+void FMotionMatchingQueryLog::SerializeTraits(FArchive& Ar, FMotionTraitField& Traits)
+{
+	for (int32 WordIndex = 0; WordIndex < MOTION_TRAIT_FIELD_WORDS; ++WordIndex)
+	{
+		Ar << Traits.GetWord(WordIndex);
+	}
+}
+
+void FMotionMatchingQueryLog::SerializeQuery(FArchive& Ar, FMotionMatchingSearchQuery& Query)
+{
+	uint8 PoseMatchMethod = (uint8)Query.PoseMatchMethod;
+	Ar << PoseMatchMethod;
+	Query.PoseMatchMethod = (EPoseMatchMethod)PoseMatchMethod;
+
+	Ar << Query.NextPoseId;
+	Ar << Query.OverridePoseMultiplier;
+	Ar << Query.OverrideTrajectoryMultiplier;
+	Ar << Query.bFavourCurrentPose;
+	Ar << Query.CurrentPoseFavour;
+
+	//Query features
+	FPoseMotionData& CurrentPose = Query.CurrentPose;
+	Ar << CurrentPose.LocalVelocity;
+	Ar << CurrentPose.RotationalVelocity;
+
+	int32 JointCount = CurrentPose.JointData.Num();
+	Ar << JointCount;
+	CurrentPose.JointData.SetNum(FMath::Max(0, JointCount));
+	for (FJointData& Joint : CurrentPose.JointData)
+	{
+		Ar << Joint.Position;
+		Ar << Joint.Velocity;
+	}
+
+	int32 TrajectoryCount = Query.DesiredTrajectory.Num();
+	Ar << TrajectoryCount;
+	Query.DesiredTrajectory.SetNum(FMath::Max(0, TrajectoryCount));
+	for (FTrajectoryPoint& Point : Query.DesiredTrajectory)
+	{
+		Ar << Point.Position;
+		Ar << Point.RotationZ;
+		Point.UpdateFacing();
+	}
+}
+
+FMotionMatchingQueryRecorder::FMotionMatchingQueryRecorder(const FString& FileName, const UMotionDataAsset* InMotionData, const UMotionCalibration* InCalibration)
+	: CalibrationCount(0)
+{
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*FileName));
+
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Motion matching query recorder failed to create log file '%s'."), *FileName);
+		return;
+	}
+
+	uint32 FileMagic = FMotionMatchingQueryLog::Magic;
+	uint32 FileVersion = FMotionMatchingQueryLog::Version;
+	FString MotionDataPath = InMotionData ? InMotionData->GetPathName() : FString();
+	FString CalibrationPath = InCalibration ? InCalibration->GetPathName() : FString();
+
+	*Writer << FileMagic;
+	*Writer << FileVersion;
+	*Writer << MotionDataPath;
+	*Writer << CalibrationPath;
+
+	UE_LOG(LogTemp, Log, TEXT("Motion matching query recorder writing to '%s'."), *FileName);
+}
+
+FMotionMatchingQueryRecorder::~FMotionMatchingQueryRecorder()
+{
+	if (Writer)
+	{
+		Writer->Close();
+	}
+}
+
+bool FMotionMatchingQueryRecorder::IsOpen() const
+{
+	return Writer.IsValid() && !Writer->IsError();
+}
+
+void FMotionMatchingQueryRecorder::InvalidateCalibrations()
+{
+	CalibrationIds.Empty();
+}
+
+void FMotionMatchingQueryRecorder::Record(const FMotionMatchingSearchQuery& Query, const int32 CurrentPoseId, const int32 ChosenPoseId, const float ChosenCost)
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	FArchive& Ar = *Writer;
+
+	int32* ExistingCalibrationId = CalibrationIds.Find(Query.RequiredTraits);
+	int32 CalibrationId = ExistingCalibrationId ? *ExistingCalibrationId : -1;
+
+	if (CalibrationId < 0)
+	{
+		CalibrationId = CalibrationCount++;
+		CalibrationIds.Add(Query.RequiredTraits, CalibrationId);
+
+		uint8 ChunkType = (uint8)FMotionMatchingQueryLog::EChunkType::Calibration;
+		FMotionTraitField Traits = Query.RequiredTraits;
+		FCalibrationData Calibration = Query.Calibration;
+
+		Ar << ChunkType;
+		Ar << CalibrationId;
+		FMotionMatchingQueryLog::SerializeTraits(Ar, Traits);
+		FMotionMatchingQueryLog::SerializeCalibration(Ar, Calibration);
+	}
+
+	uint8 ChunkType = (uint8)FMotionMatchingQueryLog::EChunkType::Search;
+	int32 RecordCurrentPoseId = CurrentPoseId;
+	int32 RecordChosenPoseId = ChosenPoseId;
+	float RecordChosenCost = ChosenCost;
+
+	Ar << ChunkType;
+	Ar << CalibrationId;
+	Ar << RecordCurrentPoseId;
+	Ar << RecordChosenPoseId;
+	Ar << RecordChosenCost;
+
+	//The query is only read from when saving, but the serializer is shared with loading
+	FMotionMatchingQueryLog::SerializeQuery(Ar, const_cast<FMotionMatchingSearchQuery&>(Query));
+}
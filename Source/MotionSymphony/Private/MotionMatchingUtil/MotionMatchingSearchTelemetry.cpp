@@ -0,0 +1,267 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingUtil/MotionMatchingSearchTelemetry.h"
+#include "AnimGraph/AnimNode_MotionMatching.h"
+#include "CustomAssets/MotionDataAsset.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+CSV_DEFINE_CATEGORY(MotionMatching, true);
+
+static TAutoConsoleVariable<int32> CVarMMSearchTelemetry(
+	TEXT("a.AnimNode.MoSymph.MMSearch.Telemetry"),
+	0,
+	TEXT("Turns Motion Matching search cost telemetry On / Off. \n")
+	TEXT("<=0: Off \n")
+	TEXT("  1: On"));
+
+static FAutoConsoleCommand CmdMMSearchTelemetryDump(
+	TEXT("a.AnimNode.MoSymph.MMSearch.TelemetryDump"),
+	TEXT("Logs the motion matching search telemetry histograms for each motion database."),
+	FConsoleCommandDelegate::CreateLambda([]() { FMotionMatchingSearchTelemetry::Get().Dump(); }));
+
+static FAutoConsoleCommand CmdMMSearchTelemetryReset(
+	TEXT("a.AnimNode.MoSymph.MMSearch.TelemetryReset"),
+	TEXT("Clears all motion matching search telemetry."),
+	FConsoleCommandDelegate::CreateLambda([]() { FMotionMatchingSearchTelemetry::Get().Reset(); }));
+
+FMotionMatchingCostBreakdown::FMotionMatchingCostBreakdown()
+	: Momentum(0.0f),
+	AngularMomentum(0.0f),
+	Trajectory(0.0f),
+	Joints(0.0f),
+	FavourMultiplier(1.0f),
+	Total(0.0f)
+{
+}
+
+FMotionMatchingTelemetryHistogram::FMotionMatchingTelemetryHistogram()
+	: FMotionMatchingTelemetryHistogram(0.0f, 1.0f)
+{
+}
+
+FMotionMatchingTelemetryHistogram::FMotionMatchingTelemetryHistogram(const float InMin, const float InMax)
+	: Min(InMin),
+	Max(InMax)
+{
+	Reset();
+}
+
+void FMotionMatchingTelemetryHistogram::Add(const float Value)
+{
+	const float Alpha = (Value - Min) / FMath::Max(Max - Min, KINDA_SMALL_NUMBER);
+	const int32 Bucket = FMath::Clamp(FMath::FloorToInt(Alpha * BucketCount), 0, BucketCount - 1);
+
+	++Buckets[Bucket];
+	++Count;
+	Sum += Value;
+}
+
+void FMotionMatchingTelemetryHistogram::Reset()
+{
+	FMemory::Memzero(Buckets);
+	Count = 0;
+	Sum = 0.0;
+}
+
+FString FMotionMatchingTelemetryHistogram::ToString() const
+{
+	FString Result = FString::Printf(TEXT("mean %.3f [%.2f-%.2f]:"), Count > 0 ? Sum / Count : 0.0, Min, Max);
+
+	for (int32 i = 0; i < BucketCount; ++i)
+	{
+		Result += FString::Printf(TEXT(" %u"), Buckets[i]);
+	}
+
+	return Result;
+}
+
+FMotionMatchingDatabaseTelemetry::FMotionMatchingDatabaseTelemetry()
+	: MomentumShare(0.0f, 1.0f),
+	AngularMomentumShare(0.0f, 1.0f),
+	TrajectoryShare(0.0f, 1.0f),
+	JointShare(0.0f, 1.0f),
+	FavourMultiplier(0.0f, 2.0f),
+	RunnerUpGap(0.0f, 1.0f),
+	SearchCount(0),
+	JumpCount(0),
+	ContinuationCount(0),
+	ToleranceSkipCount(0),
+	RejectedCount(0),
+	RejectedGroupCount(0)
+{
+}
+
+void FMotionMatchingDatabaseTelemetry::Reset()
+{
+	MomentumShare.Reset();
+	AngularMomentumShare.Reset();
+	TrajectoryShare.Reset();
+	JointShare.Reset();
+	FavourMultiplier.Reset();
+	RunnerUpGap.Reset();
+
+	SearchCount = 0;
+	JumpCount = 0;
+	ContinuationCount = 0;
+	ToleranceSkipCount = 0;
+	RejectedCount = 0;
+	RejectedGroupCount = 0;
+}
+
+FMotionMatchingSearchTelemetry& FMotionMatchingSearchTelemetry::Get()
+{
+	static FMotionMatchingSearchTelemetry Instance;
+	return Instance;
+}
+
+bool FMotionMatchingSearchTelemetry::IsEnabled()
+{
+	return CVarMMSearchTelemetry.GetValueOnAnyThread() > 0;
+}
+
+void FMotionMatchingSearchTelemetry::RecordSearch(const UMotionDataAsset* InMotionData, const FMotionMatchingCostBreakdown& WinnerCost, const float RunnerUpCost)
+{
+	const float UnfavouredCost = FMath::Max(WinnerCost.GetUnfavouredCost(), KINDA_SMALL_NUMBER);
+	const bool bHasRunnerUp = RunnerUpCost >= 0.0f && RunnerUpCost < 10000000.0f;
+	const float Gap = bHasRunnerUp ? (RunnerUpCost - WinnerCost.Total) / FMath::Max(WinnerCost.Total, KINDA_SMALL_NUMBER) : 0.0f;
+
+	{
+		FScopeLock Lock(&DatabasesCriticalSection);
+
+		FMotionMatchingDatabaseTelemetry& Telemetry = FindOrAddDatabase(InMotionData);
+		Telemetry.MomentumShare.Add(WinnerCost.Momentum / UnfavouredCost);
+		Telemetry.AngularMomentumShare.Add(WinnerCost.AngularMomentum / UnfavouredCost);
+		Telemetry.TrajectoryShare.Add(WinnerCost.Trajectory / UnfavouredCost);
+		Telemetry.JointShare.Add(WinnerCost.Joints / UnfavouredCost);
+		Telemetry.FavourMultiplier.Add(WinnerCost.FavourMultiplier);
+
+		if (bHasRunnerUp)
+		{
+			Telemetry.RunnerUpGap.Add(Gap);
+		}
+
+		++Telemetry.SearchCount;
+	}
+
+	CSV_CUSTOM_STAT(MotionMatching, Searches, 1, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(MotionMatching, MomentumCost, WinnerCost.Momentum, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(MotionMatching, AngularMomentumCost, WinnerCost.AngularMomentum, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(MotionMatching, TrajectoryCost, WinnerCost.Trajectory, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(MotionMatching, JointCost, WinnerCost.Joints, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(MotionMatching, TotalCost, WinnerCost.Total, ECsvCustomStatOp::Accumulate);
+
+	if (bHasRunnerUp)
+	{
+		CSV_CUSTOM_STAT(MotionMatching, MinRunnerUpGap, Gap, ECsvCustomStatOp::Min);
+	}
+}
+
+void FMotionMatchingSearchTelemetry::RecordOutcome(const UMotionDataAsset* InMotionData, const bool bJumped)
+{
+	{
+		FScopeLock Lock(&DatabasesCriticalSection);
+
+		FMotionMatchingDatabaseTelemetry& Telemetry = FindOrAddDatabase(InMotionData);
+		if (bJumped)
+		{
+			++Telemetry.JumpCount;
+		}
+		else
+		{
+			++Telemetry.ContinuationCount;
+		}
+	}
+
+	if (bJumped)
+	{
+		CSV_CUSTOM_STAT(MotionMatching, Jumps, 1, ECsvCustomStatOp::Accumulate);
+	}
+	else
+	{
+		CSV_CUSTOM_STAT(MotionMatching, Continuations, 1, ECsvCustomStatOp::Accumulate);
+	}
+}
+
+void FMotionMatchingSearchTelemetry::RecordToleranceSkip(const UMotionDataAsset* InMotionData)
+{
+	{
+		FScopeLock Lock(&DatabasesCriticalSection);
+		++FindOrAddDatabase(InMotionData).ToleranceSkipCount;
+	}
+
+	CSV_CUSTOM_STAT(MotionMatching, ToleranceSkips, 1, ECsvCustomStatOp::Accumulate);
+}
+
+void FMotionMatchingSearchTelemetry::RecordSearchStats(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchStats& SearchStats)
+{
+	const int32 RejectedCount = SearchStats.CandidateCount - SearchStats.CostedCount;
+
+	{
+		FScopeLock Lock(&DatabasesCriticalSection);
+
+		FMotionMatchingDatabaseTelemetry& Telemetry = FindOrAddDatabase(InMotionData);
+		Telemetry.RejectedCount += RejectedCount;
+		Telemetry.RejectedGroupCount += SearchStats.RejectedGroupCount;
+	}
+
+	CSV_CUSTOM_STAT(MotionMatching, RejectedCandidates, RejectedCount, ECsvCustomStatOp::Accumulate);
+	CSV_CUSTOM_STAT(MotionMatching, RejectedFeatureGroups, SearchStats.RejectedGroupCount, ECsvCustomStatOp::Accumulate);
+}
+
+void FMotionMatchingSearchTelemetry::Dump() const
+{
+	FScopeLock Lock(&DatabasesCriticalSection);
+
+	if (Databases.Num() == 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Motion matching search telemetry: No searches recorded. Is a.AnimNode.MoSymph.MMSearch.Telemetry enabled?"));
+		return;
+	}
+
+	for (const TPair<FObjectKey, FMotionMatchingDatabaseTelemetry>& DatabasePair : Databases)
+	{
+		const FMotionMatchingDatabaseTelemetry& Telemetry = DatabasePair.Value;
+		const uint32 OutcomeCount = FMath::Max(Telemetry.JumpCount + Telemetry.ContinuationCount, 1u);
+		const uint32 UpdateCount = FMath::Max(Telemetry.SearchCount + Telemetry.ToleranceSkipCount, 1u);
+
+		UE_LOG(LogTemp, Log, TEXT("Motion matching search telemetry for '%s':"), *Telemetry.DatabaseName);
+		UE_LOG(LogTemp, Log, TEXT("  Searches: %u, Tolerance skips: %u (%.1f%%)"), Telemetry.SearchCount, Telemetry.ToleranceSkipCount,
+			100.0f * Telemetry.ToleranceSkipCount / UpdateCount);
+		UE_LOG(LogTemp, Log, TEXT("  Jumps: %u (%.1f%%), Continuations: %u (%.1f%%)"), Telemetry.JumpCount, 100.0f * Telemetry.JumpCount / OutcomeCount,
+			Telemetry.ContinuationCount, 100.0f * Telemetry.ContinuationCount / OutcomeCount);
+		UE_LOG(LogTemp, Log, TEXT("  Momentum share:         %s"), *Telemetry.MomentumShare.ToString());
+		UE_LOG(LogTemp, Log, TEXT("  Angular momentum share: %s"), *Telemetry.AngularMomentumShare.ToString());
+		UE_LOG(LogTemp, Log, TEXT("  Trajectory share:       %s"), *Telemetry.TrajectoryShare.ToString());
+		UE_LOG(LogTemp, Log, TEXT("  Joint share:            %s"), *Telemetry.JointShare.ToString());
+		UE_LOG(LogTemp, Log, TEXT("  Favour multiplier:      %s"), *Telemetry.FavourMultiplier.ToString());
+		UE_LOG(LogTemp, Log, TEXT("  Runner up gap:          %s"), *Telemetry.RunnerUpGap.ToString());
+		UE_LOG(LogTemp, Log, TEXT("  Feature groups per rejected candidate: %.2f (%llu rejected)"),
+			Telemetry.RejectedCount > 0 ? (double)Telemetry.RejectedGroupCount / Telemetry.RejectedCount : 0.0, Telemetry.RejectedCount);
+	}
+}
+
+void FMotionMatchingSearchTelemetry::Reset()
+{
+	FScopeLock Lock(&DatabasesCriticalSection);
+
+	for (TPair<FObjectKey, FMotionMatchingDatabaseTelemetry>& DatabasePair : Databases)
+	{
+		DatabasePair.Value.Reset();
+	}
+}
+
+FMotionMatchingDatabaseTelemetry& FMotionMatchingSearchTelemetry::FindOrAddDatabase(const UMotionDataAsset* InMotionData)
+{
+	const FObjectKey DatabaseKey(InMotionData);
+
+	if (FMotionMatchingDatabaseTelemetry* Telemetry = Databases.Find(DatabaseKey))
+	{
+		return *Telemetry;
+	}
+
+	FMotionMatchingDatabaseTelemetry& Telemetry = Databases.Add(DatabaseKey);
+	Telemetry.DatabaseName = InMotionData ? InMotionData->GetPathName() : TEXT("None");
+	return Telemetry;
+}
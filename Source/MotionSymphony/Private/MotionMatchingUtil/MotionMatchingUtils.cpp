@@ -7,6 +7,7 @@
 #include "Data/AnimMirroringData.h"
 #include "Data/CalibrationData.h"
 #include "BonePose.h"
+#include "Misc/AutomationTest.h"
 
 
 void FMotionMatchingUtils::LerpPose(FPoseMotionData& OutLerpPose,
@@ -92,8 +93,8 @@ float FMotionMatchingUtils::ComputeTrajectoryCost(const TArray<FTrajectoryPoint>
 		//Cost of distance between trajectory points
 		Cost += FVector::DistSquared(CandidatePoint.Position, CurrentPoint.Position) * PosWeight;
 
-		//Cost of angle between trajectory point facings
-		Cost += FMath::Abs(FMath::FindDeltaAngleDegrees(CandidatePoint.RotationZ, CurrentPoint.RotationZ)) * rotWeight;
+		//Cost of distance between trajectory point facing directions
+		Cost += FVector2D::DistSquared(CandidatePoint.Facing, CurrentPoint.Facing) * rotWeight;
 	}
 
 	return Cost;
@@ -114,8 +115,8 @@ float FMotionMatchingUtils::ComputeTrajectoryCost(const TArray<FTrajectoryPoint>
 		//Cost of distance between trajectory points
 		Cost += FVector::DistSquared(CandidatePoint.Position, CurrentPoint.Position) * WeightSet.Weight_Pos;
 
-		//Cost of angle between trajectory point facings
-		Cost += FMath::Abs(FMath::FindDeltaAngleDegrees(CandidatePoint.RotationZ, CurrentPoint.RotationZ)) * WeightSet.Weight_Facing;
+		//Cost of distance between trajectory point facing directions
+		Cost += FVector2D::DistSquared(CandidatePoint.Facing, CurrentPoint.Facing) * WeightSet.Weight_Facing;
 	}
 
 	return Cost;
@@ -161,6 +162,16 @@ float FMotionMatchingUtils::ComputePoseCost(const TArray<FJointData>& Current, c
 	return Cost;
 }
 
+float FMotionMatchingUtils::ComputePoseDistance(const FPoseMotionData& Current, const FPoseMotionData& Candidate, const FCalibrationData& Calibration)
+{
+	float Cost = FVector::DistSquared(Current.LocalVelocity, Candidate.LocalVelocity) * Calibration.Weight_Momentum;
+	Cost += FMath::Abs(Current.RotationalVelocity - Candidate.RotationalVelocity) * Calibration.Weight_AngularMomentum;
+	Cost += ComputeTrajectoryCost(Current.Trajectory, Candidate.Trajectory, Calibration);
+	Cost += ComputePoseCost(Current.JointData, Candidate.JointData, Calibration);
+
+	return Cost;
+}
+
 void FMotionMatchingUtils::MirrorPose(FCompactPose& OutPose, UMirroringProfile* InMirroringProfile, USkeletalMeshComponent* SkelMesh)
 {
 	if(!SkelMesh || !InMirroringProfile)
@@ -406,3 +417,81 @@ float FMotionMatchingUtils::WrapAnimationTime(float time, float length)
 
 	return time;
 }
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTrajectoryFacingCostOrderTest, "MotionSymphony.MotionMatching.TrajectoryFacingCostOrder",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FTrajectoryFacingCostOrderTest::RunTest(const FString& Parameters)
+{
+	const int32 QueryCount = 200;
+	const int32 CandidateCount = 64;
+
+	//The facing cost is the squared chord between unit directions, 2 - 2cos(delta), which increases with the absolute 
+	//wrapped angle delta over [0, 180]. Candidates for a trajectory point must rank the same as with the old angle cost
+	FRandomStream Random(49);
+	int32 OrderMismatchCount = 0;
+	float MaxChordError = 0.0f;
+
+	TArray<FTrajectoryPoint> Query;
+	TArray<FTrajectoryPoint> Candidate;
+	for (int32 QueryIndex = 0; QueryIndex < QueryCount; ++QueryIndex)
+	{
+		Query = { FTrajectoryPoint(FVector::ZeroVector, Random.FRandRange(-180.0f, 180.0f)) };
+
+		TArray<float> NewCosts;
+		TArray<float> OldCosts;
+		for (int32 CandidateIndex = 0; CandidateIndex < CandidateCount; ++CandidateIndex)
+		{
+			//Unwrapped angles are included as the old cost wrapped them
+			Candidate = { FTrajectoryPoint(FVector::ZeroVector, Random.FRandRange(-720.0f, 720.0f)) };
+
+			const float OldCost = FMath::Abs(FMath::FindDeltaAngleDegrees(Candidate[0].RotationZ, Query[0].RotationZ));
+			const float NewCost = FMotionMatchingUtils::ComputeTrajectoryCost(Query, Candidate, 1.0f, 1.0f);
+
+			MaxChordError = FMath::Max(MaxChordError, FMath::Abs(NewCost - (2.0f - 2.0f * FMath::Cos(FMath::DegreesToRadians(OldCost)))));
+			OldCosts.Add(OldCost);
+			NewCosts.Add(NewCost);
+		}
+
+		for (int32 i = 0; i < CandidateCount; ++i)
+		{
+			for (int32 j = i + 1; j < CandidateCount; ++j)
+			{
+				//Near 0 and 180 degrees the chord barely changes so costs within rounding error may be ordered either way
+				const bool bOldOrder = OldCosts[i] < OldCosts[j];
+				const float NewCostDelta = bOldOrder ? NewCosts[i] - NewCosts[j] : NewCosts[j] - NewCosts[i];
+				if (FMath::Abs(OldCosts[i] - OldCosts[j]) > 0.01f && NewCostDelta > 0.00001f)
+				{
+					++OrderMismatchCount;
+				}
+			}
+		}
+	}
+
+	TestEqual(TEXT("Candidate pairs ordered differently to the angle cost"), OrderMismatchCount, 0);
+	TestTrue(FString::Printf(TEXT("The facing cost is the squared chord of the angle delta (largest error %f)"), MaxChordError), MaxChordError < 0.0001f);
+
+	//Across the wrap a 2 degree delta must still be cheaper than a 9 degree one
+	Query = { FTrajectoryPoint(FVector::ZeroVector, 179.0f) };
+	const TArray<FTrajectoryPoint> AcrossWrap = { FTrajectoryPoint(FVector::ZeroVector, -179.0f) };
+	const TArray<FTrajectoryPoint> SameSide = { FTrajectoryPoint(FVector::ZeroVector, 170.0f) };
+	const TArray<FTrajectoryPoint> FullTurn = { FTrajectoryPoint(FVector::ZeroVector, 179.0f - 360.0f) };
+
+	TestTrue(TEXT("A facing across the wrap is ordered by its wrapped delta"),
+		FMotionMatchingUtils::ComputeTrajectoryCost(Query, AcrossWrap, 1.0f, 1.0f) < FMotionMatchingUtils::ComputeTrajectoryCost(Query, SameSide, 1.0f, 1.0f));
+	TestTrue(TEXT("A full turn costs nothing"), FMotionMatchingUtils::ComputeTrajectoryCost(Query, FullTurn, 1.0f, 1.0f) < KINDA_SMALL_NUMBER);
+
+	//Facing doesn't change the position cost so candidates that only differ in position keep their order
+	Query = { FTrajectoryPoint(FVector(100.0f, 0.0f, 0.0f), 30.0f), FTrajectoryPoint(FVector(200.0f, 50.0f, 0.0f), 60.0f) };
+	const TArray<FTrajectoryPoint> Near = { FTrajectoryPoint(FVector(110.0f, 0.0f, 0.0f), 30.0f), FTrajectoryPoint(FVector(200.0f, 60.0f, 0.0f), 60.0f) };
+	const TArray<FTrajectoryPoint> Far = { FTrajectoryPoint(FVector(100.0f, 40.0f, 0.0f), 30.0f), FTrajectoryPoint(FVector(160.0f, 50.0f, 0.0f), 60.0f) };
+
+	TestTrue(TEXT("Candidates with matching facings are ordered by position"),
+		FMotionMatchingUtils::ComputeTrajectoryCost(Query, Near, 1.0f, 100.0f) < FMotionMatchingUtils::ComputeTrajectoryCost(Query, Far, 1.0f, 100.0f));
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
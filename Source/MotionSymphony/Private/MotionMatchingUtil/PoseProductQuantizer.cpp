@@ -0,0 +1,229 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingUtil/PoseProductQuantizer.h"
+
+FPoseProductQuantizer::FPoseProductQuantizer()
+	: FeatureCount(0),
+	CentroidCount(0),
+	ItemCount(0)
+{
+}
+
+bool FPoseProductQuantizer::IsValid() const
+{
+	return FeatureCount > 0
+		&& CentroidCount > 0
+		&& CentroidCount <= 256
+		&& SubspaceOffsets.Num() > 1
+		&& Codebooks.Num() == FeatureCount * CentroidCount
+		&& Codes.Num() == ItemCount * GetSubspaceCount();
+}
+
+void FPoseProductQuantizer::Train(const TArray<float>& Features, const int32 InItemCount, const int32 InFeatureCount, 
+	const int32 SubspaceCount, const int32 InCentroidCount, const int32 Iterations, const int32 TrainingSampleLimit)
+{
+	*this = FPoseProductQuantizer();
+
+	if (InItemCount < 1 || InFeatureCount < 1 || Features.Num() != InItemCount * InFeatureCount)
+	{
+		return;
+	}
+
+	FeatureCount = InFeatureCount;
+	ItemCount = InItemCount;
+	CentroidCount = FMath::Clamp(InCentroidCount, 1, FMath::Min(256, InItemCount));
+
+	//Split the columns into contiguous sub-spaces of (nearly) equal width
+	const int32 Subspaces = FMath::Clamp(SubspaceCount, 1, FeatureCount);
+	SubspaceOffsets.SetNumUninitialized(Subspaces + 1);
+	for (int32 m = 0; m <= Subspaces; ++m)
+	{
+		SubspaceOffsets[m] = (int32)((int64)m * FeatureCount / Subspaces);
+	}
+
+	//Evenly spaced training samples keep training deterministic
+	const int32 SampleCount = FMath::Clamp(TrainingSampleLimit, CentroidCount, ItemCount);
+	TArray<int32> Samples;
+	Samples.SetNumUninitialized(SampleCount);
+	for (int32 s = 0; s < SampleCount; ++s)
+	{
+		Samples[s] = (int32)((int64)s * ItemCount / SampleCount);
+	}
+
+	Codebooks.SetNumZeroed(FeatureCount * CentroidCount);
+
+	TArray<int32> Assignments;
+	TArray<double> CentroidSums;
+	TArray<int32> CentroidCounts;
+
+	for (int32 m = 0; m < Subspaces; ++m)
+	{
+		const int32 Offset = SubspaceOffsets[m];
+		const int32 Width = SubspaceOffsets[m + 1] - Offset;
+		float* Codebook = &Codebooks[Offset * CentroidCount];
+
+		//Initialize the centroids with evenly spaced samples
+		for (int32 c = 0; c < CentroidCount; ++c)
+		{
+			const float* Sample = &Features[Samples[(int32)((int64)c * SampleCount / CentroidCount)] * FeatureCount + Offset];
+			FMemory::Memcpy(&Codebook[c * Width], Sample, Width * sizeof(float));
+		}
+
+		//Lloyd iterations
+		Assignments.Init(INDEX_NONE, SampleCount);
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			bool bChanged = false;
+			for (int32 s = 0; s < SampleCount; ++s)
+			{
+				const int32 Centroid = FindNearestCentroid(m, &Features[Samples[s] * FeatureCount + Offset]);
+				bChanged |= Centroid != Assignments[s];
+				Assignments[s] = Centroid;
+			}
+
+			if (!bChanged)
+			{
+				break;
+			}
+
+			CentroidSums.Init(0.0, CentroidCount * Width);
+			CentroidCounts.Init(0, CentroidCount);
+			for (int32 s = 0; s < SampleCount; ++s)
+			{
+				const float* Sample = &Features[Samples[s] * FeatureCount + Offset];
+				double* Sum = &CentroidSums[Assignments[s] * Width];
+				for (int32 f = 0; f < Width; ++f)
+				{
+					Sum[f] += Sample[f];
+				}
+
+				++CentroidCounts[Assignments[s]];
+			}
+
+			//Empty centroids keep their previous position
+			for (int32 c = 0; c < CentroidCount; ++c)
+			{
+				if (CentroidCounts[c] > 0)
+				{
+					for (int32 f = 0; f < Width; ++f)
+					{
+						Codebook[c * Width + f] = (float)(CentroidSums[c * Width + f] / CentroidCounts[c]);
+					}
+				}
+			}
+		}
+	}
+
+	//Encode all items
+	Codes.SetNumUninitialized(ItemCount * Subspaces);
+	for (int32 i = 0; i < ItemCount; ++i)
+	{
+		for (int32 m = 0; m < Subspaces; ++m)
+		{
+			Codes[i * Subspaces + m] = (uint8)FindNearestCentroid(m, &Features[i * FeatureCount + SubspaceOffsets[m]]);
+		}
+	}
+}
+
+void FPoseProductQuantizer::ComputeDistanceTable(const float* Query, const float* ColumnWeights, TArray<float>& OutTable) const
+{
+	const int32 Subspaces = GetSubspaceCount();
+	OutTable.SetNumUninitialized(Subspaces * CentroidCount, false);
+
+	for (int32 m = 0; m < Subspaces; ++m)
+	{
+		const int32 Offset = SubspaceOffsets[m];
+		const int32 Width = SubspaceOffsets[m + 1] - Offset;
+		const float* Codebook = &Codebooks[Offset * CentroidCount];
+
+		for (int32 c = 0; c < CentroidCount; ++c)
+		{
+			const float* Centroid = &Codebook[c * Width];
+			float Distance = 0.0f;
+			for (int32 f = 0; f < Width; ++f)
+			{
+				Distance += FMath::Square(Query[Offset + f] - Centroid[f]) * ColumnWeights[Offset + f];
+			}
+
+			OutTable[m * CentroidCount + c] = Distance;
+		}
+	}
+}
+
+void FPoseProductQuantizer::FindNearest(const TArray<float>& DistanceTable, const int32 K, TArray<int32>& OutItems) const
+{
+	OutItems.Reset();
+
+	const int32 Subspaces = GetSubspaceCount();
+	const int32 Count = FMath::Min(K, ItemCount);
+	if (Count < 1 || DistanceTable.Num() != Subspaces * CentroidCount)
+	{
+		return;
+	}
+
+	//Bounded max heap of the nearest items found so far
+	typedef TPair<float, int32> FItemDistance;
+	TArray<FItemDistance, TInlineAllocator<256>> Nearest;
+	const auto IsFurther = [](const FItemDistance& A, const FItemDistance& B) { return A.Key > B.Key; };
+
+	const uint8* ItemCodes = Codes.GetData();
+	for (int32 i = 0; i < ItemCount; ++i, ItemCodes += Subspaces)
+	{
+		float Distance = 0.0f;
+		const float* Table = DistanceTable.GetData();
+		for (int32 m = 0; m < Subspaces; ++m, Table += CentroidCount)
+		{
+			Distance += Table[ItemCodes[m]];
+		}
+
+		if (Nearest.Num() < Count)
+		{
+			Nearest.HeapPush(FItemDistance(Distance, i), IsFurther);
+		}
+		else if (Distance < Nearest.HeapTop().Key)
+		{
+			Nearest.HeapPopDiscard(IsFurther, false);
+			Nearest.HeapPush(FItemDistance(Distance, i), IsFurther);
+		}
+	}
+
+	Nearest.Sort([](const FItemDistance& A, const FItemDistance& B) { return A.Key < B.Key; });
+
+	OutItems.Reserve(Nearest.Num());
+	for (const FItemDistance& Item : Nearest)
+	{
+		OutItems.Add(Item.Value);
+	}
+}
+
+int64 FPoseProductQuantizer::GetAllocatedSize() const
+{
+	return SubspaceOffsets.GetAllocatedSize() + Codebooks.GetAllocatedSize() + Codes.GetAllocatedSize();
+}
+
+int32 FPoseProductQuantizer::FindNearestCentroid(const int32 Subspace, const float* SubFeatures) const
+{
+	const int32 Offset = SubspaceOffsets[Subspace];
+	const int32 Width = SubspaceOffsets[Subspace + 1] - Offset;
+	const float* Codebook = &Codebooks[Offset * CentroidCount];
+
+	int32 NearestCentroid = 0;
+	float NearestDistance = BIG_NUMBER;
+	for (int32 c = 0; c < CentroidCount; ++c)
+	{
+		const float* Centroid = &Codebook[c * Width];
+		float Distance = 0.0f;
+		for (int32 f = 0; f < Width; ++f)
+		{
+			Distance += FMath::Square(SubFeatures[f] - Centroid[f]);
+		}
+
+		if (Distance < NearestDistance)
+		{
+			NearestDistance = Distance;
+			NearestCentroid = c;
+		}
+	}
+
+	return NearestCentroid;
+}
@@ -5,3 +5,61 @@
 UMotionSymphonySettings::UMotionSymphonySettings(const FObjectInitializer& ObjectInitializer)
 {
 }
+
+int32 UMotionSymphonySettings::GetTraitPosition(const FString& TraitName) const
+{
+	const int32* TraitPosition = TraitNameLookup.Find(TraitName);
+
+	return TraitPosition ? *TraitPosition : INDEX_NONE;
+}
+
+FMotionTraitField UMotionSymphonySettings::GetTraitHandle(const FString& TraitName) const
+{
+	const int32 TraitPosition = GetTraitPosition(TraitName);
+
+	return TraitPosition == INDEX_NONE ? FMotionTraitField() : FMotionTraitField(TraitPosition);
+}
+
+void UMotionSymphonySettings::RebuildTraitNameLookup()
+{
+	TraitNameLookup.Empty(TraitNames.Num());
+
+	for (int32 i = 0; i < TraitNames.Num(); ++i)
+	{
+		if (!FMotionTraitField::IsValidTraitPosition(i))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Motion Symphony Settings: More than %d traits have been defined. Trait '%s' and any following it will be ignored."),
+				MOTION_TRAIT_FIELD_BITS, *TraitNames[i]);
+			break;
+		}
+
+		//The first occurrence of a name wins to match the previous linear search behaviour
+		if (!TraitNameLookup.Contains(TraitNames[i]))
+		{
+			TraitNameLookup.Add(TraitNames[i], i);
+		}
+	}
+}
+
+void UMotionSymphonySettings::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	RebuildTraitNameLookup();
+}
+
+void UMotionSymphonySettings::PostReloadConfig(FProperty* PropertyThatWasLoaded)
+{
+	Super::PostReloadConfig(PropertyThatWasLoaded);
+
+	RebuildTraitNameLookup();
+}
+
+#if WITH_EDITOR
+void UMotionSymphonySettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	RebuildTraitNameLookup();
+}
+#endif
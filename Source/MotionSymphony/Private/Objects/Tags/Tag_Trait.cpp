@@ -18,7 +18,7 @@ void UTag_Trait::PreProcessTag(FMotionAnimAsset& OutMotionAnim,
 {
 	Super::PreProcessTag(OutMotionAnim, OutMotionData, StartTime, EndTime);
 
-	UMotionSymphonySettings* Settings = GetMutableDefault<UMotionSymphonySettings>();
+	const UMotionSymphonySettings* Settings = GetDefault<UMotionSymphonySettings>();
 
 	if(!Settings)
 	{
@@ -27,17 +27,12 @@ void UTag_Trait::PreProcessTag(FMotionAnimAsset& OutMotionAnim,
 		return;
 	}
 
-	for (int32 i = 0; i < Settings->TraitNames.Num(); ++i)
+	TraitHandle = Settings->GetTraitHandle(TraitName);
+
+	if (TraitHandle.IsEmpty())
 	{
-		if (TraitName == Settings->TraitNames[i])
-		{
-			TraitHandle = FMotionTraitField(i);
-			return;
-		}
+		UE_LOG(LogTemp, Warning, TEXT("Trying to pre-process trait tag but the trait name could not be found. Please verify your trait names in project settings."));
 	}
-	
-	TraitHandle = FMotionTraitField();
-	UE_LOG(LogTemp, Warning, TEXT("Trying to pre-process trait tag but the trait name could not be found. Please verify your trait names in project settings."));
 }
 
 
@@ -14,11 +14,128 @@
 #include "Data/PoseMotionData.h"
 #include "Data/Trajectory.h"
 #include "Enumerations/EMotionMatchingEnums.h"
+#include "MotionMatchingUtil/MotionMatchingInertialization.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "AnimNode_MotionMatching.generated.h"
 
 struct FDistanceMatchPayload;
 struct FMotionActionPayload;
 struct FMotionTraitField;
+class FMotionMatchingQueryRecorder;
+struct FMotionMatchingCostBreakdown;
+
+/** A snapshot of all node state read by a motion matching pose search. A search only reads from the query and 
+the motion data so that it can be run on a worker thread without racing the node. */
+struct MOTIONSYMPHONY_API FMotionMatchingSearchQuery
+{
+public:
+	FPoseMotionData CurrentPose;
+	TArray<FTrajectoryPoint> DesiredTrajectory;
+	FCalibrationData Calibration;
+	FMotionTraitField RequiredTraits;
+
+	/** The usable poses with the required traits. The linear search iterates the motion data's trait search range for the
+	required traits instead, which holds the same poses. */
+	TArray<uint64> PoseMask;
+
+	EPoseMatchMethod PoseMatchMethod;
+	int32 NextPoseId;
+	float OverridePoseMultiplier;
+	float OverrideTrajectoryMultiplier;
+	bool bFavourCurrentPose;
+	float CurrentPoseFavour;
+
+	/** The number of poses either side of the natural next pose that are costed exactly before the search so that its 
+	early outs start from a tight bound. A negative value turns seeding off */
+	int32 SeedRadius;
+
+	/** The database that PoseMask and NextPoseId refer to in a multi-database search */
+	int32 DatabaseId;
+
+	/** The required trait pose mask of each database in a multi-database search, indexed by database id. Empty when only 
+	a single database is searched. */
+	TArray<TArray<uint64>> DatabasePoseMasks;
+
+	/** The node's pose transition count at the time of the query. Used to validate deferred results */
+	int32 TransitionCount;
+
+	/** The database currently being searched in a multi-database search. Searches of any database other than DatabaseId
+	use its entry of DatabasePoseMasks and have no natural next pose or seeds. INDEX_NONE searches DatabaseId */
+	int32 SearchDatabaseId;
+
+public:
+	FMotionMatchingSearchQuery();
+
+	/** PoseMask, NextPoseId and SeedRadius for the database currently being searched (see SearchDatabaseId) */
+	const TArray<uint64>& GetSearchPoseMask() const;
+	int32 GetSearchNextPoseId() const;
+	int32 GetSearchSeedRadius() const;
+
+private:
+	bool IsSearchingOtherDatabase() const;
+};
+
+/** Counters for how much of a pose search was pruned by its early outs */
+struct MOTIONSYMPHONY_API FMotionMatchingSearchStats
+{
+public:
+	/** Poses costed exactly before the search to seed it */
+	int32 SeedCount;
+
+	/** Poses visited by the search */
+	int32 CandidateCount;
+
+	/** Poses visited by the search that were not rejected by an early out and were costed in full */
+	int32 CostedCount;
+
+	/** Feature groups costed for the visited poses that were then rejected by an early out. Poses rejected by a lower 
+	bound alone cost none */
+	int32 RejectedGroupCount;
+
+	/** Databases of a multi-database search that were skipped because their feature bounds couldn't beat the best pose */
+	int32 SkippedDatabaseCount;
+
+public:
+	FMotionMatchingSearchStats();
+
+	void Reset();
+	void Accumulate(const FMotionMatchingSearchStats& Other);
+
+	/** The fraction of visited poses that were rejected by an early out */
+	float GetPruneRate() const;
+
+	/** The mean number of feature groups costed for each rejected pose */
+	float GetGroupsPerRejection() const;
+};
+
+/** The pose chosen by a search across a set of motion databases */
+struct MOTIONSYMPHONY_API FMotionMatchingSearchResult
+{
+public:
+	int32 DatabaseId;
+	int32 PoseId;
+
+	/** Only computed when more than one database is searched */
+	float Cost;
+
+public:
+	FMotionMatchingSearchResult();
+	FMotionMatchingSearchResult(const int32 InDatabaseId, const int32 InPoseId, const float InCost);
+};
+
+/** The shared state of a pose search dispatched to the task graph */
+struct MOTIONSYMPHONY_API FMotionMatchingAsyncSearch
+{
+public:
+	FMotionMatchingSearchQuery Query;
+	int32 ResultDatabaseId;
+	int32 ResultPoseId;
+	float ResultRunnerUpCost;
+	FMotionMatchingSearchStats ResultStats;
+
+public:
+	FMotionMatchingAsyncSearch();
+};
 
 /** An animation node which performs motion matching to synthesise animation. It is an asset player
 which uses MotionAnimData asset as it's source data. The node can be used with inertialization and 
@@ -63,6 +180,13 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation Data", meta = (PinHiddenByDefault))
 	UMotionDataAsset* MotionData;
 
+	/** Additional pose databases which are searched together with 'MotionData' (e.g. one per stance or gait) so that each
+	can be kept small. They must share its motion match config and are costed with its calibration so that costs can be 
+	compared between databases. A database is skipped without being searched if the bounds of its features show that 
+	it can't contain a better pose than the best found so far. Distance matching and actions only use 'MotionData'. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Animation Data", meta = (PinHiddenByDefault))
+	TArray<UMotionDataAsset*> AdditionalMotionData;
+
 	/** Reference to the calibration asset for motion matching. This is a modular asset which can be created and 
 	configured in you project. It will use to control weightings for motion matching aspects that affect the 
 	selection and synthesis of animation poses. */
@@ -87,10 +211,37 @@ public:
 	EPoseMatchMethod PoseMatchMethod;
 
 	/** The method of transitioning between animations. This could either be instant, blended or inertialized. Inertialization is
-	the recommended method of blending with motion matching for both performance and quality. */
+	the recommended method of blending with motion matching for both performance and quality. 'Inertialization' requires an 
+	inertialization node further down the graph while 'OffsetInertialization' is performed within this node. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Options")
 	ETransitionMethod TransitionMethod;
 
+	/** If checked, each pose search is seeded with the exact cost of the natural next pose and its neighbours in the
+	sequence. Motion is coherent from search to search so this usually gives the early outs a tight bound from the first
+	candidate. The chosen pose is unaffected. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Options")
+	bool bSeedPoseSearch;
+
+	/** The number of poses either side of the natural next pose to cost when seeding a pose search */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Options", meta = (ClampMin = 0, EditCondition = "bSeedPoseSearch"))
+	int32 SearchSeedRadius;
+
+	/** The time, in seconds, for the pose offset of an 'OffsetInertialization' transition to decay by half */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Options", meta = (ClampMin = 0.01f, 
+		EditCondition = "TransitionMethod == ETransitionMethod::OffsetInertialization"))
+	float InertializationHalfLife;
+
+	/** If checked, pose searches are dispatched to a worker thread and the result is applied on a following update. This 
+	takes the search cost off the animation update at the cost of a small delay in responsiveness and is intended for 
+	large databases. Forced searches (e.g. at the end of a clip) are always performed immediately. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Async Search")
+	bool bAsyncPoseSearch;
+
+	/** The maximum time, in seconds, to wait for an asynchronous pose search to complete. If the search has not completed
+	by this time it is discarded and a synchronous pose search is performed instead.*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Async Search", meta = (ClampMin = 0.0f, EditCondition = "bAsyncPoseSearch"))
+	float AsyncSearchDeadline;
+
 	/** This is the method for handling the past trajectory. It can either be recorded (history) or it can be taken from the 
 	current pose. The latter option is preferable if you are using procedural motion a lot but may cause other issues. Please try 
 	both options and see what works best for you. (Note: Root motion users should use history) */
@@ -167,6 +318,13 @@ private:
 	int32 CurrentChosenPoseId;
 	int32 DominantBlendChannel; 
 
+	//The databases searched by the node. 'MotionData' is always the first followed by any valid 'AdditionalMotionData'
+	TArray<UMotionDataAsset*> Databases;
+
+	//The database of the chosen pose. CurrentChosenPoseId indexes its poses
+	int32 ActiveDatabaseId;
+	UMotionDataAsset* ActiveMotionData;
+
 	bool bValidToEvaluate;
 	bool bInitialized;
 	bool bTriggerTransition;
@@ -177,6 +335,28 @@ private:
 
 	EMotionMatchingMode MotionMatchingMode;
 
+	//Pose search query reused by synchronous searches to avoid re-allocation
+	FMotionMatchingSearchQuery SearchQuery;
+
+	//Deferred pose search state
+	TSharedPtr<FMotionMatchingAsyncSearch, ESPMode::ThreadSafe> PendingSearch;
+	FGraphEventRef PendingSearchTask;
+	FGraphEventArray DetachedSearchTasks; //Abandoned searches still running. Only waited on at teardown
+	double PendingSearchDispatchTime;
+	int32 TransitionCount;
+
+	//Built-in inertialization state for the OffsetInertialization transition method
+	FMotionMatchingOffsetInertializer OffsetInertializer;
+
+	//Search query log writer. Only created while search recording is enabled
+	TSharedPtr<FMotionMatchingQueryRecorder> QueryRecorder;
+
+	//Bitset of usable pose ids matching the required traits for each database. Rebuilt from the motion data trait bitmaps
+	//when the traits change
+	TArray<TArray<uint64>> RequiredTraitPoseMasks;
+	FMotionTraitField RequiredTraitPoseMaskTraits;
+	bool bRequiredTraitPoseMaskValid;
+
 	//MotionSnapshot BoneRemapping
 	TArray<int32> PoseBoneRemap;
 
@@ -206,6 +386,36 @@ public:
 	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
 	// End of FAnimNode_Base interface
 
+	//Pose Search
+	/** Finds the lowest cost pose for a query. If OutRunnerUpCost is passed, early outs are made against the runner up
+	instead of the winner so that the second lowest cost can be reported */
+	static int32 GetLowestCostPoseId(UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+		TArray<FPoseMotionData>** OutPoseCandidates = nullptr, float* OutRunnerUpCost = nullptr, 
+		FMotionMatchingSearchStats* OutStats = nullptr);
+	static int32 GetLowestCostPoseId_Linear(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+		float* OutRunnerUpCost = nullptr, FMotionMatchingSearchStats* OutStats = nullptr);
+
+	/** Finds the lowest cost pose using the motion data's PCA pre-filter as a lower bound so that only poses that could beat 
+	the best cost found are costed exactly. Returns INDEX_NONE if there is no usable pre-filter for the query. */
+	static int32 GetLowestCostPoseId_PCA(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+		float* OutRunnerUpCost = nullptr, FMotionMatchingSearchStats* OutStats = nullptr);
+
+	/** Finds the lowest cost pose across a set of motion databases sharing a config. The query's database is searched first
+	and the others in order of the lower bound of their feature bounds, skipping any which can't beat the best pose. The 
+	query's SearchDatabaseId is set while each database is searched so that nothing is copied per database. */
+	static FMotionMatchingSearchResult GetLowestCostPose(const TArray<UMotionDataAsset*>& InDatabases, FMotionMatchingSearchQuery& Query,
+		TArray<FPoseMotionData>** OutPoseCandidates = nullptr, float* OutRunnerUpCost = nullptr, FMotionMatchingSearchStats* OutStats = nullptr);
+
+	/** Costs the natural next pose of a query and its neighbours in the sequence (see SeedRadius) exactly. Only poses in the
+	query's pose mask are costed. Returns the lowest cost seed or INDEX_NONE if seeding is off or no pose could be costed. */
+	static int32 SeedPoseSearch(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+		TArray<int32, TInlineAllocator<16>>& OutSeedPoseIds, float& OutLowestCost, float& OutRunnerUpCost);
+
+	/** Computes the full (no early out) cost of a single pose against a search query */
+	static float ComputePoseSearchCost(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query, const int32 PoseId);
+	static void ComputePoseSearchCostBreakdown(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchQuery& Query,
+		const int32 PoseId, FMotionMatchingCostBreakdown& OutCostBreakdown);
+
 private:
 	void UpdateBlending(const float DeltaTime);
 	void InitializeWithPoseRecorder(const FAnimationUpdateContext& Context);
@@ -219,11 +429,20 @@ private:
 	bool UpdateDistanceMatching(const float DeltaTime, const FAnimationUpdateContext& Context);
 	void ComputeCurrentPose();
 	void ComputeCurrentPose(const FCachedMotionPose& CachedMotionPose);
-	void SchedulePoseSearch(const FAnimationUpdateContext& Context);
+	int32 GetChannelPoseId(const FAnimChannelState& Channel, const float TimePassed, float& OutInterpolation) const;
+	void ComputeChannelPoses(FPoseMotionData*& OutBeforePose, FPoseMotionData*& OutAfterPose);
+	void SchedulePoseSearch(const FAnimationUpdateContext& Context, const bool bForceSynchronous = false);
 	void ScheduleTransitionPoseSearch(const FAnimationUpdateContext& Context);
-	int32 GetLowestCostPoseId();
-	int32 GetLowestCostPoseId(const FPoseMotionData& NextPose);
-	int32 GetLowestCostPoseId_Linear(const FPoseMotionData& NextPose);
+	void BuildSearchQuery(FMotionMatchingSearchQuery& OutQuery, const FPoseMotionData& NextPose);
+	void ApplyPoseSearchResult(const FMotionMatchingSearchResult& Result, const FAnimationUpdateContext& Context);
+	bool ResolveAsyncPoseSearch(const FAnimationUpdateContext& Context);
+	void CancelAsyncPoseSearch();
+	void DetachAsyncPoseSearch();
+	void RecordPoseSearch(const FMotionMatchingSearchQuery& Query, const FMotionMatchingSearchResult& Result, const float RunnerUpCost,
+		const FMotionMatchingSearchStats& SearchStats);
+	const TArray<uint64>& GetRequiredTraitPoseMask();
+	void SetActiveDatabase(const int32 DatabaseId);
+	UMotionDataAsset* GetChannelMotionData(const FAnimChannelState& Channel) const;
 	bool NextPoseToleranceTest(FPoseMotionData& NextPose);
 	void ApplyTrajectoryBlending();
 
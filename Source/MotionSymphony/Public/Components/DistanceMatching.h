@@ -7,6 +7,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Enumerations/EDistanceMatchingEnums.h"
 #include "Data/DistanceMatchSection.h"
+#include "Data/BakedDistanceCurveCache.h"
 #include "DistanceMatching.generated.h"
 
 USTRUCT(BlueprintInternalUseOnly)
@@ -20,8 +21,9 @@ public:
 
 private:
 	int32 LastKeyChecked;
-	float MaxDistance;
-	TArray<FRichCurveKey> CurveKeys;
+
+	/** Handle to the shared baked distance curve. Only the cursor (LastKeyChecked) is per node instance */
+	FBakedDistanceCurveHandle BakedCurve;
 	
 public:
 	FDistanceMatchingModule();
@@ -42,6 +44,12 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings, meta = (ClampMin = 0.0f))
 	float DistanceTolerance;
 
+	/** If checked, stop and start markers are predicted with a closed form solution of the standard character movement 
+	braking and acceleration model. Uncheck this if a custom movement component changes how characters brake or accelerate,
+	in which case the movement will be simulated step by step instead.*/
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Settings)
+	bool bUseAnalyticalPrediction;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = PlantDetection, meta = (ClampMin = 0.0f, ClampMax = 180.0f))
 	float MinPlantDetectionAngle;
 
@@ -119,9 +127,32 @@ public:
 	EDistanceMatchType GetDistanceMatchType() const;
 	uint32 GetCurrentInstanceId() const;
 
+	/** Predicts the distance and time it takes to brake to a stop with the standard character movement braking model
+	(friction plus braking deceleration with sub-stepped integration) without simulating each frame. Returns false if 
+	the character would not stop within MaxIterations frames. */
+	static bool PredictBrakingStop(const float Speed, const float Friction, const float BrakingDeceleration,
+		const float DeltaTime, const int32 MaxIterations, float& OutStopDistance, float& OutStopTime);
+
+	/** Predicts the distance covered and the number of frames taken to accelerate from rest to the target speed with 
+	the standard character movement acceleration model. Returns false if the speed is not reached within MaxIterations frames. */
+	static bool PredictStartDistance(const float TargetSpeed, const float Acceleration, const float DeltaTime,
+		const int32 MaxIterations, float& OutStartDistance, int32& OutIterations);
+
+	/** Simulates character movement braking, or decelerating with input acceleration, frame by frame to predict where and 
+	when the character stops relative to where it is now. Returns false if it would not stop within MaxIterations frames. */
+	static bool SimulateStop(const FVector& Velocity, const FVector& Acceleration, float Friction, float BrakingDeceleration,
+		const float DeltaTime, const int32 MaxIterations, FVector& OutStopOffset, float& OutStopTime);
+
+	/** Simulates character movement accelerating from rest to the target velocity frame by frame to predict where the 
+	character started relative to where it is now. Returns false if the velocity is not reached within MaxIterations frames. */
+	static bool SimulateStart(const FVector& TargetVelocity, const FVector& Acceleration, const float Friction, const float DeltaTime,
+		const int32 MaxIterations, FVector& OutStartOffset);
+
 protected:
 	bool CalculateStartLocation(FVector& OutStartLocation, float DeltaTime, int32 MaxIterations) const;
+	bool CalculateStartLocation_Iterative(FVector& OutStartLocation, float DeltaTime, int32 MaxIterations) const;
 	bool CalculateStopLocation(FVector& OutStopLocation, const float DeltaTime, int32 MaxIterations);
+	bool CalculateStopLocation_Iterative(FVector& OutStopLocation, const float DeltaTime, int32 MaxIterations);
 	float CalculateMarkerDistance() const;
 	
 	// Called when the game starts
@@ -10,6 +10,7 @@
 class UMotionDataAsset;
 class UWorld;
 class FPrimitiveDrawInterface;
+struct FMotionDebugDrawBatch;
 
 UCLASS()
 class MOTIONSYMPHONY_API UMMOptimisationModule : public UObject
@@ -33,8 +34,23 @@ public:
 	virtual TArray<FPoseMotionData>* GetFilteredPoseList(const FPoseMotionData& CurrentPose, 
 	const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration);
 
+	/** As GetFilteredPoseList but with the desired trajectory of the search for modules which filter on it. By default
+	this forwards to GetFilteredPoseList */
+	virtual TArray<FPoseMotionData>* GetFilteredPoseListWithTrajectory(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+		const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration);
+
+	/** Fills OutPoseIds with the ids of the candidate poses in the parent motion data for modules which filter down to
+	a subset of its poses rather than holding their own pose lists. Returns false if the module doesn't support this or
+	has no candidates, in which case the pose list functions are used instead */
+	virtual bool GetFilteredPoseIds(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+		const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration, TArray<int32>& OutPoseIds);
+
 	virtual void InitializeRuntime();
 	virtual bool IsProcessedAndValid(const UMotionDataAsset* CheckMotionData) const;
 
 	virtual void DrawDebug(FPrimitiveDrawInterface* DrawInterface, const UWorld* World, const UMotionDataAsset* MotionData) const;
+
+	/** Adds this module's debug geometry to a batch which is cached by the caller until the data changes. Returns false
+	if the module doesn't support batching, in which case DrawDebug is called every frame instead */
+	virtual bool BuildDebugDrawBatch(FMotionDebugDrawBatch& OutBatch, const UMotionDataAsset* MotionData) const;
 };
\ No newline at end of file
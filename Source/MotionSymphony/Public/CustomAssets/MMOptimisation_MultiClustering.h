@@ -47,4 +47,5 @@ public:
 	virtual void InitializeRuntime() override;
 
 	virtual void DrawDebug(FPrimitiveDrawInterface* DrawInterface, const UWorld* World, const UMotionDataAsset* MotionData) const override;
+	virtual bool BuildDebugDrawBatch(FMotionDebugDrawBatch& OutBatch, const UMotionDataAsset* MotionData) const override;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MMOptimisationModule.h"
+#include "MotionMatchingUtil/PoseProductQuantizer.h"
+#include "MMOptimisation_ProductQuantisation.generated.h"
+
+/** The product quantised features of all usable poses with a single trait set */
+USTRUCT()
+struct MOTIONSYMPHONY_API FPoseQuantizedSet
+{
+	GENERATED_BODY()
+
+public:
+	/** The ids of the poses in this set, in quantizer item order */
+	UPROPERTY()
+	TArray<int32> PoseIds;
+
+	/** The scale of each feature column which normalises it by its standard deviation (0 for constant columns) */
+	UPROPERTY()
+	TArray<float> FeatureScales;
+
+	UPROPERTY()
+	FPoseProductQuantizer Quantizer;
+
+public:
+	bool IsValid() const;
+};
+
+/** An approximate search optimisation. The normalised squared distance features (body momentum, joint positions and 
+velocities and trajectory positions) of each pose are product quantised into one byte per sub-space at pre-process. At 
+runtime a distance table is built for the query with the runtime calibration, the byte codes are scanned and only the 
+nearest 'RerankCount' poses are passed on to be re-ranked with the exact cost. */
+UCLASS()
+class MOTIONSYMPHONY_API UMMOptimisation_ProductQuantisation : public UMMOptimisationModule
+{
+	GENERATED_BODY()
+
+public:
+	/** The number of sub-spaces the pose features are split into. Each pose is stored as one byte per sub-space */
+	UPROPERTY(EditAnywhere, Category = "Settings", meta = (ClampMin = 1, ClampMax = 64))
+	int32 SubspaceCount;
+
+	/** The number of centroids trained for each sub-space */
+	UPROPERTY(EditAnywhere, Category = "Settings", meta = (ClampMin = 2, ClampMax = 256))
+	int32 CodebookSize;
+
+	/** The maximum number of k-means iterations used to train each sub-space codebook */
+	UPROPERTY(EditAnywhere, Category = "Settings", meta = (ClampMin = 1))
+	int32 TrainingIterations;
+
+	/** The maximum number of poses used to train the codebooks. All poses are still encoded */
+	UPROPERTY(EditAnywhere, Category = "Settings", meta = (ClampMin = 256))
+	int32 TrainingSampleLimit;
+
+	/** The number of approximate nearest poses which are re-ranked with the exact search cost. Higher values trade speed for accuracy */
+	UPROPERTY(EditAnywhere, Category = "Settings", meta = (ClampMin = 1))
+	int32 RerankCount;
+
+	UPROPERTY()
+	TMap<FMotionTraitField, FPoseQuantizedSet> QuantizedSets;
+
+public:
+	UMMOptimisation_ProductQuantisation(const FObjectInitializer& ObjectInitializer);
+
+	virtual void BuildOptimisationStructures(UMotionDataAsset* InMotionDataAsset) override;
+	virtual TArray<FPoseMotionData>* GetFilteredPoseList(const FPoseMotionData& CurrentPose,
+		const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration) override;
+	virtual bool GetFilteredPoseIds(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+		const FMotionTraitField RequiredTraits, const FCalibrationData& FinalCalibration, TArray<int32>& OutPoseIds) override;
+
+	virtual bool IsProcessedAndValid(const UMotionDataAsset* CheckMotionData) const override;
+
+	static int32 GetFeatureCount(const int32 JointCount, const int32 TrajectoryCount);
+
+	/** Writes the scaled features of a pose or query. OutFeatures must have room for GetFeatureCount values */
+	static void GatherFeatures(const FVector& LocalVelocity, const TArray<FJointData>& JointData,
+		const TArray<FTrajectoryPoint>& Trajectory, const TArray<float>& FeatureScales, float* OutFeatures);
+};
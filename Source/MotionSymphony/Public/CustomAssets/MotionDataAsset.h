@@ -18,6 +18,13 @@
 #include "CustomAssets/MMOptimisationModule.h"
 #include "Data/DistanceMatchSection.h"
 #include "Data/MotionAction.h"
+#include "Data/MotionPoseRange.h"
+#include "Data/PoseFeaturePCA.h"
+#include "Data/MotionFeatureBounds.h"
+#include "Serialization/BulkData.h"
+#if WITH_EDITOR && ENGINE_MAJOR_VERSION > 4
+#include "UObject/ObjectSaveContext.h"
+#endif
 #include "MotionDataAsset.generated.h"
 
 class USkeleton;
@@ -93,11 +100,58 @@ public:
 	UPROPERTY(EditAnywhere, Category = AnimationNotifies)
 	TEnumAsByte<ENotifyTriggerMode::Type> NotifyTriggerMode;
 
+	/** Animation channels (and blend space samples) with a weight below this do not gather notifies when the trigger 
+	mode is 'AllAnimations'. Root motion is still extracted from them. */
+	UPROPERTY(EditAnywhere, Category = AnimationNotifies, meta = (ClampMin = 0.0f, ClampMax = 1.0f))
+	float NotifyRelevancyWeight;
+
 	/** Check this if the pre-processing should run the optimization algorithm for faster runtime searches. 
 	Warning: Optimization can take a lot of time to complete. */
 	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation")
 	bool bOptimize;
 
+	/** Check this if the pre-processing should build a reduced (PCA) feature space for each trait set. This is used as a 
+	cheap first pass by the 'PCAPrefiltered' pose match method before the remaining poses are costed exactly. */
+	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation")
+	bool bBuildPCAPrefilter;
+
+	/** The fraction of the feature variance that the reduced feature space should explain */
+	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation", meta = (ClampMin = 0.5f, ClampMax = 1.0f, EditCondition = "bBuildPCAPrefilter"))
+	float PCATargetVariance;
+
+	/** The maximum number of dimensions of the reduced feature space */
+	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation", meta = (ClampMin = 1, ClampMax = 64, EditCondition = "bBuildPCAPrefilter"))
+	int32 PCAMaxDimensions;
+
+	/** The reduced feature space of each trait set including its retained variance and top 1 agreement with the full 
+	feature space. Built during pre-processing. */
+	UPROPERTY(VisibleAnywhere, Category = "Motion Matching|Optimisation")
+	TMap<FMotionTraitField, FPoseFeaturePCA> PCAPrefilters;
+
+	/** Check this if the pre-processing should exclude near duplicate poses (e.g. from idle loops, overlapping takes and 
+	symmetric mirrored clips) from the search. Excluded poses remain in their sequence and can still be played into. */
+	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation")
+	bool bPruneRedundantPoses;
+
+	/** The pre-process calibration weighted cost under which a pose, and the pose following it, are considered redundant 
+	with an earlier pose of the same traits and favour. It also bounds the increase of the best search cost of every leave 
+	one out query (each pose of a trait set searched against the others), a redundant pose is kept where it would not. 
+	Checking every query is quadratic in the trait set size but runs in parallel and only when pruning finds poses */
+	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation", meta = (ClampMin = 0.0f, EditCondition = "bPruneRedundantPoses"))
+	float PruneCostEpsilon;
+
+	/** The number of poses excluded from the search by the last pre-process */
+	UPROPERTY(VisibleAnywhere, Category = "Motion Matching|Optimisation")
+	int32 PrunedPoseCount;
+
+	/** The measured fraction of linear search time saved by pruning, sampled during pre-processing */
+	UPROPERTY(VisibleAnywhere, Category = "Motion Matching|Optimisation")
+	float PruneSearchTimeSaving;
+
+	/** The largest increase of the best search cost over every leave one out query after pruning, at most PruneCostEpsilon */
+	UPROPERTY(VisibleAnywhere, Category = "Motion Matching|Optimisation")
+	float PruneMaxCostIncrease;
+
 	UPROPERTY(EditAnywhere, Category = "Motion Matching|Optimisation")
 	class UMMOptimisationModule* OptimisationModule;
 
@@ -139,6 +193,11 @@ public:
 	UPROPERTY()
 	TMap<FMotionTraitField, FCalibrationData> FeatureStandardDeviations;
 
+	/** The bounds of the features of the searchable poses of each trait set. Used by multi-database searches to skip 
+	this database when it can't contain a better pose than one already found. */
+	UPROPERTY()
+	TMap<FMotionTraitField, FMotionFeatureBounds> FeatureBounds;
+
 	/** A map of distance matching sections that can be searched at runtime to perform distance matching in certain situations */
 	UPROPERTY()
 	TMap<FDistanceMatchIdentifier, FDistanceMatchGroup> DistanceMatchSections;
@@ -147,6 +206,55 @@ public:
 	UPROPERTY()
 	TArray<FMotionAction> Actions;
 
+	/** Inverted trait index of the pose database. For each trait position this holds a bitset of pose ids (64 poses per
+	word) that have that trait, or an empty array if no pose uses the trait. Built on load and after pre-processing. */
+	TArray<TArray<uint64>> TraitPoseBitmaps;
+
+	/** Bitset of every pose id that is a valid search candidate (i.e. not tagged 'DoNotUse' or pruned) */
+	TArray<uint64> UsablePoseBitmap;
+
+	/** Bitset of the pose ids excluded from the search as redundant by the pruning pass. Empty if pruning is off */
+	UPROPERTY()
+	TArray<uint64> PrunedPoseBitmap;
+
+	/** The trait positions used by at least one pose in the database */
+	TArray<int32> UsedTraitPositions;
+
+	/** The usable pose ids partitioned by trait set so that the candidates of each trait set are one contiguous range, in 
+	pose id order within a range. This is only a permutation of the search order, pose ids are unchanged. Built on load
+	and after pre-processing. */
+	TArray<int32> TraitSearchPoseIds;
+
+	/** The local velocity (XYZ) and rotational velocity (W) of each pose in TraitSearchPoseIds, stored in the same order
+	so that the first stage of a linear search reads a dense array */
+	TArray<FVector4> TraitSearchMomenta;
+
+	/** For each trait set, the first entry in TraitSearchPoseIds and the number of entries it has */
+	TMap<FMotionTraitField, FIntPoint> TraitSearchRanges;
+
+	/** The contiguous runs of poses generated from each animation (and blend space position), in pose id order */
+	UPROPERTY()
+	TArray<FMotionPoseRange> PoseRanges;
+
+	/** The blend space sample weights at the position of every blend space pose range (see FMotionPoseRange::BlendSampleStart).
+	Built during pre-processing so that jumping to a blend space pose doesn't need to evaluate the blend space. */
+	UPROPERTY()
+	TArray<FMotionBlendSampleWeight> BlendSampleWeights;
+
+	/** For each animation slot (see GetAnimSlot) the index of its first pose range and the number of ranges it has. 
+	Built on load and after pre-processing. */
+	TArray<FIntPoint> AnimPoseRangeLookup;
+
+	/** Indices into the Actions array sorted by action id and then by trait. Built on load and after pre-processing. */
+	TArray<int32> ActionIndex;
+
+	/** For each action id, the first entry in the ActionIndex and the number of entries it has */
+	TMap<int32, FIntPoint> ActionIndexRanges;
+
+	/** Cooked builds store the pose database and its search indices in this compact blob (see FCookedPoseDatabase) 
+	instead of as tagged properties. It is unpacked into 'Poses' and released on load. */
+	FByteBulkData CookedPoseData;
+
 //#if WITH_EDITOR
 	/** The final result of the K-Means clustering. This data is only stored if in the editor 
 	for the purposes of visual representation and debugging. */
@@ -204,17 +312,90 @@ public:
 	FDistanceMatchGroup& GetDistanceMatchGroup(const FDistanceMatchIdentifier MatchGroupIdentifier);
 	void AddDistanceMatchSection(const FDistanceMatchSection& NewDistanceMatchSection);
 
+	//PCA Pre-Filter
+	void BuildPCAPrefilters();
+	const FPoseFeaturePCA* FindPCAPrefilter(const FMotionTraitField& Traits) const;
+
+	//Feature Group Order
+	void BuildFeatureGroupOrders();
+
+	//Feature Bounds
+	void BuildFeatureBounds();
+	const FMotionFeatureBounds* FindFeatureBounds(const FMotionTraitField& Traits) const;
+
+	//Redundant Pose Pruning
+	void PruneRedundantPoses();
+	bool IsPosePruned(const int32 PoseId) const;
+
+	/** Can the pose be returned by a search, i.e. is it neither tagged 'DoNotUse' nor pruned */
+	bool IsPoseSearchable(const int32 PoseId) const;
+
+	//Pose Ranges
+	void BuildPoseRanges();
+	void BuildPoseRangeLookup();
+	const FMotionPoseRange* FindPoseRange(const EMotionAnimAssetType AnimType, const int32 AnimId, const bool bMirrored,
+		const FVector2D& BlendSpacePosition = FVector2D::ZeroVector) const;
+	const FMotionPoseRange* FindPoseRangeForPose(const int32 PoseId) const;
+
+	//Blend Space Sample Weights
+	void BuildBlendSampleWeights();
+
+	/** Fills the blend sample data of a blend space pose from the pre-processed sample weights. Returns false if the pose
+	has none (e.g. it isn't a blend space pose or the asset was processed before they were stored). */
+	bool GetBlendSampleData(const int32 PoseId, TArray<FBlendSampleData>& OutSampleData) const;
+
+	/** Gets the id of the pose at (or just before) the passed time of an animation in constant time. Returns INDEX_NONE 
+	if the animation has no poses. */
+	int32 GetPoseIdAtTime(const EMotionAnimAssetType AnimType, const int32 AnimId, const bool bMirrored, const float Time,
+		const FVector2D& BlendSpacePosition = FVector2D::ZeroVector) const;
+
+	//Traits
+	void BuildTraitPoseBitmaps();
+
+	/** Computes a bitset of the usable poses whose traits exactly match the passed trait field using only
+	word-wise operations on the trait pose bitmaps. */
+	void GetTraitPoseMask(const FMotionTraitField& Traits, TArray<uint64>& OutPoseMask) const;
+
+	void BuildTraitSearchIndex();
+
+	/** Builds the dense search momenta and the trait set ranges of an existing TraitSearchPoseIds order */
+	void BuildTraitSearchRanges();
+
+	/** Gets the range of TraitSearchPoseIds holding the usable poses whose traits exactly match the passed trait field.
+	Returns false if there are none. */
+	bool GetTraitSearchRange(const FMotionTraitField& Traits, int32& OutStart, int32& OutEnd) const;
+
+	/** Sets the facing direction of every pose trajectory point from its rotation. Returns the number that changed */
+	int32 UpdateTrajectoryFacings();
+
+	/** Unpacks the cooked pose database into the pose array if this asset was loaded from a cooked package */
+	bool LoadCookedPoseDatabase();
+
 	//Actions
 	void AddAction(const FPoseMotionData& ClosestPose, const FMotionAnimAsset& MotionAnim, const int32 ActionId, const float Time);
+	void BuildActionIndex();
+
+	/** Gets the range of the ActionIndex holding the actions with the passed action id and traits. If no action with the id 
+	has the traits, the range of all the actions with that id is returned instead. Returns false if there are none. */
+	bool GetActionCandidates(const int32 ActionId, const FMotionTraitField& Traits, int32& OutStart, int32& OutEnd) const;
 
 	/** UObject Interface*/
 	virtual void PostLoad() override;
+	virtual void GetResourceSizeEx(FResourceSizeEx& CumulativeResourceSize) override;
 	/** End UObject Interface*/
 
 	/** UAnimationAsset interface */
 	virtual void Serialize(FArchive& Ar) override;
 	/** End UAnimationAsset interface */
 
+#if WITH_EDITOR
+#if ENGINE_MAJOR_VERSION > 4
+	virtual void PostSaveRoot(FObjectPostSaveRootContext ObjectSaveContext) override;
+#else
+	virtual void PostSaveRoot(bool bCleanupIsRequired) override;
+#endif
+#endif
+
 	//~ Begin UAnimationAsset Interface
 #if WITH_EDITOR
 	virtual void RemapTracksToNewSkeleton(USkeleton* NewSkeleton, bool bConvertSpaces) override;
@@ -245,10 +426,11 @@ public:
 	bool SetAnimMetaPreviewIndex(EMotionAnimAssetType CurAnimType, int32 CurAnimId);
 
 private:
-	void AddAnimNotifiesToNotifyQueue(FAnimNotifyQueue& NotifyQueue, TArray<FAnimNotifyEventReference>& Notifies, float InstanceWeight) const;
+	void AddAnimNotifiesToNotifyQueue(FAnimNotifyQueue& NotifyQueue, const TArray<FAnimNotifyEventReference>& Notifies, float InstanceWeight) const;
 
 	void PreProcessAnim(const int32 SourceAnimIndex, const bool bMirror = false);
 	void PreProcessBlendSpace(const int32 SourceBlendSpaceIndex, const bool bMirror = false);
 	void PreProcessComposite(const int32 SourceCompositeIndex, const bool bMirror = false);
 	void GeneratePoseSequencing();
+	int32 GetAnimSlot(const EMotionAnimAssetType AnimType, const int32 AnimId, const bool bMirrored) const;
 };
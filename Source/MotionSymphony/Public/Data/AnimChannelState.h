@@ -9,6 +9,8 @@
 #include "Animation/AnimationAsset.h"
 #include "AnimChannelState.generated.h"
 
+class UMotionDataAsset;
+
 /** A data structure for tracking animation channels within a motion matching animation stack. 
 Every time a new pose is picked from the animation database, a channel is created for managing
 its state. */
@@ -26,6 +28,11 @@ public:
 	UPROPERTY()
 	float HighestWeight;
 	
+	/** The motion database that the channel's animation belongs to. A motion matching node can play channels from any of 
+	the databases it searches. Null channels belong to the motion data asset that is ticking them. */
+	UPROPERTY()
+	UMotionDataAsset* MotionData;
+
 	/** Id of the animation used for this channel */
 	UPROPERTY()
 	int32 AnimId;
@@ -0,0 +1,50 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Curves/RichCurve.h"
+
+/** A distance curve baked into flat arrays of key times and distances split into monotonic segments. This allows
+ * a matching time to be found for a desired distance with a binary search rather than a linear walk over the curve 
+ * keys. Segments are baked for both the raw and the negated curve so either can be queried without re-baking.*/
+struct MOTIONSYMPHONY_API FBakedDistanceCurve
+{
+public:
+	/** A run of consecutive keys over which the distance never increases */
+	struct FSegment
+	{
+		int32 StartKey;
+		int32 EndKey; //Inclusive
+		float MinDistance;
+		float MaxDistance;
+		float StartTime;
+		float EndTime;
+	};
+
+private:
+	TArray<float> KeyTimes;
+	TArray<float> KeyDistances;
+	TArray<FSegment> Segments;
+	TArray<FSegment> NegatedSegments;
+	float MaxDistance;
+
+public:
+	FBakedDistanceCurve();
+
+	void Bake(const TArray<FRichCurveKey>& InKeys);
+	void Reset();
+
+	int32 GetKeyCount() const;
+	float GetMaxDistance() const;
+	const TArray<FSegment>& GetSegments(const bool bNegated) const;
+	SIZE_T GetAllocatedSize() const;
+
+	/** Finds the time at which the curve first reaches the desired distance, searching from the passed key onwards.
+	 * Returns -1.0f if the start key is invalid. If a matching key is found, InOutStartKey is updated to that key. */
+	float FindMatchingTime(const float DesiredDistance, const bool bNegated, int32& InOutStartKey) const;
+
+private:
+	static void BuildSegments(const TArray<float>& InKeyTimes, const TArray<float>& InKeyDistances,
+		const float Negator, TArray<FSegment>& OutSegments);
+};
@@ -0,0 +1,73 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "Data/BakedDistanceCurve.h"
+
+class UAnimSequenceBase;
+
+typedef TSharedPtr<const FBakedDistanceCurve, ESPMode::ThreadSafe> FBakedDistanceCurveHandle;
+
+/** A process wide cache of baked distance curves shared by all distance matching node instances. Curves are extracted
+ * and baked lazily the first time they are requested and are reference counted through their handles. A curve is freed
+ * when the last handle to it is released. */
+class MOTIONSYMPHONY_API FBakedDistanceCurveCache
+{
+private:
+	struct FCurveKey
+	{
+		FObjectKey Sequence;
+		FName CurveName;
+		FGuid DataGuid;
+
+		bool operator==(const FCurveKey& Other) const
+		{
+			return Sequence == Other.Sequence && CurveName == Other.CurveName && DataGuid == Other.DataGuid;
+		}
+
+		friend uint32 GetTypeHash(const FCurveKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Sequence), GetTypeHash(Key.CurveName)), GetTypeHash(Key.DataGuid));
+		}
+	};
+
+	TMap<FCurveKey, TWeakPtr<const FBakedDistanceCurve, ESPMode::ThreadSafe>> Curves;
+	mutable FCriticalSection CurvesCriticalSection;
+
+	//Running totals since startup. Guarded by CurvesCriticalSection
+	int32 RequestCount;
+	int32 BakeCount;
+
+public:
+	/** Memory and usage of the cache. UnsharedSize is what the live handles would use if every node held its own copy
+	of its curve as it did before the cache, which gives the before and after resident size */
+	struct FStats
+	{
+		int32 CurveCount;
+		int32 HandleCount;
+		int32 RequestCount;
+		int32 BakeCount;
+		SIZE_T AllocatedSize;
+		SIZE_T UnsharedSize;
+
+		FStats();
+	};
+
+public:
+	FBakedDistanceCurveCache();
+
+	static FBakedDistanceCurveCache& Get();
+
+	/** Returns a handle to the baked distance curve of the passed sequence, extracting and baking it if it isn't already
+	cached. Returns an invalid handle if the sequence does not have the curve. Safe to call from any thread. */
+	FBakedDistanceCurveHandle FindOrBake(UAnimSequenceBase* InAnimSequence, const FName& DistanceCurveName);
+
+	/** Gets the number of live cached curves, the handles to them and their total allocated size */
+	FStats GetStats() const;
+
+private:
+	static FGuid GetSequenceDataGuid(UAnimSequenceBase* InAnimSequence);
+	static bool ExtractCurve(UAnimSequenceBase* InAnimSequence, const FName& DistanceCurveName, FBakedDistanceCurve& OutCurve);
+};
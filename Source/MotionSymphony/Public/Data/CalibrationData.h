@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "CustomAssets/MotionCalibration.h"
+#include "Enumerations/EMotionMatchingEnums.h"
 #include "CalibrationData.generated.h"
 
 struct FJointWeightSet;
@@ -34,6 +35,11 @@ public:
 	UPROPERTY();
 	TArray<FTrajectoryWeightSet> TrajectoryWeights;
 
+	/** The order the pose search evaluates feature groups in, most discriminative first. It is measured for each trait set 
+	during pre-processing and carried over to the final weights. Empty uses the default order. */
+	UPROPERTY()
+	TArray<EMotionFeatureGroup> FeatureGroupOrder;
+
 public:
 	FCalibrationData();
 	FCalibrationData(UMotionDataAsset* SourceMotionData);
@@ -45,4 +51,15 @@ public:
 
 	void GenerateStandardDeviationWeights(const UMotionDataAsset* SourceMotionData, const FMotionTraitField& MotionTrait);
 	void GenerateFinalWeights(const UMotionCalibration* UserCalibration, const FCalibrationData& StdDeviationNormalizers);
+
+	/** Writes the feature group evaluation order to OutOrder (EMotionFeatureGroup::Count entries). The default order is 
+	used if the stored one is not a permutation of every group. */
+	void GetFeatureGroupOrder(EMotionFeatureGroup* OutOrder) const;
+
+	/** Generates the standard deviation weights for every trait combination used in the motion data. Poses are partitioned
+	by trait in a single pass and each partition's statistics are then accumulated in parallel. */
+	static void GenerateStandardDeviationWeights(const UMotionDataAsset* SourceMotionData, TMap<FMotionTraitField, FCalibrationData>& OutStdDeviations);
+
+private:
+	void SetStandardDeviationWeights(const UMotionDataAsset* SourceMotionData, const TArray<int32>& PoseIds);
 };
\ No newline at end of file
@@ -0,0 +1,91 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Data/PoseMotionData.h"
+
+/** A compact, contiguous and versioned binary layout of a pre-processed pose database used for cooked builds. Instead of
+ * serializing every pose as tagged properties with its own trajectory and joint arrays, the cooked database stores a single
+ * blob made of a header followed by six tightly packed sections:
+ *
+ *  - Feature matrix: PoseCount x FeatureStride floats (local velocity, rotational velocity, trajectory and joints)
+ *  - Pose metadata: animation reference, time, favour, candidate set and flags
+ *  - Sequencing: next and last pose ids
+ *  - Traits: PoseCount x MOTION_TRAIT_FIELD_WORDS trait words
+ *  - Search index: the searchable pose ids in trait search order (see UMotionDataAsset::TraitSearchPoseIds)
+ *  - Pruned poses: the redundant pose pruning bitmap words
+ *
+ * The blob is validated in full before anything is unpacked from it. It is unpacked into the regular pose array on load,
+ * so it saves package size and load time (no tagged property parsing and no search index sort) but the resident size and
+ * allocation count of the loaded pose database are the same as for an uncooked asset. */
+struct MOTIONSYMPHONY_API FCookedPoseDatabase
+{
+public:
+	static const uint32 Magic;
+	static const uint32 Version;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 PayloadCrc;
+		int32 PoseCount;
+		int32 TrajectoryPointCount;
+		int32 JointCount;
+		int32 TraitWordCount;
+		int32 FeatureStride;
+		int32 SearchIndexCount;
+		int32 PrunedWordCount;
+		int64 FeatureOffset;
+		int64 MetadataOffset;
+		int64 SequencingOffset;
+		int64 TraitOffset;
+		int64 SearchIndexOffset;
+		int64 PrunedOffset;
+		int64 TotalSize;
+	};
+
+	struct FPoseMetadata
+	{
+		int32 AnimId;
+		int32 CandidateSetId;
+		float Time;
+		float Favour;
+		FVector2D BlendSpacePosition;
+		uint8 AnimType;
+		uint8 Flags;
+		uint16 Padding;
+	};
+
+	struct FPoseSequencing
+	{
+		int32 NextPoseId;
+		int32 LastPoseId;
+	};
+
+	enum EPoseFlags : uint8
+	{
+		Mirrored = 1 << 0,
+		DoNotUse = 1 << 1
+	};
+
+public:
+	/** Returns true if the poses can be packed. All poses must have the same number of trajectory points and joints
+	and each pose id must match its index in the database */
+	static bool CanPack(const TArray<FPoseMotionData>& Poses);
+
+	/** Packs the pose database and its search indices into a single contiguous blob */
+	static void Pack(const TArray<FPoseMotionData>& Poses, const TArray<int32>& SearchPoseIds, const TArray<uint64>& PrunedPoseBitmap, 
+		TArray<uint8>& OutBlob);
+
+	/** Checks the header, section bounds, payload checksum and pose references of a blob without unpacking it */
+	static bool Validate(const uint8* Data, const int64 DataSize);
+
+	/** Validates and unpacks a blob into a pose database and its search indices. Returns false and leaves the outputs 
+	untouched if the blob is invalid */
+	static bool Unpack(const uint8* Data, const int64 DataSize, TArray<FPoseMotionData>& OutPoses, TArray<int32>& OutSearchPoseIds,
+		TArray<uint64>& OutPrunedPoseBitmap);
+
+	static int32 GetFeatureStride(const int32 TrajectoryPointCount, const int32 JointCount);
+};
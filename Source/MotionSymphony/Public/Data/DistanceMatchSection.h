@@ -6,6 +6,7 @@
 #include "Enumerations/EDistanceMatchingEnums.h"
 #include "Enumerations/EMotionMatchingEnums.h"
 #include "Animation/AnimCurveTypes.h"
+#include "Data/BakedDistanceCurve.h"
 #include "DistanceMatchSection.generated.h"
 
 USTRUCT(BlueprintType)
@@ -49,6 +50,10 @@ public:
 	virtual void GenerateDistanceCurve(const UAnimSequence* Sequence);
 	virtual void GenerateRotationCurve(const UAnimSequence* Sequence);
 
+	/** Bakes the distance curve into monotonic segments for fast runtime lookups. This data is not serialized
+	and must be re-baked after loading or after the distance curve changes.*/
+	void BakeDistanceCurve();
+
 	float FindMatchingTime(const float DesiredDistance, int32& StartKey);
 
 public:
@@ -92,4 +97,7 @@ public:
 
 	UPROPERTY()
 	FFloatCurve DistanceCurve;
+
+	/** The runtime lookup structure baked from the distance curve */
+	FBakedDistanceCurve BakedDistanceCurve;
 };
\ No newline at end of file
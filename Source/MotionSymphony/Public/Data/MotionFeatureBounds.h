@@ -0,0 +1,65 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MotionFeatureBounds.generated.h"
+
+struct FCalibrationData;
+struct FPoseMotionData;
+struct FTrajectoryPoint;
+
+/** A conservative axis aligned bounding box of the raw features of a set of poses (e.g. all searchable poses of a motion
+database with a single trait set). Weighted with a search calibration, the distance from a query to the box is a lower 
+bound of the search cost of every pose in the set so that whole databases can be skipped by a multi-database search. */
+USTRUCT()
+struct MOTIONSYMPHONY_API FMotionFeatureBounds
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY()
+	FBox LocalVelocity;
+
+	UPROPERTY()
+	float MinRotationalVelocity;
+
+	UPROPERTY()
+	float MaxRotationalVelocity;
+
+	/** The bounds of each trajectory point position */
+	UPROPERTY()
+	TArray<FBox> TrajectoryPositions;
+
+	/** The bounds of each trajectory point facing direction */
+	UPROPERTY()
+	TArray<FBox2D> TrajectoryFacings;
+
+	/** The bounds of each pose joint position */
+	UPROPERTY()
+	TArray<FBox> JointPositions;
+
+	/** The bounds of each pose joint velocity */
+	UPROPERTY()
+	TArray<FBox> JointVelocities;
+
+	/** The lowest pose favour in the set. The cost of every pose is multiplied by at least this */
+	UPROPERTY()
+	float MinFavour;
+
+	UPROPERTY()
+	int32 PoseCount;
+
+public:
+	FMotionFeatureBounds();
+
+	bool IsValid() const;
+
+	/** Grows the bounds to contain the features of the passed pose */
+	void Add(const FPoseMotionData& Pose);
+
+	/** Computes a lower bound of the search cost of every pose in the bounds. The current pose favour is not applied as it 
+	only ever applies to the natural next pose. */
+	float ComputeLowerBound(const FPoseMotionData& CurrentPose, const TArray<FTrajectoryPoint>& DesiredTrajectory,
+		const FCalibrationData& Calibration, const float PoseMultiplier, const float TrajectoryMultiplier) const;
+};
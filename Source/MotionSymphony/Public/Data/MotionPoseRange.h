@@ -0,0 +1,78 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Enumerations/EMotionMatchingEnums.h"
+#include "MotionPoseRange.generated.h"
+
+/** The normalised weight of a single blend space sample at a blend space position */
+USTRUCT()
+struct MOTIONSYMPHONY_API FMotionBlendSampleWeight
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY()
+	int32 SampleIndex;
+
+	UPROPERTY()
+	float Weight;
+
+public:
+	FMotionBlendSampleWeight();
+	FMotionBlendSampleWeight(const int32 InSampleIndex, const float InWeight);
+};
+
+/** A contiguous run of poses in the pose database which were all generated from the same animation (and the same 
+blend space position for blend spaces). Poses within a range are spaced at the pose interval from the start time. */
+USTRUCT()
+struct MOTIONSYMPHONY_API FMotionPoseRange
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY()
+	EMotionAnimAssetType AnimType;
+
+	UPROPERTY()
+	int32 AnimId;
+
+	UPROPERTY()
+	bool bMirrored;
+
+	UPROPERTY()
+	bool bLoop;
+
+	UPROPERTY()
+	FVector2D BlendSpacePosition;
+
+	UPROPERTY()
+	int32 StartPoseId;
+
+	/** The last pose id in the range (inclusive) */
+	UPROPERTY()
+	int32 EndPoseId;
+
+	/** The animation time of the first pose in the range */
+	UPROPERTY()
+	float StartTime;
+
+	/** The first of this range's blend space sample weights in the motion data's BlendSampleWeights (blend spaces only) */
+	UPROPERTY()
+	int32 BlendSampleStart;
+
+	/** The number of blend space samples weighted at this range's blend space position */
+	UPROPERTY()
+	int32 BlendSampleCount;
+
+public:
+	FMotionPoseRange();
+
+	int32 Num() const;
+	bool Contains(const int32 PoseId) const;
+
+	/** Gets the pose at or before the passed animation time in constant time. Times past the end of the range wrap if the
+	range loops and clamp otherwise. OutInterpolation is the progress from the returned pose to the next pose. */
+	int32 GetPoseIdAtTime(const float Time, const float PoseInterval, float& OutInterpolation) const;
+};
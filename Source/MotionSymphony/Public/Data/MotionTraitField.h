@@ -5,24 +5,46 @@
 #include "CoreMinimal.h"
 #include "MotionTraitField.generated.h"
 
+/** The maximum number of motion traits supported by a project. This is fixed at compile time and can be overridden
+ * via PublicDefinitions in the project build rules. It must be a multiple of 32 and larger than 64. */
+#ifndef MOTION_TRAIT_FIELD_BITS
+#define MOTION_TRAIT_FIELD_BITS 128
+#endif
+
+/** The number of 32 bit words stored in a trait field beyond the original A and B words */
+#define MOTION_TRAIT_FIELD_EXTENDED_WORDS ((MOTION_TRAIT_FIELD_BITS - 64) / 32)
+
+/** The total number of 32 bit words stored in a trait field */
+#define MOTION_TRAIT_FIELD_WORDS (MOTION_TRAIT_FIELD_BITS / 32)
+
+static_assert(MOTION_TRAIT_FIELD_BITS > 64 && MOTION_TRAIT_FIELD_BITS % 32 == 0,
+	"MOTION_TRAIT_FIELD_BITS must be a multiple of 32 and larger than 64");
+
 USTRUCT(BlueprintType)
 struct MOTIONSYMPHONY_API FMotionTraitField
 {
 	GENERATED_USTRUCT_BODY()
 
 public:
+	/** Traits 0 - 31 */
 	UPROPERTY()
 	int32 A;
 
+	/** Traits 32 - 63 */
 	UPROPERTY()
 	int32 B;
 
+	/** Traits 64 and above. Assets saved before this existed simply load these as zero */
+	UPROPERTY()
+	int32 Extended[MOTION_TRAIT_FIELD_EXTENDED_WORDS];
+
 public:
 	FMotionTraitField();
 	FMotionTraitField(const int32 TraitIndex);
 	FMotionTraitField(const int32 InA, const int32 InB);
 
 	void Clear();
+	bool IsEmpty() const;
 
 	void SetTraitPosition(const int32 TraitPosition);
 	void UnSetTraitPosition(const int32 TraitPosition);
@@ -32,6 +54,24 @@ public:
 	bool HasTrait(const int32 TraitPosition) const;
 	bool HasTraits(const FMotionTraitField Traits) const;
 
+	/** Appends the position of every set trait in ascending order */
+	void GetTraitPositions(TArray<int32>& OutTraitPositions) const;
+
+	FORCEINLINE static bool IsValidTraitPosition(const int32 TraitPosition)
+	{
+		return TraitPosition > -1 && TraitPosition < MOTION_TRAIT_FIELD_BITS;
+	}
+
+	FORCEINLINE int32 GetWord(const int32 WordIndex) const
+	{
+		return WordIndex == 0 ? A : (WordIndex == 1 ? B : Extended[WordIndex - 2]);
+	}
+
+	FORCEINLINE int32& GetWord(const int32 WordIndex)
+	{
+		return WordIndex == 0 ? A : (WordIndex == 1 ? B : Extended[WordIndex - 2]);
+	}
+
 	bool operator != (const FMotionTraitField& rhs) const;
 	bool operator == (const FMotionTraitField& rhs) const;
 	FMotionTraitField operator | (const FMotionTraitField& rhs) const;
@@ -40,7 +80,13 @@ public:
 	void operator &= (const FMotionTraitField& rhs);
 };
 
-inline uint64 GetTypeHash(const FMotionTraitField A)
+inline uint32 GetTypeHash(const FMotionTraitField A)
 {
-	return ((uint64)A.A << 32) | (uint32)A.B;
+	uint32 Hash = HashCombine(::GetTypeHash(A.A), ::GetTypeHash(A.B));
+	for (int32 i = 0; i < MOTION_TRAIT_FIELD_EXTENDED_WORDS; ++i)
+	{
+		Hash = HashCombine(Hash, ::GetTypeHash(A.Extended[i]));
+	}
+
+	return Hash;
 }
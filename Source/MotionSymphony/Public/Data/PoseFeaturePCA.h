@@ -0,0 +1,83 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseFeaturePCA.generated.h"
+
+class UMotionDataAsset;
+struct FCalibrationData;
+struct FJointData;
+struct FTrajectoryPoint;
+
+/** A principal component basis over the normalised, squared distance features (body momentum, joint positions and 
+velocities and trajectory positions and facing directions) of all usable poses with a single trait set. The projected coordinates of each pose 
+are used as a cheap lower bound on the search cost so that only poses which could beat the best exact cost need to be 
+costed in full. */
+USTRUCT()
+struct MOTIONSYMPHONY_API FPoseFeaturePCA
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	/** The number of full features per pose */
+	UPROPERTY()
+	int32 FeatureCount;
+
+	/** The number of principal components kept */
+	UPROPERTY(VisibleAnywhere, Category = "PCA")
+	int32 Dimensions;
+
+	/** The fraction of the feature variance explained by the kept components */
+	UPROPERTY(VisibleAnywhere, Category = "PCA")
+	float RetainedVariance;
+
+	/** The fraction of sampled queries where the nearest pose in the reduced space was also the nearest in the full 
+	feature space. The runtime search always re-ranks with the exact cost so this only indicates pre-filter efficiency. */
+	UPROPERTY(VisibleAnywhere, Category = "PCA")
+	float TopOneAgreement;
+
+	/** The scale of each feature column which normalises it by its standard deviation (0 for constant columns) */
+	UPROPERTY()
+	TArray<float> FeatureScales;
+
+	/** The mean of each normalised feature column */
+	UPROPERTY()
+	TArray<float> Mean;
+
+	/** The kept principal components (Dimensions x FeatureCount, row major) */
+	UPROPERTY()
+	TArray<float> Basis;
+
+	/** The ids of the poses in this set */
+	UPROPERTY()
+	TArray<int32> PoseIds;
+
+	/** The projected coordinates of each pose in PoseIds (PoseIds.Num() x Dimensions, row major) */
+	UPROPERTY()
+	TArray<float> Coordinates;
+
+public:
+	FPoseFeaturePCA();
+
+	bool IsValid() const;
+
+	/** Builds the basis from the passed poses. Components are kept until TargetVariance is explained or MaxDimensions is reached */
+	void Build(const UMotionDataAsset* InMotionData, const TArray<int32>& InPoseIds, const FCalibrationData& StdDeviationNormalizers,
+		const float TargetVariance, const int32 MaxDimensions);
+
+	/** Projects a set of query features into the reduced space. OutCoordinates must have room for 'Dimensions' values. 
+	Returns false if the feature layout doesn't match the basis. */
+	bool Project(const FVector& LocalVelocity, const TArray<FJointData>& JointData, 
+		const TArray<FTrajectoryPoint>& Trajectory, float* OutCoordinates) const;
+
+	/** The smallest ratio of the passed calibration's squared distance weights to the squared feature scales. Multiplying 
+	the squared distance in the reduced space by this gives a lower bound of the squared distance part of the search cost */
+	float GetLowerBoundScale(const FCalibrationData& Calibration, const float PoseMultiplier, const float TrajectoryMultiplier) const;
+
+	static int32 GetFeatureCount(const int32 JointCount, const int32 TrajectoryCount);
+
+private:
+	void GatherFeatures(const FVector& LocalVelocity, const TArray<FJointData>& JointData,
+		const TArray<FTrajectoryPoint>& Trajectory, float* OutFeatures) const;
+};
@@ -25,6 +25,9 @@ public:
 
 	void MakeRelativeTo(FTransform a_transform);
 
+	/** Sets the facing direction of every point from its RotationZ (e.g. after the points were set from blueprint) */
+	void UpdateFacings();
+
 	void SetTrajectoryPoint(const int32 Index, const FVector InPosition, const float InRotationZ);
 	void AddTrajectoryPoint(const FVector InPosition, const float InRotationZ);
 	int32 TrajectoryPointCount() const;
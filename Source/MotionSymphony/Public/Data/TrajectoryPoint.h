@@ -17,10 +17,20 @@ public:
 	UPROPERTY(BlueprintReadWrite, Category = "TrajectoryPoint")
 	float RotationZ;
 
+	/** The facing (RotationZ) as a unit direction in the XY plane. Facings are compared with a squared distance between 
+	these directions rather than an angle difference so that the trajectory cost is Euclidean and has no wrapping. */
+	UPROPERTY()
+	FVector2D Facing;
+
 public:
 	FTrajectoryPoint();
 	FTrajectoryPoint(FVector a_position, float a_rotationX);
 
+	/** Sets the facing direction from RotationZ. Must be called after RotationZ is set directly */
+	void UpdateFacing();
+
+	static FVector2D GetFacingDirection(const float InRotationZ);
+
 	static void Lerp(FTrajectoryPoint& o_result, FTrajectoryPoint& a_from, 
 		FTrajectoryPoint& a_to, float a_progress);
 
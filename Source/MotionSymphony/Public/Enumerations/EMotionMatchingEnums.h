@@ -20,6 +20,18 @@ enum class EPoseMatchMethod : uint8
 {
 	Optimized,
 	Linear,
+	PCAPrefiltered
+};
+
+/** The groups of features that make up the cost of a pose in a motion matching search */
+UENUM()
+enum class EMotionFeatureGroup : uint8
+{
+	Momentum,
+	AngularMomentum,
+	Trajectory,
+	Joints,
+	Count UMETA(Hidden)
 };
 
 /** An enumeration for the blend status of any given motion matching animation channel */
@@ -38,7 +50,8 @@ enum class ETransitionMethod : uint8
 {
 	None,
 	Inertialization,
-	Blend
+	Blend,
+	OffsetInertialization
 };
 
 /** An enumeration for the different methods of determining past trajectory for motion matching */
@@ -0,0 +1,45 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FPrimitiveDrawInterface;
+class FSceneView;
+
+/** A cached buffer of debug geometry which is built once and then submitted every frame with a single line reservation.
+Geometry is either plain lines, which are always drawn, or polylines with an anchor point. Polylines whose anchors fall
+into the same screen space cell are collapsed into a single aggregated point so that dense pose clouds stay cheap to draw. */
+struct MOTIONSYMPHONY_API FMotionDebugDrawBatch
+{
+private:
+	struct FPolyline
+	{
+		FVector Anchor;
+		FLinearColor Color;
+		int32 FirstVertex;
+		int32 VertexCount;
+	};
+
+	TArray<FVector> LineVertices;
+	TArray<FLinearColor> LineColors;
+
+	TArray<FVector> PolylineVertices;
+	TArray<FPolyline> Polylines;
+
+public:
+	void Reset();
+	bool IsEmpty() const;
+
+	void AddLine(const FVector& Start, const FVector& End, const FLinearColor& Color);
+	void AddWireSphere(const FVector& Center, const float Radius, const int32 Segments, const FLinearColor& Color);
+	void AddArrow(const FVector& Start, const FVector& End, const float ArrowSize, const FLinearColor& Color);
+
+	/** Adds a polyline which can be collapsed by screen space LOD. The last point is used as its anchor */
+	void AddPolyline(const TArray<FVector>& Points, const FLinearColor& Color);
+
+	/** Submits the batch. Polylines are collapsed to aggregated points per LODCellSize pixel cell when a view is passed 
+	and LODCellSize is greater than zero. */
+	void Draw(FPrimitiveDrawInterface* DrawInterface, const FSceneView* View, const FTransform& Transform, 
+		const float Thickness, const uint8 DepthPriority, const float LODCellSize = 0.0f) const;
+};
@@ -0,0 +1,45 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BonePose.h"
+
+/** Offset based inertialization for the motion matching node. When a transition is requested, the offset between the 
+last output pose and the new source pose is stored per bone. This offset is then decayed towards zero with a critically
+damped spring. Only the new source pose ever needs to be evaluated, no matter how often the node transitions. */
+class MOTIONSYMPHONY_API FMotionMatchingOffsetInertializer
+{
+private:
+	struct FBoneOffset
+	{
+		FVector Position;
+		FVector Velocity;
+		FVector Rotation; //Axis * Angle
+		FVector AngularVelocity;
+
+		FBoneOffset();
+	};
+
+	/** Offsets and last output transforms are indexed by skeleton bone index so that they survive LOD changes */
+	TArray<FBoneOffset> Offsets;
+	TArray<FTransform> LastOutputPose;
+	TBitArray<> LastOutputValid;
+
+	float PendingDeltaTime;
+	bool bPendingTransition;
+
+public:
+	FMotionMatchingOffsetInertializer();
+
+	void Reset();
+	void RequestTransition();
+	void Update(const float DeltaTime);
+
+	/** Captures new offsets if a transition has been requested, decays the offsets by the time updated since the last call
+	and applies them to the passed source pose */
+	void Apply(FCompactPose& InOutPose, const float HalfLife);
+
+private:
+	static void DecaySpring(FVector& InOutOffset, FVector& InOutVelocity, const float HalfLife, const float DeltaTime);
+};
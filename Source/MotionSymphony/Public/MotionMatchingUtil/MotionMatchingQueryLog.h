@@ -0,0 +1,77 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraph/AnimNode_MotionMatching.h"
+
+class UMotionDataAsset;
+class UMotionCalibration;
+
+/** A single recorded motion matching search. The query's calibration and required traits are resolved from the
+log's calibration table via the calibration id. The pose mask is not recorded as it can be rebuilt from the traits. */
+struct MOTIONSYMPHONY_API FMotionMatchingQueryRecord
+{
+public:
+	int32 CalibrationId;
+	int32 CurrentPoseId;
+	int32 ChosenPoseId;
+	float ChosenCost;
+	FMotionMatchingSearchQuery Query;
+
+public:
+	FMotionMatchingQueryRecord();
+};
+
+/** A binary log of motion matching searches that can be replayed offline against a motion data asset. The log starts
+with a header (magic, version, motion data and calibration paths) followed by a stream of chunks. Calibration chunks
+are written the first time a calibration is used and each search chunk references one by id. */
+struct MOTIONSYMPHONY_API FMotionMatchingQueryLog
+{
+public:
+	static const uint32 Magic;
+	static const uint32 Version;
+
+	enum class EChunkType : uint8
+	{
+		Calibration,
+		Search
+	};
+
+	FString MotionDataPath;
+	FString CalibrationPath;
+	TArray<FMotionTraitField> CalibrationTraits;
+	TArray<FCalibrationData> Calibrations;
+	TArray<FMotionMatchingQueryRecord> Records;
+
+public:
+	/** Loads a query log. Returns false if the file could not be opened or is not a compatible query log */
+	bool Load(const FString& FileName);
+
+	/** Makes a unique log file name in the profiling directory for the passed motion data */
+	static FString MakeLogFileName(const UMotionDataAsset* InMotionData);
+
+	static void SerializeCalibration(FArchive& Ar, FCalibrationData& Calibration);
+	static void SerializeTraits(FArchive& Ar, FMotionTraitField& Traits);
+	static void SerializeQuery(FArchive& Ar, FMotionMatchingSearchQuery& Query);
+};
+
+/** Writes motion matching searches to a query log as they happen */
+class MOTIONSYMPHONY_API FMotionMatchingQueryRecorder
+{
+private:
+	TUniquePtr<FArchive> Writer;
+	TMap<FMotionTraitField, int32> CalibrationIds;
+	int32 CalibrationCount;
+
+public:
+	FMotionMatchingQueryRecorder(const FString& FileName, const UMotionDataAsset* InMotionData, const UMotionCalibration* InCalibration);
+	~FMotionMatchingQueryRecorder();
+
+	bool IsOpen() const;
+
+	/** Must be called when the node's final calibrations are rebuilt so that new calibration chunks are written */
+	void InvalidateCalibrations();
+
+	void Record(const FMotionMatchingSearchQuery& Query, const int32 CurrentPoseId, const int32 ChosenPoseId, const float ChosenCost);
+};
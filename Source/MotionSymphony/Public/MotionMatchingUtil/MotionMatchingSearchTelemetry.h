@@ -0,0 +1,109 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+
+class UMotionDataAsset;
+struct FMotionMatchingSearchStats;
+
+/** The cost of a single pose against a search query split by feature group */
+struct MOTIONSYMPHONY_API FMotionMatchingCostBreakdown
+{
+public:
+	float Momentum;
+	float AngularMomentum;
+	float Trajectory;
+	float Joints;
+	float FavourMultiplier;
+	float Total;
+
+public:
+	FMotionMatchingCostBreakdown();
+
+	FORCEINLINE float GetUnfavouredCost() const { return Momentum + AngularMomentum + Trajectory + Joints; }
+};
+
+/** A fixed size histogram with linear buckets over [Min, Max]. Values outside the range fall into the end buckets */
+struct MOTIONSYMPHONY_API FMotionMatchingTelemetryHistogram
+{
+public:
+	static constexpr int32 BucketCount = 20;
+
+	float Min;
+	float Max;
+	uint32 Buckets[BucketCount];
+	uint32 Count;
+	double Sum;
+
+public:
+	FMotionMatchingTelemetryHistogram();
+	FMotionMatchingTelemetryHistogram(const float InMin, const float InMax);
+
+	void Add(const float Value);
+	void Reset();
+	FString ToString() const;
+};
+
+/** Aggregated search telemetry for a single motion database */
+struct MOTIONSYMPHONY_API FMotionMatchingDatabaseTelemetry
+{
+public:
+	FString DatabaseName;
+
+	/** The share of the winning pose's (un-favoured) cost contributed by each feature group */
+	FMotionMatchingTelemetryHistogram MomentumShare;
+	FMotionMatchingTelemetryHistogram AngularMomentumShare;
+	FMotionMatchingTelemetryHistogram TrajectoryShare;
+	FMotionMatchingTelemetryHistogram JointShare;
+
+	/** The favour multiplier applied to the winning pose */
+	FMotionMatchingTelemetryHistogram FavourMultiplier;
+
+	/** The gap between the best and second best cost relative to the best cost */
+	FMotionMatchingTelemetryHistogram RunnerUpGap;
+
+	uint32 SearchCount;
+	uint32 JumpCount;
+	uint32 ContinuationCount;
+	uint32 ToleranceSkipCount;
+
+	/** Candidates rejected by an early out and the feature groups costed for them before they were rejected */
+	uint64 RejectedCount;
+	uint64 RejectedGroupCount;
+
+public:
+	FMotionMatchingDatabaseTelemetry();
+
+	void Reset();
+};
+
+/** Opt-in motion matching search telemetry (a.AnimNode.MoSymph.MMSearch.Telemetry). Searches are aggregated per motion
+ * database into fixed size histograms so that recording does not allocate once a database has been seen. Per frame totals
+ * are exported to the CSV profiler (category 'MotionMatching') and the histograms can be logged with the
+ * a.AnimNode.MoSymph.MMSearch.TelemetryDump console command. */
+class MOTIONSYMPHONY_API FMotionMatchingSearchTelemetry
+{
+private:
+	TMap<FObjectKey, FMotionMatchingDatabaseTelemetry> Databases;
+	mutable FCriticalSection DatabasesCriticalSection;
+
+public:
+	static FMotionMatchingSearchTelemetry& Get();
+	static bool IsEnabled();
+
+	/** Records the result of a search. A negative runner up cost means that it was not tracked */
+	void RecordSearch(const UMotionDataAsset* InMotionData, const FMotionMatchingCostBreakdown& WinnerCost, const float RunnerUpCost);
+	void RecordOutcome(const UMotionDataAsset* InMotionData, const bool bJumped);
+	void RecordToleranceSkip(const UMotionDataAsset* InMotionData);
+
+	/** Records the pruning of a search. A multi-database search is recorded against the primary database */
+	void RecordSearchStats(const UMotionDataAsset* InMotionData, const FMotionMatchingSearchStats& SearchStats);
+
+	void Dump() const;
+	void Reset();
+
+private:
+	FMotionMatchingDatabaseTelemetry& FindOrAddDatabase(const UMotionDataAsset* InMotionData);
+};
@@ -34,6 +34,9 @@ public:
 	static float ComputePoseCost(const TArray<FJointData>& Current,
 		const TArray<FJointData>& Candidate, const FCalibrationData& Calibration);
 
+	/** The un-favoured search cost between two database poses, i.e. the cost of 'Candidate' if 'Current' were the query */
+	static float ComputePoseDistance(const FPoseMotionData& Current, const FPoseMotionData& Candidate, const FCalibrationData& Calibration);
+
 	static inline float LerpAngle(float AngleA, float AngleB, float Progress)
 	{
 		const float Max = PI * 2.0f;
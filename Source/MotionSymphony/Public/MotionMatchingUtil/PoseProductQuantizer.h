@@ -0,0 +1,59 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PoseProductQuantizer.generated.h"
+
+/** Product quantisation of a set of feature vectors. The feature columns are split into contiguous sub-spaces which each
+have a small codebook trained with k-means. Each item is then stored as one byte code per sub-space. Squared distances from
+a query to every item are approximated by summing per sub-space lookups into a distance table built once per query. */
+USTRUCT()
+struct MOTIONSYMPHONY_API FPoseProductQuantizer
+{
+	GENERATED_USTRUCT_BODY()
+
+public:
+	UPROPERTY()
+	int32 FeatureCount;
+
+	UPROPERTY()
+	int32 CentroidCount;
+
+	/** The first feature column of each sub-space with a final entry of FeatureCount */
+	UPROPERTY()
+	TArray<int32> SubspaceOffsets;
+
+	/** The centroids of each sub-space. For sub-space m, centroid c starts at (SubspaceOffsets[m] * CentroidCount) + (c * SubspaceWidth) */
+	UPROPERTY()
+	TArray<float> Codebooks;
+
+	/** One code per sub-space for each item (ItemCount x SubspaceCount, row major) */
+	UPROPERTY()
+	TArray<uint8> Codes;
+
+	UPROPERTY()
+	int32 ItemCount;
+
+public:
+	FPoseProductQuantizer();
+
+	FORCEINLINE int32 GetSubspaceCount() const { return FMath::Max(0, SubspaceOffsets.Num() - 1); }
+	bool IsValid() const;
+
+	/** Trains the codebooks and encodes the features (InItemCount x InFeatureCount, row major). Training is deterministic. 
+	Only up to TrainingSampleLimit evenly spaced items are used to train the codebooks but all items are encoded. */
+	void Train(const TArray<float>& Features, const int32 InItemCount, const int32 InFeatureCount, const int32 SubspaceCount, 
+		const int32 InCentroidCount, const int32 Iterations, const int32 TrainingSampleLimit);
+
+	/** Builds the asymmetric distance table for a query. Each feature column's squared difference is scaled by its weight */
+	void ComputeDistanceTable(const float* Query, const float* ColumnWeights, TArray<float>& OutTable) const;
+
+	/** Scans the codes and outputs the indices of the K items with the lowest approximate distance, nearest first */
+	void FindNearest(const TArray<float>& DistanceTable, const int32 K, TArray<int32>& OutItems) const;
+
+	int64 GetAllocatedSize() const;
+
+private:
+	int32 FindNearestCentroid(const int32 Subspace, const float* SubFeatures) const;
+};
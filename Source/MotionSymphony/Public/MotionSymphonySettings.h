@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Data/MotionTraitField.h"
 #include "MotionSymphonySettings.generated.h"
 
 UCLASS(config = Game, defaultconfig)
@@ -18,5 +19,25 @@ public:
 
 	//UPROPERTY(EditAnywhere, config, Category = "Actions")
 	TArray<FString> ActionNames;
-};
 
+private:
+	/** Cached lookup from trait name to trait bit position. Rebuilt whenever the trait names change */
+	TMap<FString, int32> TraitNameLookup;
+
+public:
+	/** Returns the bit position of the named trait or INDEX_NONE if the trait does not exist or is out of range */
+	int32 GetTraitPosition(const FString& TraitName) const;
+
+	/** Returns a trait field with the named trait set or an empty trait field if the trait does not exist */
+	FMotionTraitField GetTraitHandle(const FString& TraitName) const;
+
+	void RebuildTraitNameLookup();
+
+	/** UObject Interface*/
+	virtual void PostInitProperties() override;
+	virtual void PostReloadConfig(FProperty* PropertyThatWasLoaded) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	/** End UObject Interface*/
+};
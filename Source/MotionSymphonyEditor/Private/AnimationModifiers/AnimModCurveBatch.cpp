@@ -0,0 +1,522 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "AnimationModifiers/AnimModCurveBatch.h"
+#include "AnimationModifiers/AnimMod_SpeedCurve.h"
+#include "AnimationModifiers/AnimMod_RootMotionCurves.h"
+#include "AnimationModifiers/AnimMod_RootYawCurve.h"
+#include "AnimationModifiers/AnimMod_DistanceMatching.h"
+#include "AnimationModifiers/AnimMod_RotationMatching.h"
+#include "AnimationBlueprintLibrary.h"
+#include "Animation/AnimSequence.h"
+#include "Async/ParallelFor.h"
+#include "Misc/ScopedSlowTask.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/ObjectKey.h"
+
+#define LOCTEXT_NAMESPACE "AnimModCurveBatch"
+
+namespace AnimModCurveBatch
+{
+	typedef TTuple<FObjectKey, ERootMotionSampling> FTrackKey;
+
+	FCriticalSection CacheCriticalSection;
+	TMap<FTrackKey, TSharedRef<const FRootMotionTrack>> TrackCache;
+	int32 ActiveScopeCount = 0;
+}
+
+FRootMotionTrack::FRootMotionTrack()
+	: Interval(0.0f)
+{
+}
+
+void FRootMotionTrack::Extract(const UAnimSequence* Sequence, const ERootMotionSampling Sampling)
+{
+	if (!Sequence)
+	{
+		Interval = 0.0f;
+		Times.Empty();
+		Deltas.Empty();
+		return;
+	}
+
+#if ENGINE_MAJOR_VERSION < 5
+	const int32 NumSampleFrames = Sequence->GetNumberOfFrames();
+	const float FrameRate = Sequence->GetFrameRate();
+#else
+	const int32 NumSampleFrames = Sequence->GetNumberOfSampledKeys();
+	const float FrameRate = Sequence->GetSamplingFrameRate().AsDecimal();
+#endif
+
+	Sample(Sequence->GetPlayLength(), NumSampleFrames, FrameRate, Sampling, [Sequence](float StartTime, float DeltaTime)
+	{
+		return Sequence->ExtractRootMotion(StartTime, DeltaTime, false);
+	});
+}
+
+void FRootMotionTrack::Sample(const float PlayLength, const int32 NumSampleFrames, const float FrameRate, const ERootMotionSampling Sampling,
+	TFunctionRef<FTransform(float StartTime, float DeltaTime)> ExtractRootMotion)
+{
+	Interval = 0.0f;
+	Times.Empty();
+	Deltas.Empty();
+
+	if (Sampling == ERootMotionSampling::KeyRate)
+	{
+		//Only sample at 30Hz to avoid unnecessary keys. Time is accumulated the same way the modifiers always have
+		Interval = 1.0f / 30.0f;
+
+		const int32 ExpectedCount = FMath::CeilToInt(PlayLength / Interval) + 1;
+		Times.Reserve(ExpectedCount);
+		Deltas.Reserve(ExpectedCount);
+
+		for (float Time = 0.0f; Time < PlayLength; Time += Interval)
+		{
+			Times.Add(Time);
+			Deltas.Add(ExtractRootMotion(Time, Interval));
+		}
+	}
+	else
+	{
+		if (FrameRate <= 0.0f)
+		{
+			return;
+		}
+
+		//The last frame has no interval following it
+		Interval = 1.0f / FrameRate;
+		Times.Reserve(NumSampleFrames);
+		Deltas.Reserve(NumSampleFrames);
+
+		for (int32 Frame = 0; Frame < NumSampleFrames - 1; ++Frame)
+		{
+			const float Time = Interval * Frame;
+			Times.Add(Time);
+			Deltas.Add(ExtractRootMotion(Time, Interval));
+		}
+	}
+}
+
+FAnimCurveSource::FAnimCurveSource()
+	: FrameRate(0.0f),
+	DistanceMarkerTime(0.0f)
+{
+}
+
+FAnimCurveSource::FAnimCurveSource(const UAnimSequence* Sequence)
+	: FrameRate(0.0f),
+	DistanceMarkerTime(0.0f)
+{
+	if (!Sequence)
+	{
+		return;
+	}
+
+#if ENGINE_MAJOR_VERSION < 5
+	FrameRate = Sequence->GetFrameRate();
+#else
+	FrameRate = Sequence->GetSamplingFrameRate().AsDecimal();
+#endif
+
+	//Find the Distance Matching Notify and record the time that it sits at
+	const FName DistanceMarkerName = FName(TEXT("DistanceMarker"));
+	for (const FAnimNotifyEvent& NotifyEvent : Sequence->Notifies)
+	{
+		if (NotifyEvent.NotifyName == DistanceMarkerName)
+		{
+			DistanceMarkerTime = NotifyEvent.GetTriggerTime();
+			break;
+		}
+	}
+}
+
+FAnimCurveKeys::FAnimCurveKeys(const FName InCurveName, const int32 ExpectedKeyCount)
+	: CurveName(InCurveName)
+{
+	Times.Reserve(ExpectedKeyCount);
+	Values.Reserve(ExpectedKeyCount);
+}
+
+void FAnimCurveKeys::Add(const float Time, const float Value)
+{
+	Times.Add(Time);
+	Values.Add(Value);
+}
+
+void FAnimCurveKeys::Write(UAnimSequence* Sequence) const
+{
+	if (!Sequence)
+	{
+		return;
+	}
+
+	if (UAnimationBlueprintLibrary::DoesCurveExist(Sequence, CurveName, ERawCurveTrackTypes::RCT_Float))
+	{
+		UAnimationBlueprintLibrary::RemoveCurve(Sequence, CurveName, false);
+	}
+
+	UAnimationBlueprintLibrary::AddCurve(Sequence, CurveName, ERawCurveTrackTypes::RCT_Float, false);
+
+	if (Times.Num() > 0)
+	{
+		UAnimationBlueprintLibrary::AddFloatCurveKeys(Sequence, CurveName, Times, Values);
+	}
+}
+
+FAnimModCurveBatch::FScope::FScope()
+{
+	FScopeLock Lock(&AnimModCurveBatch::CacheCriticalSection);
+	++AnimModCurveBatch::ActiveScopeCount;
+}
+
+FAnimModCurveBatch::FScope::~FScope()
+{
+	FScopeLock Lock(&AnimModCurveBatch::CacheCriticalSection);
+
+	//Tracks are never kept beyond a batch as the sequences may be edited afterwards
+	if (--AnimModCurveBatch::ActiveScopeCount == 0)
+	{
+		AnimModCurveBatch::TrackCache.Empty();
+	}
+}
+
+TSharedRef<const FRootMotionTrack> FAnimModCurveBatch::GetRootMotionTrack(const UAnimSequence* Sequence, const ERootMotionSampling Sampling)
+{
+	const AnimModCurveBatch::FTrackKey TrackKey(FObjectKey(Sequence), Sampling);
+
+	{
+		FScopeLock Lock(&AnimModCurveBatch::CacheCriticalSection);
+
+		if (const TSharedRef<const FRootMotionTrack>* CachedTrack = AnimModCurveBatch::TrackCache.Find(TrackKey))
+		{
+			return *CachedTrack;
+		}
+	}
+
+	TSharedRef<FRootMotionTrack> Track = MakeShared<FRootMotionTrack>();
+	Track->Extract(Sequence, Sampling);
+
+	FScopeLock Lock(&AnimModCurveBatch::CacheCriticalSection);
+	if (AnimModCurveBatch::ActiveScopeCount > 0)
+	{
+		AnimModCurveBatch::TrackCache.Add(TrackKey, Track);
+	}
+
+	return Track;
+}
+
+void FAnimModCurveBatch::ApplyModifiers(const TArray<UAnimSequence*>& Sequences, const TArray<UClass*>& ModifierClasses)
+{
+	FScope BatchScope;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	//Curve modifiers are generated from the root motion tracks in parallel. Any other modifier is applied as usual
+	TArray<UClass*> KnownCurveModifierClasses;
+	GetCurveModifierClasses(KnownCurveModifierClasses);
+
+	TArray<const UClass*> CurveModifierClasses;
+	TArray<ERootMotionSampling> CurveModifierSamplings;
+	TArray<UAnimationModifier*> Modifiers;
+	for (UClass* ModifierClass : ModifierClasses)
+	{
+		if (!ModifierClass || !ModifierClass->IsChildOf(UAnimationModifier::StaticClass())
+			|| ModifierClass->HasAnyClassFlags(CLASS_Abstract))
+		{
+			continue;
+		}
+
+		ERootMotionSampling Sampling;
+		if (KnownCurveModifierClasses.Contains(ModifierClass) && GetModifierSampling(ModifierClass, Sampling))
+		{
+			CurveModifierClasses.Add(ModifierClass);
+			CurveModifierSamplings.Add(Sampling);
+		}
+		else
+		{
+			Modifiers.Add(NewObject<UAnimationModifier>(GetTransientPackage(), ModifierClass));
+		}
+	}
+
+	struct FSequenceCurves
+	{
+		UAnimSequence* Sequence;
+		FAnimCurveSource Source;
+		TArray<TSharedRef<const FRootMotionTrack>> Tracks;
+		TArray<FAnimCurveKeys> CurveKeys;
+
+		FSequenceCurves(UAnimSequence* InSequence)
+			: Sequence(InSequence),
+			Source(InSequence)
+		{
+		}
+	};
+
+	FScopedSlowTask ApplyTask(Sequences.Num() * 2, LOCTEXT("ApplyingModifiers", "Generating Animation Curves..."));
+	ApplyTask.MakeDialog();
+
+	//Root motion extraction reads the sequences' animation data, which isn't safe off the game thread. Each track is only
+	//extracted once regardless of how many modifiers read it and is cached for the other modifiers
+	TArray<FSequenceCurves> SequenceCurves;
+	SequenceCurves.Reserve(Sequences.Num());
+	for (UAnimSequence* Sequence : Sequences)
+	{
+		ApplyTask.EnterProgressFrame();
+
+		if (!Sequence)
+		{
+			continue;
+		}
+
+		FSequenceCurves& Curves = SequenceCurves.Emplace_GetRef(Sequence);
+		for (const ERootMotionSampling Sampling : CurveModifierSamplings)
+		{
+			Curves.Tracks.Add(GetRootMotionTrack(Sequence, Sampling));
+		}
+	}
+
+	const double ExtractEndTime = FPlatformTime::Seconds();
+
+	//Generating keys only reads the tracks and curve sources so it is safe to run in parallel
+	ParallelFor(SequenceCurves.Num(), [&](const int32 SequenceIndex)
+	{
+		FSequenceCurves& Curves = SequenceCurves[SequenceIndex];
+		for (int32 ModifierIndex = 0; ModifierIndex < CurveModifierClasses.Num(); ++ModifierIndex)
+		{
+			GenerateCurveKeys(CurveModifierClasses[ModifierIndex], *Curves.Tracks[ModifierIndex], Curves.Source, Curves.CurveKeys);
+		}
+	});
+
+	const double GenerateEndTime = FPlatformTime::Seconds();
+
+	//Curves are written on the game thread as they modify the sequences (and may add curve names to the skeleton)
+	for (FSequenceCurves& Curves : SequenceCurves)
+	{
+		ApplyTask.EnterProgressFrame();
+
+		Curves.Sequence->Modify();
+
+		for (const FAnimCurveKeys& Keys : Curves.CurveKeys)
+		{
+			Keys.Write(Curves.Sequence);
+		}
+
+		for (UAnimationModifier* Modifier : Modifiers)
+		{
+			Modifier->OnApply(Curves.Sequence);
+		}
+
+		Curves.Sequence->MarkPackageDirty();
+	}
+
+	const double EndTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogTemp, Log, TEXT("Applied %d animation modifiers to %d sequences in %.2fs (root motion extracted in %.2fs, curve keys generated in %.2fs)."),
+		CurveModifierClasses.Num() + Modifiers.Num(), SequenceCurves.Num(), EndTime - StartTime, ExtractEndTime - StartTime, GenerateEndTime - ExtractEndTime);
+}
+
+bool FAnimModCurveBatch::GenerateCurveKeys(const UClass* ModifierClass, const FRootMotionTrack& RootMotion,
+	const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys)
+{
+	if (ModifierClass == UAnimMod_SpeedCurve::StaticClass())
+	{
+		UAnimMod_SpeedCurve::GenerateCurveKeys(RootMotion, Source, OutCurveKeys);
+	}
+	else if (ModifierClass == UAnimMod_RootMotionCurves::StaticClass())
+	{
+		UAnimMod_RootMotionCurves::GenerateCurveKeys(RootMotion, Source, OutCurveKeys);
+	}
+	else if (ModifierClass == UAnimMod_RootYawCurve::StaticClass())
+	{
+		UAnimMod_RootYawCurve::GenerateCurveKeys(RootMotion, Source, OutCurveKeys);
+	}
+	else if (ModifierClass == UAnimMod_DistanceMatching::StaticClass())
+	{
+		UAnimMod_DistanceMatching::GenerateCurveKeys(RootMotion, Source, OutCurveKeys);
+	}
+	else if (ModifierClass == UAnimMod_RotationMatching::StaticClass())
+	{
+		UAnimMod_RotationMatching::GenerateCurveKeys(RootMotion, Source, OutCurveKeys);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool FAnimModCurveBatch::GetModifierSampling(const UClass* ModifierClass, ERootMotionSampling& OutSampling)
+{
+	if (!ModifierClass)
+	{
+		return false;
+	}
+
+	if (ModifierClass->IsChildOf(UAnimMod_SpeedCurve::StaticClass())
+		|| ModifierClass->IsChildOf(UAnimMod_RootMotionCurves::StaticClass())
+		|| ModifierClass->IsChildOf(UAnimMod_RootYawCurve::StaticClass()))
+	{
+		OutSampling = ERootMotionSampling::KeyRate;
+		return true;
+	}
+
+	if (ModifierClass->IsChildOf(UAnimMod_DistanceMatching::StaticClass())
+		|| ModifierClass->IsChildOf(UAnimMod_RotationMatching::StaticClass()))
+	{
+		OutSampling = ERootMotionSampling::Frame;
+		return true;
+	}
+
+	return false;
+}
+
+void FAnimModCurveBatch::GetCurveModifierClasses(TArray<UClass*>& OutModifierClasses)
+{
+	OutModifierClasses.Add(UAnimMod_SpeedCurve::StaticClass());
+	OutModifierClasses.Add(UAnimMod_RootMotionCurves::StaticClass());
+	OutModifierClasses.Add(UAnimMod_RootYawCurve::StaticClass());
+	OutModifierClasses.Add(UAnimMod_DistanceMatching::StaticClass());
+	OutModifierClasses.Add(UAnimMod_RotationMatching::StaticClass());
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAnimModCurveBatchTest, "MotionSymphony.Editor.AnimModifiers.BatchedCurves",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FAnimModCurveBatchTest::RunTest(const FString& Parameters)
+{
+	const float PlayLength = 2.5f;
+	const float FrameRate = 30.0f;
+	const int32 NumSampleFrames = 76;
+	const float MarkerTime = 1.2f;
+
+	//A synthetic root path that moves forward, sways, bobs and turns so that every curve has varying keys
+	auto GetRootTransform = [](const float Time)
+	{
+		return FTransform(FRotator(0.0f, 40.0f * Time + 10.0f * FMath::Sin(3.0f * Time), 0.0f),
+			FVector(150.0f * Time, 30.0f * FMath::Sin(2.0f * Time), 5.0f * FMath::Sin(6.0f * Time)));
+	};
+
+	auto ExtractRootMotion = [&GetRootTransform](float StartTime, float DeltaTime)
+	{
+		return GetRootTransform(StartTime + DeltaTime).GetRelativeTransform(GetRootTransform(StartTime));
+	};
+
+	//Batched curve generation
+	FAnimCurveSource Source;
+	Source.FrameRate = FrameRate;
+	Source.DistanceMarkerTime = MarkerTime;
+
+	FRootMotionTrack KeyRateTrack;
+	FRootMotionTrack FrameTrack;
+	KeyRateTrack.Sample(PlayLength, NumSampleFrames, FrameRate, ERootMotionSampling::KeyRate, ExtractRootMotion);
+	FrameTrack.Sample(PlayLength, NumSampleFrames, FrameRate, ERootMotionSampling::Frame, ExtractRootMotion);
+
+	TArray<UClass*> ModifierClasses;
+	FAnimModCurveBatch::GetCurveModifierClasses(ModifierClasses);
+
+	TArray<FAnimCurveKeys> BatchedKeys;
+	for (const UClass* ModifierClass : ModifierClasses)
+	{
+		ERootMotionSampling Sampling = ERootMotionSampling::KeyRate;
+		FAnimModCurveBatch::GetModifierSampling(ModifierClass, Sampling);
+		FAnimModCurveBatch::GenerateCurveKeys(ModifierClass, Sampling == ERootMotionSampling::KeyRate ? KeyRateTrack : FrameTrack,
+			Source, BatchedKeys);
+	}
+
+	//The previous modifiers, which extracted root motion for each key, in the same curve order
+	const float KeyRate = 1.0f / 30.0f;
+	const float HalfKeyRate = KeyRate * 0.5f;
+
+	FAnimCurveKeys SpeedKeys(FName(TEXT("Speed")));
+	FAnimCurveKeys MoveXKeys(FName(TEXT("RootVelocity_X")));
+	FAnimCurveKeys MoveYKeys(FName(TEXT("RootVelocity_Y")));
+	FAnimCurveKeys MoveZKeys(FName(TEXT("RootVelocity_Z")));
+	FAnimCurveKeys YawKeys(FName(TEXT("RootVelocity_Yaw")));
+	for (float Time = 0.0f; Time < PlayLength; Time += KeyRate)
+	{
+		const float KeyTime = Time + HalfKeyRate;
+		const FTransform RootMotion = ExtractRootMotion(Time, KeyRate);
+		const FVector MoveVelocity = RootMotion.GetLocation() / KeyRate;
+
+		SpeedKeys.Add(KeyTime, RootMotion.GetLocation().Size() / KeyRate);
+		MoveXKeys.Add(KeyTime, MoveVelocity.X);
+		MoveYKeys.Add(KeyTime, MoveVelocity.Y);
+		MoveZKeys.Add(KeyTime, MoveVelocity.Z);
+		YawKeys.Add(KeyTime, RootMotion.Rotator().Yaw / KeyRate);
+	}
+
+	const float FrameDelta = 1.0f / FrameRate;
+	const int32 MarkerFrame = (int32)FMath::RoundHalfToZero(FrameRate * MarkerTime);
+
+	FAnimCurveKeys DistanceKeys(FName(TEXT("MoSymph_Distance")));
+	FAnimCurveKeys RotationKeys(FName(TEXT("MoSymph_Rotation")));
+	DistanceKeys.Add(FrameDelta * MarkerFrame, 0.0f);
+	RotationKeys.Add(FrameDelta * MarkerFrame, 0.0f);
+
+	float CumDistance = 0.0f;
+	float CumRotation = 0.0f;
+	for (int32 i = 1; i < MarkerFrame; ++i)
+	{
+		const float StartTime = FrameDelta * (MarkerFrame - i);
+		const FTransform RootMotion = ExtractRootMotion(StartTime, FrameDelta);
+		const FVector MoveDelta = FVector(RootMotion.GetLocation().X, RootMotion.GetLocation().Y, 0.0f);
+
+		CumDistance += MoveDelta.Size();
+		CumRotation += FMath::Abs(RootMotion.Rotator().Yaw);
+
+		DistanceKeys.Add(StartTime, CumDistance);
+		RotationKeys.Add(StartTime, CumRotation);
+	}
+
+	CumDistance = 0.0f;
+	CumRotation = 0.0f;
+	for (int32 i = MarkerFrame + 1; i < NumSampleFrames; ++i)
+	{
+		const float StartTime = FrameDelta * i;
+		const FTransform RootMotion = ExtractRootMotion(StartTime - FrameDelta, FrameDelta);
+		const FVector MoveDelta = FVector(RootMotion.GetLocation().X, RootMotion.GetLocation().Y, 0.0f);
+
+		CumDistance -= MoveDelta.Size();
+		CumRotation -= FMath::Abs(RootMotion.Rotator().Yaw);
+
+		DistanceKeys.Add(StartTime, CumDistance);
+		RotationKeys.Add(StartTime, CumRotation);
+	}
+
+	const TArray<FAnimCurveKeys> ReferenceKeys = { SpeedKeys, MoveXKeys, MoveYKeys, MoveZKeys, YawKeys, YawKeys, DistanceKeys, RotationKeys };
+
+	TestEqual(TEXT("Curve count"), BatchedKeys.Num(), ReferenceKeys.Num());
+	for (int32 CurveIndex = 0; CurveIndex < FMath::Min(BatchedKeys.Num(), ReferenceKeys.Num()); ++CurveIndex)
+	{
+		const FAnimCurveKeys& Batched = BatchedKeys[CurveIndex];
+		const FAnimCurveKeys& Reference = ReferenceKeys[CurveIndex];
+		const FString CurveName = Reference.CurveName.ToString();
+
+		TestTrue(FString::Printf(TEXT("%s curve name"), *CurveName), Batched.CurveName == Reference.CurveName);
+		if (!TestEqual(FString::Printf(TEXT("%s key count"), *CurveName), Batched.Times.Num(), Reference.Times.Num()))
+		{
+			continue;
+		}
+
+		//Frame times are computed slightly differently so values are compared relative to their magnitude
+		float MaxTimeError = 0.0f;
+		float MaxValueError = 0.0f;
+		for (int32 KeyIndex = 0; KeyIndex < Reference.Times.Num(); ++KeyIndex)
+		{
+			MaxTimeError = FMath::Max(MaxTimeError, FMath::Abs(Batched.Times[KeyIndex] - Reference.Times[KeyIndex]));
+			MaxValueError = FMath::Max(MaxValueError, FMath::Abs(Batched.Values[KeyIndex] - Reference.Values[KeyIndex])
+				/ FMath::Max(1.0f, FMath::Abs(Reference.Values[KeyIndex])));
+		}
+
+		TestTrue(FString::Printf(TEXT("%s keys match the previous modifier"), *CurveName), MaxTimeError <= 0.0001f && MaxValueError <= 0.001f);
+	}
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
+
+#undef LOCTEXT_NAMESPACE
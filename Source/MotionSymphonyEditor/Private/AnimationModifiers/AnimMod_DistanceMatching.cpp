@@ -4,6 +4,7 @@
 #include "AnimationModifiers/AnimMod_DistanceMatching.h"
 #include "AnimationBlueprintLibrary.h"
 #include "Animation/AnimSequence.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
 
 void UAnimMod_DistanceMatching::OnApply_Implementation(UAnimSequence* AnimationSequence)
 {
@@ -12,76 +13,59 @@ void UAnimMod_DistanceMatching::OnApply_Implementation(UAnimSequence* AnimationS
 		return;
 	}
 
-	//Clear or add the releveant curves
-	FName CurveName = FName(TEXT("MoSymph_Distance"));
+	TSharedRef<const FRootMotionTrack> RootMotion = FAnimModCurveBatch::GetRootMotionTrack(AnimationSequence, ERootMotionSampling::Frame);
 
-	bool bCurveExists = UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence, 
-		CurveName , ERawCurveTrackTypes::RCT_Float);
+	TArray<FAnimCurveKeys> CurveKeys;
+	GenerateCurveKeys(*RootMotion, FAnimCurveSource(AnimationSequence), CurveKeys);
 
-	if (bCurveExists)
+	for (const FAnimCurveKeys& Keys : CurveKeys)
 	{
-		//Clear curve
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, CurveName, false);
+		Keys.Write(AnimationSequence);
 	}
+}
 
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, CurveName, ERawCurveTrackTypes::RCT_Float, false);
-
-	//Find the Distance Matching Notify and record the time that it sits at
-	float MarkerTime = 0.0f;
-	FName DistanceMarkerName = FName(TEXT("DistanceMarker"));
-	for (FAnimNotifyEvent& NotifyEvent : AnimationSequence->Notifies)
-	{
-		if (NotifyEvent.NotifyName == DistanceMarkerName)
-		{
-			MarkerTime = NotifyEvent.GetTriggerTime();
-			break;
-		}
-	}
-
-	//Calculate FrameRate and Marker Frame
-#if ENGINE_MAJOR_VERSION < 5
-	float FrameRate = AnimationSequence->GetFrameRate();
-#else
-	float FrameRate = AnimationSequence->GetSamplingFrameRate().AsDecimal();
-#endif
-
-	int32 MarkerFrame = (int32)FMath::RoundHalfToZero(FrameRate * MarkerTime);
+void UAnimMod_DistanceMatching::GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys)
+{
+	const int32 NumSampleFrames = RootMotion.Num() + 1;
 
-	//Add keys for cumulative distance leading up to the marker
-	float CumDistance = 0.0f;
+	FAnimCurveKeys DistanceKeys(FName(TEXT("MoSymph_Distance")), NumSampleFrames);
 
-	float FrameDelta = 1.0f / FrameRate;
-	UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, FrameDelta * MarkerFrame, 0.0f);
-	for(int32 i = 1; i < MarkerFrame; ++i)
+	if (Source.FrameRate > 0.0f)
 	{
-		float StartTime = FrameDelta * (MarkerFrame - i);
-		FVector MoveDelta = AnimationSequence->ExtractRootMotion(StartTime, FMath::Abs(FrameDelta), false).GetLocation();
-		MoveDelta.Z = 0.0f;
+		//Calculate the Marker Frame
+		int32 MarkerFrame = (int32)FMath::RoundHalfToZero(Source.FrameRate * Source.DistanceMarkerTime);
 
-		CumDistance += MoveDelta.Size();
+		//Add keys for cumulative distance leading up to the marker
+		float CumDistance = 0.0f;
 
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, StartTime, CumDistance);
+		float FrameDelta = 1.0f / Source.FrameRate;
+		DistanceKeys.Add(FrameDelta * MarkerFrame, 0.0f);
+		for (int32 i = 1; i < MarkerFrame; ++i)
+		{
+			const int32 Frame = MarkerFrame - i;
+			FVector MoveDelta = RootMotion.GetDelta(Frame).GetLocation();
+			MoveDelta.Z = 0.0f;
 
-	}
+			CumDistance += MoveDelta.Size();
 
-	//Add keys for cumulative distance beyond the marker
-	CumDistance = 0.0f;
-#if ENGINE_MAJOR_VERSION > 4
-	int32 NumSampleFrames = AnimationSequence->GetNumberOfSampledKeys();
-#else
-	int32 NumSampleFrames = AnimationSequence->GetNumberOfFrames();
-#endif
+			DistanceKeys.Add(FrameDelta * Frame, CumDistance);
+		}
 
-	for (int32 i = MarkerFrame + 1; i < NumSampleFrames; ++i)
-	{
-		float StartTime = FrameDelta * i;
-		FVector MoveDelta = AnimationSequence->ExtractRootMotion(StartTime - FrameDelta, FMath::Abs(FrameDelta), false).GetLocation();
-		MoveDelta.Z = 0.0f;
+		//Add keys for cumulative distance beyond the marker
+		CumDistance = 0.0f;
 
-		CumDistance -= MoveDelta.Size();
+		for (int32 i = MarkerFrame + 1; i < NumSampleFrames; ++i)
+		{
+			FVector MoveDelta = RootMotion.GetDelta(i - 1).GetLocation();
+			MoveDelta.Z = 0.0f;
+
+			CumDistance -= MoveDelta.Size();
 
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, StartTime, CumDistance);
+			DistanceKeys.Add(FrameDelta * i, CumDistance);
+		}
 	}
+
+	OutCurveKeys.Add(MoveTemp(DistanceKeys));
 }
 
 void UAnimMod_DistanceMatching::OnRevert_Implementation(UAnimSequence* AnimationSequence)
@@ -2,7 +2,9 @@
 
 
 #include "AnimationModifiers/AnimMod_RootMotionCurves.h"
+#include "AnimationBlueprintLibrary.h"
 #include "Animation/AnimSequence.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
 
 void UAnimMod_RootMotionCurves::OnApply_Implementation(UAnimSequence* AnimationSequence)
 {
@@ -11,57 +13,46 @@ void UAnimMod_RootMotionCurves::OnApply_Implementation(UAnimSequence* AnimationS
 		return;
 	}
 
-	const FName MoveXCurveName = FName(TEXT("RootVelocity_X"));
-	const FName MoveYCurveName = FName(TEXT("RootVelocity_Y"));
-	const FName MoveZCurveName = FName(TEXT("RootVelocity_Z"));
-	const FName YawCurveName = FName(TEXT("RootVelocity_Yaw"));
+	//Root motion is sampled at 30Hz to avoid unnecessary keys
+	TSharedRef<const FRootMotionTrack> RootMotion = FAnimModCurveBatch::GetRootMotionTrack(AnimationSequence, ERootMotionSampling::KeyRate);
 
-	if (UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence,
-		MoveXCurveName, ERawCurveTrackTypes::RCT_Float))
-	{
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, MoveXCurveName, false);
-	}
+	TArray<FAnimCurveKeys> CurveKeys;
+	GenerateCurveKeys(*RootMotion, FAnimCurveSource(AnimationSequence), CurveKeys);
 
-	if (UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence,
-		MoveYCurveName, ERawCurveTrackTypes::RCT_Float))
+	for (const FAnimCurveKeys& Keys : CurveKeys)
 	{
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, MoveYCurveName, false);
+		Keys.Write(AnimationSequence);
 	}
+}
 
-	if (UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence,
-		MoveXCurveName, ERawCurveTrackTypes::RCT_Float))
-	{
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, MoveZCurveName, false);
-	}
-
-	if (UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence,
-		YawCurveName, ERawCurveTrackTypes::RCT_Float))
-	{
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, YawCurveName, false);
-	}
-
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, MoveXCurveName, ERawCurveTrackTypes::RCT_Float, false);
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, MoveYCurveName, ERawCurveTrackTypes::RCT_Float, false);
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, MoveZCurveName, ERawCurveTrackTypes::RCT_Float, false);
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, YawCurveName, ERawCurveTrackTypes::RCT_Float, false);
-
-	//Speed Key Rate
-	const float KeyRate = 1.0f / 30.0f; //Only do it at 30Hz to avoid unnecessary keys
+void UAnimMod_RootMotionCurves::GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys)
+{
+	const float KeyRate = RootMotion.Interval;
 	const float HalfKeyRate = KeyRate * 0.5f;
 
-	for (float Time = 0.0f; Time < AnimationSequence->GetPlayLength(); Time += KeyRate)
+	FAnimCurveKeys MoveXKeys(FName(TEXT("RootVelocity_X")), RootMotion.Num());
+	FAnimCurveKeys MoveYKeys(FName(TEXT("RootVelocity_Y")), RootMotion.Num());
+	FAnimCurveKeys MoveZKeys(FName(TEXT("RootVelocity_Z")), RootMotion.Num());
+	FAnimCurveKeys YawKeys(FName(TEXT("RootVelocity_Yaw")), RootMotion.Num());
+
+	for (int32 i = 0; i < RootMotion.Num(); ++i)
 	{
-		const float KeyTime = Time + HalfKeyRate;
-		FTransform RootMotion = AnimationSequence->ExtractRootMotion(Time, KeyRate, false);
+		const float KeyTime = RootMotion.Times[i] + HalfKeyRate;
+		const FTransform& RootMotionDelta = RootMotion.Deltas[i];
 
-		const FVector MoveVelocity = RootMotion.GetLocation() / KeyRate;
-		const float YawSpeed = RootMotion.Rotator().Yaw / KeyRate;
+		const FVector MoveVelocity = RootMotionDelta.GetLocation() / KeyRate;
+		const float YawSpeed = RootMotionDelta.Rotator().Yaw / KeyRate;
 
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, MoveXCurveName, KeyTime, MoveVelocity.X);
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, MoveYCurveName, KeyTime, MoveVelocity.Y);
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, MoveZCurveName, KeyTime, MoveVelocity.Z);
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, YawCurveName, KeyTime, YawSpeed);
+		MoveXKeys.Add(KeyTime, MoveVelocity.X);
+		MoveYKeys.Add(KeyTime, MoveVelocity.Y);
+		MoveZKeys.Add(KeyTime, MoveVelocity.Z);
+		YawKeys.Add(KeyTime, YawSpeed);
 	}
+
+	OutCurveKeys.Add(MoveTemp(MoveXKeys));
+	OutCurveKeys.Add(MoveTemp(MoveYKeys));
+	OutCurveKeys.Add(MoveTemp(MoveZKeys));
+	OutCurveKeys.Add(MoveTemp(YawKeys));
 }
 
 void UAnimMod_RootMotionCurves::OnRevert_Implementation(UAnimSequence* AnimationSequence)
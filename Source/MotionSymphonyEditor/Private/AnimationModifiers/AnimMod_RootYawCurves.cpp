@@ -2,7 +2,9 @@
 
 
 #include "AnimationModifiers/AnimMod_RootYawCurve.h"
+#include "AnimationBlueprintLibrary.h"
 #include "Animation/AnimSequence.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
 
 void UAnimMod_RootYawCurve::OnApply_Implementation(UAnimSequence* AnimationSequence)
 {
@@ -11,29 +13,31 @@ void UAnimMod_RootYawCurve::OnApply_Implementation(UAnimSequence* AnimationSeque
 		return;
 	}
 	
-	const FName YawCurveName = FName(TEXT("RootVelocity_Yaw"));
+	//Root motion is sampled at 30Hz to avoid unnecessary keys
+	TSharedRef<const FRootMotionTrack> RootMotion = FAnimModCurveBatch::GetRootMotionTrack(AnimationSequence, ERootMotionSampling::KeyRate);
 
-	if (UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence,
-		YawCurveName, ERawCurveTrackTypes::RCT_Float))
+	TArray<FAnimCurveKeys> CurveKeys;
+	GenerateCurveKeys(*RootMotion, FAnimCurveSource(AnimationSequence), CurveKeys);
+
+	for (const FAnimCurveKeys& Keys : CurveKeys)
 	{
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, YawCurveName, false);
+		Keys.Write(AnimationSequence);
 	}
+}
 
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, YawCurveName, ERawCurveTrackTypes::RCT_Float, false);
-
-	//Speed Key Rate
-	const float KeyRate = 1.0f / 30.0f; //Only do it at 30Hz to avoid unnecessary keys
+void UAnimMod_RootYawCurve::GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys)
+{
+	const float KeyRate = RootMotion.Interval;
 	const float HalfKeyRate = KeyRate * 0.5f;
 
-	for (float Time = 0.0f; Time < AnimationSequence->GetPlayLength(); Time += KeyRate)
+	FAnimCurveKeys YawKeys(FName(TEXT("RootVelocity_Yaw")), RootMotion.Num());
+
+	for (int32 i = 0; i < RootMotion.Num(); ++i)
 	{
-		const float KeyTime = Time + HalfKeyRate;
-		FTransform RootMotion = AnimationSequence->ExtractRootMotion(Time, KeyRate, false);
-		
-		const float YawSpeed = RootMotion.Rotator().Yaw / KeyRate;
-		
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, YawCurveName, KeyTime, YawSpeed);
+		YawKeys.Add(RootMotion.Times[i] + HalfKeyRate, RootMotion.Deltas[i].Rotator().Yaw / KeyRate);
 	}
+
+	OutCurveKeys.Add(MoveTemp(YawKeys));
 }
 
 void UAnimMod_RootYawCurve::OnRevert_Implementation(UAnimSequence* AnimationSequence)
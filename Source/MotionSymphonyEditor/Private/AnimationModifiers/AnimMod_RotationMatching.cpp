@@ -1,7 +1,9 @@
 // Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
 
 #include "AnimationModifiers/AnimMod_RotationMatching.h"
+#include "AnimationBlueprintLibrary.h"
 #include "Animation/AnimSequence.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
 
 void UAnimMod_RotationMatching::OnApply_Implementation(UAnimSequence* AnimationSequence)
 {
@@ -10,70 +12,52 @@ void UAnimMod_RotationMatching::OnApply_Implementation(UAnimSequence* AnimationS
 		return;
 	}
 
-	//Clear or add the releveant curves
-	FName CurveName = FName(TEXT("MoSymph_Rotation"));
+	TSharedRef<const FRootMotionTrack> RootMotion = FAnimModCurveBatch::GetRootMotionTrack(AnimationSequence, ERootMotionSampling::Frame);
 
-	bool bCurveExists = UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence,
-		CurveName, ERawCurveTrackTypes::RCT_Float);
+	TArray<FAnimCurveKeys> CurveKeys;
+	GenerateCurveKeys(*RootMotion, FAnimCurveSource(AnimationSequence), CurveKeys);
 
-	if (bCurveExists)
+	for (const FAnimCurveKeys& Keys : CurveKeys)
 	{
-		//Clear curve
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, CurveName, false);
+		Keys.Write(AnimationSequence);
 	}
+}
+
+void UAnimMod_RotationMatching::GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys)
+{
+	const int32 NumSampleFrames = RootMotion.Num() + 1;
 
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, CurveName, ERawCurveTrackTypes::RCT_Float, false);
+	FAnimCurveKeys RotationKeys(FName(TEXT("MoSymph_Rotation")), NumSampleFrames);
 
-	//Find the Distance Matching Notify and record the time that it sits at
-	float MarkerTime = 0.0f;
-	FName DistanceMarkerName = FName(TEXT("DistanceMarker"));
-	for (FAnimNotifyEvent& NotifyEvent : AnimationSequence->Notifies)
+	if (Source.FrameRate > 0.0f)
 	{
-		if (NotifyEvent.NotifyName == DistanceMarkerName)
+		//Calculate the Marker Frame
+		int32 MarkerFrame = (int32)FMath::RoundHalfToZero(Source.FrameRate * Source.DistanceMarkerTime);
+
+		//Add keys for cumulative rotation leading up to the marker
+		float CumRotation = 0.0f;
+		float FrameDelta = 1.0f / Source.FrameRate;
+		RotationKeys.Add(FrameDelta * MarkerFrame, 0.0f);
+		for (int32 i = 1; i < MarkerFrame; ++i)
 		{
-			MarkerTime = NotifyEvent.GetTriggerTime();
-			break;
-		}
-	}
+			const int32 Frame = MarkerFrame - i;
+			CumRotation += FMath::Abs(RootMotion.GetDelta(Frame).Rotator().Yaw);
 
-#if ENGINE_MAJOR_VERSION < 5
-	int32 NumSampleFrames = AnimationSequence->GetNumberOfFrames();
-	float FrameRate = AnimationSequence->GetFrameRate();
-#else
-	int32 NumSampleFrames = AnimationSequence->GetNumberOfSampledKeys();
-	float FrameRate = AnimationSequence->GetSamplingFrameRate().AsDecimal();
-#endif
-
-	//Calculate FrameRate and Marker Frame
-	int32 MarkerFrame = (int32)FMath::RoundHalfToZero(FrameRate * MarkerTime);
-
-	//Add keys for cumulative distance leading up to the marker
-	float CumRotation = 0.0f;;
-	float FrameDelta = 1.0f / FrameRate;
-	UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, FrameDelta * MarkerFrame, 0.0f);
-	for (int32 i = 1; i < MarkerFrame; ++i)
-	{
-		float StartTime = FrameDelta * (MarkerFrame - i);
-		float YawDelta = AnimationSequence->ExtractRootMotion(StartTime, FMath::Abs(FrameDelta), false).Rotator().Yaw;
+			RotationKeys.Add(FrameDelta * Frame, CumRotation);
+		}
 
-		CumRotation += FMath::Abs(YawDelta);
+		//Add keys for cumulative rotation beyond the marker
+		CumRotation = 0.0f;
 
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, StartTime, CumRotation);
+		for (int32 i = MarkerFrame + 1; i < NumSampleFrames; ++i)
+		{
+			CumRotation -= FMath::Abs(RootMotion.GetDelta(i - 1).Rotator().Yaw);
 
+			RotationKeys.Add(FrameDelta * i, CumRotation);
+		}
 	}
 
-	//Add keys for cumulative distance beyond the marker
-	CumRotation = 0.0f;
-
-	for (int32 i = MarkerFrame + 1; i < NumSampleFrames; ++i)
-	{
-		float StartTime = FrameDelta * i;
-		float YawDelta = AnimationSequence->ExtractRootMotion(StartTime - FrameDelta, FMath::Abs(FrameDelta), false).Rotator().Yaw;
-
-		CumRotation -= FMath::Abs(YawDelta);
-
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, StartTime, CumRotation);
-	}
+	OutCurveKeys.Add(MoveTemp(RotationKeys));
 }
 
 void UAnimMod_RotationMatching::OnRevert_Implementation(UAnimSequence* AnimationSequence)
@@ -3,6 +3,7 @@
 #include "AnimationModifiers/AnimMod_SpeedCurve.h"
 #include "AnimationBlueprintLibrary.h"
 #include "Animation/AnimSequence.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
 
 void UAnimMod_SpeedCurve::OnApply_Implementation(UAnimSequence* AnimationSequence)
 {
@@ -11,31 +12,33 @@ void UAnimMod_SpeedCurve::OnApply_Implementation(UAnimSequence* AnimationSequenc
 		return;
 	}
 
-	FName CurveName = FName(TEXT("Speed"));
+	//Root motion is sampled at 30Hz to avoid unnecessary keys
+	TSharedRef<const FRootMotionTrack> RootMotion = FAnimModCurveBatch::GetRootMotionTrack(AnimationSequence, ERootMotionSampling::KeyRate);
 
-	bool bCurveExists = UAnimationBlueprintLibrary::DoesCurveExist(AnimationSequence, 
-		CurveName, ERawCurveTrackTypes::RCT_Float);
+	TArray<FAnimCurveKeys> CurveKeys;
+	GenerateCurveKeys(*RootMotion, FAnimCurveSource(AnimationSequence), CurveKeys);
 
-	if (bCurveExists)
+	for (const FAnimCurveKeys& Keys : CurveKeys)
 	{
-		UAnimationBlueprintLibrary::RemoveCurve(AnimationSequence, CurveName, false);
+		Keys.Write(AnimationSequence);
 	}
+}
 
-	UAnimationBlueprintLibrary::AddCurve(AnimationSequence, CurveName, ERawCurveTrackTypes::RCT_Float, false);
+void UAnimMod_SpeedCurve::GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys)
+{
+	const float KeyRate = RootMotion.Interval;
+	const float HalfKeyRate = KeyRate * 0.5f;
 
-	//Speed Key Rate
-	float KeyRate = 1.0f / 30.0f; //Only do it at 30Hz to avoid unnecessary keys
-	float HalfKeyRate = KeyRate * 0.5f;
+	FAnimCurveKeys SpeedKeys(FName(TEXT("Speed")), RootMotion.Num());
 
-	for (float Time = 0.0f; Time < AnimationSequence->GetPlayLength(); Time += KeyRate)
+	for (int32 i = 0; i < RootMotion.Num(); ++i)
 	{
-		float KeyTime = Time + HalfKeyRate;
-		FVector MoveDelta = AnimationSequence->ExtractRootMotion(Time, KeyRate, false).GetLocation();
+		const FVector MoveDelta = RootMotion.Deltas[i].GetLocation();
 
-		float Speed = MoveDelta.Size() / KeyRate;
-
-		UAnimationBlueprintLibrary::AddFloatCurveKey(AnimationSequence, CurveName, KeyTime, Speed);
+		SpeedKeys.Add(RootMotion.Times[i] + HalfKeyRate, MoveDelta.Size() / KeyRate);
 	}
+
+	OutCurveKeys.Add(MoveTemp(SpeedKeys));
 }
 
 void UAnimMod_SpeedCurve::OnRevert_Implementation(UAnimSequence* AnimationSequence)
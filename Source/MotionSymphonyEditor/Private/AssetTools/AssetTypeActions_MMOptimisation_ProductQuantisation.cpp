@@ -0,0 +1,44 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "AssetTypeActions_MMOptimisation_ProductQuantisation.h"
+#include "CustomAssets/MMOptimisation_ProductQuantisation.h"
+#include "Framework/MultiBox/MultiBoxBuilder.h"
+
+#define LOCTEXT_NAMESPACE "AssetTypeActions"
+
+FText FAssetTypeActions_MMOptimisation_ProductQuantisation::GetName() const
+{
+	return NSLOCTEXT("AssetTypeActions", "AssetTypeActions_MMOptimisation_ProductQuantisation", "MMOptimisation ProductQuantisation");
+}
+
+FColor FAssetTypeActions_MMOptimisation_ProductQuantisation::GetTypeColor() const
+{
+	return FColor::Blue;
+}
+
+UClass* FAssetTypeActions_MMOptimisation_ProductQuantisation::GetSupportedClass() const
+{
+	return UMMOptimisation_ProductQuantisation::StaticClass();
+}
+
+uint32 FAssetTypeActions_MMOptimisation_ProductQuantisation::GetCategories()
+{
+	return EAssetTypeCategories::Animation;
+}
+
+void FAssetTypeActions_MMOptimisation_ProductQuantisation::GetActions(const TArray<UObject*>& InObjects, FMenuBuilder& MenuBuilder)
+{
+
+}
+
+bool FAssetTypeActions_MMOptimisation_ProductQuantisation::HasActions(const TArray<UObject*>& InObjects) const
+{
+	return false;
+}
+
+bool FAssetTypeActions_MMOptimisation_ProductQuantisation::CanFilter()
+{
+	return true;
+}
+
+#undef LOCTEXT_NAMESPACE
\ No newline at end of file
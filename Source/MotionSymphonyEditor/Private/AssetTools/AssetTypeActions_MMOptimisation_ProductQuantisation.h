@@ -0,0 +1,24 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Toolkits/IToolkitHost.h"
+#include "AssetTypeActions_Base.h"
+
+class FAssetTypeActions_MMOptimisation_ProductQuantisation
+	: public FAssetTypeActions_Base
+{
+public:
+	FAssetTypeActions_MMOptimisation_ProductQuantisation() {}
+
+public:
+	virtual FText GetName() const override;
+	virtual FColor GetTypeColor() const override;
+	virtual UClass* GetSupportedClass() const override;
+
+	virtual uint32 GetCategories() override;
+	virtual void GetActions(const TArray<UObject*>& InObjects, FMenuBuilder& MenuBuilder) override;
+	virtual bool HasActions(const TArray<UObject*>& InObjects) const override;
+	virtual bool CanFilter() override;
+};
\ No newline at end of file
@@ -0,0 +1,100 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionCurveBatchCommandlet.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
+#include "AnimationModifier.h"
+#include "Animation/AnimSequence.h"
+#include "AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+UMotionCurveBatchCommandlet::UMotionCurveBatchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UMotionCurveBatchCommandlet::Main(const FString& Params)
+{
+	FString ContentPath;
+	FString ModifierNames;
+	if (!FParse::Value(*Params, TEXT("Path="), ContentPath)
+		|| !FParse::Value(*Params, TEXT("Modifiers="), ModifierNames))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionCurveBatch: Usage: -Path=<ContentPath> -Modifiers=<ModifierClass>[+<ModifierClass>...] [-Save]"));
+		return 1;
+	}
+
+	//Modifiers
+	TArray<FString> ModifierClassNames;
+	ModifierNames.ParseIntoArray(ModifierClassNames, TEXT("+"));
+
+	TArray<UClass*> ModifierClasses;
+	for (const FString& ModifierClassName : ModifierClassNames)
+	{
+		UClass* ModifierClass = FindObject<UClass>(ANY_PACKAGE, *ModifierClassName);
+		if (!ModifierClass || !ModifierClass->IsChildOf(UAnimationModifier::StaticClass()))
+		{
+			UE_LOG(LogTemp, Error, TEXT("MotionCurveBatch: '%s' is not an animation modifier class."), *ModifierClassName);
+			return 1;
+		}
+
+		ModifierClasses.Add(ModifierClass);
+	}
+
+	//Sequences
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.PackagePaths.Add(FName(*ContentPath));
+	Filter.ClassNames.Add(UAnimSequence::StaticClass()->GetFName());
+	Filter.bRecursivePaths = true;
+	Filter.bRecursiveClasses = true;
+
+	TArray<FAssetData> SequenceAssets;
+	AssetRegistry.GetAssets(Filter, SequenceAssets);
+
+	TArray<UAnimSequence*> Sequences;
+	Sequences.Reserve(SequenceAssets.Num());
+	for (const FAssetData& SequenceAsset : SequenceAssets)
+	{
+		if (UAnimSequence* Sequence = Cast<UAnimSequence>(SequenceAsset.GetAsset()))
+		{
+			Sequences.Add(Sequence);
+		}
+	}
+
+	if (Sequences.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionCurveBatch: No animation sequences found under '%s'."), *ContentPath);
+		return 1;
+	}
+
+	FAnimModCurveBatch::ApplyModifiers(Sequences, ModifierClasses);
+
+	//Save
+	if (FParse::Param(*Params, TEXT("Save")))
+	{
+		int32 FailedCount = 0;
+		for (UAnimSequence* Sequence : Sequences)
+		{
+			UPackage* Package = Sequence->GetOutermost();
+			const FString FileName = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+			if (!UPackage::SavePackage(Package, Sequence, RF_Standalone, *FileName))
+			{
+				UE_LOG(LogTemp, Error, TEXT("MotionCurveBatch: Failed to save '%s'."), *FileName);
+				++FailedCount;
+			}
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("MotionCurveBatch: Saved %d of %d sequences."), Sequences.Num() - FailedCount, Sequences.Num());
+		return FailedCount > 0 ? 1 : 0;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("MotionCurveBatch: Generated curves for %d sequences. Pass -Save to save them."), Sequences.Num());
+	return 0;
+}
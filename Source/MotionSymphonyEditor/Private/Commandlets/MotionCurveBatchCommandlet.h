@@ -0,0 +1,25 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionCurveBatchCommandlet.generated.h"
+
+/**
+ * Generates the root motion curves of the Motion Symphony animation modifiers (see FAnimModCurveBatch) for every animation
+ * sequence under a content path. Root motion is extracted once per sequence, in parallel, and shared by all modifiers.
+ *
+ * Usage: -run=MotionCurveBatch -Path=<ContentPath> -Modifiers=<ModifierClass>[+<ModifierClass>...] [-Save]
+ * e.g. -run=MotionCurveBatch -Path=/Game/Locomotion -Modifiers=AnimMod_SpeedCurve+AnimMod_RootMotionCurves -Save
+ */
+UCLASS()
+class UMotionCurveBatchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionCurveBatchCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
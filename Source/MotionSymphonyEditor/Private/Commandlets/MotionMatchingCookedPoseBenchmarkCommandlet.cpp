@@ -0,0 +1,148 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingCookedPoseBenchmarkCommandlet.h"
+#include "Data/CookedPoseDatabase.h"
+#include "Data/PoseMotionData.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Math/RandomStream.h"
+
+static SIZE_T GetPoseDatabaseResidentSize(const TArray<FPoseMotionData>& Poses)
+{
+	SIZE_T ResidentSize = Poses.GetAllocatedSize();
+	for (const FPoseMotionData& Pose : Poses)
+	{
+		ResidentSize += Pose.Trajectory.GetAllocatedSize() + Pose.JointData.GetAllocatedSize();
+	}
+
+	return ResidentSize;
+}
+
+UMotionMatchingCookedPoseBenchmarkCommandlet::UMotionMatchingCookedPoseBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UMotionMatchingCookedPoseBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 PoseCount = 100000;
+	int32 TrajectoryPointCount = 7;
+	int32 JointCount = 4;
+	int32 Seed = 1234;
+	FParse::Value(*Params, TEXT("Poses="), PoseCount);
+	FParse::Value(*Params, TEXT("TrajectoryPoints="), TrajectoryPointCount);
+	FParse::Value(*Params, TEXT("Joints="), JointCount);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	PoseCount = FMath::Max(PoseCount, 1);
+	TrajectoryPointCount = FMath::Max(TrajectoryPointCount, 1);
+	JointCount = FMath::Max(JointCount, 1);
+
+	//Synthetic poses are laid out in clips of consecutive poses like a pre-processed database
+	const int32 ClipLength = 500;
+	FRandomStream Random(Seed);
+
+	TArray<FPoseMotionData> Poses;
+	Poses.Reserve(PoseCount);
+	for (int32 PoseId = 0; PoseId < PoseCount; ++PoseId)
+	{
+		FPoseMotionData& Pose = Poses.Emplace_GetRef(TrajectoryPointCount, JointCount);
+		const int32 ClipPoseIndex = PoseId % ClipLength;
+
+		Pose.PoseId = PoseId;
+		Pose.AnimType = EMotionAnimAssetType::Sequence;
+		Pose.AnimId = PoseId / ClipLength;
+		Pose.Time = ClipPoseIndex * 0.05f;
+		Pose.NextPoseId = ClipPoseIndex < ClipLength - 1 && PoseId < PoseCount - 1 ? PoseId + 1 : INDEX_NONE;
+		Pose.LastPoseId = ClipPoseIndex > 0 ? PoseId - 1 : INDEX_NONE;
+		Pose.LocalVelocity = Random.GetUnitVector() * Random.FRandRange(0.0f, 600.0f);
+		Pose.RotationalVelocity = Random.FRandRange(-180.0f, 180.0f);
+
+		for (FTrajectoryPoint& Point : Pose.Trajectory)
+		{
+			Point = FTrajectoryPoint(Random.GetUnitVector() * Random.FRandRange(0.0f, 300.0f), Random.FRandRange(-180.0f, 180.0f));
+		}
+
+		for (FJointData& Joint : Pose.JointData)
+		{
+			Joint = FJointData(Random.GetUnitVector() * 50.0f, Random.GetUnitVector() * Random.FRandRange(0.0f, 300.0f));
+		}
+	}
+
+	TArray<int32> SearchPoseIds;
+	SearchPoseIds.SetNumUninitialized(PoseCount);
+	for (int32 PoseId = 0; PoseId < PoseCount; ++PoseId)
+	{
+		SearchPoseIds[PoseId] = PoseId;
+	}
+
+	TArray<uint64> PrunedPoseBitmap;
+	PrunedPoseBitmap.SetNumZeroed((PoseCount + 63) / 64);
+
+	//Cooked pose database
+	TArray<uint8> Blob;
+	uint64 StartCycles = FPlatformTime::Cycles64();
+	FCookedPoseDatabase::Pack(Poses, SearchPoseIds, PrunedPoseBitmap, Blob);
+	const double PackTime = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	StartCycles = FPlatformTime::Cycles64();
+	const bool bValid = FCookedPoseDatabase::Validate(Blob.GetData(), Blob.Num());
+	const double ValidateTime = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	TArray<FPoseMotionData> UnpackedPoses;
+	TArray<int32> UnpackedSearchPoseIds;
+	TArray<uint64> UnpackedPrunedPoseBitmap;
+	StartCycles = FPlatformTime::Cycles64();
+	const bool bUnpacked = FCookedPoseDatabase::Unpack(Blob.GetData(), Blob.Num(), UnpackedPoses, UnpackedSearchPoseIds, UnpackedPrunedPoseBitmap);
+	const double UnpackTime = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	if (!bValid || !bUnpacked || UnpackedPoses.Num() != PoseCount)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingCookedPoseBenchmark: The packed pose database failed to validate or unpack."));
+		return 1;
+	}
+
+	//Tagged property serialization of the same poses, as loaded by an uncooked asset
+	TArray<uint8> TaggedData;
+	StartCycles = FPlatformTime::Cycles64();
+	{
+		FMemoryWriter Writer(TaggedData);
+		for (FPoseMotionData& Pose : Poses)
+		{
+			FPoseMotionData::StaticStruct()->SerializeItem(Writer, &Pose, nullptr);
+		}
+	}
+	const double TaggedWriteTime = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	TArray<FPoseMotionData> TaggedPoses;
+	StartCycles = FPlatformTime::Cycles64();
+	{
+		FMemoryReader Reader(TaggedData);
+		TaggedPoses.SetNum(PoseCount);
+		for (FPoseMotionData& Pose : TaggedPoses)
+		{
+			FPoseMotionData::StaticStruct()->SerializeItem(Reader, &Pose, nullptr);
+		}
+	}
+	const double TaggedReadTime = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	//The unpacked database holds the pose array, a trajectory and joint array per pose and the two search index arrays
+	const SIZE_T ResidentSize = GetPoseDatabaseResidentSize(UnpackedPoses) + UnpackedSearchPoseIds.GetAllocatedSize()
+		+ UnpackedPrunedPoseBitmap.GetAllocatedSize();
+	const int32 ResidentAllocationCount = 1 + PoseCount * 2 + 2;
+
+	UE_LOG(LogTemp, Display, TEXT("MotionMatchingCookedPoseBenchmark: %d poses, %d trajectory points, %d joints, seed %d"),
+		PoseCount, TrajectoryPointCount, JointCount, Seed);
+	UE_LOG(LogTemp, Display, TEXT("  Cooked: %d KB blob (%.1f bytes per pose), pack %.2f ms, validate %.2f ms, unpack %.2f ms"),
+		Blob.Num() / 1024, (double)Blob.Num() / PoseCount, PackTime, ValidateTime, UnpackTime);
+	UE_LOG(LogTemp, Display, TEXT("  Tagged properties: %d KB (%.1f bytes per pose), write %.2f ms, read %.2f ms (%.1fx cooked unpack)"),
+		TaggedData.Num() / 1024, (double)TaggedData.Num() / PoseCount, TaggedWriteTime, TaggedReadTime,
+		TaggedReadTime / FMath::Max(UnpackTime, 0.001));
+	UE_LOG(LogTemp, Display, TEXT("  Resident after unpack: %d KB in %d allocations (%.2fx the blob)"),
+		(int32)(ResidentSize / 1024), ResidentAllocationCount, (double)ResidentSize / FMath::Max(Blob.Num(), 1));
+
+	return 0;
+}
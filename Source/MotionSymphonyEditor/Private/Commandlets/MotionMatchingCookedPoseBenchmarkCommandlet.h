@@ -0,0 +1,26 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionMatchingCookedPoseBenchmarkCommandlet.generated.h"
+
+/**
+ * Benchmarks the cooked pose database (see FCookedPoseDatabase) on a synthetic pose database. Reports pack, validate and 
+ * unpack times and the blob size, and compares them with tagged property serialization of the same poses, which is how 
+ * uncooked assets load them. The resident size and allocation count of the unpacked poses are reported next to the blob
+ * size since the blob is unpacked into the regular pose array rather than kept resident.
+ *
+ * Usage: -run=MotionMatchingCookedPoseBenchmark [-Poses=<Count>] [-TrajectoryPoints=<Count>] [-Joints=<Count>] [-Seed=<Seed>]
+ */
+UCLASS()
+class UMotionMatchingCookedPoseBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionMatchingCookedPoseBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,161 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingPQBenchmarkCommandlet.h"
+#include "MotionMatchingUtil/PoseProductQuantizer.h"
+#include "Math/RandomStream.h"
+
+static float ComputeSquaredDistance(const float* A, const float* B, const int32 FeatureCount)
+{
+	float Distance = 0.0f;
+	for (int32 f = 0; f < FeatureCount; ++f)
+	{
+		Distance += FMath::Square(A[f] - B[f]);
+	}
+
+	return Distance;
+}
+
+UMotionMatchingPQBenchmarkCommandlet::UMotionMatchingPQBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UMotionMatchingPQBenchmarkCommandlet::Main(const FString& Params)
+{
+	int32 PoseCount = 50000;
+	int32 FeatureCount = 48;
+	int32 QueryCount = 1000;
+	int32 Seed = 1234;
+	FParse::Value(*Params, TEXT("Poses="), PoseCount);
+	FParse::Value(*Params, TEXT("Features="), FeatureCount);
+	FParse::Value(*Params, TEXT("Queries="), QueryCount);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	PoseCount = FMath::Max(PoseCount, 256);
+	FeatureCount = FMath::Max(FeatureCount, 1);
+	QueryCount = FMath::Max(QueryCount, 1);
+
+	//Synthetic poses are noisy samples around a set of cluster centres, similar to clips of related motion
+	FRandomStream Random(Seed);
+	const int32 ClusterCount = FMath::Max(PoseCount / 200, 1);
+
+	TArray<float> Centres;
+	Centres.SetNumUninitialized(ClusterCount * FeatureCount);
+	for (float& Value : Centres)
+	{
+		Value = Random.FRandRange(-2.0f, 2.0f);
+	}
+
+	TArray<float> Features;
+	Features.SetNumUninitialized(PoseCount * FeatureCount);
+	for (int32 i = 0; i < PoseCount; ++i)
+	{
+		const float* Centre = &Centres[Random.RandHelper(ClusterCount) * FeatureCount];
+		for (int32 f = 0; f < FeatureCount; ++f)
+		{
+			Features[i * FeatureCount + f] = Centre[f] + Random.FRandRange(-0.5f, 0.5f);
+		}
+	}
+
+	//Queries are perturbed poses so that the nearest pose is meaningful but not trivially the source pose
+	TArray<float> Queries;
+	Queries.SetNumUninitialized(QueryCount * FeatureCount);
+	for (int32 q = 0; q < QueryCount; ++q)
+	{
+		const float* Source = &Features[Random.RandHelper(PoseCount) * FeatureCount];
+		for (int32 f = 0; f < FeatureCount; ++f)
+		{
+			Queries[q * FeatureCount + f] = Source[f] + Random.FRandRange(-0.25f, 0.25f);
+		}
+	}
+
+	TArray<float> ColumnWeights;
+	ColumnWeights.Init(1.0f, FeatureCount);
+
+	//Brute force ground truth
+	TArray<int32> TrueNearest;
+	TrueNearest.SetNumUninitialized(QueryCount);
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+	for (int32 q = 0; q < QueryCount; ++q)
+	{
+		const float* Query = &Queries[q * FeatureCount];
+		float NearestDistance = BIG_NUMBER;
+		for (int32 i = 0; i < PoseCount; ++i)
+		{
+			const float Distance = ComputeSquaredDistance(Query, &Features[i * FeatureCount], FeatureCount);
+			if (Distance < NearestDistance)
+			{
+				NearestDistance = Distance;
+				TrueNearest[q] = i;
+			}
+		}
+	}
+
+	const double BruteForceTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0 / QueryCount;
+
+	UE_LOG(LogTemp, Display, TEXT("MotionMatchingPQBenchmark: %d poses, %d features, %d queries, seed %d"), PoseCount, FeatureCount, QueryCount, Seed);
+	UE_LOG(LogTemp, Display, TEXT("  Brute force: %.2f us per query"), BruteForceTime);
+
+	const int32 SubspaceCounts[] = { 4, 8, 16 };
+	const int32 RerankCounts[] = { 1, 16, 64, 256 };
+
+	TArray<float> DistanceTable;
+	TArray<int32> NearestItems;
+
+	for (const int32 SubspaceCount : SubspaceCounts)
+	{
+		FPoseProductQuantizer Quantizer;
+
+		StartCycles = FPlatformTime::Cycles64();
+		Quantizer.Train(Features, PoseCount, FeatureCount, SubspaceCount, 256, 16, 16384);
+		const double TrainTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		if (!Quantizer.IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("MotionMatchingPQBenchmark: Training failed with %d sub-spaces."), SubspaceCount);
+			return 1;
+		}
+
+		UE_LOG(LogTemp, Display, TEXT("  %d sub-spaces: trained in %.2f s, %d KB"), Quantizer.GetSubspaceCount(), TrainTime,
+			(int32)(Quantizer.GetAllocatedSize() / 1024));
+
+		for (const int32 RerankCount : RerankCounts)
+		{
+			int32 HitCount = 0;
+
+			StartCycles = FPlatformTime::Cycles64();
+			for (int32 q = 0; q < QueryCount; ++q)
+			{
+				const float* Query = &Queries[q * FeatureCount];
+				Quantizer.ComputeDistanceTable(Query, ColumnWeights.GetData(), DistanceTable);
+				Quantizer.FindNearest(DistanceTable, RerankCount, NearestItems);
+
+				//Exact re-rank
+				int32 Nearest = INDEX_NONE;
+				float NearestDistance = BIG_NUMBER;
+				for (const int32 Item : NearestItems)
+				{
+					const float Distance = ComputeSquaredDistance(Query, &Features[Item * FeatureCount], FeatureCount);
+					if (Distance < NearestDistance)
+					{
+						NearestDistance = Distance;
+						Nearest = Item;
+					}
+				}
+
+				HitCount += Nearest == TrueNearest[q] ? 1 : 0;
+			}
+
+			const double SearchTime = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0 / QueryCount;
+
+			UE_LOG(LogTemp, Display, TEXT("    Re-rank %3d: recall@1 %.1f%%, %.2f us per query (%.1fx brute force)"), RerankCount,
+				100.0 * HitCount / QueryCount, SearchTime, BruteForceTime / FMath::Max(SearchTime, 0.001));
+		}
+	}
+
+	return 0;
+}
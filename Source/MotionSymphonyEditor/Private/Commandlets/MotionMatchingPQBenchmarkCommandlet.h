@@ -0,0 +1,25 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionMatchingPQBenchmarkCommandlet.generated.h"
+
+/**
+ * Benchmarks product quantised search (see FPoseProductQuantizer) against a brute force search on synthetic, clustered 
+ * pose features. Reports recall@1 (how often re-ranking the approximate nearest items finds the true nearest item) and 
+ * search timing for a range of sub-space and re-rank counts. Data is generated from a fixed seed so results are repeatable.
+ *
+ * Usage: -run=MotionMatchingPQBenchmark [-Poses=<Count>] [-Features=<Count>] [-Queries=<Count>] [-Seed=<Seed>]
+ */
+UCLASS()
+class UMotionMatchingPQBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionMatchingPQBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,217 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingReplayCommandlet.h"
+#include "AnimGraph/AnimNode_MotionMatching.h"
+#include "CustomAssets/MotionDataAsset.h"
+#include "CustomAssets/MotionCalibration.h"
+#include "CustomAssets/MMOptimisationModule.h"
+#include "MotionMatchingUtil/MotionMatchingQueryLog.h"
+
+UMotionMatchingReplayCommandlet::UMotionMatchingReplayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UMotionMatchingReplayCommandlet::Main(const FString& Params)
+{
+	FString LogFileName;
+	if (!FParse::Value(*Params, TEXT("Log="), LogFileName))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingReplay: No query log specified. Usage: -Log=<QueryLog> [-MotionData=<AssetPath>] [-Optimisation=<AssetPath>|None] [-Calibration=<AssetPath>] [-PCA] [-SeedRadius=<N>]"));
+		return 1;
+	}
+
+	FMotionMatchingQueryLog QueryLog;
+	if (!QueryLog.Load(LogFileName))
+	{
+		return 1;
+	}
+
+	//Motion Data
+	FString MotionDataPath = QueryLog.MotionDataPath;
+	FParse::Value(*Params, TEXT("MotionData="), MotionDataPath);
+
+	UMotionDataAsset* MotionData = LoadObject<UMotionDataAsset>(nullptr, *MotionDataPath);
+	if (!MotionData || !MotionData->bIsProcessed)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingReplay: Motion data '%s' could not be loaded or has not been pre-processed."), *MotionDataPath);
+		return 1;
+	}
+
+	//Optimisation. The module is swapped on the loaded asset for the replay only and the asset is never saved
+	bool bUseOptimisation = MotionData->IsOptimisationValid();
+	FString OptimisationPath;
+	if (FParse::Value(*Params, TEXT("Optimisation="), OptimisationPath))
+	{
+		if (OptimisationPath.Equals(TEXT("None"), ESearchCase::IgnoreCase))
+		{
+			bUseOptimisation = false;
+		}
+		else
+		{
+			UMMOptimisationModule* OptimisationModule = LoadObject<UMMOptimisationModule>(nullptr, *OptimisationPath);
+			if (!OptimisationModule)
+			{
+				UE_LOG(LogTemp, Error, TEXT("MotionMatchingReplay: Optimisation module '%s' could not be loaded."), *OptimisationPath);
+				return 1;
+			}
+
+			MotionData->OptimisationModule = OptimisationModule;
+			if (!OptimisationModule->IsProcessedAndValid(MotionData))
+			{
+				OptimisationModule->BuildOptimisationStructures(MotionData);
+			}
+
+			bUseOptimisation = OptimisationModule->IsProcessedAndValid(MotionData);
+		}
+	}
+
+	if (bUseOptimisation)
+	{
+		MotionData->OptimisationModule->InitializeRuntime();
+	}
+
+	//PCA pre-filter. Takes priority over the optimisation module
+	const bool bUsePCA = FParse::Param(*Params, TEXT("PCA")) && MotionData->PCAPrefilters.Num() > 0;
+
+	//Search seeding. A negative radius turns it off
+	int32 SeedRadius = 2;
+	FParse::Value(*Params, TEXT("SeedRadius="), SeedRadius);
+
+	//Calibration
+	TArray<FCalibrationData> Calibrations = QueryLog.Calibrations;
+	FString CalibrationPath;
+	if (FParse::Value(*Params, TEXT("Calibration="), CalibrationPath))
+	{
+		UMotionCalibration* Calibration = LoadObject<UMotionCalibration>(nullptr, *CalibrationPath);
+		if (!Calibration)
+		{
+			UE_LOG(LogTemp, Error, TEXT("MotionMatchingReplay: Calibration '%s' could not be loaded."), *CalibrationPath);
+			return 1;
+		}
+
+		Calibration->ValidateData();
+
+		for (int32 CalibrationId = 0; CalibrationId < Calibrations.Num(); ++CalibrationId)
+		{
+			if (const FCalibrationData* StdDeviations = MotionData->FeatureStandardDeviations.Find(QueryLog.CalibrationTraits[CalibrationId]))
+			{
+				Calibrations[CalibrationId] = FCalibrationData();
+				Calibrations[CalibrationId].GenerateFinalWeights(Calibration, *StdDeviations);
+			}
+		}
+	}
+
+	TArray<TArray<uint64>> PoseMasks;
+	PoseMasks.SetNum(Calibrations.Num());
+	for (int32 CalibrationId = 0; CalibrationId < Calibrations.Num(); ++CalibrationId)
+	{
+		MotionData->GetTraitPoseMask(QueryLog.CalibrationTraits[CalibrationId], PoseMasks[CalibrationId]);
+
+		//The feature group order is measured on the motion data so it isn't recorded in the log
+		if (const FCalibrationData* StdDeviations = MotionData->FeatureStandardDeviations.Find(QueryLog.CalibrationTraits[CalibrationId]))
+		{
+			Calibrations[CalibrationId].FeatureGroupOrder = StdDeviations->FeatureGroupOrder;
+		}
+	}
+
+	//Replay
+	const int32 PoseCount = MotionData->Poses.Num();
+	const int32 JointCount = PoseCount > 0 ? MotionData->Poses[0].JointData.Num() : 0;
+	const int32 TrajectoryCount = PoseCount > 0 ? MotionData->Poses[0].Trajectory.Num() : 0;
+
+	int32 ReplayCount = 0;
+	int32 SkippedCount = 0;
+	int32 AgreementCount = 0;
+	double TotalCostDelta = 0.0;
+	float MaxCostDelta = 0.0f;
+	TArray<double> SearchTimes;
+	SearchTimes.Reserve(QueryLog.Records.Num());
+	FMotionMatchingSearchStats TotalSearchStats;
+	FMotionMatchingSearchStats TotalUnseededSearchStats;
+
+	FMotionMatchingSearchQuery Query;
+	for (const FMotionMatchingQueryRecord& Record : QueryLog.Records)
+	{
+		//Records from a different version of the motion data can't be compared
+		if (!MotionData->Poses.IsValidIndex(Record.ChosenPoseId)
+			|| Record.Query.CurrentPose.JointData.Num() != JointCount
+			|| Record.Query.DesiredTrajectory.Num() != TrajectoryCount)
+		{
+			++SkippedCount;
+			continue;
+		}
+
+		Query = Record.Query;
+		Query.Calibration = Calibrations[Record.CalibrationId];
+		Query.PoseMask = PoseMasks[Record.CalibrationId];
+		Query.PoseMatchMethod = bUsePCA ? EPoseMatchMethod::PCAPrefiltered 
+			: bUseOptimisation ? EPoseMatchMethod::Optimized : EPoseMatchMethod::Linear;
+		Query.SeedRadius = SeedRadius;
+
+		FMotionMatchingSearchStats SearchStats;
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const int32 ReplayPoseId = FAnimNode_MotionMatching::GetLowestCostPoseId(MotionData, Query, nullptr, nullptr, &SearchStats);
+		SearchTimes.Add(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0);
+		TotalSearchStats.Accumulate(SearchStats);
+
+		//The same search without seeding shows how much the seed improves pruning
+		if (SeedRadius >= 0)
+		{
+			Query.SeedRadius = INDEX_NONE;
+			FMotionMatchingSearchStats UnseededSearchStats;
+			FAnimNode_MotionMatching::GetLowestCostPoseId(MotionData, Query, nullptr, nullptr, &UnseededSearchStats);
+			TotalUnseededSearchStats.Accumulate(UnseededSearchStats);
+			Query.SeedRadius = SeedRadius;
+		}
+
+		//Both choices are costed with the replay calibration. A negative delta means the replay found a better pose
+		const float ReplayCost = FAnimNode_MotionMatching::ComputePoseSearchCost(MotionData, Query, ReplayPoseId);
+		const float RecordedCost = FAnimNode_MotionMatching::ComputePoseSearchCost(MotionData, Query, Record.ChosenPoseId);
+		const float CostDelta = ReplayCost - RecordedCost;
+
+		++ReplayCount;
+		AgreementCount += ReplayPoseId == Record.ChosenPoseId ? 1 : 0;
+		TotalCostDelta += CostDelta;
+		MaxCostDelta = FMath::Max(MaxCostDelta, FMath::Abs(CostDelta));
+	}
+
+	if (ReplayCount == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingReplay: No records could be replayed (%d skipped)."), SkippedCount);
+		return 1;
+	}
+
+	SearchTimes.Sort();
+	double TotalSearchTime = 0.0;
+	for (const double SearchTime : SearchTimes)
+	{
+		TotalSearchTime += SearchTime;
+	}
+
+	const int32 P95Index = FMath::Clamp(FMath::CeilToInt(SearchTimes.Num() * 0.95f) - 1, 0, SearchTimes.Num() - 1);
+
+	UE_LOG(LogTemp, Display, TEXT("MotionMatchingReplay: '%s' against '%s' (%s search)"),
+		*LogFileName, *MotionData->GetPathName(), bUsePCA ? TEXT("PCA pre-filtered") : bUseOptimisation ? TEXT("optimised") : TEXT("linear"));
+	UE_LOG(LogTemp, Display, TEXT("  Records: %d replayed, %d skipped"), ReplayCount, SkippedCount);
+	UE_LOG(LogTemp, Display, TEXT("  Pose agreement: %.2f%% (%d / %d)"), 100.0 * AgreementCount / ReplayCount, AgreementCount, ReplayCount);
+	UE_LOG(LogTemp, Display, TEXT("  Cost delta: mean %f, max abs %f"), TotalCostDelta / ReplayCount, MaxCostDelta);
+	UE_LOG(LogTemp, Display, TEXT("  Search time (us): mean %.2f, median %.2f, p95 %.2f, max %.2f"),
+		TotalSearchTime / ReplayCount, SearchTimes[SearchTimes.Num() / 2], SearchTimes[P95Index], SearchTimes.Last());
+	UE_LOG(LogTemp, Display, TEXT("  Pruning: %.2f%% of candidates early out (mean %.1f candidates, %.1f fully costed, %.1f seeds)"),
+		100.0f * TotalSearchStats.GetPruneRate(), (float)TotalSearchStats.CandidateCount / ReplayCount,
+		(float)TotalSearchStats.CostedCount / ReplayCount, (float)TotalSearchStats.SeedCount / ReplayCount);
+	UE_LOG(LogTemp, Display, TEXT("  Feature groups per rejected candidate: %.2f"), TotalSearchStats.GetGroupsPerRejection());
+
+	if (SeedRadius >= 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("  Pruning without seeding: %.2f%% of candidates early out (mean %.1f fully costed). Seed radius %d improves it by %.2f%%"),
+			100.0f * TotalUnseededSearchStats.GetPruneRate(), (float)TotalUnseededSearchStats.CostedCount / ReplayCount, SeedRadius,
+			100.0f * (TotalSearchStats.GetPruneRate() - TotalUnseededSearchStats.GetPruneRate()));
+	}
+
+	return 0;
+}
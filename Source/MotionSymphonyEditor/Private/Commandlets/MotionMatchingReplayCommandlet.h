@@ -0,0 +1,27 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionMatchingReplayCommandlet.generated.h"
+
+/**
+ * Replays a motion matching query log (see FMotionMatchingQueryLog) against a motion data asset and reports pose choice
+ * agreement, cost deltas and search timing. Runs headless so optimisation and calibration settings can be tuned against
+ * recorded gameplay on a build machine.
+ *
+ * Search pruning is reported with and without seeding so the seed radius can be tuned too. A negative radius turns it off.
+ *
+ * Usage: -run=MotionMatchingReplay -Log=<QueryLog> [-MotionData=<AssetPath>] [-Optimisation=<AssetPath>|None] [-Calibration=<AssetPath>] [-PCA] [-SeedRadius=<N>]
+ */
+UCLASS()
+class UMotionMatchingReplayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionMatchingReplayCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,277 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MotionMatchingTransitionBenchmarkCommandlet.h"
+#include "AnimationRuntime.h"
+#include "Animation/AnimSequence.h"
+#include "CustomAssets/MotionDataAsset.h"
+#include "Data/AnimChannelState.h"
+#include "MotionMatchingUtil/MotionMatchingInertialization.h"
+#include "MotionMatchingUtil/MotionMatchingUtils.h"
+#include "Math/RandomStream.h"
+
+struct FTransitionBenchmarkJump
+{
+	int32 Frame;
+	int32 AnimId;
+	float Time;
+};
+
+static FAnimChannelState MakeBenchmarkChannel(const FMotionAnimSequence& MotionAnim, const int32 AnimId, const float Time,
+	const EBlendStatus BlendStatus)
+{
+	FPoseMotionData Pose;
+	Pose.AnimId = AnimId;
+	Pose.AnimType = EMotionAnimAssetType::Sequence;
+	Pose.Time = Time;
+
+	return FAnimChannelState(Pose, BlendStatus, 1.0f, MotionAnim.Sequence->GetPlayLength(), MotionAnim.bLoop, MotionAnim.PlayRate);
+}
+
+static float GetBenchmarkAnimTime(const FMotionAnimSequence& MotionAnim, const FAnimChannelState& Channel)
+{
+	return MotionAnim.bLoop ? FMotionMatchingUtils::WrapAnimationTime(Channel.AnimTime, MotionAnim.Sequence->GetPlayLength()) : Channel.AnimTime;
+}
+
+UMotionMatchingTransitionBenchmarkCommandlet::UMotionMatchingTransitionBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UMotionMatchingTransitionBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MotionDataPath;
+	if (!FParse::Value(*Params, TEXT("MotionData="), MotionDataPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingTransitionBenchmark: No motion data specified. Usage: -MotionData=<AssetPath> [-Seconds=<N>] [-FrameRate=<Hz>] [-BlendTime=<Seconds>] [-HalfLife=<Seconds>] [-Seed=<Seed>]"));
+		return 1;
+	}
+
+	float Seconds = 20.0f;
+	float FrameRate = 60.0f;
+	float BlendTime = 0.3f;
+	float HalfLife = 0.1f;
+	int32 Seed = 1234;
+	FParse::Value(*Params, TEXT("Seconds="), Seconds);
+	FParse::Value(*Params, TEXT("FrameRate="), FrameRate);
+	FParse::Value(*Params, TEXT("BlendTime="), BlendTime);
+	FParse::Value(*Params, TEXT("HalfLife="), HalfLife);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+
+	FrameRate = FMath::Max(FrameRate, 1.0f);
+	const float DeltaTime = 1.0f / FrameRate;
+	const int32 FrameCount = FMath::Max(FMath::RoundToInt(Seconds * FrameRate), 1);
+
+	UMotionDataAsset* MotionData = LoadObject<UMotionDataAsset>(nullptr, *MotionDataPath);
+	USkeleton* Skeleton = MotionData ? MotionData->GetSkeleton() : nullptr;
+	if (!Skeleton)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingTransitionBenchmark: Motion data '%s' could not be loaded or has no skeleton."), *MotionDataPath);
+		return 1;
+	}
+
+	TArray<int32> AnimIds;
+	for (int32 i = 0; i < MotionData->GetSourceAnimCount(); ++i)
+	{
+		const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(i);
+		if (MotionAnim.Sequence && MotionAnim.Sequence->GetPlayLength() > DeltaTime)
+		{
+			AnimIds.Add(i);
+		}
+	}
+
+	if (AnimIds.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("MotionMatchingTransitionBenchmark: Motion data '%s' has no usable sequences."), *MotionDataPath);
+		return 1;
+	}
+
+	//Evaluate every bone of the skeleton, the worst case for both paths
+	TArray<FBoneIndexType> RequiredBoneIndices;
+	RequiredBoneIndices.SetNumUninitialized(Skeleton->GetReferenceSkeleton().GetNum());
+	for (int32 i = 0; i < RequiredBoneIndices.Num(); ++i)
+	{
+		RequiredBoneIndices[i] = (FBoneIndexType)i;
+	}
+
+	FBoneContainer BoneContainer(RequiredBoneIndices, FCurveEvaluationOption(true), *Skeleton);
+
+	FCompactPose OutputPose;
+	OutputPose.SetBoneContainer(&BoneContainer);
+
+	FBlendedCurve OutputCurve;
+	OutputCurve.InitFrom(BoneContainer);
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 25
+	FStackCustomAttributes OutputAttributes;
+#endif
+
+	UE_LOG(LogTemp, Display, TEXT("MotionMatchingTransitionBenchmark: '%s', %d sequences, %d bones, %d frames at %.0f Hz, blend time %.2f s, half life %.2f s, seed %d"),
+		*MotionDataPath, AnimIds.Num(), RequiredBoneIndices.Num(), FrameCount, FrameRate, BlendTime, HalfLife, Seed);
+
+	const float JumpRates[] = { 2.0f, 5.0f, 10.0f, 20.0f, 30.0f };
+
+	for (const float JumpRate : JumpRates)
+	{
+		//Both paths replay the same jumps so only the transition method differs
+		FRandomStream Random(Seed);
+		TArray<FTransitionBenchmarkJump> Jumps;
+		float JumpAccumulator = 0.0f;
+		for (int32 Frame = 0; Frame < FrameCount; ++Frame)
+		{
+			JumpAccumulator += DeltaTime * JumpRate;
+			if (Frame == 0 || JumpAccumulator >= 1.0f)
+			{
+				JumpAccumulator = FMath::Fmod(JumpAccumulator, 1.0f);
+
+				FTransitionBenchmarkJump Jump;
+				Jump.Frame = Frame;
+				Jump.AnimId = AnimIds[Random.RandHelper(AnimIds.Num())];
+				Jump.Time = Random.FRandRange(0.0f, MotionData->GetSourceAnimAtIndex(Jump.AnimId).Sequence->GetPlayLength() - DeltaTime);
+				Jumps.Add(Jump);
+			}
+		}
+
+		//Blend path
+		TArray<FAnimChannelState> BlendChannels;
+		int64 TotalChannelCount = 0;
+		int32 MaxChannelCount = 0;
+		int32 JumpIndex = 0;
+
+		uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Frame = 0; Frame < FrameCount; ++Frame)
+		{
+			if (JumpIndex < Jumps.Num() && Jumps[JumpIndex].Frame == Frame)
+			{
+				const FTransitionBenchmarkJump& Jump = Jumps[JumpIndex++];
+				BlendChannels.Emplace(MakeBenchmarkChannel(MotionData->GetSourceAnimAtIndex(Jump.AnimId), Jump.AnimId, Jump.Time, EBlendStatus::Chosen));
+			}
+
+			for (int32 i = 0; i < BlendChannels.Num(); ++i)
+			{
+				const bool bCurrent = i == BlendChannels.Num() - 1;
+				const float Weight = BlendChannels[i].Update(DeltaTime, BlendTime, bCurrent, 1.0f);
+
+				if (!bCurrent && Weight < -0.05f)
+				{
+					BlendChannels.RemoveAt(i);
+					--i;
+				}
+			}
+
+			const int32 PoseCount = BlendChannels.Num();
+			TotalChannelCount += PoseCount;
+			MaxChannelCount = FMath::Max(MaxChannelCount, PoseCount);
+
+			if (PoseCount > 1 && BlendTime > 0.00001f)
+			{
+				TArray<FCompactPose, TInlineAllocator<8>> ChannelPoses;
+				ChannelPoses.AddZeroed(PoseCount);
+
+				TArray<FBlendedCurve, TInlineAllocator<8>> ChannelCurves;
+				ChannelCurves.AddZeroed(PoseCount);
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 25
+				TArray<FStackCustomAttributes, TInlineAllocator<8>> ChannelAttributes;
+				ChannelAttributes.AddZeroed(PoseCount);
+#endif
+
+				TArray<float, TInlineAllocator<8>> ChannelWeights;
+				ChannelWeights.AddZeroed(PoseCount);
+
+				float TotalBlendPower = 0.0f;
+				for (int32 i = 0; i < PoseCount; ++i)
+				{
+					const FAnimChannelState& AnimChannel = BlendChannels[i];
+					const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(AnimChannel.AnimId);
+
+					ChannelPoses[i].SetBoneContainer(&BoneContainer);
+					ChannelCurves[i].InitFrom(OutputCurve);
+
+					ChannelWeights[i] = AnimChannel.Weight * ((((float)(i + 1)) / ((float)PoseCount)));
+					TotalBlendPower += ChannelWeights[i];
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 25
+					FAnimationPoseData AnimationPoseData = { ChannelPoses[i], ChannelCurves[i], ChannelAttributes[i] };
+					MotionAnim.Sequence->GetAnimationPose(AnimationPoseData, FAnimExtractContext(GetBenchmarkAnimTime(MotionAnim, AnimChannel), true));
+#else
+					MotionAnim.Sequence->GetAnimationPose(ChannelPoses[i], ChannelCurves[i], FAnimExtractContext(GetBenchmarkAnimTime(MotionAnim, AnimChannel), true));
+#endif
+				}
+
+				if (TotalBlendPower > 0.0f)
+				{
+					for (int32 i = 0; i < PoseCount; ++i)
+					{
+						ChannelWeights[i] = ChannelWeights[i] / TotalBlendPower;
+					}
+
+					TArrayView<FCompactPose> ChannelPoseView(ChannelPoses);
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 25
+					FAnimationPoseData AnimationPoseData = { OutputPose, OutputCurve, OutputAttributes };
+					FAnimationRuntime::BlendPosesTogether(ChannelPoseView, ChannelCurves, ChannelAttributes, ChannelWeights, AnimationPoseData);
+#else
+					FAnimationRuntime::BlendPosesTogether(ChannelPoseView, ChannelCurves, ChannelWeights, OutputPose, OutputCurve);
+#endif
+
+					OutputPose.NormalizeRotations();
+				}
+			}
+			else if (PoseCount > 0)
+			{
+				const FAnimChannelState& AnimChannel = BlendChannels.Last();
+				const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(AnimChannel.AnimId);
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 25
+				FAnimationPoseData AnimationPoseData = { OutputPose, OutputCurve, OutputAttributes };
+				MotionAnim.Sequence->GetAnimationPose(AnimationPoseData, FAnimExtractContext(GetBenchmarkAnimTime(MotionAnim, AnimChannel), true));
+#else
+				MotionAnim.Sequence->GetAnimationPose(OutputPose, OutputCurve, FAnimExtractContext(GetBenchmarkAnimTime(MotionAnim, AnimChannel), true));
+#endif
+			}
+		}
+
+		const double BlendTimePerFrame = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0 / FrameCount;
+
+		//Offset inertialization path
+		FMotionMatchingOffsetInertializer OffsetInertializer;
+		FAnimChannelState CurrentChannel;
+		JumpIndex = 0;
+
+		StartCycles = FPlatformTime::Cycles64();
+		for (int32 Frame = 0; Frame < FrameCount; ++Frame)
+		{
+			if (JumpIndex < Jumps.Num() && Jumps[JumpIndex].Frame == Frame)
+			{
+				const FTransitionBenchmarkJump& Jump = Jumps[JumpIndex++];
+				CurrentChannel = MakeBenchmarkChannel(MotionData->GetSourceAnimAtIndex(Jump.AnimId), Jump.AnimId, Jump.Time, EBlendStatus::Dominant);
+				OffsetInertializer.RequestTransition();
+			}
+
+			CurrentChannel.Update(DeltaTime, BlendTime, true, 1.0f);
+			OffsetInertializer.Update(DeltaTime);
+
+			const FMotionAnimSequence& MotionAnim = MotionData->GetSourceAnimAtIndex(CurrentChannel.AnimId);
+
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION > 25
+			FAnimationPoseData AnimationPoseData = { OutputPose, OutputCurve, OutputAttributes };
+			MotionAnim.Sequence->GetAnimationPose(AnimationPoseData, FAnimExtractContext(GetBenchmarkAnimTime(MotionAnim, CurrentChannel), true));
+#else
+			MotionAnim.Sequence->GetAnimationPose(OutputPose, OutputCurve, FAnimExtractContext(GetBenchmarkAnimTime(MotionAnim, CurrentChannel), true));
+#endif
+
+			OffsetInertializer.Apply(OutputPose, HalfLife);
+		}
+
+		const double OffsetTimePerFrame = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) * 1000000.0 / FrameCount;
+
+		UE_LOG(LogTemp, Display, TEXT("  %4.0f jumps/s: Blend %.2f us per frame (%.2f avg, %d max channels), OffsetInertialization %.2f us per frame (%.1fx faster)"),
+			JumpRate, BlendTimePerFrame, (double)TotalChannelCount / FrameCount, MaxChannelCount, OffsetTimePerFrame,
+			BlendTimePerFrame / FMath::Max(OffsetTimePerFrame, 0.001));
+	}
+
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MotionMatchingTransitionBenchmarkCommandlet.generated.h"
+
+/**
+ * Benchmarks pose evaluation for the Blend and OffsetInertialization transition methods at a range of jump rates. Jumps
+ * go to random times in random sequences of a motion data asset. The Blend path extracts and blends every live channel
+ * like the motion matching node does, while the OffsetInertialization path extracts a single pose and applies the
+ * inertializer. Reports time per frame and the average and peak number of live blend channels for each jump rate.
+ *
+ * Usage: -run=MotionMatchingTransitionBenchmark -MotionData=<AssetPath> [-Seconds=<N>] [-FrameRate=<Hz>] [-BlendTime=<Seconds>] [-HalfLife=<Seconds>] [-Seed=<Seed>]
+ */
+UCLASS()
+class UMotionMatchingTransitionBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMotionMatchingTransitionBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
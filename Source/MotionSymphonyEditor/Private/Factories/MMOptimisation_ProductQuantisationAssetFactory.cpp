@@ -0,0 +1,21 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#include "MMOptimisation_ProductQuantisationAssetFactory.h"
+#include "CustomAssets/MMOptimisation_ProductQuantisation.h"
+
+UMMOptimisation_ProductQuantisationFactory::UMMOptimisation_ProductQuantisationFactory(const FObjectInitializer& ObjectInitializer)
+{
+	SupportedClass = UMMOptimisation_ProductQuantisation::StaticClass();
+	bCreateNew = true;
+	bEditAfterNew = true; 
+}
+
+UObject* UMMOptimisation_ProductQuantisationFactory::FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn, FName CallingContext)
+{
+	return NewObject<UMMOptimisation_ProductQuantisation>(InParent, InClass, InName, Flags);
+}
+
+bool UMMOptimisation_ProductQuantisationFactory::ShouldShowInNewMenu() const
+{
+	return true;
+}
@@ -0,0 +1,20 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Factories/Factory.h"
+#include "CustomAssets/MirroringProfile.h"
+#include "MMOptimisation_ProductQuantisationAssetFactory.generated.h"
+
+
+UCLASS(hidecategories = Object)
+class UMMOptimisation_ProductQuantisationFactory : public UFactory
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	virtual UObject* FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName,
+		EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn, FName CallingContext) override;
+	virtual bool ShouldShowInNewMenu() const override;
+};
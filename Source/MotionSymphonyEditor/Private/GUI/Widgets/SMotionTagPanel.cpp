@@ -47,6 +47,8 @@
 #include "Data/MotionAnimAsset.h"
 #include "Objects/Tags/TagPoint.h"
 #include "Objects/Tags/TagSection.h"
+#include "Misc/AutomationTest.h"
+#include "Widgets/SWindow.h"
 
 
 // AnimNotify Drawing
@@ -368,6 +370,12 @@ public:
 
 		void Construct(const FArguments& Declaration);
 
+	/** Points the node at a different notify and resets its state. Used when reusing pooled nodes */
+	void SetNotify(FAnimNotifyEvent* InAnimNotify);
+
+	/** Whether the node or one of its duration markers is being dragged */
+	bool IsBeingDragged() const { return bBeingDragged || DragMarkerTransactionIdx != INDEX_NONE; }
+
 	// SWidget interface
 	virtual FReply OnDragDetected(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
 	virtual FReply OnMouseMove(const FGeometry& MyGeometry, const FPointerEvent& MouseEvent) override;
@@ -489,6 +497,14 @@ private:
 	float LabelWidth;
 	FVector2D BranchingPointIconSize;
 
+	/** The inputs of the last layout. Layout is skipped while these are unchanged and text is only measured when the name changes */
+	FVector2D LayoutTrackSize;
+	float LayoutViewMin;
+	float LayoutViewMax;
+	float LayoutTime;
+	float LayoutDuration;
+	FName LayoutName;
+
 	/** Last position the user clicked in the widget */
 	FVector2D LastMouseDownPosition;
 
@@ -533,6 +549,8 @@ public:
 
 	float GetWidgetPaddingLeft();
 
+	TSharedPtr<SMotionTagNode> GetNode() const { return NodePtr; }
+
 protected:
 	TSharedPtr<SWidget> PairedWidget;
 	TSharedPtr<SMotionTagNode> NodePtr;
@@ -645,7 +663,7 @@ public:
 	void Construct(const FArguments& InArgs);
 
 	// SWidget interface
-	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override { UpdateCachedGeometry(AllottedGeometry); }
+	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
 	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
 	virtual FCursorReply OnCursorQuery(const FGeometry& MyGeometry, const FPointerEvent& CursorEvent) const override;
 	virtual bool SupportsKeyboardFocus() const override
@@ -683,6 +701,8 @@ public:
 
 	// Adds our current selection to the provided set
 	void AppendSelectionToSet(FGraphPanelSelectionSet& SelectionSet);
+	// Adds the guids of our current selection to the provided set
+	void AppendSelectedGuidsToSet(TSet<FGuid>& GuidSet) const;
 	// Adds our current selection to the provided array
 	void AppendSelectionToArray(TArray<INodeObjectInterface*>& Selection) const;
 	// Gets the currently selected SMotionTagNode instances
@@ -690,7 +710,7 @@ public:
 	// Gets the indices of the selected notifies
 	const TArray<int32>& GetSelectedNotifyIndices() const { return SelectedNodeIndices; }
 
-	INodeObjectInterface* GetNodeObjectInterface(int32 NodeIndex) { return NotifyNodes[NodeIndex]->NodeObjectInterface; }
+	INodeObjectInterface* GetNodeObjectInterface(int32 NodeIndex) { return &NodeObjects[NodeIndex]; }
 	/**
 	* Deselects all currently selected notify nodes
 	* @param bUpdateSelectionSet - Whether we should report a selection change to the panel
@@ -701,10 +721,13 @@ public:
 	void SelectNodesByGuid(const TSet<FGuid>& InGuids, bool bUpdateSelectionSet);
 
 	/** Get the number of notify nodes we contain */
-	int32 GetNumNotifyNodes() const { return NotifyNodes.Num(); }
+	int32 GetNumNotifyNodes() const { return NodeObjects.Num(); }
+
+	/** Get the number of node widgets that currently exist for this track, including pooled ones */
+	int32 GetNumNodeWidgets() const;
 
 	/** Check whether a node is selected */
-	bool IsNodeSelected(int32 NodeIndex) const { return NotifyNodes[NodeIndex]->bSelected; }
+	bool IsNodeSelected(int32 NodeIndex) const { return SelectedNodeIndices.Contains(NodeIndex); }
 
 	// get Property Data of one element (NotifyIndex) from Notifies property of Sequence
 	static uint8* FindNotifyPropertyData(UAnimSequenceBase* Sequence, int32 NotifyIndex, FArrayProperty*& ArrayProperty);
@@ -830,6 +853,22 @@ private:
 	// Store the tracks geometry for later use
 	void UpdateCachedGeometry(const FGeometry& InGeometry);
 
+	// Lays out every node that isn't being dragged. Nodes only recompute their layout when their inputs change
+	void UpdateNodeLayout(const FGeometry& InGeometry) const;
+
+	// Creates widgets for the nodes that overlap the track and slots them. Widgets of nodes that scrolled out of view
+	// are returned to the pool unless they are selected or being dragged
+	void RefreshVisibleNodes(const FGeometry& InGeometry);
+
+	// Returns the widget of a node, taking one from the pool or creating it if the node doesn't have one
+	TSharedPtr<SMotionTagNode> AcquireNode(int32 NotifyIndex);
+
+	// Returns the widget of a node to the pool
+	void ReleaseNode(int32 NotifyIndex);
+
+	// Sets the selection state of a node's widget, creating it if it is selected
+	void SetNodeSelected(int32 NotifyIndex, bool bSelected);
+
 	// Returns the padding needed to render the notify in the correct track position
 	FMargin GetNotifyTrackPadding(int32 NotifyIndex) const
 	{
@@ -850,8 +889,10 @@ protected:
 	float LastClickedTime;
 
 	struct FMotionAnimAsset* MotionAnim; // need for menu generation of anim notifies - 
-	TArray<TSharedPtr<SMotionTagNode>>		NotifyNodes;
+	TArray<FTagNodeInterface>				NodeObjects;	// One per notify. Selection, menus and copy work on these
+	TArray<TSharedPtr<SMotionTagNode>>		NotifyNodes;	// One per notify. Only valid for visible, selected or dragged notifies
 	TArray<TSharedPtr<SMotionTagPair>>		NotifyPairs;
+	TArray<TSharedPtr<SMotionTagPair>>		NodePool;		// Unused node widgets, reused as notifies scroll into view
 	TArray<FAnimNotifyEvent*>				AnimNotifies;
 	TAttribute<float>						ViewInputMin;
 	TAttribute<float>						ViewInputMax;
@@ -892,9 +933,16 @@ protected:
 
 	TSharedPtr<SBorder>						TrackArea;
 
-	/** Cache the SOverlay used to store all this tracks nodes */
+	/** Cache the SOverlay used to store this tracks visible nodes. Only nodes that overlap the track have widgets 
+	slotted here */
 	TSharedPtr<SOverlay> NodeSlots;
 
+	/** The indices of the nodes currently slotted in NodeSlots */
+	TArray<int32> VisibleNodeIndices;
+
+	/** The widest node laid out so far. Notifies that start this far left of the track may still overlap it */
+	float MaxNodeWidth;
+
 	/** Cached for drag drop handling code */
 	FGeometry CachedGeometry;
 
@@ -1357,24 +1405,11 @@ void SMotionTagNode::Construct(const FArguments& InArgs)
 	//Sequence = InArgs._Sequence;
 	MotionAnim = InArgs._MotionAnim;
 	Font = FCoreStyle::GetDefaultFontStyle("Regular", 10);
-	bBeingDragged = false;
-	CurrentDragHandle = ETagStateHandleHit::None;
-	bDrawTooltipToRight = true;
-	bSelected = false;
 	DragMarkerTransactionIdx = INDEX_NONE;
 
-
-	if (InArgs._AnimNotify)
-	{
-		MakeNodeInterface<FTagNodeInterface>(InArgs._AnimNotify);
-	}
-	else
-	{
-		check(false);	// Must specify something for this node to represent
-						// Either AnimNotify or AnimSyncMarker
-	}
-	// Cache notify name for blueprint / Native notifies.
-	NodeObjectInterface->CacheName();
+	check(InArgs._AnimNotify);	// Must specify something for this node to represent
+								// Either AnimNotify or AnimSyncMarker
+	SetNotify(InArgs._AnimNotify);
 
 	OnNodeDragStarted = InArgs._OnNodeDragStarted;
 	PanTrackRequest = InArgs._PanTrackRequest;
@@ -1398,6 +1433,29 @@ void SMotionTagNode::Construct(const FArguments& InArgs)
 	}
 
 	SetClipping(EWidgetClipping::ClipToBounds);
+}
+
+void SMotionTagNode::SetNotify(FAnimNotifyEvent* InAnimNotify)
+{
+	check(DragMarkerTransactionIdx == INDEX_NONE);
+
+	bBeingDragged = false;
+	CurrentDragHandle = ETagStateHandleHit::None;
+	bDrawTooltipToRight = true;
+	bSelected = false;
+	LastSnappedTime = -1.0f;
+	LayoutTrackSize = FVector2D(-1.0f, -1.0f);
+	LayoutViewMin = 0.0f;
+	LayoutViewMax = 0.0f;
+	LayoutTime = 0.0f;
+	LayoutDuration = 0.0f;
+	LayoutName = NAME_None;
+	TextSize = FVector2D::ZeroVector;
+
+	MakeNodeInterface<FTagNodeInterface>(InAnimNotify);
+
+	// Cache notify name for blueprint / Native notifies.
+	NodeObjectInterface->CacheName();
 
 	SetToolTipText(TAttribute<FText>(this, &SMotionTagNode::GetNodeTooltip));
 }
@@ -1514,16 +1572,43 @@ ETagStateHandleHit::Type SMotionTagNode::DurationHandleHitTest(const FVector2D&
 
 void SMotionTagNode::UpdateSizeAndPosition(const FGeometry& AllottedGeometry)
 {
-	FTrackScaleInfo ScaleInfo(ViewInputMin.Get(), ViewInputMax.Get(), 0, 0, AllottedGeometry.Size);
-
 	// Cache the geometry information, the alloted geometry is the same size as the track.
 	CachedAllotedGeometrySize = AllottedGeometry.Size * AllottedGeometry.Scale;
 
-	NotifyTimePositionX = ScaleInfo.InputToLocalX(NodeObjectInterface->GetTime());
-	NotifyDurationSizeX = ScaleInfo.PixelsPerInput * NodeObjectInterface->GetDuration();
+	const float ViewMin = ViewInputMin.Get();
+	const float ViewMax = ViewInputMax.Get();
+	const float Time = NodeObjectInterface->GetTime();
+	const float Duration = NodeObjectInterface->GetDuration();
+	const FName Name = NodeObjectInterface->GetName();
+
+	if (LayoutTrackSize == AllottedGeometry.Size
+		&& LayoutViewMin == ViewMin
+		&& LayoutViewMax == ViewMax
+		&& LayoutTime == Time
+		&& LayoutDuration == Duration
+		&& LayoutName == Name)
+	{
+		return;
+	}
+
+	LayoutTrackSize = AllottedGeometry.Size;
+	LayoutViewMin = ViewMin;
+	LayoutViewMax = ViewMax;
+	LayoutTime = Time;
+	LayoutDuration = Duration;
+
+	FTrackScaleInfo ScaleInfo(ViewMin, ViewMax, 0, 0, AllottedGeometry.Size);
+
+	NotifyTimePositionX = ScaleInfo.InputToLocalX(Time);
+	NotifyDurationSizeX = ScaleInfo.PixelsPerInput * Duration;
+
+	if (LayoutName != Name || TextSize.IsZero())
+	{
+		const TSharedRef< FSlateFontMeasure > FontMeasureService = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
+		TextSize = FontMeasureService->Measure(GetNotifyText(), Font);
+		LayoutName = Name;
+	}
 
-	const TSharedRef< FSlateFontMeasure > FontMeasureService = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
-	TextSize = FontMeasureService->Measure(GetNotifyText(), Font);
 	LabelWidth = TextSize.X + (TextBorderSize.X * 2.f) + (ScrubHandleSize.X / 2.f);
 
 	bool bDrawBranchingPoint = NodeObjectInterface->IsBranchingPoint();
@@ -2046,6 +2131,7 @@ void SMotionTagTrack::Construct(const FArguments& InArgs)
 	OnSetInputViewRange = InArgs._OnSetInputViewRange;
 	OnGetTimingNodeVisibility = InArgs._OnGetTimingNodeVisibility;
 	OnInvokeTab = InArgs._OnInvokeTab;
+	MaxNodeWidth = 0.0f;
 
 	this->ChildSlot
 		[
@@ -2053,6 +2139,9 @@ void SMotionTagTrack::Construct(const FArguments& InArgs)
 			.Visibility(EVisibility::SelfHitTestInvisible)
 		.BorderImage(FEditorStyle::GetBrush("NoBorder"))
 		.Padding(FMargin(0.f, 0.f))
+		[
+			SAssignNew(NodeSlots, SOverlay)
+		]
 		];
 
 	Update();
@@ -2076,17 +2165,12 @@ int32 SMotionTagTrack::OnPaint(const FPaintArgs& Args, const FGeometry& Allotted
 	int32 CustomLayerId = LayerId + 1;
 	FTrackScaleInfo ScaleInfo(ViewInputMin.Get(), ViewInputMax.Get(), 0.f, 0.f, AllottedGeometry.Size);
 
+	UpdateNodeLayout(AllottedGeometry);
+
 	bool bAnyDraggedNodes = false;
-	for (int32 I = 0; I < NotifyNodes.Num(); ++I)
+	for (const TSharedPtr<SMotionTagNode>& Node : NotifyNodes)
 	{
-		if (NotifyNodes[I].Get()->bBeingDragged == false)
-		{
-			NotifyNodes[I].Get()->UpdateSizeAndPosition(AllottedGeometry);
-		}
-		else
-		{
-			bAnyDraggedNodes = true;
-		}
+		bAnyDraggedNodes |= Node.IsValid() && Node->bBeingDragged;
 	}
 
 	if (TrackIndex < MotionAnim->MotionTagTracks.Num() - 1)
@@ -2131,6 +2215,183 @@ int32 SMotionTagTrack::OnPaint(const FPaintArgs& Args, const FGeometry& Allotted
 	return SCompoundWidget::OnPaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, CustomLayerId, InWidgetStyle, bParentEnabled);
 }
 
+void SMotionTagTrack::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
+{
+	UpdateCachedGeometry(AllottedGeometry);
+	UpdateNodeLayout(AllottedGeometry);
+	RefreshVisibleNodes(AllottedGeometry);
+}
+
+void SMotionTagTrack::UpdateNodeLayout(const FGeometry& InGeometry) const
+{
+	for (const TSharedPtr<SMotionTagNode>& Node : NotifyNodes)
+	{
+		if (Node.IsValid() && !Node->bBeingDragged)
+		{
+			Node->UpdateSizeAndPosition(InGeometry);
+		}
+	}
+}
+
+void SMotionTagTrack::RefreshVisibleNodes(const FGeometry& InGeometry)
+{
+	const float TrackWidth = InGeometry.GetLocalSize().X;
+	FTrackScaleInfo ScaleInfo(ViewInputMin.Get(), ViewInputMax.Get(), 0.f, 0.f, InGeometry.GetLocalSize());
+
+	//Notifies are culled by their time first so that only those near the track need a widget to be laid out exactly
+	TArray<int32, TInlineAllocator<64>> NewVisibleNodeIndices;
+	for (int32 NodeIndex = 0; NodeIndex < NodeObjects.Num(); ++NodeIndex)
+	{
+		const FTagNodeInterface& NodeObject = NodeObjects[NodeIndex];
+		const float StartX = ScaleInfo.InputToLocalX(NodeObject.GetTime());
+		const float EndX = StartX + ScaleInfo.PixelsPerInput * NodeObject.NotifyEvent->GetDuration();
+
+		const bool bNearTrack = StartX <= TrackWidth + ScrubHandleSize.X && EndX + MaxNodeWidth >= 0.0f;
+		//Selected nodes always have a widget so their selection state lives on it
+		const SMotionTagNode* ExistingNode = NotifyNodes[NodeIndex].Get();
+		const bool bKeepWidget = ExistingNode && (ExistingNode->bSelected || ExistingNode->IsBeingDragged());
+
+		if (!bNearTrack)
+		{
+			if (ExistingNode && !bKeepWidget)
+			{
+				ReleaseNode(NodeIndex);
+			}
+
+			continue;
+		}
+
+		TSharedPtr<SMotionTagNode> Node = AcquireNode(NodeIndex);
+		if (!Node->bBeingDragged)
+		{
+			Node->UpdateSizeAndPosition(InGeometry);
+		}
+
+		const float NodeX = Node->GetWidgetPosition().X;
+		const float NodeWidth = Node->GetSize().X;
+		MaxNodeWidth = FMath::Max(MaxNodeWidth, NodeWidth);
+
+		if (!Node->bBeingDragged 
+			&& NodeX <= TrackWidth 
+			&& NodeX + NodeWidth >= 0.0f)
+		{
+			NewVisibleNodeIndices.Add(NodeIndex);
+		}
+		else if (!bKeepWidget)
+		{
+			ReleaseNode(NodeIndex);
+		}
+	}
+
+	if (NewVisibleNodeIndices.Num() == VisibleNodeIndices.Num()
+		&& FMemory::Memcmp(NewVisibleNodeIndices.GetData(), VisibleNodeIndices.GetData(), VisibleNodeIndices.Num() * sizeof(int32)) == 0)
+	{
+		return;
+	}
+
+	NodeSlots->ClearChildren();
+	VisibleNodeIndices.Reset(NewVisibleNodeIndices.Num());
+
+	for (const int32 NodeIndex : NewVisibleNodeIndices)
+	{
+		NodeSlots->AddSlot()
+			.Padding(TAttribute<FMargin>::Create(TAttribute<FMargin>::FGetter::CreateSP(this, &SMotionTagTrack::GetNotifyTrackPadding, NodeIndex)))
+			[
+				NotifyPairs[NodeIndex]->AsShared()
+			];
+
+		VisibleNodeIndices.Add(NodeIndex);
+	}
+}
+
+TSharedPtr<SMotionTagNode> SMotionTagTrack::AcquireNode(int32 NotifyIndex)
+{
+	if (NotifyNodes[NotifyIndex].IsValid())
+	{
+		return NotifyNodes[NotifyIndex];
+	}
+
+	TSharedPtr<SMotionTagNode> AnimNotifyNode = nullptr;
+	TSharedPtr<SMotionTagPair> NotifyPair = nullptr;
+
+	if (NodePool.Num() > 0)
+	{
+		NotifyPair = NodePool.Pop(false);
+		AnimNotifyNode = NotifyPair->GetNode();
+		AnimNotifyNode->SetNotify(AnimNotifies[NotifyIndex]);
+		AnimNotifyNode->OnNodeDragStarted = FOnNotifyNodeDragStarted::CreateSP(this, &SMotionTagTrack::OnTagNodeDragStarted, NotifyIndex);
+	}
+	else
+	{
+		SAssignNew(AnimNotifyNode, SMotionTagNode)
+			.MotionAnim(MotionAnim)
+			.AnimNotify(AnimNotifies[NotifyIndex])
+			.OnNodeDragStarted(this, &SMotionTagTrack::OnTagNodeDragStarted, NotifyIndex)
+			.OnUpdatePanel(OnUpdatePanel)
+			.PanTrackRequest(OnRequestTrackPan)
+			.ViewInputMin(ViewInputMin)
+			.ViewInputMax(ViewInputMax)
+			.OnSnapPosition(OnSnapPosition)
+			.OnSelectionChanged(OnSelectionChanged);
+
+		SAssignNew(NotifyPair, SMotionTagPair)
+			.LeftContent()
+			[
+				SNew(SBox)
+			]
+		.Node(AnimNotifyNode);
+	}
+
+	AnimNotifyNode->bSelected = SelectedNodeIndices.Contains(NotifyIndex);
+	AnimNotifyNode->CachedTrackGeometry = CachedGeometry;
+
+	if (CachedGeometry.GetLocalSize().X > 0.0f)
+	{
+		AnimNotifyNode->UpdateSizeAndPosition(CachedGeometry);
+	}
+
+	NotifyNodes[NotifyIndex] = AnimNotifyNode;
+	NotifyPairs[NotifyIndex] = NotifyPair;
+	return AnimNotifyNode;
+}
+
+void SMotionTagTrack::ReleaseNode(int32 NotifyIndex)
+{
+	TSharedPtr<SMotionTagPair> NotifyPair = NotifyPairs[NotifyIndex];
+	NotifyNodes[NotifyIndex] = nullptr;
+	NotifyPairs[NotifyIndex] = nullptr;
+
+	// Nodes being dragged are still referenced by the drag operation so they aren't reused
+	if (NotifyPair.IsValid() && !NotifyPair->GetNode()->IsBeingDragged())
+	{
+		NotifyPair->GetNode()->SetToolTipText(FText::GetEmpty());
+		NodePool.Add(NotifyPair);
+	}
+}
+
+void SMotionTagTrack::SetNodeSelected(int32 NotifyIndex, bool bSelected)
+{
+	if (bSelected)
+	{
+		AcquireNode(NotifyIndex)->bSelected = true;
+	}
+	else if (NotifyNodes[NotifyIndex].IsValid())
+	{
+		NotifyNodes[NotifyIndex]->bSelected = false;
+	}
+}
+
+int32 SMotionTagTrack::GetNumNodeWidgets() const
+{
+	int32 WidgetCount = NodePool.Num();
+	for (const TSharedPtr<SMotionTagNode>& Node : NotifyNodes)
+	{
+		WidgetCount += Node.IsValid() ? 1 : 0;
+	}
+
+	return WidgetCount;
+}
+
 FCursorReply SMotionTagTrack::OnCursorQuery(const FGeometry& MyGeometry, const FPointerEvent& CursorEvent) const
 {
 	if (ViewInputMin.Get() > 0.f || ViewInputMax.Get() < MotionAnim->GetPlayLength())
@@ -2475,10 +2736,9 @@ void SMotionTagTrack::SelectTrackObjectNode(int32 TrackNodeIndex, bool Append, b
 		if (!SelectedNodeIndices.Contains(TrackNodeIndex))
 		{
 			// select new one
-			if (NotifyNodes.IsValidIndex(TrackNodeIndex))
+			if (NodeObjects.IsValidIndex(TrackNodeIndex))
 			{
-				TSharedPtr<SMotionTagNode> Node = NotifyNodes[TrackNodeIndex];
-				Node->bSelected = true;
+				SetNodeSelected(TrackNodeIndex, true);
 				SelectedNodeIndices.Add(TrackNodeIndex);
 
 				if (bUpdateSelection)
@@ -2492,7 +2752,7 @@ void SMotionTagTrack::SelectTrackObjectNode(int32 TrackNodeIndex, bool Append, b
 
 void SMotionTagTrack::ToggleTrackObjectNodeSelectionStatus(int32 TrackNodeIndex, bool bUpdateSelection)
 {
-	check(NotifyNodes.IsValidIndex(TrackNodeIndex));
+	check(NodeObjects.IsValidIndex(TrackNodeIndex));
 
 	bool bSelected = SelectedNodeIndices.Contains(TrackNodeIndex);
 	if (bSelected)
@@ -2504,8 +2764,7 @@ void SMotionTagTrack::ToggleTrackObjectNodeSelectionStatus(int32 TrackNodeIndex,
 		SelectedNodeIndices.Add(TrackNodeIndex);
 	}
 
-	TSharedPtr<SMotionTagNode> Node = NotifyNodes[TrackNodeIndex];
-	Node->bSelected = !Node->bSelected;
+	SetNodeSelected(TrackNodeIndex, !bSelected);
 
 	if (bUpdateSelection)
 	{
@@ -2515,9 +2774,8 @@ void SMotionTagTrack::ToggleTrackObjectNodeSelectionStatus(int32 TrackNodeIndex,
 
 void SMotionTagTrack::DeselectTrackObjectNode(int32 TrackNodeIndex, bool bUpdateSelection)
 {
-	check(NotifyNodes.IsValidIndex(TrackNodeIndex));
-	TSharedPtr<SMotionTagNode> Node = NotifyNodes[TrackNodeIndex];
-	Node->bSelected = false;
+	check(NodeObjects.IsValidIndex(TrackNodeIndex));
+	SetNodeSelected(TrackNodeIndex, false);
 
 	int32 ItemsRemoved = SelectedNodeIndices.Remove(TrackNodeIndex);
 	check(ItemsRemoved > 0);
@@ -2530,9 +2788,9 @@ void SMotionTagTrack::DeselectTrackObjectNode(int32 TrackNodeIndex, bool bUpdate
 
 void SMotionTagTrack::DeselectAllNotifyNodes(bool bUpdateSelectionSet)
 {
-	for (TSharedPtr<SMotionTagNode> Node : NotifyNodes)
+	for (int32 NodeIndex : SelectedNodeIndices)
 	{
-		Node->bSelected = false;
+		SetNodeSelected(NodeIndex, false);
 	}
 	SelectedNodeIndices.Empty();
 
@@ -2546,11 +2804,11 @@ void SMotionTagTrack::SelectNodesByGuid(const TSet<FGuid>& InGuids, bool bUpdate
 {
 	SelectedNodeIndices.Empty();
 
-	for (int32 NodeIndex = 0; NodeIndex < NotifyNodes.Num(); ++NodeIndex)
+	for (int32 NodeIndex = 0; NodeIndex < NodeObjects.Num(); ++NodeIndex)
 	{
-		TSharedPtr<SMotionTagNode> Node = NotifyNodes[NodeIndex];
-		Node->bSelected = InGuids.Contains(Node->NodeObjectInterface->GetGuid());
-		if (Node->bSelected)
+		const bool bSelected = InGuids.Contains(NodeObjects[NodeIndex].GetGuid());
+		SetNodeSelected(NodeIndex, bSelected);
+		if (bSelected)
 		{
 			SelectedNodeIndices.Add(NodeIndex);
 		}
@@ -2572,7 +2830,7 @@ TSharedPtr<SWidget> SMotionTagTrack::SummonContextMenu(const FGeometry& MyGeomet
 	FMenuBuilder MenuBuilder(bCloseWindowAfterMenuSelection, WeakCommandList.Pin());
 	FUIAction NewAction;
 
-	INodeObjectInterface* NodeObject = NodeIndex != INDEX_NONE ? NotifyNodes[NodeIndex]->NodeObjectInterface : nullptr;
+	INodeObjectInterface* NodeObject = NodeIndex != INDEX_NONE ? GetNodeObjectInterface(NodeIndex) : nullptr;
 	FAnimNotifyEvent* NotifyEvent = NodeObject ? NodeObject->GetNotifyEvent() : nullptr;
 	int32 NotifyIndex = NotifyEvent ? AnimNotifies.IndexOfByKey(NotifyEvent) : INDEX_NONE;
 
@@ -2588,7 +2846,7 @@ TSharedPtr<SWidget> SMotionTagTrack::SummonContextMenu(const FGeometry& MyGeomet
 	{
 		if (NodeObject)
 		{
-			if (!NotifyNodes[NodeIndex]->bSelected)
+			if (!IsNodeSelected(NodeIndex))
 			{
 				SelectTrackObjectNode(NodeIndex, MouseEvent.IsControlDown());
 			}
@@ -2613,9 +2871,9 @@ TSharedPtr<SWidget> SMotionTagTrack::SummonContextMenu(const FGeometry& MyGeomet
 					.AllowSpin(false)
 					.OnValueCommitted_Lambda([this, NodeIndex](float InValue, ETextCommit::Type InCommitType)
 						{
-							if (InCommitType == ETextCommit::OnEnter && NotifyNodes.IsValidIndex(NodeIndex))
+							if (InCommitType == ETextCommit::OnEnter && NodeObjects.IsValidIndex(NodeIndex))
 							{
-								INodeObjectInterface* LocalNodeObject = NotifyNodes[NodeIndex]->NodeObjectInterface;
+								INodeObjectInterface* LocalNodeObject = GetNodeObjectInterface(NodeIndex);
 
 								float NewTime = FMath::Clamp(InValue, 0.0f, (float)MotionAnim->GetPlayLength() - LocalNodeObject->GetDuration());
 								LocalNodeObject->SetTime(NewTime);
@@ -2659,9 +2917,9 @@ TSharedPtr<SWidget> SMotionTagTrack::SummonContextMenu(const FGeometry& MyGeomet
 					.AllowSpin(false)
 					.OnValueCommitted_Lambda([this, NodeIndex](int32 InValue, ETextCommit::Type InCommitType)
 						{
-							if (InCommitType == ETextCommit::OnEnter && NotifyNodes.IsValidIndex(NodeIndex))
+							if (InCommitType == ETextCommit::OnEnter && NodeObjects.IsValidIndex(NodeIndex))
 							{
-								INodeObjectInterface* LocalNodeObject = NotifyNodes[NodeIndex]->NodeObjectInterface;
+								INodeObjectInterface* LocalNodeObject = GetNodeObjectInterface(NodeIndex);
 
 								UAnimSequenceBase* ThisSequence = Cast<UAnimSequenceBase>(MotionAnim->AnimAsset);
 
@@ -3037,111 +3295,32 @@ void SMotionTagTrack::AddNewNotify(const FText& NewNotifyName, ETextCommit::Type
 
 void SMotionTagTrack::Update()
 {
-	NotifyPairs.Empty();
-	NotifyNodes.Empty();
-
-	TrackArea->SetContent(
-		SAssignNew(NodeSlots, SOverlay)
-	);
+	// Node widgets are returned to the pool and only recreated for the notifies that are visible or selected
+	NodeSlots->ClearChildren();
+	VisibleNodeIndices.Empty();
+	SelectedNodeIndices.Empty();
 
-	if (AnimNotifies.Num() > 0)
+	for (int32 NodeIndex = 0; NodeIndex < NotifyNodes.Num(); ++NodeIndex)
 	{
-		TArray<TSharedPtr<FTimingRelevantElementBase>> TimingElements;
-		SMotionTimingPanel::GetTimingRelevantElements(Cast<UAnimSequenceBase>(MotionAnim->AnimAsset), TimingElements);
-		for (int32 NotifyIndex = 0; NotifyIndex < AnimNotifies.Num(); ++NotifyIndex)
-		{
-			TSharedPtr<FTimingRelevantElementBase> Element;
-			FAnimNotifyEvent* Event = AnimNotifies[NotifyIndex];
-
-			for (int32 Idx = 0; Idx < TimingElements.Num(); ++Idx)
-			{
-				Element = TimingElements[Idx];
-
-				if (Element->GetType() == ETimingElementType::NotifyStateBegin
-					|| Element->GetType() == ETimingElementType::BranchPointNotify
-					|| Element->GetType() == ETimingElementType::QueuedNotify)
-				{
-					// Only the notify type will return the type flags above
-					FTimingRelevantElement_Notify* NotifyElement = static_cast<FTimingRelevantElement_Notify*>(Element.Get());
-					if (Event == &MotionAnim->Tags[NotifyElement->NotifyIndex])
-					{
-						break;
-					}
-				}
-			}
-
-			TSharedPtr<SMotionTagNode> AnimNotifyNode = nullptr;
-			TSharedPtr<SMotionTagPair> NotifyPair = nullptr;
-			//TSharedPtr<SMotionTimingNode> TimingNode = nullptr;
-			//TSharedPtr<SMotionTimingNode> EndTimingNode = nullptr;
-
-			// Create visibility attribute to control timing node visibility for notifies
-			TAttribute<EVisibility> TimingNodeVisibility = TAttribute<EVisibility>::Create(TAttribute<EVisibility>::FGetter::CreateLambda(
-				[this]()
-				{
-					/*if (OnGetTimingNodeVisibility.IsBound())
-					{
-						return OnGetTimingNodeVisibility.Execute(ETimingElementType::QueuedNotify);
-					}*/
-					return EVisibility(EVisibility::Hidden);
-				}));
-
-			/*SAssignNew(TimingNode, SMotionTimingNode)
-				.InElement(Element)
-				.bUseTooltip(true)
-				.Visibility(TimingNodeVisibility);*/
-
-			if (Event->NotifyStateClass)
-			{
-				TSharedPtr<FTimingRelevantElementBase>* FoundStateEndElement = TimingElements.FindByPredicate([Event](TSharedPtr<FTimingRelevantElementBase>& ElementToTest)
-					{
-						if (ElementToTest.IsValid() && ElementToTest->GetType() == ETimingElementType::NotifyStateEnd)
-						{
-							FTimingRelevantElement_NotifyStateEnd* StateElement = static_cast<FTimingRelevantElement_NotifyStateEnd*>(ElementToTest.Get());
-							return &(StateElement->Sequence->Notifies[StateElement->NotifyIndex]) == Event;
-						}
-						return false;
-					});
-
-				//if (FoundStateEndElement)
-				//{
-				//	// Create an end timing node if we have a state
-				//	SAssignNew(EndTimingNode, SMotionTimingNode)
-				//		.InElement(*FoundStateEndElement)
-				//		.bUseTooltip(true)
-				//		.Visibility(TimingNodeVisibility);
-				//}
-			}
+		ReleaseNode(NodeIndex);
+	}
 
-			SAssignNew(AnimNotifyNode, SMotionTagNode)
-				.MotionAnim(MotionAnim)
-				.AnimNotify(Event)
-				.OnNodeDragStarted(this, &SMotionTagTrack::OnTagNodeDragStarted, NotifyIndex)
-				.OnUpdatePanel(OnUpdatePanel)
-				.PanTrackRequest(OnRequestTrackPan)
-				.ViewInputMin(ViewInputMin)
-				.ViewInputMax(ViewInputMax)
-				.OnSnapPosition(OnSnapPosition)
-				.OnSelectionChanged(OnSelectionChanged);
-			//	.StateEndTimingNode(EndTimingNode);
-
-			SAssignNew(NotifyPair, SMotionTagPair)
-				.LeftContent()
-				[
-					SNew(SBox)
-					//TimingNode.ToSharedRef()
-				]
-			.Node(AnimNotifyNode);
+	NodeObjects.Reset(AnimNotifies.Num());
+	for (FAnimNotifyEvent* AnimNotify : AnimNotifies)
+	{
+		FTagNodeInterface& NodeObject = NodeObjects.Emplace_GetRef(AnimNotify);
+		NodeObject.CacheName();
+	}
 
-			NodeSlots->AddSlot()
-				.Padding(TAttribute<FMargin>::Create(TAttribute<FMargin>::FGetter::CreateSP(this, &SMotionTagTrack::GetNotifyTrackPadding, NotifyIndex)))
-				[
-					NotifyPair->AsShared()
-				];
+	NotifyNodes.Reset(AnimNotifies.Num());
+	NotifyNodes.SetNum(AnimNotifies.Num());
+	NotifyPairs.Reset(AnimNotifies.Num());
+	NotifyPairs.SetNum(AnimNotifies.Num());
 
-			NotifyNodes.Add(AnimNotifyNode);
-			NotifyPairs.Add(NotifyPair);
-		}
+	//Nodes are slotted on the next tick once the track has been laid out, unless it already has been
+	if (CachedGeometry.GetLocalSize().X > 0.0f)
+	{
+		RefreshVisibleNodes(CachedGeometry);
 	}
 }
 
@@ -3149,7 +3328,8 @@ int32 SMotionTagTrack::GetHitNotifyNode(const FGeometry& MyGeometry, const FVect
 {
 	for (int32 I = NotifyNodes.Num() - 1; I >= 0; --I) //Run through from 'top most' Notify to bottom
 	{
-		if (NotifyNodes[I].Get()->HitTest(MyGeometry, CursorPosition))
+		// Only notifies near the track have widgets and only those can be under the cursor
+		if (NotifyNodes[I].IsValid() && NotifyNodes[I]->HitTest(MyGeometry, CursorPosition))
 		{
 			return I;
 		}
@@ -3169,8 +3349,8 @@ FReply SMotionTagTrack::OnTagNodeDragStarted(TSharedRef<SMotionTagNode> NotifyNo
 	// Sort our nodes so we're acessing them in time order
 	SelectedNodeIndices.Sort([this](const int32& A, const int32& B)
 		{
-			float TimeA = NotifyNodes[A]->NodeObjectInterface->GetTime();
-			float TimeB = NotifyNodes[B]->NodeObjectInterface->GetTime();
+			float TimeA = NodeObjects[A].GetTime();
+			float TimeB = NodeObjects[B].GetTime();
 			return TimeA < TimeB;
 		});
 
@@ -3280,7 +3460,7 @@ void SMotionTagTrack::AppendSelectionToSet(FGraphPanelSelectionSet& SelectionSet
 	// Add our selection to the provided set
 	for (int32 Index : SelectedNodeIndices)
 	{
-		if (FAnimNotifyEvent* Event = NotifyNodes[Index]->NodeObjectInterface->GetNotifyEvent())
+		if (FAnimNotifyEvent* Event = NodeObjects[Index].GetNotifyEvent())
 		{
 			if (Event->Notify)
 			{
@@ -3298,7 +3478,15 @@ void SMotionTagTrack::AppendSelectionToArray(TArray<INodeObjectInterface*>& Sele
 {
 	for (int32 Idx : SelectedNodeIndices)
 	{
-		Selection.Add(NotifyNodes[Idx]->NodeObjectInterface);
+		Selection.Add(const_cast<FTagNodeInterface*>(&NodeObjects[Idx]));
+	}
+}
+
+void SMotionTagTrack::AppendSelectedGuidsToSet(TSet<FGuid>& GuidSet) const
+{
+	for (int32 Idx : SelectedNodeIndices)
+	{
+		GuidSet.Add(NodeObjects[Idx].GetGuid());
 	}
 }
 
@@ -3372,7 +3560,7 @@ void SMotionTagTrack::AppendSelectedNodeWidgetsToArray(TArray<TSharedPtr<SMotion
 {
 	for (TSharedPtr<SMotionTagNode> Node : NotifyNodes)
 	{
-		if (Node->bSelected)
+		if (Node.IsValid() && Node->bSelected)
 		{
 			NodeArray.Add(Node);
 		}
@@ -3384,10 +3572,9 @@ void SMotionTagTrack::RefreshMarqueeSelectedNodes(FSlateRect& Rect, FTagMarqueeO
 	if (Marquee.Operation != FTagMarqueeOperation::Replace)
 	{
 		// Maintain the original selection from before the operation
-		for (int32 Idx = 0; Idx < NotifyNodes.Num(); ++Idx)
+		for (int32 Idx = 0; Idx < NodeObjects.Num(); ++Idx)
 		{
-			TSharedPtr<SMotionTagNode> Notify = NotifyNodes[Idx];
-			bool bWasSelected = Marquee.OriginalSelection.Contains(Notify);
+			bool bWasSelected = Marquee.OriginalSelection.Contains(NodeObjects[Idx].GetGuid());
 			if (bWasSelected)
 			{
 				SelectTrackObjectNode(Idx, true, false);
@@ -3399,9 +3586,15 @@ void SMotionTagTrack::RefreshMarqueeSelectedNodes(FSlateRect& Rect, FTagMarqueeO
 		}
 	}
 
+	// Only notifies near the track have widgets and only those can intersect the marquee
 	for (int32 Index = 0; Index < NotifyNodes.Num(); ++Index)
 	{
 		TSharedPtr<SMotionTagNode> Node = NotifyNodes[Index];
+		if (!Node.IsValid())
+		{
+			continue;
+		}
+
 		FSlateRect NodeRect = FSlateRect(Node->GetWidgetPosition(), Node->GetWidgetPosition() + Node->GetSize());
 
 		if (FSlateRect::DoRectanglesIntersect(Rect, NodeRect))
@@ -3437,7 +3630,10 @@ void SMotionTagTrack::ClearNodeTooltips()
 
 	for (TSharedPtr<SMotionTagNode> Node : NotifyNodes)
 	{
-		Node->SetToolTipText(EmptyTooltip);
+		if (Node.IsValid())
+		{
+			Node->SetToolTipText(EmptyTooltip);
+		}
 	}
 }
 
@@ -3461,7 +3657,10 @@ void SMotionTagTrack::UpdateCachedGeometry(const FGeometry& InGeometry)
 
 	for (TSharedPtr<SMotionTagNode> Node : NotifyNodes)
 	{
-		Node->CachedTrackGeometry = InGeometry;
+		if (Node.IsValid())
+		{
+			Node->CachedTrackGeometry = InGeometry;
+		}
 	}
 }
 
@@ -4381,13 +4580,13 @@ FReply SMotionTagPanel::OnMouseButtonDown(const FGeometry& MyGeometry, const FPo
 
 	if (bLeftButton)
 	{
-		TArray<TSharedPtr<SMotionTagNode>> SelectedNodes;
+		TSet<FGuid> SelectedNodeGuids;
 		for (TSharedPtr<SMotionTagTrack> Track : TagMotionTracks)
 		{
-			Track->AppendSelectedNodeWidgetsToArray(SelectedNodes);
+			Track->AppendSelectedGuidsToSet(SelectedNodeGuids);
 		}
 
-		Marquee.Start(MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition()), Marquee.OperationTypeFromMouseEvent(MouseEvent), SelectedNodes);
+		Marquee.Start(MyGeometry.AbsoluteToLocal(MouseEvent.GetScreenSpacePosition()), Marquee.OperationTypeFromMouseEvent(MouseEvent), SelectedNodeGuids);
 		if (Marquee.Operation == FTagMarqueeOperation::Replace)
 		{
 			// Remove and Add operations preserve selections, replace starts afresh
@@ -4645,4 +4844,80 @@ void SMotionTagPanel::HandleObjectsSelected(const TArray<UObject*>& InObjects)
 	}
 }
 
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMotionTagTrackPaintTest, "MotionSymphony.Editor.TagTrack.Paint5000Tags",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+bool FMotionTagTrackPaintTest::RunTest(const FString& Parameters)
+{
+	if (!FSlateApplication::IsInitialized())
+	{
+		AddWarning(TEXT("Slate is not initialized. The tag track paint test was skipped."));
+		return true;
+	}
+
+	const int32 TagCount = 5000;
+	const float AnimLength = 100.0f;
+	const float ViewLength = 2.0f;
+	const int32 FrameCount = 200;
+
+	FMotionAnimAsset MotionAnim;
+	MotionAnim.MotionTagTracks.AddDefaulted();
+	MotionAnim.Tags.SetNum(TagCount);
+
+	TArray<FAnimNotifyEvent*> AnimNotifies;
+	for (int32 TagIndex = 0; TagIndex < TagCount; ++TagIndex)
+	{
+		FAnimNotifyEvent& Tag = MotionAnim.Tags[TagIndex];
+		Tag.NotifyName = FName(*FString::Printf(TEXT("Tag_%d"), TagIndex));
+		Tag.SetTime(AnimLength * (float)TagIndex / (float)TagCount);
+		Tag.Guid = FGuid::NewGuid();
+		AnimNotifies.Add(&Tag);
+	}
+
+	float ViewMin = 0.0f;
+	TSharedRef<SMotionTagTrack> Track = SNew(SMotionTagTrack)
+		.MotionAnim(&MotionAnim)
+		.AnimNotifies(AnimNotifies)
+		.TrackIndex(0)
+		.ViewInputMin_Lambda([&ViewMin]() { return ViewMin; })
+		.ViewInputMax_Lambda([&ViewMin, ViewLength]() { return ViewMin + ViewLength; });
+
+	TSharedRef<SWindow> Window = SNew(SWindow)
+		.ClientSize(FVector2D(1600.0f, FMotionTimelineTrack_TagsPanel::NotificationTrackHeight))
+		.CreateTitleBar(false)
+		[
+			Track
+		];
+
+	FSlateWindowElementList ElementList(Window);
+	int32 MaxNodeWidgets = 0;
+	double PaintSeconds = 0.0;
+
+	//Scroll across the whole animation so that widgets are continually released and reused
+	for (int32 Frame = 0; Frame < FrameCount; ++Frame)
+	{
+		ViewMin = (AnimLength - ViewLength) * (float)Frame / (float)(FrameCount - 1);
+
+		ElementList.ResetElementList();
+		const double StartTime = FPlatformTime::Seconds();
+		Window->SlatePrepass(1.0f);
+		Window->PaintWindow(FSlateApplication::Get().GetCurrentTime(), 1.0f / 60.0f, ElementList, FWidgetStyle(), true);
+		PaintSeconds += FPlatformTime::Seconds() - StartTime;
+
+		MaxNodeWidgets = FMath::Max(MaxNodeWidgets, Track->GetNumNodeWidgets());
+	}
+
+	AddInfo(FString::Printf(TEXT("%d tags: %.3f ms average prepass and paint, at most %d node widgets."), 
+		TagCount, PaintSeconds * 1000.0 / FrameCount, MaxNodeWidgets));
+
+	//About 100 tags are in view at a time. Widgets must only exist for those, not for every tag
+	TestTrue(TEXT("Node widgets are only created for the visible tags"), MaxNodeWidgets > 0 && MaxNodeWidgets < TagCount / 10);
+
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
+
 #undef LOCTEXT_NAMESPACE
\ No newline at end of file
@@ -95,7 +95,7 @@ struct FTagMarqueeOperation
 		return Rect.IsValid() && bActive;
 	}
 
-	void Start(const FVector2D& InStartLocation, FTagMarqueeOperation::Type InOperationType, TArray<TSharedPtr<SMotionTagNode>>& InOriginalSelection)
+	void Start(const FVector2D& InStartLocation, FTagMarqueeOperation::Type InOperationType, const TSet<FGuid>& InOriginalSelection)
 	{
 		Rect = FMarqueeRect(InStartLocation);
 		Operation = InOperationType;
@@ -132,8 +132,8 @@ public:
 	/** Whether the marquee has been activated, usually by a drag */
 	bool bActive;
 
-	/** The original selection state before the marquee selection */
-	TArray<TSharedPtr<SMotionTagNode>> OriginalSelection;
+	/** The guids of the notifies selected before the marquee selection. Node widgets are pooled so they can't identify a notify */
+	TSet<FGuid> OriginalSelection;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -7,6 +7,10 @@
 #include "ISettingsSection.h"
 #include "ISettingsContainer.h"
 #include "MotionSymphonySettings.h"
+#include "AnimationModifiers/AnimModCurveBatch.h"
+#include "Animation/AnimSequence.h"
+#include "ContentBrowserMenuContexts.h"
+#include "ToolMenus.h"
 
 #define LOCTEXT_NAMESPACE "FMotionSymphonyEditorModule"
 
@@ -45,11 +49,64 @@ void FMotionSymphonyEditorModule::RegisterAssetTools()
 	RegisterMotionCalibrationAssetTypeActions(AssetTools, MakeShareable(new FAssetTypeActions_MotionCalibration()));
 	RegisterMMOptimisationTraitBinsAssetTypeActions(AssetTools, MakeShareable(new FAssetTypeActions_MMOptimisation_TraitBins()));
 	RegisterMMOptimisationMultiClusteringAssetTypeActions(AssetTools, MakeShareable(new FAssetTypeActions_MMOptimisation_MultiClustering()));
+	RegisterMMOptimisationProductQuantisationAssetTypeActions(AssetTools, MakeShareable(new FAssetTypeActions_MMOptimisation_ProductQuantisation()));
 }
 
 void FMotionSymphonyEditorModule::RegisterMenuExtensions()
 {
-	
+	UToolMenus::RegisterStartupCallback(FSimpleMulticastDelegate::FDelegate::CreateRaw(this, 
+		&FMotionSymphonyEditorModule::RegisterAnimSequenceMenuExtensions));
+}
+
+void FMotionSymphonyEditorModule::RegisterAnimSequenceMenuExtensions()
+{
+	FToolMenuOwnerScoped OwnerScoped(this);
+
+	UToolMenu* Menu = UToolMenus::Get()->ExtendMenu("ContentBrowser.AssetContextMenu.AnimSequence");
+	FToolMenuSection& Section = Menu->FindOrAddSection("GetAssetActions");
+
+	Section.AddSubMenu("MotionSymphonyCurves", 
+		LOCTEXT("GenerateCurvesMenu", "Generate Motion Symphony Curves"),
+		LOCTEXT("GenerateCurvesMenuTooltip", "Applies a Motion Symphony curve modifier to all selected sequences. Root motion is extracted once per sequence in parallel."),
+		FNewToolMenuDelegate::CreateLambda([](UToolMenu* SubMenu)
+	{
+		const UContentBrowserAssetContextMenuContext* Context = SubMenu->FindContext<UContentBrowserAssetContextMenuContext>();
+		if (!Context)
+		{
+			return;
+		}
+
+		TArray<TWeakObjectPtr<UAnimSequence>> Sequences;
+		for (const TWeakObjectPtr<UObject>& SelectedObject : Context->SelectedObjects)
+		{
+			if (UAnimSequence* Sequence = Cast<UAnimSequence>(SelectedObject.Get()))
+			{
+				Sequences.Add(Sequence);
+			}
+		}
+
+		TArray<UClass*> ModifierClasses;
+		FAnimModCurveBatch::GetCurveModifierClasses(ModifierClasses);
+
+		FToolMenuSection& ModifierSection = SubMenu->AddSection("Modifiers", LOCTEXT("ModifiersSection", "Modifiers"));
+		for (UClass* ModifierClass : ModifierClasses)
+		{
+			ModifierSection.AddMenuEntry(ModifierClass->GetFName(), ModifierClass->GetDisplayNameText(), ModifierClass->GetToolTipText(), 
+				FSlateIcon(), FUIAction(FExecuteAction::CreateLambda([Sequences, ModifierClass]()
+			{
+				TArray<UAnimSequence*> ValidSequences;
+				for (const TWeakObjectPtr<UAnimSequence>& Sequence : Sequences)
+				{
+					if (Sequence.IsValid())
+					{
+						ValidSequences.Add(Sequence.Get());
+					}
+				}
+
+				FAnimModCurveBatch::ApplyModifiers(ValidSequences, { ModifierClass });
+			})));
+		}
+	}));
 }
 
 void FMotionSymphonyEditorModule::RegisterMotionDataAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MotionDataAsset> TypeActions)
@@ -88,6 +145,12 @@ void FMotionSymphonyEditorModule::RegisterMMOptimisationMultiClusteringAssetType
 	RegisteredAssetTypeActions.Add(TypeActions);
 }
 
+void FMotionSymphonyEditorModule::RegisterMMOptimisationProductQuantisationAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MMOptimisation_ProductQuantisation> TypeActions)
+{
+	AssetTools.RegisterAssetTypeActions(TypeActions);
+	RegisteredAssetTypeActions.Add(TypeActions);
+}
+
 //void FMotionSymphonyEditorModule::RegisterMMOptimisationLayeredAABBAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MirroringProfile> TypeActions)
 //{
 //	AssetTools.RegisterAssetTypeActions(TypeActions);
@@ -101,7 +164,8 @@ void FMotionSymphonyEditorModule::UnRegisterAssetTools()
 
 void FMotionSymphonyEditorModule::UnRegisterMenuExtensions()
 {
-	
+	UToolMenus::UnRegisterStartupCallback(this);
+	UToolMenus::UnregisterOwner(this);
 }
 
 void FMotionSymphonyEditorModule::UnRegisterAssetTypeActions()
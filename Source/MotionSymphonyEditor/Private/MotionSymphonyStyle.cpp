@@ -69,6 +69,9 @@ TSharedRef<class FSlateStyleSet> FMotionSymphonyStyle::Create()
 	Style->Set("ClassIcon.MMOptimisation_MultiClustering", new IMAGE_BRUSH(TEXT("MotionClustering128"), Icon20x20));
 	Style->Set("ClassThumbnail.MMOptimisation_MultiClustering", new IMAGE_BRUSH(TEXT("MotionClustering128"), Icon128x128));
 
+	Style->Set("ClassIcon.MMOptimisation_ProductQuantisation", new IMAGE_BRUSH(TEXT("MotionClustering128"), Icon20x20));
+	Style->Set("ClassThumbnail.MMOptimisation_ProductQuantisation", new IMAGE_BRUSH(TEXT("MotionClustering128"), Icon128x128));
+
 	Style->Set("MotionSymphony.Toolbar.AddAnims", new IMAGE_BRUSH(TEXT("MotionDataAsset128"), Icon64x64));
 	Style->Set("MotionSymphony.Toolbar.ClearAnims", new IMAGE_BRUSH(TEXT("MotionTraitBins128"), Icon64x64));
 	Style->Set("MotionSymphony.Toolbar.NextAnim", new IMAGE_BRUSH(TEXT("MotionNextAnim128"), Icon64x64));
@@ -1419,6 +1419,8 @@ void FMotionPreProcessToolkit::PreProcessAnimData()
 	ActiveMotionDataAsset->Modify();
 	ActiveMotionDataAsset->PreProcess();
 	ActiveMotionDataAsset->MarkPackageDirty();
+
+	ViewportPtr->InvalidateDebugDrawBatches();
 }
 
 void FMotionPreProcessToolkit::OpenPickAnimsDialog()
@@ -1491,6 +1493,8 @@ void FMotionPreProcessToolkit::DrawCachedTrajectoryPoints(FPrimitiveDrawInterfac
 	
 	FLinearColor color = FLinearColor::Green;
 
+	DrawInterface->AddReserveLines(ESceneDepthPriorityGroup::SDPG_Foreground, CachedTrajectoryPoints.Num(), false, true);
+
 	for (auto& point : CachedTrajectoryPoints)
 	{
 		DrawInterface->DrawLine(lastPoint, point, color, ESceneDepthPriorityGroup::SDPG_Foreground, 3.0f);
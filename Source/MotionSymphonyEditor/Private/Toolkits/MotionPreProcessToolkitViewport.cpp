@@ -18,6 +18,11 @@ void SMotionPreProcessToolkitViewport::SetupAnimatedRenderComponent()
 	EditorViewportClient->SetupAnimatedRenderComponent();
 }
 
+void SMotionPreProcessToolkitViewport::InvalidateDebugDrawBatches()
+{
+	EditorViewportClient->InvalidateDebugDrawBatches();
+}
+
 void SMotionPreProcessToolkitViewport::BindCommands()
 {
 	SEditorViewport::BindCommands();
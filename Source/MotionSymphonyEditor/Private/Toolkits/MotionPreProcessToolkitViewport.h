@@ -30,6 +30,7 @@ public:
 	void Construct(const FArguments& InArgs, TWeakPtr<class FMotionPreProcessToolkit> InMotionPreProcessToolkitPtr);
 
 	void SetupAnimatedRenderComponent();
+	void InvalidateDebugDrawBatches();
 
 	// SEditorViewport interface
 	virtual void BindCommands() override;
@@ -11,7 +11,7 @@
 #include "Animation/DebugSkelMeshComponent.h"
 #include "Editor/AdvancedPreviewScene/Public/AssetViewerSettings.h"
 #include "Utils.h"
-#include "DrawDebugHelpers.h"
+#include "SceneManagement.h"
 #include "MotionMatchingUtil/MMBlueprintFunctionLibrary.h"
 
 
@@ -40,7 +40,8 @@ FBox FMotionPreProcessToolkitViewportClient::GetDesiredFocusBounds() const
 FMotionPreProcessToolkitViewportClient::FMotionPreProcessToolkitViewportClient(const TAttribute<UMotionDataAsset*>& InMotionDataAsset,
 	TWeakPtr<FMotionPreProcessToolkit> InMotionPreProcessToolkitPtr)
 	: MotionPreProcessToolkitPtr(InMotionPreProcessToolkitPtr), CurrentMotionConfig(nullptr), bShowPivot(false), bShowMatchBones(true),
-	bShowTrajectory(true), bShowPose(false), bShowOptimizationDebug(false)
+	bShowTrajectory(true), bShowPose(false), bShowOptimizationDebug(false), PoseDebugBatchPoseIndex(INDEX_NONE),
+	bPoseDebugBatchDirty(true), OptimisationDebugBatchPoseCount(0), bOptimisationDebugBatched(false), bOptimisationDebugBatchDirty(true)
 {
 	MotionData = InMotionDataAsset;
 
@@ -84,7 +85,6 @@ void FMotionPreProcessToolkitViewportClient::Draw(const FSceneView* SceneView, F
 	}
 
 	UWorld* World = PreviewScene->GetWorld();
-	FlushPersistentDebugLines(World);
 
 	if (bShowMatchBones)
 	{
@@ -103,7 +103,7 @@ void FMotionPreProcessToolkitViewportClient::Draw(const FSceneView* SceneView, F
 
 	if(bShowOptimizationDebug)
 	{
-		DrawOptimisationDebug(DrawInterface, World);
+		DrawOptimisationDebug(SceneView, DrawInterface, World);
 	}
 }
 
@@ -291,7 +291,7 @@ void FMotionPreProcessToolkitViewportClient::DrawMatchBones(FPrimitiveDrawInterf
 		const int32 BoneIndex = DebugSkeletalMesh->GetBoneIndex(BoneRef.BoneName);
 		FVector JointPos = DebugSkeletalMesh->GetBoneTransform(BoneIndex).GetLocation();
 
-		DrawDebugSphere(World, JointPos, 8.0f, 8, FColor::Yellow, true, -1, 0);
+		DrawWireSphere(DrawInterface, JointPos, FColor::Yellow, 8.0f, 8, SDPG_World);
 	}
 }
 
@@ -305,7 +305,7 @@ void FMotionPreProcessToolkitViewportClient::DrawCurrentTrajectory(FPrimitiveDra
 	MotionPreProcessToolkitPtr.Pin()->DrawCachedTrajectoryPoints(DrawInterface);
 }
 
-void FMotionPreProcessToolkitViewportClient::DrawCurrentPose(FPrimitiveDrawInterface* DrawInterface, const UWorld* World) const
+void FMotionPreProcessToolkitViewportClient::DrawCurrentPose(FPrimitiveDrawInterface* DrawInterface, const UWorld* World)
 {
 	if (!DrawInterface 
 	 || !World 
@@ -323,7 +323,7 @@ void FMotionPreProcessToolkitViewportClient::DrawCurrentPose(FPrimitiveDrawInter
 	
 	const int PreviewIndex = MotionPreProcessToolkitPtr.Pin()->PreviewPoseCurrentIndex;
 
-	if (PreviewIndex < 0 || PreviewIndex > ActiveMotionData->Poses.Num())
+	if (PreviewIndex < 0 || PreviewIndex >= ActiveMotionData->Poses.Num())
 	{
 		return;
 	}
@@ -334,47 +334,44 @@ void FMotionPreProcessToolkitViewportClient::DrawCurrentPose(FPrimitiveDrawInter
 		return;
 	}
 
-	const FTransform PreviewTransform = DebugSkeletalMesh->GetComponentTransform();
-	FPoseMotionData& Pose = ActiveMotionData->Poses[PreviewIndex];
-
-	//Draw all pre-processed pose joint data relative to the character
-	for (int i = 0; i < Pose.JointData.Num(); ++i)
+	//The pose data is relative to the character so it is batched once per pose and transformed when drawn
+	if (bPoseDebugBatchDirty
+		|| PoseDebugBatchPoseIndex != PreviewIndex
+		|| PoseDebugBatchMotionData.Get() != ActiveMotionData)
 	{
-		FJointData& JointData = Pose.JointData[i];
-
-		FVector BonePos = PreviewTransform.TransformPosition(JointData.Position);
-
-		DrawDebugSphere(World, BonePos, 8.0f, 8, FColor::Blue, true, -1, 0);
+		PoseDebugBatch.Reset();
+		bPoseDebugBatchDirty = false;
+		PoseDebugBatchPoseIndex = PreviewIndex;
+		PoseDebugBatchMotionData = ActiveMotionData;
 
-		FVector EndPoint = BonePos + PreviewTransform.TransformVector(JointData.Velocity * 0.3333f);
+		const FPoseMotionData& Pose = ActiveMotionData->Poses[PreviewIndex];
 
-		DrawDebugDirectionalArrow(World, BonePos, EndPoint, 20.0f, FColor::Blue, true, -1, 0, 1.5f);
-	}
-
-	if (Pose.Trajectory.Num() > 0)
-	{
-		FVector LastPointPos = PreviewTransform.TransformPosition(Pose.Trajectory[0].Position);
-		for (FTrajectoryPoint& Point : Pose.Trajectory)
+		for (const FJointData& JointData : Pose.JointData)
 		{
-			FVector PointPos = PreviewTransform.TransformPosition(Point.Position);
-
-			DrawDebugSphere(World, PointPos, 5.0f, 8, FColor::Red, true, -1, 0);
-
-			DrawInterface->DrawLine(LastPointPos, PointPos, FLinearColor::Red, 
-				ESceneDepthPriorityGroup::SDPG_Foreground, 3.0f);
+			PoseDebugBatch.AddWireSphere(JointData.Position, 8.0f, 8, FLinearColor::Blue);
+			PoseDebugBatch.AddArrow(JointData.Position, JointData.Position + JointData.Velocity * 0.3333f, 20.0f, FLinearColor::Blue);
+		}
 
-			FQuat Rotation = FQuat(FVector::UpVector, FMath::DegreesToRadians(Point.RotationZ + 90.0f));
-			FVector ArrowVector = PreviewTransform.TransformVector(Rotation * (FVector::ForwardVector * 50.0f));
+		if (Pose.Trajectory.Num() > 0)
+		{
+			FVector LastPointPos = Pose.Trajectory[0].Position;
+			for (const FTrajectoryPoint& Point : Pose.Trajectory)
+			{
+				PoseDebugBatch.AddWireSphere(Point.Position, 5.0f, 8, FLinearColor::Red);
+				PoseDebugBatch.AddLine(LastPointPos, Point.Position, FLinearColor::Red);
 
-			DrawDebugDirectionalArrow(World, PointPos, PointPos + ArrowVector, 20.0f, FColor::Red,
-				true, -1, 0, 1.5f);
+				const FQuat Rotation = FQuat(FVector::UpVector, FMath::DegreesToRadians(Point.RotationZ + 90.0f));
+				PoseDebugBatch.AddArrow(Point.Position, Point.Position + Rotation * (FVector::ForwardVector * 50.0f), 20.0f, FLinearColor::Red);
 
-			LastPointPos = PointPos;
+				LastPointPos = Point.Position;
+			}
 		}
 	}
+
+	PoseDebugBatch.Draw(DrawInterface, nullptr, DebugSkeletalMesh->GetComponentTransform(), 1.5f, SDPG_Foreground);
 }
 
-void FMotionPreProcessToolkitViewportClient::DrawOptimisationDebug(FPrimitiveDrawInterface* DrawInterface, const UWorld* World) const
+void FMotionPreProcessToolkitViewportClient::DrawOptimisationDebug(const FSceneView* SceneView, FPrimitiveDrawInterface* DrawInterface, const UWorld* World)
 {
 	if (!DrawInterface || !World || !MotionPreProcessToolkitPtr.IsValid())
 	{
@@ -391,7 +388,36 @@ void FMotionPreProcessToolkitViewportClient::DrawOptimisationDebug(FPrimitiveDra
 		return;
 	}
 
-	ActiveMotionData->OptimisationModule->DrawDebug(DrawInterface, World, ActiveMotionData);
+	UMMOptimisationModule* OptimisationModule = ActiveMotionData->OptimisationModule;
+
+	if (bOptimisationDebugBatchDirty
+		|| OptimisationDebugBatchMotionData.Get() != ActiveMotionData
+		|| OptimisationDebugBatchModule.Get() != OptimisationModule
+		|| OptimisationDebugBatchPoseCount != ActiveMotionData->Poses.Num())
+	{
+		OptimisationDebugBatch.Reset();
+		bOptimisationDebugBatchDirty = false;
+		OptimisationDebugBatchMotionData = ActiveMotionData;
+		OptimisationDebugBatchModule = OptimisationModule;
+		OptimisationDebugBatchPoseCount = ActiveMotionData->Poses.Num();
+		bOptimisationDebugBatched = OptimisationModule->BuildDebugDrawBatch(OptimisationDebugBatch, ActiveMotionData);
+	}
+
+	if (bOptimisationDebugBatched)
+	{
+		//Dense pose clouds are collapsed into aggregated points per 6x6 pixel cell
+		OptimisationDebugBatch.Draw(DrawInterface, SceneView, FTransform::Identity, 0.0f, SDPG_Foreground, 6.0f);
+	}
+	else
+	{
+		OptimisationModule->DrawDebug(DrawInterface, World, ActiveMotionData);
+	}
+}
+
+void FMotionPreProcessToolkitViewportClient::InvalidateDebugDrawBatches()
+{
+	bPoseDebugBatchDirty = true;
+	bOptimisationDebugBatchDirty = true;
 }
 
 void FMotionPreProcessToolkitViewportClient::SetCurrentTrajectory(const FTrajectory InTrajectory)
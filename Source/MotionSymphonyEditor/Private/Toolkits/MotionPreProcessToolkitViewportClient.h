@@ -12,6 +12,7 @@
 #include "SEditorViewport.h"
 #include "MotionPreProcessToolkit.h"
 #include "AssetViewerSettings.h"
+#include "MotionMatchingUtil/MotionDebugDrawBatch.h"
 
 class USphereReflectionCaptureComponent;
 class UMaterialInstanceConstant;
@@ -58,6 +59,20 @@ private:
 	bool bShowPose;
 	bool bShowOptimizationDebug;
 
+	/** Cached debug geometry for the preview pose, in component space. Rebuilt when the previewed pose or data changes */
+	FMotionDebugDrawBatch PoseDebugBatch;
+	TWeakObjectPtr<UMotionDataAsset> PoseDebugBatchMotionData;
+	int32 PoseDebugBatchPoseIndex;
+	bool bPoseDebugBatchDirty;
+
+	/** Cached optimisation module debug geometry. Rebuilt when the motion data or its optimisation changes */
+	FMotionDebugDrawBatch OptimisationDebugBatch;
+	TWeakObjectPtr<UMotionDataAsset> OptimisationDebugBatchMotionData;
+	TWeakObjectPtr<UMMOptimisationModule> OptimisationDebugBatchModule;
+	int32 OptimisationDebugBatchPoseCount;
+	bool bOptimisationDebugBatched;
+	bool bOptimisationDebugBatchDirty;
+
 public:
 	FMotionPreProcessToolkitViewportClient(const TAttribute<class UMotionDataAsset*>& InMotionData, TWeakPtr<class FMotionPreProcessToolkit> InMotionPreProcessToolkitPtr);
 
@@ -85,8 +100,11 @@ public:
 
 	void DrawMatchBones(FPrimitiveDrawInterface* DrawInterface, const UWorld* World) const;
 	void DrawCurrentTrajectory(FPrimitiveDrawInterface* DrawInterface) const;
-	void DrawCurrentPose(FPrimitiveDrawInterface* DrawInterface, const UWorld* World) const;
-	void DrawOptimisationDebug(FPrimitiveDrawInterface* DrawInterface, const UWorld* World) const;
+	void DrawCurrentPose(FPrimitiveDrawInterface* DrawInterface, const UWorld* World);
+	void DrawOptimisationDebug(const FSceneView* SceneView, FPrimitiveDrawInterface* DrawInterface, const UWorld* World);
+
+	/** Forces cached debug geometry to be rebuilt, e.g. after the motion data has been pre-processed */
+	void InvalidateDebugDrawBatches();
 	void SetCurrentTrajectory(const FTrajectory InTrajectory);
 
 	UDebugSkelMeshComponent* GetPreviewComponent() const;
@@ -0,0 +1,112 @@
+// Copyright 2020-2021 Kenneth Claassen. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+
+class UAnimSequence;
+
+/** How the root motion of a sequence is sampled for curve generation */
+enum class ERootMotionSampling : uint8
+{
+	/** A fixed 30Hz key rate, used by the speed and root velocity curves */
+	KeyRate,
+
+	/** Every frame of the sequence, used by the distance and rotation matching curves */
+	Frame
+};
+
+/** The root motion of a sequence extracted once at a fixed sampling. Each sample holds the root motion delta over the
+interval starting at the sample time. */
+struct MOTIONSYMPHONYEDITOR_API FRootMotionTrack
+{
+public:
+	float Interval;
+	TArray<float> Times;
+	TArray<FTransform> Deltas;
+
+public:
+	FRootMotionTrack();
+
+	void Extract(const UAnimSequence* Sequence, const ERootMotionSampling Sampling);
+
+	/** Samples root motion over a play length and frame count with an extraction function in the form of
+	UAnimSequence::ExtractRootMotion(StartTime, DeltaTime, bAllowLooping) */
+	void Sample(const float PlayLength, const int32 NumSampleFrames, const float FrameRate, const ERootMotionSampling Sampling,
+		TFunctionRef<FTransform(float StartTime, float DeltaTime)> ExtractRootMotion);
+
+	FORCEINLINE int32 Num() const { return Deltas.Num(); }
+
+	/** Gets the delta of a sample or identity if it is out of range */
+	FORCEINLINE const FTransform& GetDelta(const int32 SampleIndex) const
+	{
+		return Deltas.IsValidIndex(SampleIndex) ? Deltas[SampleIndex] : FTransform::Identity;
+	}
+};
+
+/** The sequence data, other than root motion, that curves are generated from. It is gathered on the game thread so that
+curve keys can then be generated on any thread */
+struct MOTIONSYMPHONYEDITOR_API FAnimCurveSource
+{
+public:
+	float FrameRate;
+
+	/** The trigger time of the 'DistanceMarker' notify or zero if there is none */
+	float DistanceMarkerTime;
+
+public:
+	FAnimCurveSource();
+	FAnimCurveSource(const UAnimSequence* Sequence);
+};
+
+/** Float curve keys gathered for a single curve so that they can be written to a sequence in one go */
+struct MOTIONSYMPHONYEDITOR_API FAnimCurveKeys
+{
+public:
+	FName CurveName;
+	TArray<float> Times;
+	TArray<float> Values;
+
+public:
+	FAnimCurveKeys(const FName InCurveName, const int32 ExpectedKeyCount = 0);
+
+	void Add(const float Time, const float Value);
+
+	/** Replaces the curve on the sequence with these keys */
+	void Write(UAnimSequence* Sequence) const;
+};
+
+/** Batched curve generation for the Motion Symphony animation modifiers. Within a batch the root motion of each sequence
+ * is extracted once per sampling and shared by every modifier. Outside of a batch modifiers extract it on demand. */
+class MOTIONSYMPHONYEDITOR_API FAnimModCurveBatch
+{
+public:
+	/** While a scope is alive, extracted root motion tracks are cached */
+	struct MOTIONSYMPHONYEDITOR_API FScope
+	{
+		FScope();
+		~FScope();
+	};
+
+public:
+	/** Gets the root motion track of a sequence, from the batch cache if possible */
+	static TSharedRef<const FRootMotionTrack> GetRootMotionTrack(const UAnimSequence* Sequence, const ERootMotionSampling Sampling);
+
+	/** Applies the modifiers to every sequence. Root motion is extracted on the game thread, as reading animation data 
+	isn't thread safe, the curve keys of the Motion Symphony curve modifiers are then generated in parallel and written 
+	on the game thread. Any other modifier is applied on the game thread. The modifiers are not added to the sequences' 
+	modifier stacks. */
+	static void ApplyModifiers(const TArray<UAnimSequence*>& Sequences, const TArray<UClass*>& ModifierClasses);
+
+	/** Generates the curve keys of a Motion Symphony curve modifier class. Safe to call from any thread. Returns false if 
+	the class isn't one of them (subclasses aren't, as they may override OnApply) */
+	static bool GenerateCurveKeys(const UClass* ModifierClass, const FRootMotionTrack& RootMotion, 
+		const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys);
+
+	/** The root motion sampling a modifier class reads. Returns false if it doesn't use a root motion track */
+	static bool GetModifierSampling(const UClass* ModifierClass, ERootMotionSampling& OutSampling);
+
+	/** The Motion Symphony modifiers that generate curves from root motion */
+	static void GetCurveModifierClasses(TArray<UClass*>& OutModifierClasses);
+};
@@ -7,6 +7,9 @@
 #include "AnimMod_DistanceMatching.generated.h"
 
 class UAnimSequence;
+struct FRootMotionTrack;
+struct FAnimCurveSource;
+struct FAnimCurveKeys;
 
 /** Animation modifier for generating a distance matching curve to a point within the animation 
 The animation point must be set by playing an animNotify and calling it 'DistanceMatch' */
@@ -17,4 +20,8 @@ class MOTIONSYMPHONYEDITOR_API UAnimMod_DistanceMatching : public UAnimationModi
 	
 	virtual void OnApply_Implementation(UAnimSequence* AnimationSequence) override;
 	virtual void OnRevert_Implementation(UAnimSequence* AnimationSequence) override;
+
+public:
+	/** Generates the curve keys without touching the sequence so that it can run on any thread */
+	static void GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys);
 };
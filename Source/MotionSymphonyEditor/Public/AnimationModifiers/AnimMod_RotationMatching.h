@@ -7,6 +7,9 @@
 #include "AnimMod_RotationMatching.generated.h"
 
 class UAnimSequence;
+struct FRootMotionTrack;
+struct FAnimCurveSource;
+struct FAnimCurveKeys;
 
 /**
  * 
@@ -18,4 +21,8 @@ class MOTIONSYMPHONYEDITOR_API UAnimMod_RotationMatching : public UAnimationModi
 	
 	virtual void OnApply_Implementation(UAnimSequence* AnimationSequence) override;
 	virtual void OnRevert_Implementation(UAnimSequence* AnimationSequence) override;
+
+public:
+	/** Generates the curve keys without touching the sequence so that it can run on any thread */
+	static void GenerateCurveKeys(const FRootMotionTrack& RootMotion, const FAnimCurveSource& Source, TArray<FAnimCurveKeys>& OutCurveKeys);
 };
@@ -12,6 +12,7 @@
 #include "AssetTypeActions_MirroringProfile.h"
 #include "AssetTypeActions_MMOptimisation_TraitBins.h"
 #include "AssetTypeActions_MMOptimisation_MultiClustering.h"
+#include "AssetTypeActions_MMOptimisation_ProductQuantisation.h"
 
 class FMotionSymphonyEditorModule : public IModuleInterface
 {
@@ -27,12 +28,14 @@ private:
 
 	void RegisterAssetTools();
 	void RegisterMenuExtensions();
+	void RegisterAnimSequenceMenuExtensions();
 	void RegisterMotionDataAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MotionDataAsset> TypeActions);
 	void RegisterMotionMatchConfigAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MotionMatchConfig> TypeActions);
 	void RegisterMotionCalibrationAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MotionCalibration> TypeActions);
 	void RegisterMirroringProfileAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MirroringProfile> TypeActions);
 	void RegisterMMOptimisationTraitBinsAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MMOptimisation_TraitBins> TypeActions);
 	void RegisterMMOptimisationMultiClusteringAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MMOptimisation_MultiClustering> TypeActions);
+	void RegisterMMOptimisationProductQuantisationAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MMOptimisation_ProductQuantisation> TypeActions);
 	//void RegisterMMOptimisationLayeredAABBAssetTypeActions(IAssetTools& AssetTools, TSharedRef<FAssetTypeActions_MMOptimisation_LayeredAABB> TypeActions);
 
 	void UnRegisterAssetTools();